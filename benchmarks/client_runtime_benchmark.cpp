@@ -0,0 +1,142 @@
+/**
+ * @file client_runtime_benchmark.cpp
+ * @brief Threads, channels and memory of many clients: standalone vs shared runtime
+ *
+ * Creates N clients (default 15, like a plugin host with 15 components),
+ * each subscribing to one signal, and starts them:
+ * - standalone: Client::create(address), a private runtime per client
+ * - shared: Client::create(address, runtime) on one runtime
+ *
+ * Reports the process threads and heap (counted by replacing global
+ * operator new) added by the clients, and the gRPC channels they use.
+ * Without a databroker at the address the streams keep reconnecting,
+ * which exercises the same channels and threads.
+ *
+ * Usage: client_runtime_benchmark [clients] [address]
+ */
+
+#include <kuksa_cpp/client.hpp>
+#include <kuksa_cpp/runtime.hpp>
+#include <kuksa_cpp/testing/test_utils.hpp>
+#include <glog/logging.h>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <dirent.h>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <new>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+std::atomic<std::size_t> g_allocated{0};
+
+} // namespace
+
+// Counting allocator: every block carries its size in a header
+void* operator new(std::size_t size) {
+    auto* block = static_cast<std::size_t*>(std::malloc(size + sizeof(std::max_align_t)));
+    if (!block) {
+        throw std::bad_alloc();
+    }
+    *block = size;
+    g_allocated.fetch_add(size, std::memory_order_relaxed);
+    return reinterpret_cast<char*>(block) + sizeof(std::max_align_t);
+}
+
+void operator delete(void* ptr) noexcept {
+    if (!ptr) {
+        return;
+    }
+    auto* block = reinterpret_cast<std::size_t*>(static_cast<char*>(ptr) - sizeof(std::max_align_t));
+    g_allocated.fetch_sub(*block, std::memory_order_relaxed);
+    std::free(block);
+}
+
+void operator delete(void* ptr, std::size_t) noexcept {
+    operator delete(ptr);
+}
+
+namespace {
+
+std::size_t thread_count() {
+    std::size_t count = 0;
+    if (DIR* dir = opendir("/proc/self/task")) {
+        while (auto* entry = readdir(dir)) {
+            if (entry->d_name[0] != '.') {
+                ++count;
+            }
+        }
+        closedir(dir);
+    }
+    return count;
+}
+
+template<typename Factory>
+void measure(const std::string& label, std::size_t clients, std::size_t channels, Factory&& factory) {
+    auto threads_before = thread_count();
+    auto heap_before = g_allocated.load();
+
+    auto speed = kuksa::TestResolver::signal<float>("Vehicle.Speed", 1);
+    std::vector<std::unique_ptr<kuksa::Client>> created;
+    for (std::size_t i = 0; i < clients; ++i) {
+        auto client = factory();
+        client->subscribe(speed, [](const vss::types::QualifiedValue<float>&) {});
+        if (!client->start().ok()) {
+            std::cerr << label << ": client " << i << " failed to start" << std::endl;
+            return;
+        }
+        created.push_back(std::move(client));
+    }
+    // Let the streams connect (or start retrying)
+    std::this_thread::sleep_for(std::chrono::milliseconds(500));
+
+    auto threads = thread_count() - threads_before;
+    auto heap = g_allocated.load() - heap_before;
+    std::cout << std::left << std::setw(22) << label
+              << std::right << std::setw(8) << threads << " threads"
+              << std::setw(12) << heap / 1024 << " KiB heap"
+              << std::setw(10) << heap / 1024 / clients << " KiB/client"
+              << std::setw(6) << channels << " channels"
+              << std::endl;
+
+    created.clear();
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    google::InitGoogleLogging(argv[0]);
+    FLAGS_minloglevel = 2;
+
+    std::size_t clients = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 15;
+    std::string address = argc > 2 ? argv[2] : "127.0.0.1:1";
+
+    std::cout << clients << " clients against " << address << std::endl;
+
+    // Warm up gRPC's own process-wide threads so they are not counted below
+    measure("warm-up (1 client)", 1, 1, [&]() {
+        return std::move(*kuksa::Client::create(address));
+    });
+
+    measure("standalone", clients, clients, [&]() {
+        return std::move(*kuksa::Client::create(address));
+    });
+
+    std::shared_ptr<kuksa::Runtime> runtime;
+    measure("shared runtime", clients, 1, [&]() {
+        if (!runtime) {
+            runtime = kuksa::Runtime::create();
+        }
+        return std::move(*kuksa::Client::create(address, runtime));
+    });
+
+    auto stats = runtime->stats();
+    std::cout << "shared runtime: " << stats.threads << " thread(s), "
+              << stats.operations << " operations completed" << std::endl;
+    return 0;
+}
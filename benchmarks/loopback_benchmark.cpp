@@ -0,0 +1,91 @@
+/**
+ * @file loopback_benchmark.cpp
+ * @brief Publish-to-callback latency between two clients on a loopback runtime
+ *
+ * A consumer subscribes to a signal and a producer on the same runtime
+ * (RuntimeOptions::loopback) publishes to it. Reports the time from the
+ * start of publish() to the consumer's callback, and the time publish()
+ * takes including the asynchronous forward to the databroker.
+ *
+ * The forward does not affect delivery, so no databroker is needed: without
+ * one at the address the forwards simply fail.
+ *
+ * Usage: loopback_benchmark [iterations] [address]
+ */
+
+#include <kuksa_cpp/client.hpp>
+#include <kuksa_cpp/runtime.hpp>
+#include <kuksa_cpp/testing/test_utils.hpp>
+#include <glog/logging.h>
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+void report(const std::string& label, std::vector<double>& samples) {
+    if (samples.empty()) {
+        std::cout << std::left << std::setw(22) << label << " no samples" << std::endl;
+        return;
+    }
+    std::sort(samples.begin(), samples.end());
+    auto at = [&](double q) { return samples[static_cast<std::size_t>(q * (samples.size() - 1))]; };
+    std::cout << std::left << std::setw(22) << label << std::right << std::fixed << std::setprecision(0)
+              << " p50 " << std::setw(7) << at(0.50) << " ns"
+              << "   p99 " << std::setw(7) << at(0.99) << " ns"
+              << "   max " << std::setw(9) << samples.back() << " ns" << std::endl;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    google::InitGoogleLogging(argv[0]);
+    FLAGS_minloglevel = 3;
+
+    std::size_t iterations = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 20000;
+    std::string address = argc > 2 ? argv[2] : "127.0.0.1:1";
+
+    kuksa::RuntimeOptions options;
+    options.loopback = true;
+    auto runtime = *kuksa::Runtime::create(options);
+
+    auto speed = kuksa::TestResolver::signal<float>("Vehicle.Speed", 1);
+    Clock::time_point published;
+    Clock::time_point received;
+
+    auto consumer = std::move(*kuksa::Client::create(address, runtime));
+    consumer->subscribe(speed, [&](const vss::types::QualifiedValue<float>&) { received = Clock::now(); });
+    if (!consumer->start().ok()) {
+        std::cerr << "consumer failed to start" << std::endl;
+        return 1;
+    }
+    auto producer = std::move(*kuksa::Client::create(address, runtime));
+
+    std::vector<double> delivery;
+    std::vector<double> publish;
+    std::size_t failed = 0;
+    delivery.reserve(iterations);
+    publish.reserve(iterations);
+    for (std::size_t i = 0; i < iterations; ++i) {
+        published = Clock::now();
+        if (!producer->publish(speed, static_cast<float>(i)).ok()) {
+            ++failed;
+            continue;
+        }
+        auto returned = Clock::now();
+        delivery.push_back(std::chrono::duration<double, std::nano>(received - published).count());
+        publish.push_back(std::chrono::duration<double, std::nano>(returned - published).count());
+    }
+
+    std::cout << iterations << " loopback publishes (" << address << ")" << std::endl;
+    report("publish -> callback", delivery);
+    report("publish() incl. forward", publish);
+    std::cout << "looped back: " << runtime->stats().looped_back << ", failed: " << failed << std::endl;
+    return 0;
+}
@@ -0,0 +1,127 @@
+/**
+ * @file priority_lanes_benchmark.cpp
+ * @brief Latency of critical publishes while bulk telemetry saturates the client
+ *
+ * One client publishes a critical signal (a brake light) once per iteration
+ * and measures how long publish() takes, while bulk threads on the same
+ * client publish large float arrays back to back:
+ * - shared lane: every signal on the NORMAL lane (one channel, one connection)
+ * - priority lanes: the brake light on HIGH, the telemetry on BULK
+ *
+ * Uses an in-process stand-in databroker unless an address is given.
+ *
+ * Usage: priority_lanes_benchmark [iterations] [bulk_threads] [address]
+ */
+
+#include "fake_databroker.hpp"
+#include <kuksa_cpp/client.hpp>
+#include <kuksa_cpp/runtime.hpp>
+#include <kuksa_cpp/testing/test_utils.hpp>
+#include <glog/logging.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+// 256 KiB per bulk publish
+constexpr std::size_t BULK_SAMPLES = 64 * 1024;
+
+void report(const std::string& label, std::vector<double>& samples, uint64_t bulk) {
+    if (samples.empty()) {
+        std::cout << std::left << std::setw(16) << label << " no samples" << std::endl;
+        return;
+    }
+    std::sort(samples.begin(), samples.end());
+    auto at = [&](double q) { return samples[static_cast<std::size_t>(q * (samples.size() - 1))]; };
+    std::cout << std::left << std::setw(16) << label << std::right << std::fixed << std::setprecision(1)
+              << " p50 " << std::setw(8) << at(0.50) << " us"
+              << "   p99 " << std::setw(8) << at(0.99) << " us"
+              << "   p99.9 " << std::setw(8) << at(0.999) << " us"
+              << "   max " << std::setw(9) << samples.back() << " us"
+              << "   (" << bulk << " bulk publishes)" << std::endl;
+}
+
+std::vector<double> measure(const std::string& address, bool lanes, std::size_t iterations,
+                            std::size_t bulk_threads, uint64_t& bulk_published) {
+    auto brake = kuksa::TestResolver::signal<bool>("Vehicle.Body.Lights.Brake.IsActive", 1);
+    auto telemetry = kuksa::TestResolver::signal<std::vector<float>>("Vehicle.Telemetry.Samples", 2);
+
+    auto runtime = kuksa::Runtime::create();
+    auto client = std::move(*kuksa::Client::create(address, runtime));
+    if (lanes) {
+        client->set_priority(brake, kuksa::Priority::HIGH);
+        client->set_priority(telemetry, kuksa::Priority::BULK);
+    }
+
+    std::atomic<bool> stopping{false};
+    std::atomic<uint64_t> published{0};
+    std::vector<std::thread> bulk;
+    for (std::size_t i = 0; i < bulk_threads; ++i) {
+        bulk.emplace_back([&]() {
+            std::vector<float> samples(BULK_SAMPLES, 1.0f);
+            while (!stopping) {
+                if (client->publish(telemetry, samples).ok()) {
+                    ++published;
+                }
+            }
+        });
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(200));
+
+    std::vector<double> samples;
+    samples.reserve(iterations);
+    for (std::size_t i = 0; i < iterations; ++i) {
+        auto start = Clock::now();
+        if (client->publish(brake, i % 2 == 0).ok()) {
+            samples.push_back(std::chrono::duration<double, std::micro>(Clock::now() - start).count());
+        }
+        std::this_thread::sleep_for(std::chrono::microseconds(500));
+    }
+
+    stopping = true;
+    for (auto& thread : bulk) {
+        thread.join();
+    }
+    bulk_published = published;
+    return samples;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    google::InitGoogleLogging(argv[0]);
+    FLAGS_minloglevel = 2;
+
+    std::size_t iterations = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 2000;
+    std::size_t bulk_threads = argc > 2 ? std::strtoul(argv[2], nullptr, 10) : 1;
+    std::unique_ptr<FakeDatabroker> broker;
+    std::string address;
+    if (argc > 3) {
+        address = argv[3];
+    } else {
+        broker = std::make_unique<FakeDatabroker>();
+        broker->add_signal("Vehicle.Body.Lights.Brake.IsActive", 1, kuksa::val::v2::DATA_TYPE_BOOLEAN);
+        broker->add_signal("Vehicle.Telemetry.Samples", 2, kuksa::val::v2::DATA_TYPE_FLOAT_ARRAY);
+        address = broker->address();
+    }
+
+    std::cout << iterations << " critical publishes against " << bulk_threads
+              << " bulk publishers via " << address << std::endl;
+
+    uint64_t bulk = 0;
+    auto shared = measure(address, false, iterations, bulk_threads, bulk);
+    report("shared lane", shared, bulk);
+
+    auto lanes = measure(address, true, iterations, bulk_threads, bulk);
+    report("priority lanes", lanes, bulk);
+    return 0;
+}
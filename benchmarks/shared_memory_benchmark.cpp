@@ -0,0 +1,115 @@
+/**
+ * @file shared_memory_benchmark.cpp
+ * @brief Publish-to-callback latency between runtimes: databroker vs shared memory
+ *
+ * A consumer and a producer on separate runtimes (as in two processes on one
+ * host) exchange one signal. Each publish waits for the consumer's callback
+ * before the next, and the time from publish() to the callback is reported:
+ * - grpc: through the databroker (PublishValue, then the SubscribeById stream)
+ * - shared memory: both runtimes open one segment (RuntimeOptions::shared_memory)
+ *
+ * Uses an in-process stand-in databroker unless an address is given.
+ *
+ * Usage: shared_memory_benchmark [iterations] [address]
+ */
+
+#include "fake_databroker.hpp"
+#include <kuksa_cpp/client.hpp>
+#include <kuksa_cpp/runtime.hpp>
+#include <kuksa_cpp/testing/test_utils.hpp>
+#include <glog/logging.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+#include <sys/mman.h>
+#include <unistd.h>
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+void report(const std::string& label, std::vector<double>& samples) {
+    if (samples.empty()) {
+        std::cout << std::left << std::setw(16) << label << " no samples" << std::endl;
+        return;
+    }
+    std::sort(samples.begin(), samples.end());
+    auto at = [&](double q) { return samples[static_cast<std::size_t>(q * (samples.size() - 1))]; };
+    std::cout << std::left << std::setw(16) << label << std::right << std::fixed << std::setprecision(1)
+              << " p50 " << std::setw(8) << at(0.50) << " us"
+              << "   p99 " << std::setw(8) << at(0.99) << " us"
+              << "   max " << std::setw(9) << samples.back() << " us" << std::endl;
+}
+
+std::vector<double> measure(const std::string& address, const kuksa::RuntimeOptions& options, std::size_t iterations) {
+    auto speed = kuksa::TestResolver::signal<float>("Vehicle.Speed", 1);
+    auto producer_runtime = *kuksa::Runtime::create(options);
+    auto consumer_runtime = *kuksa::Runtime::create(options);
+
+    std::atomic<int> received{-1};
+    Clock::time_point arrived;
+    auto consumer = std::move(*kuksa::Client::create(address, consumer_runtime));
+    consumer->subscribe(speed, [&](const vss::types::QualifiedValue<float>& value) {
+        if (value.value) {
+            arrived = Clock::now();
+            received = static_cast<int>(*value.value);
+        }
+    });
+    if (!consumer->start().ok() || !consumer->wait_until_ready(std::chrono::seconds(5)).ok()) {
+        std::cerr << "consumer not ready" << std::endl;
+        return {};
+    }
+    auto producer = std::move(*kuksa::Client::create(address, producer_runtime));
+
+    std::vector<double> samples;
+    samples.reserve(iterations);
+    for (std::size_t i = 0; i < iterations; ++i) {
+        auto published = Clock::now();
+        if (!producer->publish(speed, static_cast<float>(i)).ok()) {
+            continue;
+        }
+        auto deadline = published + std::chrono::seconds(1);
+        while (received.load() != static_cast<int>(i) && Clock::now() < deadline) {
+        }
+        if (received.load() == static_cast<int>(i)) {
+            samples.push_back(std::chrono::duration<double, std::micro>(arrived - published).count());
+        }
+    }
+    return samples;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    google::InitGoogleLogging(argv[0]);
+    FLAGS_minloglevel = 2;
+
+    std::size_t iterations = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 2000;
+    std::unique_ptr<FakeDatabroker> broker;
+    std::string address;
+    if (argc > 2) {
+        address = argv[2];
+    } else {
+        broker = std::make_unique<FakeDatabroker>();
+        broker->add_signal("Vehicle.Speed", 1, kuksa::val::v2::DATA_TYPE_FLOAT);
+        address = broker->address();
+    }
+
+    std::cout << iterations << " publishes between two runtimes via " << address << std::endl;
+
+    auto grpc = measure(address, kuksa::RuntimeOptions{}, iterations);
+    report("grpc", grpc);
+
+    kuksa::RuntimeOptions options;
+    options.shared_memory = "/kuksa-benchmark-" + std::to_string(::getpid());
+    auto shared = measure(address, options, iterations);
+    ::shm_unlink(options.shared_memory.c_str());
+    report("shared memory", shared);
+    return 0;
+}
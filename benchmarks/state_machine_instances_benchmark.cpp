@@ -0,0 +1,172 @@
+/**
+ * @file state_machine_instances_benchmark.cpp
+ * @brief Memory and event throughput of many machines of one shape
+ *
+ * Compares, for N door machines (default 100000):
+ * - one StateMachine per door
+ * - one shared StateMachineDefinition and a MachineInstance per door
+ *
+ * Memory is the heap allocated while creating the machines (counted by
+ * replacing global operator new) plus sizeof of each machine. Throughput
+ * sends every door one event per round: trigger(TriggerId) per machine,
+ * dispatch() per instance, broadcast() and dispatch_batch().
+ *
+ * Usage: state_machine_instances_benchmark [instances] [rounds]
+ */
+
+#include <kuksa_cpp/state_machine/state_machine.hpp>
+#include <kuksa_cpp/state_machine/state_machine_definition.hpp>
+#include <glog/logging.h>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <new>
+#include <string>
+#include <vector>
+
+namespace {
+
+std::atomic<std::size_t> g_allocated{0};
+
+} // namespace
+
+// Counting allocator: every block carries its size in a header
+void* operator new(std::size_t size) {
+    auto* block = static_cast<std::size_t*>(std::malloc(size + sizeof(std::max_align_t)));
+    if (!block) {
+        throw std::bad_alloc();
+    }
+    *block = size;
+    g_allocated.fetch_add(size, std::memory_order_relaxed);
+    return reinterpret_cast<char*>(block) + sizeof(std::max_align_t);
+}
+
+void operator delete(void* ptr) noexcept {
+    if (!ptr) {
+        return;
+    }
+    auto* block = reinterpret_cast<std::size_t*>(static_cast<char*>(ptr) - sizeof(std::max_align_t));
+    g_allocated.fetch_sub(*block, std::memory_order_relaxed);
+    std::free(block);
+}
+
+void operator delete(void* ptr, std::size_t) noexcept {
+    operator delete(ptr);
+}
+
+namespace {
+
+enum class DoorState {
+    Closed,
+    Open,
+    Locked,
+    _Count
+};
+
+template<typename Fn>
+void measure(const std::string& label, std::size_t events, Fn&& fn) {
+    auto start = std::chrono::steady_clock::now();
+    fn();
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    std::cout << std::left << std::setw(34) << label
+              << std::right << std::setw(12) << std::fixed << std::setprecision(0)
+              << events / seconds << " events/s"
+              << std::setw(12) << std::setprecision(1) << seconds * 1e9 / events << " ns/event"
+              << std::endl;
+}
+
+void report_memory(const std::string& label, std::size_t heap, std::size_t inline_bytes, std::size_t count) {
+    double total = static_cast<double>(heap + inline_bytes * count);
+    std::cout << std::left << std::setw(34) << label
+              << std::right << std::setw(12) << std::fixed << std::setprecision(1)
+              << total / (1024.0 * 1024.0) << " MiB"
+              << std::setw(12) << std::setprecision(0) << total / count << " B/machine"
+              << std::endl;
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    google::InitGoogleLogging(argv[0]);
+    FLAGS_logtostderr = 1;
+    FLAGS_minloglevel = google::GLOG_WARNING;  // keep INIT and transition logs out of the measurement
+
+    std::size_t instances = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 100000;
+    std::size_t rounds = argc > 2 ? std::strtoul(argv[2], nullptr, 10) : 20;
+    std::size_t events = instances * rounds;
+
+    std::cout << "State machine instances (" << instances << " doors, " << rounds << " rounds)" << std::endl;
+
+    // One StateMachine per door
+    {
+        using Machine = sdv::StateMachine<DoorState>;
+        auto before = g_allocated.load();
+        std::vector<std::unique_ptr<Machine>> doors;
+        doors.reserve(instances);
+        for (std::size_t i = 0; i < instances; ++i) {
+            auto door = std::make_unique<Machine>("Door", DoorState::Closed);
+            door->add_transition(DoorState::Closed, DoorState::Open, "toggle");
+            door->add_transition(DoorState::Open, DoorState::Closed, "toggle");
+            door->add_transition(DoorState::Closed, DoorState::Locked, "lock");
+            door->add_transition(DoorState::Locked, DoorState::Closed, "unlock");
+            door->set_text_logging(false);
+            doors.push_back(std::move(door));
+        }
+        report_memory("StateMachine per door", g_allocated.load() - before, 0, instances);
+
+        auto toggle = doors.front()->register_trigger("toggle");
+        measure("trigger(TriggerId) per machine", events, [&]() {
+            for (std::size_t r = 0; r < rounds; ++r) {
+                for (auto& door : doors) {
+                    door->trigger(toggle);
+                }
+            }
+        });
+    }
+
+    // One definition, an instance per door
+    {
+        using Definition = sdv::StateMachineDefinition<DoorState>;
+        auto before = g_allocated.load();
+        Definition::Builder builder("Door", DoorState::Closed);
+        auto toggle = builder.add_transition(DoorState::Closed, DoorState::Open, "toggle");
+        builder.add_transition(DoorState::Open, DoorState::Closed, "toggle");
+        builder.add_transition(DoorState::Closed, DoorState::Locked, "lock");
+        builder.add_transition(DoorState::Locked, DoorState::Closed, "unlock");
+        auto definition = builder.build();
+        std::vector<Definition::Instance> doors(instances, definition->make_instance());
+        report_memory("Definition + instance per door", g_allocated.load() - before, 0, instances);
+        std::cout << "  sizeof(MachineInstance) = " << sizeof(Definition::Instance) << " B" << std::endl;
+
+        measure("dispatch() per instance", events, [&]() {
+            for (std::size_t r = 0; r < rounds; ++r) {
+                for (auto& door : doors) {
+                    definition->dispatch(door, toggle);
+                }
+            }
+        });
+
+        measure("broadcast()", events, [&]() {
+            for (std::size_t r = 0; r < rounds; ++r) {
+                definition->broadcast(doors, toggle);
+            }
+        });
+
+        std::vector<Definition::Event> batch;
+        batch.reserve(instances);
+        for (std::size_t i = 0; i < instances; ++i) {
+            batch.push_back({static_cast<std::uint32_t>(i), toggle, nullptr});
+        }
+        measure("dispatch_batch()", events, [&]() {
+            for (std::size_t r = 0; r < rounds; ++r) {
+                definition->dispatch_batch(doors, batch);
+            }
+        });
+    }
+
+    return 0;
+}
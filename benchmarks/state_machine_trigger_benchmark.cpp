@@ -0,0 +1,131 @@
+/**
+ * @file state_machine_trigger_benchmark.cpp
+ * @brief Event throughput of StateMachine::trigger variants
+ *
+ * Compares:
+ * - trigger()                       inline on the caller's thread
+ * - trigger(TriggerId)              inline, interned trigger (no name lookup)
+ * - trigger(TriggerId), trace only  binary trace ring, text logging disabled
+ * - trigger_async().get()           round-trip through the shared executor
+ * - trigger_async() pipelined       N events queued, then wait for the last
+ * - post() event queue              lock-free enqueue, run-to-completion worker
+ * - std::async + trigger()          previous behaviour (one OS thread per event)
+ *
+ * Usage: state_machine_trigger_benchmark [events]
+ */
+
+#include <kuksa_cpp/state_machine/state_machine.hpp>
+#include <glog/logging.h>
+#include <chrono>
+#include <cstdlib>
+#include <future>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+enum class ToggleState {
+    Off,
+    On,
+    _Count
+};
+
+std::unique_ptr<sdv::StateMachine<ToggleState>> make_machine() {
+    auto sm = std::make_unique<sdv::StateMachine<ToggleState>>("Toggle", ToggleState::Off);
+    sm->add_transition(ToggleState::Off, ToggleState::On, "toggle");
+    sm->add_transition(ToggleState::On, ToggleState::Off, "toggle");
+    return sm;
+}
+
+template<typename Fn>
+void run(const std::string& label, int events, Fn&& fn) {
+    auto sm = make_machine();
+
+    auto start = std::chrono::steady_clock::now();
+    fn(*sm, events);
+    auto elapsed = std::chrono::steady_clock::now() - start;
+
+    double seconds = std::chrono::duration<double>(elapsed).count();
+    double ns_per_event = seconds * 1e9 / events;
+
+    std::cout << std::left << std::setw(34) << label
+              << std::right << std::setw(12) << std::fixed << std::setprecision(0)
+              << events / seconds << " events/s"
+              << std::setw(12) << std::setprecision(1) << ns_per_event << " ns/event"
+              << std::endl;
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    google::InitGoogleLogging(argv[0]);
+    FLAGS_logtostderr = 1;
+    FLAGS_minloglevel = google::GLOG_WARNING;  // keep transition logs out of the measurement
+
+    int events = argc > 1 ? std::atoi(argv[1]) : 200000;
+    // Spawning a thread per event is orders of magnitude slower; cap its run
+    int legacy_events = std::min(events, 20000);
+
+    std::cout << "StateMachine trigger throughput (" << events << " events)" << std::endl;
+
+    run("trigger() inline", events, [](auto& sm, int n) {
+        for (int i = 0; i < n; ++i) {
+            sm.trigger("toggle");
+        }
+    });
+
+    run("trigger(TriggerId) inline", events, [](auto& sm, int n) {
+        auto toggle = sm.register_trigger("toggle");
+        for (int i = 0; i < n; ++i) {
+            sm.trigger(toggle);
+        }
+    });
+
+    run("trigger(TriggerId), trace only", events, [](auto& sm, int n) {
+        auto toggle = sm.register_trigger("toggle");
+        sm.enable_trace(1024);
+        sm.set_text_logging(false);
+        for (int i = 0; i < n; ++i) {
+            sm.trigger(toggle);
+        }
+    });
+
+    run("trigger_async().get()", events, [](auto& sm, int n) {
+        for (int i = 0; i < n; ++i) {
+            sm.trigger_async("toggle").get();
+        }
+    });
+
+    run("trigger_async() pipelined", events, [](auto& sm, int n) {
+        std::vector<std::future<bool>> futures;
+        futures.reserve(n);
+        for (int i = 0; i < n; ++i) {
+            futures.push_back(sm.trigger_async("toggle"));
+        }
+        for (auto& f : futures) {
+            f.get();
+        }
+    });
+
+    run("post() event queue", events, [](auto& sm, int n) {
+        auto toggle = sm.register_trigger("toggle");
+        sm.start_event_queue({4096, false});
+        for (int i = 0; i < n; ++i) {
+            while (!sm.post(toggle)) {
+                std::this_thread::yield();
+            }
+        }
+        sm.stop_event_queue();  // drains
+    });
+
+    run("std::async + trigger() (legacy)", legacy_events, [](auto& sm, int n) {
+        for (int i = 0; i < n; ++i) {
+            std::async(std::launch::async, [&sm]() { return sm.trigger("toggle"); }).get();
+        }
+    });
+
+    return 0;
+}
@@ -0,0 +1,146 @@
+/**
+ * @file struct_binding_benchmark.cpp
+ * @brief Reader latency of a 50-signal snapshot while a writer saturates it
+ *
+ * A control loop reads the latest values of 50 float signals, while the
+ * subscription side applies updates as fast as it can:
+ * - mutex copy: the pattern StructBinding replaces, fields updated and the
+ *   struct copied under one std::mutex
+ * - seqlock: StructBinding::dispatch() writes, StructBinding::read() copies
+ *
+ * Updates are fed with dispatch() directly, so no databroker is involved.
+ *
+ * Usage: struct_binding_benchmark [reads] [writer_threads]
+ */
+
+#include <kuksa_cpp/struct_binding.hpp>
+#include <kuksa_cpp/testing/test_utils.hpp>
+#include <glog/logging.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+constexpr int32_t SIGNALS = 50;
+
+// 50 float signals, e.g. the dynamics inputs of a controller
+struct Signals {
+    float s0, s1, s2, s3, s4, s5, s6, s7, s8, s9;
+    float s10, s11, s12, s13, s14, s15, s16, s17, s18, s19;
+    float s20, s21, s22, s23, s24, s25, s26, s27, s28, s29;
+    float s30, s31, s32, s33, s34, s35, s36, s37, s38, s39;
+    float s40, s41, s42, s43, s44, s45, s46, s47, s48, s49;
+};
+
+float Signals::*const FIELD_POINTERS[SIGNALS] = {
+    &Signals::s0, &Signals::s1, &Signals::s2, &Signals::s3, &Signals::s4, &Signals::s5, &Signals::s6, &Signals::s7,
+    &Signals::s8, &Signals::s9, &Signals::s10, &Signals::s11, &Signals::s12, &Signals::s13, &Signals::s14, &Signals::s15,
+    &Signals::s16, &Signals::s17, &Signals::s18, &Signals::s19, &Signals::s20, &Signals::s21, &Signals::s22, &Signals::s23,
+    &Signals::s24, &Signals::s25, &Signals::s26, &Signals::s27, &Signals::s28, &Signals::s29, &Signals::s30, &Signals::s31,
+    &Signals::s32, &Signals::s33, &Signals::s34, &Signals::s35, &Signals::s36, &Signals::s37, &Signals::s38, &Signals::s39,
+    &Signals::s40, &Signals::s41, &Signals::s42, &Signals::s43, &Signals::s44, &Signals::s45, &Signals::s46, &Signals::s47,
+    &Signals::s48, &Signals::s49,
+};
+
+void report(const std::string& label, std::vector<double>& samples, uint64_t updates, double seconds) {
+    std::sort(samples.begin(), samples.end());
+    auto at = [&](double q) { return samples[static_cast<std::size_t>(q * (samples.size() - 1))]; };
+    std::cout << std::left << std::setw(12) << label << std::right << std::fixed << std::setprecision(0)
+              << " p50 " << std::setw(7) << at(0.50) << " ns"
+              << "   p99 " << std::setw(7) << at(0.99) << " ns"
+              << "   p99.9 " << std::setw(8) << at(0.999) << " ns"
+              << "   max " << std::setw(10) << samples.back() << " ns"
+              << "   (" << std::setprecision(1) << updates / seconds / 1e6 << " M updates/s)" << std::endl;
+}
+
+// Runs writers calling update(i) until read() was timed reads times
+template<typename Update, typename Read>
+void measure(const std::string& label, std::size_t reads, std::size_t writer_threads, Update update, Read read) {
+    std::atomic<bool> stopping{false};
+    std::atomic<uint64_t> updates{0};
+    std::vector<std::thread> writers;
+    for (std::size_t w = 0; w < writer_threads; ++w) {
+        writers.emplace_back([&, w]() {
+            uint64_t count = 0;
+            for (int32_t i = static_cast<int32_t>(w); !stopping; ++i, ++count) {
+                update(i % SIGNALS);
+            }
+            updates += count;
+        });
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+
+    std::vector<double> samples;
+    samples.reserve(reads);
+    float checksum = 0.0f;
+    auto begin = Clock::now();
+    for (std::size_t i = 0; i < reads; ++i) {
+        auto start = Clock::now();
+        Signals snapshot = read();
+        samples.push_back(std::chrono::duration<double, std::nano>(Clock::now() - start).count());
+        checksum += snapshot.s0 + snapshot.s49;
+    }
+    double seconds = std::chrono::duration<double>(Clock::now() - begin).count();
+
+    stopping = true;
+    for (auto& writer : writers) {
+        writer.join();
+    }
+    if (checksum < 0.0f) {
+        std::cout << checksum << std::endl;  // keep the reads
+    }
+    report(label, samples, updates, seconds);
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    google::InitGoogleLogging(argv[0]);
+    FLAGS_minloglevel = 2;
+
+    std::size_t reads = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 1000000;
+    std::size_t writer_threads = argc > 2 ? std::strtoul(argv[2], nullptr, 10) : 1;
+    std::cout << reads << " snapshots of " << SIGNALS << " signals against " << writer_threads
+              << " writer thread(s), " << std::thread::hardware_concurrency() << " CPUs" << std::endl;
+
+    std::vector<vss::types::DynamicQualifiedValue> updates;
+    for (int32_t i = 0; i < SIGNALS; ++i) {
+        updates.emplace_back(static_cast<float>(i), vss::types::SignalQuality::VALID);
+    }
+
+    {
+        std::mutex mutex;
+        Signals shared{};
+        measure("mutex copy", reads, writer_threads,
+                [&](int32_t i) {
+                    float value = std::get<float>(updates[i].value);
+                    std::lock_guard<std::mutex> lock(mutex);
+                    shared.*FIELD_POINTERS[i] = value;
+                },
+                [&]() {
+                    std::lock_guard<std::mutex> lock(mutex);
+                    return shared;
+                });
+    }
+
+    {
+        kuksa::StructBinding<Signals> binding;
+        for (int32_t i = 0; i < SIGNALS; ++i) {
+            binding.bind(FIELD_POINTERS[i], kuksa::TestResolver::signal<float>("Vehicle.Signal" + std::to_string(i), i));
+        }
+        measure("seqlock", reads, writer_threads,
+                [&](int32_t i) { binding.dispatch(i, updates[i]); },
+                [&]() { return binding.read(); });
+    }
+    return 0;
+}
@@ -157,9 +157,11 @@ void ClimateProtectionSystem::setup_state_machines() {
     };
 
     // Initialize state machines with callbacks
+    // Only a start the engine machine commanded counts as charging
     protection_sm_ = std::make_unique<ClimateProtectionStateMachine>(
         hvac_controller,
-        engine_starter
+        engine_starter,
+        [this]() { return engine_sm_ && engine_sm_->started_by_us(); }
     );
 
     engine_sm_ = std::make_unique<EngineManagementStateMachine>(
@@ -222,15 +224,16 @@ void ClimateProtectionSystem::subscribe_to_signals() {
         }
     });
 
-    // Important: Engine state
-    client_->subscribe(engine_is_running_, [self](vss::types::QualifiedValue<bool> qv) {
-        using vss::types::SignalQuality;
-        if (qv.quality == SignalQuality::VALID) {
-            self->handle_engine_state_change(*qv.value);
-        } else {
-            LOG(WARNING) << "Engine state unavailable/invalid";
-        }
-    });
+    // Important: Engine state. Only edges reach the state machines; each
+    // ignores the event outside the state that expects it (e.g. engine_running
+    // is only accepted in STARTING). The engine machine is bound first: its
+    // STARTING -> RUNNING_FOR_CHARGE transition is what lets the protection
+    // machine accept engine_started, so a driver start or an engine already
+    // running at startup leaves protection in BATTERY_LOW_ENGINE_START
+    bindings_
+        .on_edge(engine_is_running_, engine_sm_->machine(), "engine_running", "engine_stopped")
+        .on_edge(engine_is_running_, protection_sm_->machine(), "engine_started", "");
+    bindings_.subscribe(*client_);
 
     // Nice-to-have: Coolant temp (can continue with stale/old data)
     client_->subscribe(coolant_temp_, [self](vss::types::QualifiedValue<float> qv) {
@@ -274,29 +277,6 @@ void ClimateProtectionSystem::handle_hvac_state_change(bool is_active) {
     LOG(INFO) << "HVAC state: " << (is_active ? "ACTIVE" : "INACTIVE");
 }
 
-void ClimateProtectionSystem::handle_engine_state_change(bool is_running) {
-    bool was_running = current_engine_running_;
-    current_engine_running_ = is_running;
-
-    if (is_running && !was_running) {
-        LOG(INFO) << "Engine started";
-        // Transition engine state machine
-        if (engine_sm_->current_state() == EngineState::STARTING) {
-            engine_sm_->trigger_engine_running();
-            // Also transition protection state machine
-            if (protection_sm_->current_state() == ProtectionState::BATTERY_LOW_ENGINE_START) {
-                protection_sm_->trigger_engine_started();
-            }
-        }
-    } else if (!is_running && was_running) {
-        LOG(INFO) << "Engine stopped";
-        // Transition engine state machine
-        if (engine_sm_->current_state() == EngineState::STOPPING) {
-            engine_sm_->trigger_engine_stopped();
-        }
-    }
-}
-
 void ClimateProtectionSystem::handle_coolant_temp_change(float temp) {
     current_coolant_temp_ = temp;
     VLOG(1) << "Coolant temperature: " << temp << "°C";
@@ -342,7 +322,7 @@ void ClimateProtectionSystem::enter_safe_mode() {
 
     // 2. If engine is running for charging and we started it, stop it
     //    (can't verify fuel level or charging effectiveness)
-    if (engine_sm_->started_by_us() && current_engine_running_) {
+    if (engine_sm_->started_by_us() && engine_sm_->is_running_for_charge()) {
         LOG(WARNING) << "Safe mode: Stopping engine (cannot verify state)";
         engine_sm_->force_stop();
     }
@@ -418,7 +398,7 @@ void ClimateProtectionSystem::check_fuel_protection() {
             protection_sm_->trigger_fuel_critical();
 
             // If engine is running for charging, stop it
-            if (engine_sm_->current_state() == EngineState::RUNNING_FOR_CHARGE) {
+            if (engine_sm_->is_running_for_charge()) {
                 LOG(WARNING) << "Stopping engine due to low fuel";
                 engine_sm_->trigger_stop_charging();
             }
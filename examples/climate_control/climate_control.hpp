@@ -9,6 +9,7 @@
 #pragma once
 
 #include <kuksa_cpp/kuksa.hpp>
+#include <kuksa_cpp/signal_bindings.hpp>
 #include "climate_protection_state_machine.hpp"
 #include "engine_management_state_machine.hpp"
 #include <iostream>
@@ -36,7 +37,6 @@ private:
     void handle_battery_voltage_change(float voltage);
     void handle_fuel_level_change(float level);
     void handle_hvac_state_change(bool is_active);
-    void handle_engine_state_change(bool is_running);
     void handle_coolant_temp_change(float temp);
     void handle_ambient_temp_change(float temp);
 
@@ -62,6 +62,7 @@ private:
     std::string kuksa_url_;
     std::shared_ptr<kuksa::Resolver> resolver_;
     std::shared_ptr<kuksa::Client> client_;
+    kuksa::SignalBindings bindings_;          // signal edges -> state machine events
 
     // VSS 5.1 Signal handles (inputs - monitoring)
     kuksa::SignalHandle<float> battery_voltage_;           // Vehicle.LowVoltageBattery.CurrentVoltage
@@ -86,7 +87,6 @@ private:
     float current_coolant_temp_ = 20.0f;
     float current_ambient_temp_ = 20.0f;
     bool current_hvac_active_ = false;
-    bool current_engine_running_ = false;
 
     // Signal health tracking (critical signals)
     bool battery_voltage_available_ = false;
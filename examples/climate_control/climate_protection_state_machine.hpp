@@ -56,19 +56,25 @@ class ClimateProtectionStateMachine {
 public:
     using HvacController = std::function<void(bool active)>;
     using EngineStarter = std::function<void()>;
+    using StartCheck = std::function<bool()>;
 
     /**
      * @brief Construct climate protection state machine
      *
      * @param hvac_controller Callback to control HVAC (true=enable, false=disable)
      * @param engine_starter Callback to start engine for charging
+     * @param started_for_charging Whether the running engine is one the system
+     *        started for charging; engine_started is ignored otherwise (driver
+     *        start, engine already running at startup)
      */
-    explicit ClimateProtectionStateMachine(
+    ClimateProtectionStateMachine(
         HvacController hvac_controller,
-        EngineStarter engine_starter
+        EngineStarter engine_starter,
+        StartCheck started_for_charging
     )
         : hvac_controller_(std::move(hvac_controller))
         , engine_starter_(std::move(engine_starter))
+        , started_for_charging_(std::move(started_for_charging))
     {
         init_state_machine();
     }
@@ -80,6 +86,13 @@ public:
         return state_machine_->current_state();
     }
 
+    /**
+     * @brief Underlying state machine (for signal bindings and observers)
+     */
+    sdv::StateMachine<ProtectionState>& machine() {
+        return *state_machine_;
+    }
+
     /**
      * @brief Check if in normal monitoring state
      */
@@ -132,7 +145,7 @@ public:
      * @brief Trigger engine started event
      *
      * Transitions:
-     * - BATTERY_LOW_ENGINE_START -> ENGINE_CHARGING
+     * - BATTERY_LOW_ENGINE_START -> ENGINE_CHARGING, if started_for_charging
      */
     void trigger_engine_started() {
         state_machine_->trigger("engine_started");
@@ -207,7 +220,8 @@ private:
         state_machine_->add_transition(
             ProtectionState::BATTERY_LOW_ENGINE_START,
             ProtectionState::ENGINE_CHARGING,
-            "engine_started"
+            "engine_started",
+            [this](const sdv::Context&) { return started_for_charging_(); }
         );
 
         state_machine_->add_transition(
@@ -244,4 +258,5 @@ private:
     std::unique_ptr<sdv::StateMachine<ProtectionState>> state_machine_;
     HvacController hvac_controller_;
     EngineStarter engine_starter_;
+    StartCheck started_for_charging_;
 };
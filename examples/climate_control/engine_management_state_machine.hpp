@@ -17,6 +17,7 @@ enum class EngineState {
     STOPPED,                       // Engine not running
     STARTING,                      // Engine start command sent
     RUNNING_FOR_CHARGE,           // Engine running for battery charging
+    RUNNING_MIN_RUNTIME_MET,      // Still charging, minimum runtime elapsed
     STOPPING,                      // Engine stop command sent
     _Count
 };
@@ -29,6 +30,7 @@ inline std::string engine_state_name(EngineState state) {
         case EngineState::STOPPED:              return "STOPPED";
         case EngineState::STARTING:             return "STARTING";
         case EngineState::RUNNING_FOR_CHARGE:   return "RUNNING_FOR_CHARGE";
+        case EngineState::RUNNING_MIN_RUNTIME_MET: return "RUNNING_MIN_RUNTIME_MET";
         case EngineState::STOPPING:             return "STOPPING";
         default:                                return "UNKNOWN";
     }
@@ -40,13 +42,15 @@ inline std::string engine_state_name(EngineState state) {
  * Wraps the generic StateMachine<EngineState> to provide:
  * - Type-safe trigger methods instead of string-based triggers
  * - Encapsulated engine control actions
- * - Runtime tracking for minimum engine runtime enforcement
+ * - Minimum engine runtime enforced by a state timeout (no polling)
  * - Observability via state machine logs
  *
  * State flow:
  *   STOPPED --[start_for_charge]--> STARTING
  *   STARTING --[engine_running]--> RUNNING_FOR_CHARGE
- *   RUNNING_FOR_CHARGE --[stop_charging]--> STOPPING
+ *   RUNNING_FOR_CHARGE --[min_runtime_elapsed (timeout)]--> RUNNING_MIN_RUNTIME_MET
+ *   RUNNING_FOR_CHARGE --[stop_charging]--> STOPPING  (emergency, e.g. low fuel)
+ *   RUNNING_MIN_RUNTIME_MET --[stop_charging]--> STOPPING
  *   STOPPING --[engine_stopped]--> STOPPED
  */
 class EngineManagementStateMachine {
@@ -77,11 +81,20 @@ public:
         return state_machine_->current_state();
     }
 
+    /**
+     * @brief Underlying state machine (for signal bindings and observers)
+     */
+    sdv::StateMachine<EngineState>& machine() {
+        return *state_machine_;
+    }
+
     /**
      * @brief Check if engine is running for charge
      */
     bool is_running_for_charge() const {
-        return state_machine_->current_state() == EngineState::RUNNING_FOR_CHARGE;
+        auto state = state_machine_->current_state();
+        return state == EngineState::RUNNING_FOR_CHARGE ||
+               state == EngineState::RUNNING_MIN_RUNTIME_MET;
     }
 
     /**
@@ -102,11 +115,7 @@ public:
      * @brief Check if engine has met minimum runtime requirement
      */
     bool has_met_minimum_runtime() const {
-        if (!engine_started_by_us_) {
-            return false;
-        }
-        auto runtime = std::chrono::steady_clock::now() - engine_start_time_;
-        return runtime >= min_runtime_;
+        return state_machine_->current_state() == EngineState::RUNNING_MIN_RUNTIME_MET;
     }
 
     /**
@@ -152,6 +161,7 @@ public:
      *
      * Transitions:
      * - RUNNING_FOR_CHARGE -> STOPPING
+     * - RUNNING_MIN_RUNTIME_MET -> STOPPING
      */
     void trigger_stop_charging() {
         state_machine_->trigger("stop_charging");
@@ -206,6 +216,12 @@ private:
                 LOG(INFO) << "Engine: Running for battery charging";
                 engine_started_by_us_ = true;
                 engine_start_time_ = std::chrono::steady_clock::now();
+            })
+            .timeout(min_runtime_, "min_runtime_elapsed");
+
+        state_machine_->define_state(EngineState::RUNNING_MIN_RUNTIME_MET)
+            .on_entry([]() {
+                LOG(INFO) << "Engine: Minimum runtime reached";
             });
 
         state_machine_->define_state(EngineState::STOPPING)
@@ -229,6 +245,18 @@ private:
 
         state_machine_->add_transition(
             EngineState::RUNNING_FOR_CHARGE,
+            EngineState::RUNNING_MIN_RUNTIME_MET,
+            "min_runtime_elapsed"
+        );
+
+        state_machine_->add_transition(
+            EngineState::RUNNING_FOR_CHARGE,
+            EngineState::STOPPING,
+            "stop_charging"
+        );
+
+        state_machine_->add_transition(
+            EngineState::RUNNING_MIN_RUNTIME_MET,
             EngineState::STOPPING,
             "stop_charging"
         );
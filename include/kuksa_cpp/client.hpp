@@ -18,6 +18,9 @@
 
 #include <kuksa_cpp/types.hpp>
 #include <kuksa_cpp/error.hpp>
+#include <kuksa_cpp/runtime.hpp>
+#include <kuksa_cpp/signal_cells.hpp>
+#include <kuksa_cpp/signal_queue.hpp>
 #include <glog/logging.h>
 #include <absl/strings/str_format.h>
 #include <string>
@@ -25,8 +28,10 @@
 #include <map>
 #include <functional>
 #include <memory>
+#include <mutex>
 #include <type_traits>
 #include <optional>
+#include <cstdint>
 
 namespace kuksa {
 
@@ -107,6 +112,14 @@ std::optional<T> try_extract_value(const vss::types::Value& value) {
 
 } // namespace detail
 
+/**
+ * @brief Behaviour of a client connected to redundant databrokers
+ */
+struct FailoverOptions {
+    /// Publish to every databroker in parallel instead of only the active one
+    bool publish_to_all = false;
+};
+
 /**
  * @brief Unified VSS client with dual streams
  *
@@ -115,7 +128,7 @@ std::optional<T> try_extract_value(const vss::types::Value& value) {
  * - Two logical streams:
  *   1. OpenProviderStream (bidirectional) - for actuators/sensors
  *   2. SubscribeById (unidirectional) - for subscriptions
- * - Batch publish support via PublishValuesRequest
+ * - Batch publish support (one PublishValue RPC per value)
  * - Thread-safe batch operations
  *
  * Example usage:
@@ -171,6 +184,51 @@ public:
         const std::string& databroker_address
     );
 
+    /**
+     * @brief Factory method to create a client on a shared runtime
+     *
+     * The client uses the runtime's channel for databroker_address and runs
+     * its streams on the runtime's threads instead of owning either. The
+     * single-argument create() is equivalent to passing a new one-thread
+     * runtime.
+     *
+     * @param databroker_address Address of KUKSA databroker (e.g., "localhost:55555")
+     * @param runtime Runtime shared with other clients
+     * @return Result containing Client instance, or InvalidArgumentError if runtime is null
+     */
+    static Result<std::unique_ptr<Client>> create(
+        const std::string& databroker_address,
+        std::shared_ptr<Runtime> runtime
+    );
+
+    /**
+     * @brief Factory method to create a client of redundant databrokers
+     *
+     * The databrokers are listed in order of preference and must serve the
+     * same signals with the same ids. Subscriptions are opened on all of
+     * them; updates of the active one (initially the first) are delivered.
+     * When its stream fails, the client switches to a standby on the standby's
+     * next update, without resubscribing, and back once the preferred
+     * databroker delivers again. get(), set() and publish() go to the active
+     * databroker and try the others if it is unavailable.
+     *
+     * With FailoverOptions::publish_to_all, publish() sends to all databrokers
+     * in parallel and succeeds if any of them accepts the value.
+     *
+     * The provider stream (serve_actuator) uses the first databroker only.
+     *
+     * @param databroker_addresses Databroker addresses, most preferred first
+     * @param runtime Runtime shared with other clients
+     * @param options Failover behaviour
+     * @return Result containing Client instance, or InvalidArgumentError if
+     *         no address is given or runtime is null
+     */
+    static Result<std::unique_ptr<Client>> create(
+        const std::vector<std::string>& databroker_addresses,
+        std::shared_ptr<Runtime> runtime,
+        const FailoverOptions& options = {}
+    );
+
     // ========================================================================
     // ACTUATOR PROVIDER API
     // ========================================================================
@@ -193,7 +251,7 @@ public:
      * @param callback Called when actuation request arrives
      * @throws std::logic_error if client is already running
      *
-     * @warning The callback is executed on the provider gRPC thread.
+     * @warning The callback is executed on a runtime thread (see Runtime).
      *          DO NOT call publish() from inside the callback - it will cause
      *          gRPC errors (TOO_MANY_OPERATIONS). Instead, queue work to a
      *          separate thread/state machine that will publish later.
@@ -435,7 +493,7 @@ public:
 
     // NOTE: Sensors do NOT need registration! KUKSA doesn't enforce sensor
     // ownership - any client can publish sensor values at any time using
-    // PublishValuesRequest. Only actuators need registration via
+    // PublishValue. Only actuators need registration via
     // ProvideActuationRequest because actuation requires bidirectional
     // communication (receiving target values from KUKSA).
 
@@ -448,6 +506,9 @@ public:
      *
      * Thread-safe. Can be called from any thread after start().
      *
+     * On a loopback runtime, subscribers in this process are called before
+     * this returns and the databroker is updated asynchronously (see Runtime).
+     *
      * @param handle Signal handle
      * @param qvalue Qualified value with quality indicator
      * @return Status indicating success or failure
@@ -511,18 +572,19 @@ public:
     };
 
     /**
-     * @brief Batch publish multiple values (efficient!)
+     * @brief Publish multiple values
      *
-     * Uses PublishValuesRequest on the provider stream to send multiple
-     * values in a single RPC. Much more efficient than multiple publish() calls.
+     * Sends one PublishValue RPC per value, HIGH priority signals first, and
+     * blocks until all of them completed. A failed value does not stop the
+     * others from being sent.
      *
      * Thread-safe. Can be called from any thread after start().
      *
      * @param values List of {handle, value} pairs to publish
-     * @param callback Optional callback invoked when batch completes (on provider thread)
-     *                 - Receives map of signal_id -> Status for each signal
-     *                 - Only called for signals with errors (empty map = all succeeded)
-     * @return Status indicating if batch was queued successfully
+     * @param callback Optional callback invoked before returning (on the calling thread)
+     *                 - Receives map of signal_id -> Status
+     *                 - Only contains signals with errors (empty map = all succeeded)
+     * @return OK if every value was published
      *
      * Example:
      * @code
@@ -583,7 +645,7 @@ public:
      *
      * Must be called before start().
      *
-     * @warning The callback is executed on the subscription thread.
+     * @warning The callback is executed on a runtime thread (see Runtime).
      *          It MUST NOT block or perform long-running operations.
      *          Do NOT call publish() from inside the callback - queue work to another thread.
      *
@@ -601,6 +663,54 @@ public:
      */
     void subscribe(const DynamicSignalHandle& signal, std::function<void(const vss::types::DynamicQualifiedValue&)> callback);
 
+    /**
+     * @brief Subscribe into a queue that the application polls
+     *
+     * Instead of running a callback, every update (including the initial
+     * value) is appended to the returned SignalQueue, which one application
+     * thread drains with poll() at its own cadence - e.g. once per tick of
+     * a control loop - without locks, allocation or system calls. Updates
+     * that arrive while the queue is full are dropped and counted in
+     * SignalQueue::overflows().
+     *
+     * Replaces any other subscription of this client to signal. Must be
+     * called before start().
+     *
+     * @param capacity Minimum queue size, rounded up to a power of two
+     * @throws std::logic_error if client is already running
+     */
+    template<typename T>
+    std::shared_ptr<SignalQueue<T>> subscribe_queue(const SignalHandle<T>& signal, size_t capacity = 64);
+
+    /**
+     * @brief Subscribe to the latest value only
+     *
+     * Like subscribe_queue(), but the returned LatestSignal only keeps the
+     * most recent update: poll() yields it once, and updates replaced before
+     * being polled are counted in LatestSignal::overflows().
+     *
+     * @throws std::logic_error if client is already running
+     */
+    template<typename T>
+    std::shared_ptr<LatestSignal<T>> subscribe_latest(const SignalHandle<T>& signal);
+
+    /**
+     * @brief Subscribe into a cell that any thread can read without locks
+     *
+     * Every update overwrites the returned SignalCell through a seqlock;
+     * readers call load() for a consistent copy, or load_if_changed() to
+     * skip unchanged values. For several signals read together, see
+     * StructBinding. Only for trivially copyable types (no strings or
+     * arrays).
+     *
+     * Replaces any other subscription of this client to signal. Must be
+     * called before start().
+     *
+     * @throws std::logic_error if client is already running
+     */
+    template<typename T>
+    std::shared_ptr<SignalCell<T>> subscribe_cell(const SignalHandle<T>& signal);
+
     /**
      * @brief Unsubscribe from a signal
      */
@@ -626,6 +736,93 @@ public:
      */
     virtual size_t subscription_count() const = 0;
 
+    // ========================================================================
+    // PRIORITY LANES
+    // ========================================================================
+
+    /**
+     * @brief Move a signal's traffic to the lane of priority
+     *
+     * Signals default to Priority::NORMAL. Every priority in use gets its own
+     * gRPC channel (a separate connection) and its own subscription stream,
+     * shared with the runtime's other clients of that lane, so gets, sets,
+     * publishes and updates of HIGH signals never queue behind BULK ones.
+     * publish_batch() sends HIGH values first, and the provider stream runs
+     * on the lane of the most critical served actuator. Subscription
+     * callbacks are dispatched in priority order (see Runtime).
+     *
+     * Must be called before start() (and before publishing from other threads).
+     *
+     * @throws std::logic_error if client is already running
+     */
+    template<typename T>
+    void set_priority(const SignalHandle<T>& signal, Priority priority) {
+        set_priority_impl(signal.id(), priority);
+    }
+
+    void set_priority(const DynamicSignalHandle& signal, Priority priority) {
+        set_priority_impl(signal.id(), priority);
+    }
+
+    // ========================================================================
+    // EVENT LOOP INTEGRATION
+    // ========================================================================
+
+    /// Runs a task on the application's event loop, e.g. asio::post(io, task)
+    using Executor = std::function<void(std::function<void()>)>;
+
+    /**
+     * @brief Queue callbacks for dispatch_pending() and signal them on an eventfd
+     *
+     * Subscription and actuation callbacks then run on the thread that calls
+     * dispatch_pending(), typically an event loop that watches the returned
+     * descriptor for readability (asio::posix::stream_descriptor, uv_poll_t,
+     * epoll). The descriptor is written once per batch, not once per update.
+     * It belongs to the client and stays valid until the client is destroyed.
+     * A callback may destroy the client: the callbacks still queued are then
+     * dropped.
+     *
+     * Must be called before start().
+     *
+     * @return The eventfd, FailedPreconditionError if the client is running
+     *         or callbacks already go elsewhere, or an error if no eventfd
+     *         could be created
+     */
+    virtual Result<int> enable_event_fd() {
+        return absl::UnimplementedError("Event loop integration is not supported");
+    }
+
+    /**
+     * @brief Hand callbacks to executor instead of running them on runtime threads
+     *
+     * When callbacks become pending, executor is given one task that runs all
+     * of them; further updates join that batch until it runs. As with
+     * enable_event_fd(), a callback may destroy the client. Must be called
+     * before start().
+     *
+     * @return FailedPreconditionError if the client is running or callbacks
+     *         already go elsewhere
+     */
+    virtual Status set_executor(Executor executor) {
+        (void)executor;
+        return absl::UnimplementedError("Event loop integration is not supported");
+    }
+
+    /**
+     * @brief Run queued callbacks on the calling thread (see enable_event_fd())
+     *
+     * Called from one of those callbacks it runs nothing and returns 0; the
+     * batch in progress continues when the callback returns.
+     *
+     * @param max_callbacks Run at most this many; the eventfd stays readable
+     *        while more are queued
+     * @return Number of callbacks run
+     */
+    virtual size_t dispatch_pending(size_t max_callbacks = SIZE_MAX) {
+        (void)max_callbacks;
+        return 0;
+    }
+
     // ========================================================================
     // LIFECYCLE
     // ========================================================================
@@ -633,9 +830,10 @@ public:
     /**
      * @brief Start both provider and subscriber streams
      *
-     * Launches threads as needed:
-     * 1. Provider thread - if actuators registered (manages OpenProviderStream)
-     * 2. Subscriber thread - if subscriptions registered (manages SubscribeById)
+     * Opens streams as needed, driven by the runtime's threads:
+     * 1. Provider stream - if actuators registered (OpenProviderStream)
+     * 2. Subscriber stream - if subscriptions registered (SubscribeById),
+     *    shared with the runtime's other clients (see Runtime)
      *
      * Must be called after registering actuators and/or subscriptions.
      *
@@ -711,6 +909,9 @@ protected:
 
     virtual bool unsubscribe_impl(int32_t signal_id) = 0;
 
+    // Clients without lanes treat every signal alike
+    virtual void set_priority_impl(int32_t /*signal_id*/, Priority /*priority*/) {}
+
     /**
      * @brief Create a typed SignalHandle (for derived classes)
      */
@@ -885,6 +1086,42 @@ void Client::subscribe(const SignalHandle<T>& signal, typename SignalHandle<T>::
     });
 }
 
+// Queues and cells have a single producer; updates of one signal can
+// arrive on several threads (runtime threads, loopback publishers), so
+// writes are serialized here. The reading side never takes this lock.
+template<typename T>
+std::shared_ptr<SignalQueue<T>> Client::subscribe_queue(const SignalHandle<T>& signal, size_t capacity) {
+    auto queue = std::make_shared<SignalQueue<T>>(capacity);
+    auto producer = std::make_shared<std::mutex>();
+    subscribe(signal, [queue, producer](vss::types::QualifiedValue<T> qvalue) {
+        std::lock_guard<std::mutex> lock(*producer);
+        queue->push(std::move(qvalue));
+    });
+    return queue;
+}
+
+template<typename T>
+std::shared_ptr<LatestSignal<T>> Client::subscribe_latest(const SignalHandle<T>& signal) {
+    auto latest = std::make_shared<LatestSignal<T>>();
+    auto producer = std::make_shared<std::mutex>();
+    subscribe(signal, [latest, producer](vss::types::QualifiedValue<T> qvalue) {
+        std::lock_guard<std::mutex> lock(*producer);
+        latest->push(std::move(qvalue));
+    });
+    return latest;
+}
+
+template<typename T>
+std::shared_ptr<SignalCell<T>> Client::subscribe_cell(const SignalHandle<T>& signal) {
+    auto cell = std::make_shared<SignalCell<T>>();
+    auto writer = std::make_shared<std::mutex>();
+    subscribe(signal, [cell, writer](vss::types::QualifiedValue<T> qvalue) {
+        std::lock_guard<std::mutex> lock(*writer);
+        cell->store(qvalue);
+    });
+    return cell;
+}
+
 inline void Client::subscribe(const DynamicSignalHandle& signal, std::function<void(const vss::types::DynamicQualifiedValue&)> callback) {
     // DynamicSignalHandle is always valid if it exists (created by Resolver)
     // We need to wrap it in a shared_ptr for subscribe_impl
@@ -0,0 +1,175 @@
+/**
+ * @file runtime.hpp
+ * @brief Process-wide gRPC runtime shared by several clients
+ */
+
+#pragma once
+
+#include <kuksa_cpp/error.hpp>
+#include <kuksa_cpp/types.hpp>
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+
+namespace kuksa {
+
+/**
+ * @brief Configuration of a Runtime
+ */
+struct RuntimeOptions {
+    /// Completion queue threads (at least one)
+    size_t threads = 1;
+
+    /// Hand publishes to subscribers in this process directly (see Runtime)
+    bool loopback = false;
+
+    /// POSIX shared memory segment (e.g. "/kuksa-vehicle") for publishes
+    /// between processes on this host (see Runtime); empty to disable
+    std::string shared_memory;
+
+    /// HTTP/2 keepalive ping interval on the runtime's channels, also while
+    /// no call is active, so a databroker that hangs or is cut off without
+    /// closing the connection is noticed; zero disables keepalive
+    std::chrono::milliseconds keepalive_interval{10000};
+
+    /// How long a ping may go unanswered before the connection is closed,
+    /// failing its streams so they reconnect
+    std::chrono::milliseconds keepalive_timeout{5000};
+};
+
+/**
+ * @brief Delay from receiving a subscription update to running its callback
+ *
+ * Percentiles are the upper bounds of power-of-two microsecond buckets.
+ */
+struct DispatchLatency {
+    uint64_t callbacks = 0;  ///< Callbacks run
+    double p50_us = 0;
+    double p99_us = 0;
+    double max_us = 0;
+};
+
+/**
+ * @brief Counters of a Runtime
+ */
+struct RuntimeStats {
+    size_t channels = 0;      ///< Pooled gRPC channels (one per databroker address and priority lane)
+    size_t clients = 0;       ///< Client attachments to those channels
+    size_t threads = 0;       ///< Completion queue threads
+    size_t streams = 0;       ///< Open provider and subscription streams
+    uint64_t operations = 0;  ///< Asynchronous operations completed so far
+    size_t subscriptions = 0; ///< SubscribeById streams shared by the clients' subscriptions
+    size_t signals = 0;       ///< Distinct signals subscribed to
+    uint64_t decoded = 0;     ///< Subscription updates decoded (once per signal update)
+    uint64_t delivered = 0;   ///< Subscription callbacks invoked (once per subscriber)
+    uint64_t looped_back = 0; ///< Publishes delivered in process (loopback)
+    uint64_t shared_written = 0;   ///< Publishes written to shared memory
+    uint64_t shared_received = 0;  ///< Updates received from shared memory
+    uint64_t shared_dropped = 0;   ///< Publishes not written because their slot stayed locked
+    uint64_t paused_reads = 0;     ///< Times a subscription stream stopped reading until its queued callbacks drained
+    std::array<DispatchLatency, PRIORITY_COUNT> dispatch;  ///< Per priority class, indexed by Priority
+};
+
+/**
+ * @brief Channels, completion queue and stream threads shared by clients
+ *
+ * Without a runtime every client owns a gRPC channel and the threads that
+ * drive its streams. A host that loads many components, each with its own
+ * Client, ends up with one channel and up to two threads per component.
+ *
+ * Clients created on a shared runtime are lightweight views instead:
+ * - clients for the same address share one channel (one HTTP/2 connection)
+ * - all provider and subscriber streams run asynchronously on one
+ *   completion queue, polled by a fixed number of runtime threads
+ * - subscriptions are multiplexed: a signal subscribed by several clients
+ *   is on one SubscribeById stream and each update is decoded once, then
+ *   handed to every subscribing client
+ *
+ * Usage:
+ * @code
+ *   auto runtime = kuksa::Runtime::create();
+ *   auto climate = *kuksa::Client::create("localhost:55555", runtime);
+ *   auto doors = *kuksa::Client::create("localhost:55555", runtime);
+ *   // ... 15 components, still 1 channel and 1 stream thread
+ * @endcode
+ *
+ * Subscription and actuation callbacks run on the runtime threads. With a
+ * single thread, a slow callback delays every client on the runtime, so
+ * callbacks should hand work off rather than block.
+ *
+ * Loopback (RuntimeOptions::loopback): a publish() to a signal that a client
+ * on the runtime subscribes to is handed to the subscribers' callbacks
+ * directly, without serialization, and forwarded to the databroker
+ * asynchronously. publish() then returns once the callbacks ran; forwarding
+ * errors are only logged. The databroker's copy of the update is recognised
+ * and not delivered a second time. Loopback callbacks run on the publishing
+ * thread, not on a runtime thread.
+ *
+ * Shared memory (RuntimeOptions::shared_memory): runtimes in different
+ * processes that open the same segment exchange publishes through it. A
+ * publish() also stores the value in the segment (in native form, no
+ * protobuf) and wakes the other runtimes, whose subscribers get it without
+ * the databroker round trip. The databroker stays the authority: publish()
+ * still goes to it and reports its result, and the copy it sends back to
+ * subscribers that already got the value is dropped. The value is stored
+ * before the databroker answers, so other runtimes also get values it then
+ * rejects; only the publisher sees the error. Updates from shared
+ * memory are delivered on the runtime's shared memory watcher thread. Use
+ * one segment per databroker; string arrays, structs and values larger than
+ * a slot only travel through the databroker. The segment outlives the
+ * runtimes; remove it with shm_unlink() when no longer needed.
+ *
+ * Priorities (Client::set_priority): once a client uses a lane other than
+ * NORMAL, subscription callbacks are scheduled rather than run as each
+ * update arrives. Pending HIGH callbacks run before NORMAL ones and those
+ * before BULK ones, across all streams; a long frame of lower priority is
+ * delivered in slices so that a HIGH update arriving meanwhile overtakes it.
+ * With several runtime threads, a slow BULK callback does not hold back
+ * the other classes. A class whose callbacks fall behind stops reading its
+ * streams until they catch up, so the databroker is slowed down by gRPC
+ * flow control instead of updates piling up in memory. RuntimeStats::dispatch reports the dispatch latency of
+ * each class. Loopback and shared memory updates are not scheduled: they are
+ * delivered as they arrive, on the threads named above, whatever their
+ * priority, and are not counted in RuntimeStats::dispatch.
+ *
+ * Clients keep their runtime alive; the runtime stops its threads when the
+ * last client and the last external reference are gone. Do not release the
+ * last reference from inside a callback.
+ */
+class Runtime {
+public:
+    /**
+     * @brief Create a runtime
+     *
+     * @param threads Completion queue threads (at least one)
+     */
+    static std::shared_ptr<Runtime> create(size_t threads = 1);
+
+    /**
+     * @brief Create a runtime with options (e.g. loopback, shared memory)
+     *
+     * @return Runtime, or an error if the shared memory segment cannot be opened
+     */
+    static Result<std::shared_ptr<Runtime>> create(const RuntimeOptions& options);
+
+    ~Runtime();
+
+    Runtime(const Runtime&) = delete;
+    Runtime& operator=(const Runtime&) = delete;
+
+    RuntimeStats stats() const;
+
+private:
+    friend class VSSClientImpl;
+    friend class SubscriptionHub;
+    class Impl;
+
+    explicit Runtime(const RuntimeOptions& options);
+
+    std::unique_ptr<Impl> impl_;
+};
+
+} // namespace kuksa
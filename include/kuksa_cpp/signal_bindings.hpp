@@ -0,0 +1,289 @@
+/**
+ * @file signal_bindings.hpp
+ * @brief Declarative signal-to-event bindings for state machines
+ */
+
+#pragma once
+
+#include "client.hpp"
+#include <kuksa_cpp/state_machine/transition_table.hpp>
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace kuksa {
+
+/**
+ * @brief Hysteresis band for a threshold binding
+ *
+ * The signal is "above" once a value exceeds high and "below" once a value
+ * drops under low; values inside [low, high] keep the previous side. With
+ * low == high this is a plain threshold.
+ */
+template<typename T>
+struct Hysteresis {
+    T low;
+    T high;
+};
+
+/**
+ * @brief Counters of a SignalBindings instance
+ */
+struct SignalBindingStats {
+    uint64_t updates = 0;     ///< Binding evaluations (one per update per binding)
+    uint64_t events = 0;      ///< Edges posted to a state machine
+    uint64_t suppressed = 0;  ///< Evaluations that changed nothing
+};
+
+/**
+ * @brief Maps signal updates to state machine events
+ *
+ * Each binding turns a stream of values into edges: a threshold crossing
+ * with hysteresis, a bool rising/falling edge, or the loss of a valid
+ * value. Bindings are evaluated on the subscription thread and only an
+ * actual edge reaches the machine, as machine.post(TriggerId): with the
+ * machine's event queue running that is a lock-free enqueue, otherwise the
+ * transition runs inline on the subscription thread. Updates that change
+ * nothing never touch the machine.
+ *
+ * Event names are interned with the machine when the binding is added. An
+ * empty event name means "no event" for that direction. The first valid
+ * value that has a side posts its event, so the machine learns the initial
+ * condition: any value for an edge, a value outside the band for a
+ * threshold (values inside the band leave the side unknown until one
+ * leaves it). An invalid or missing value resets the side.
+ *
+ * All bindings of a signal share one subscription, so several machines
+ * (or several bindings on one machine) can follow the same signal.
+ *
+ * Usage:
+ * @code
+ *   kuksa::SignalBindings bindings;
+ *   bindings
+ *       .on_threshold(battery_voltage, protection_sm, kuksa::Hysteresis<float>{23.6f, 24.5f},
+ *                     "battery_recovered", "battery_critical")
+ *       .on_edge(engine_running, engine_sm, "engine_running", "engine_stopped")
+ *       .on_unavailable(battery_voltage, protection_sm, "battery_signal_lost");
+ *   bindings.subscribe(*client);   // before client->start()
+ * @endcode
+ *
+ * Add all bindings before subscribe(). The bound machines must outlive
+ * the client's subscriptions.
+ */
+class SignalBindings {
+public:
+    SignalBindings() : state_(std::make_shared<State>()) {}
+
+    /**
+     * @brief Post above_event when value rises over band.high, below_event
+     *        when it falls under band.low
+     */
+    template<typename T, typename Machine>
+    SignalBindings& on_threshold(const SignalHandle<T>& signal, Machine& machine, Hysteresis<T> band,
+                                 const std::string& above_event, const std::string& below_event) {
+        static_assert(std::is_arithmetic_v<T>, "Threshold bindings need a numeric signal");
+        if (band.low > band.high) {
+            throw std::invalid_argument("Hysteresis band for " + signal.path() + " has low > high");
+        }
+        auto above = intern(machine, above_event);
+        auto below = intern(machine, below_event);
+        auto side = Side::UNKNOWN;
+        add(signal, [&machine, band, above, below, side](const vss::types::DynamicQualifiedValue& qv) mutable {
+            auto value = valid_value<T>(qv);
+            if (!value) {
+                side = Side::UNKNOWN;
+                return false;
+            }
+            if (*value > band.high && side != Side::ABOVE) {
+                side = Side::ABOVE;
+                return post(machine, above);
+            }
+            if (*value < band.low && side != Side::BELOW) {
+                side = Side::BELOW;
+                return post(machine, below);
+            }
+            return false;
+        });
+        return *this;
+    }
+
+    /**
+     * @brief Post rising_event when a bool signal becomes true, falling_event
+     *        when it becomes false
+     */
+    template<typename Machine>
+    SignalBindings& on_edge(const SignalHandle<bool>& signal, Machine& machine,
+                            const std::string& rising_event, const std::string& falling_event) {
+        auto rising = intern(machine, rising_event);
+        auto falling = intern(machine, falling_event);
+        auto side = Side::UNKNOWN;
+        add(signal, [&machine, rising, falling, side](const vss::types::DynamicQualifiedValue& qv) mutable {
+            auto value = valid_value<bool>(qv);
+            if (!value) {
+                side = Side::UNKNOWN;
+                return false;
+            }
+            auto next = *value ? Side::ABOVE : Side::BELOW;
+            if (next == side) {
+                return false;
+            }
+            side = next;
+            return post(machine, *value ? rising : falling);
+        });
+        return *this;
+    }
+
+    /**
+     * @brief Post event when the signal stops delivering valid values
+     *
+     * Fires once per loss: on the first update that is not VALID (or carries
+     * no value) after a valid one, and on the very first update if that is
+     * already invalid.
+     */
+    template<typename T, typename Machine>
+    SignalBindings& on_unavailable(const SignalHandle<T>& signal, Machine& machine,
+                                   const std::string& event) {
+        auto id = intern(machine, event);
+        bool lost = false;
+        add(signal, [&machine, id, lost](const vss::types::DynamicQualifiedValue& qv) mutable {
+            bool valid = qv.quality == vss::types::SignalQuality::VALID && !vss::types::is_empty(qv.value);
+            if (valid || lost) {
+                lost = !valid;
+                return false;
+            }
+            lost = true;
+            return post(machine, id);
+        });
+        return *this;
+    }
+
+    /**
+     * @brief Subscribe every bound signal on client (one subscription per signal)
+     *
+     * Like Client::subscribe(), must be called before client.start().
+     *
+     * @throws std::logic_error if called twice or if the client is running
+     */
+    void subscribe(Client& client) {
+        if (subscribed_) {
+            throw std::logic_error("SignalBindings already subscribed");
+        }
+        for (const auto& [signal_id, signal] : state_->signals) {
+            client.subscribe(*signal.handle, [state = state_, signal_id = signal_id](
+                                                 const vss::types::DynamicQualifiedValue& qv) {
+                state->dispatch(signal_id, qv);
+            });
+        }
+        subscribed_ = true;
+    }
+
+    /**
+     * @brief Evaluate the bindings of a signal against an update
+     *
+     * Called by the subscriptions set up in subscribe(); also usable to feed
+     * updates from another source. Not thread-safe per signal: updates of
+     * one signal must be delivered by one thread at a time.
+     */
+    void dispatch(int32_t signal_id, const vss::types::DynamicQualifiedValue& qv) {
+        state_->dispatch(signal_id, qv);
+    }
+
+    SignalBindingStats stats() const {
+        SignalBindingStats stats;
+        stats.updates = state_->updates.load(std::memory_order_relaxed);
+        stats.events = state_->events.load(std::memory_order_relaxed);
+        stats.suppressed = stats.updates - stats.events;
+        return stats;
+    }
+
+    /**
+     * @brief Number of bindings
+     */
+    size_t size() const {
+        size_t count = 0;
+        for (const auto& [id, signal] : state_->signals) {
+            count += signal.bindings.size();
+        }
+        return count;
+    }
+
+private:
+    enum class Side : uint8_t { UNKNOWN, ABOVE, BELOW };
+
+    // Evaluates one update; returns true if it posted an event
+    using Binding = std::function<bool(const vss::types::DynamicQualifiedValue&)>;
+
+    struct Signal {
+        std::shared_ptr<DynamicSignalHandle> handle;
+        std::vector<Binding> bindings;
+    };
+
+    struct State {
+        std::unordered_map<int32_t, Signal> signals;
+        std::atomic<uint64_t> updates{0};
+        std::atomic<uint64_t> events{0};
+
+        void dispatch(int32_t signal_id, const vss::types::DynamicQualifiedValue& qv) {
+            auto it = signals.find(signal_id);
+            if (it == signals.end()) {
+                return;
+            }
+            uint64_t posted = 0;
+            for (auto& binding : it->second.bindings) {
+                posted += binding(qv) ? 1 : 0;
+            }
+            updates.fetch_add(it->second.bindings.size(), std::memory_order_relaxed);
+            if (posted > 0) {
+                events.fetch_add(posted, std::memory_order_relaxed);
+            }
+        }
+    };
+
+    template<typename Machine>
+    static sdv::TriggerId intern(Machine& machine, const std::string& event) {
+        return event.empty() ? sdv::kInvalidTriggerId : machine.register_trigger(event);
+    }
+
+    template<typename Machine>
+    static bool post(Machine& machine, sdv::TriggerId event) {
+        if (event == sdv::kInvalidTriggerId) {
+            return false;
+        }
+        machine.post(event);
+        return true;
+    }
+
+    template<typename T>
+    static std::optional<T> valid_value(const vss::types::DynamicQualifiedValue& qv) {
+        if (qv.quality != vss::types::SignalQuality::VALID || vss::types::is_empty(qv.value)) {
+            return std::nullopt;
+        }
+        return detail::try_extract_value<T>(qv.value);
+    }
+
+    template<typename T>
+    void add(const SignalHandle<T>& signal, Binding binding) {
+        if (subscribed_) {
+            throw std::logic_error("Cannot add bindings after SignalBindings::subscribe()");
+        }
+        if (!signal.is_valid()) {
+            throw std::invalid_argument("Cannot bind an invalid signal handle");
+        }
+        auto& entry = state_->signals[signal.id()];
+        if (!entry.handle) {
+            entry.handle = signal.dynamic_handle();
+        }
+        entry.bindings.push_back(std::move(binding));
+    }
+
+    std::shared_ptr<State> state_;
+    bool subscribed_ = false;
+};
+
+} // namespace kuksa
@@ -0,0 +1,118 @@
+/**
+ * @file signal_cells.hpp
+ * @brief Seqlock cells that many threads read without locks
+ */
+
+#pragma once
+
+#include <kuksa_cpp/types.hpp>
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <thread>
+#include <type_traits>
+
+namespace kuksa {
+
+/**
+ * @brief A value written by one thread and read lock-free by any number
+ *
+ * The writer makes the sequence odd, changes the value and makes it even
+ * again; a reader copies the value and retries if the sequence moved in
+ * between, so it always returns a value exactly as one write left it.
+ * Readers never block the writer and never write shared memory, so they
+ * do not slow each other down. T must be trivially copyable.
+ *
+ * Writers must be serialized by the caller.
+ */
+template<typename T>
+class Seqlock {
+    static_assert(std::is_trivially_copyable_v<T>, "Seqlock needs a trivially copyable type");
+
+public:
+    Seqlock() = default;
+    explicit Seqlock(const T& initial) : value_(initial) {}
+
+    Seqlock(const Seqlock&) = delete;
+    Seqlock& operator=(const Seqlock&) = delete;
+
+    /**
+     * @brief Consistent copy of the value
+     */
+    T load() const {
+        T out;
+        uint64_t ignored;
+        while (!try_load(out, ignored)) {
+            std::this_thread::yield();
+        }
+        return out;
+    }
+
+    /**
+     * @brief Copy the value if a write completed since version
+     *
+     * @param version In: the version of the caller's copy (0 for none).
+     *        Out: the version of out.
+     * @return false if nothing changed, leaving out untouched
+     */
+    bool load_if_changed(T& out, uint64_t& version) const {
+        for (;;) {
+            if (this->version() == version) {
+                return false;
+            }
+            if (try_load(out, version)) {
+                return true;
+            }
+            std::this_thread::yield();
+        }
+    }
+
+    /**
+     * @brief Change the value in place; mutate gets a T& (writer only)
+     */
+    template<typename Mutate>
+    void write(Mutate&& mutate) {
+        const uint64_t sequence = sequence_.load(std::memory_order_relaxed);
+        sequence_.store(sequence + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        mutate(value_);
+        sequence_.store(sequence + 2, std::memory_order_release);
+    }
+
+    void store(const T& value) {
+        write([&value](T& current) { current = value; });
+    }
+
+    /// Number of completed writes
+    uint64_t version() const { return sequence_.load(std::memory_order_acquire) >> 1; }
+
+private:
+    // One attempt; false if a write was in progress or overlapped the copy
+    bool try_load(T& out, uint64_t& version) const {
+        const uint64_t before = sequence_.load(std::memory_order_acquire);
+        if (before & 1) {
+            return false;
+        }
+        std::memcpy(static_cast<void*>(&out), &value_, sizeof(T));
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (sequence_.load(std::memory_order_relaxed) != before) {
+            return false;  // torn read
+        }
+        version = before >> 1;
+        return true;
+    }
+
+    alignas(64) std::atomic<uint64_t> sequence_{0};  // odd while being written
+    T value_{};
+};
+
+/**
+ * @brief Latest update of a signal, readable by any thread without locks
+ *
+ * Filled by Client::subscribe_cell(). Unlike LatestSignal, reads do not
+ * consume the value, so several threads can follow the same cell.
+ */
+template<typename T>
+using SignalCell = Seqlock<vss::types::QualifiedValue<T>>;
+
+} // namespace kuksa
@@ -0,0 +1,211 @@
+/**
+ * @file signal_queue.hpp
+ * @brief Wait-free queues that a control loop polls for signal updates
+ */
+
+#pragma once
+
+#include <kuksa_cpp/types.hpp>
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+namespace kuksa {
+
+namespace detail {
+
+// Keeps producer and consumer indices on separate cache lines
+constexpr std::size_t QUEUE_CACHE_LINE = 64;
+
+inline std::size_t round_up_to_power_of_two(std::size_t n) {
+    std::size_t capacity = 1;
+    while (capacity < n) {
+        capacity <<= 1;
+    }
+    return capacity;
+}
+
+} // namespace detail
+
+/**
+ * @brief Bounded single-producer/single-consumer ring of signal updates
+ *
+ * Filled by the client (see Client::subscribe_queue()) and drained by one
+ * application thread with poll(), at its own cadence. poll() is wait-free:
+ * two atomic loads, one store and a swap per value, with no locks,
+ * allocation or system calls. Values are swapped out rather than copied,
+ * so poll() does not free either: the caller's previous array and string
+ * values go into the ring, and the producer frees them when it reuses the
+ * slot.
+ *
+ * When the ring is full, new updates are dropped and counted in
+ * overflows(); the values already queued are delivered in order.
+ *
+ * Usage:
+ * @code
+ *   auto speeds = client->subscribe_queue(speed, 64);
+ *   client->start();
+ *
+ *   std::array<vss::types::QualifiedValue<float>, 16> batch;
+ *   while (running) {                       // 1 kHz control loop
+ *       size_t n = speeds->poll(batch);
+ *       for (size_t i = 0; i < n; ++i) { ... batch[i] ... }
+ *       sleep_until(next_tick);
+ *   }
+ * @endcode
+ */
+template<typename T>
+class SignalQueue {
+public:
+    using Value = vss::types::QualifiedValue<T>;
+
+    /**
+     * @param capacity Minimum number of queued updates, rounded up to a power of two
+     */
+    explicit SignalQueue(std::size_t capacity)
+        : slots_(detail::round_up_to_power_of_two(capacity < 1 ? 1 : capacity))
+        , mask_(slots_.size() - 1) {}
+
+    SignalQueue(const SignalQueue&) = delete;
+    SignalQueue& operator=(const SignalQueue&) = delete;
+
+    /**
+     * @brief Move up to max queued updates, oldest first, into out (consumer only)
+     *
+     * @return Number of updates written to out[0..n)
+     */
+    std::size_t poll(Value* out, std::size_t max) {
+        const uint64_t head = head_.load(std::memory_order_relaxed);
+        const uint64_t tail = tail_.load(std::memory_order_acquire);
+        std::size_t n = static_cast<std::size_t>(tail - head);
+        if (n > max) {
+            n = max;
+        }
+        for (std::size_t i = 0; i < n; ++i) {
+            using std::swap;
+            swap(out[i], slots_[(head + i) & mask_]);
+        }
+        head_.store(head + n, std::memory_order_release);
+        return n;
+    }
+
+    template<std::size_t N>
+    std::size_t poll(std::array<Value, N>& out) {
+        return poll(out.data(), N);
+    }
+
+    /**
+     * @brief Queue value, or count an overflow if the ring is full (producer only)
+     *
+     * @return false if value was dropped
+     */
+    bool push(Value value) {
+        const uint64_t tail = tail_.load(std::memory_order_relaxed);
+        if (tail - head_cache_ == slots_.size()) {
+            head_cache_ = head_.load(std::memory_order_acquire);
+            if (tail - head_cache_ == slots_.size()) {
+                overflows_.fetch_add(1, std::memory_order_relaxed);
+                return false;
+            }
+        }
+        slots_[tail & mask_] = std::move(value);
+        tail_.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    /// Updates waiting for poll() (a snapshot)
+    std::size_t size() const {
+        return static_cast<std::size_t>(tail_.load(std::memory_order_acquire) -
+                                        head_.load(std::memory_order_acquire));
+    }
+
+    std::size_t capacity() const { return slots_.size(); }
+
+    /// Updates dropped because the ring was full
+    uint64_t overflows() const { return overflows_.load(std::memory_order_relaxed); }
+
+private:
+    std::vector<Value> slots_;
+    const std::size_t mask_;
+
+    alignas(detail::QUEUE_CACHE_LINE) std::atomic<uint64_t> head_{0};  // next slot to poll
+    alignas(detail::QUEUE_CACHE_LINE) std::atomic<uint64_t> tail_{0};  // next slot to fill
+    uint64_t head_cache_ = 0;  // producer's last view of head_
+    std::atomic<uint64_t> overflows_{0};
+};
+
+/**
+ * @brief Latest update of a signal, for loops that only need the current value
+ *
+ * A wait-free triple buffer (see Client::subscribe_latest()): the producer
+ * never waits for the reader, and poll() returns the most recent update
+ * that has not been polled yet. Updates replaced before the reader got to
+ * them are counted in overflows().
+ */
+template<typename T>
+class LatestSignal {
+public:
+    using Value = vss::types::QualifiedValue<T>;
+
+    LatestSignal() = default;
+    LatestSignal(const LatestSignal&) = delete;
+    LatestSignal& operator=(const LatestSignal&) = delete;
+
+    /**
+     * @brief Move the latest update into out if there is a new one (consumer only)
+     *
+     * @return false, leaving out untouched, if nothing arrived since the last poll
+     */
+    bool poll(Value& out) {
+        if ((middle_.load(std::memory_order_relaxed) & FRESH) == 0) {
+            return false;
+        }
+        const uint8_t previous = middle_.exchange(read_, std::memory_order_acq_rel);
+        read_ = previous & INDEX;
+        using std::swap;
+        swap(out, slots_[read_]);
+        return true;
+    }
+
+    /// Same as poll(Value&), shaped like SignalQueue::poll()
+    std::size_t poll(Value* out, std::size_t max) {
+        return max > 0 && poll(*out) ? 1 : 0;
+    }
+
+    /**
+     * @brief Publish value as the latest update (producer only)
+     *
+     * @return false if it replaced an update the reader never saw
+     */
+    bool push(Value value) {
+        slots_[write_] = std::move(value);
+        const uint8_t previous = middle_.exchange(write_ | FRESH, std::memory_order_acq_rel);
+        write_ = previous & INDEX;
+        if (previous & FRESH) {
+            overflows_.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+        return true;
+    }
+
+    /// Whether poll() would return an update
+    bool fresh() const { return (middle_.load(std::memory_order_acquire) & FRESH) != 0; }
+
+    /// Updates replaced before they were polled
+    uint64_t overflows() const { return overflows_.load(std::memory_order_relaxed); }
+
+private:
+    static constexpr uint8_t INDEX = 0x3;
+    static constexpr uint8_t FRESH = 0x4;
+
+    std::array<Value, 3> slots_;
+    alignas(detail::QUEUE_CACHE_LINE) uint8_t write_ = 0;        // producer's slot
+    alignas(detail::QUEUE_CACHE_LINE) std::atomic<uint8_t> middle_{1};  // handed over, plus FRESH
+    alignas(detail::QUEUE_CACHE_LINE) uint8_t read_ = 2;         // consumer's slot
+    std::atomic<uint64_t> overflows_{0};
+};
+
+} // namespace kuksa
@@ -0,0 +1,191 @@
+/**
+ * @file event_queue.hpp
+ * @brief Lock-free MPSC event queue used by StateMachine's run-to-completion mode
+ */
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <memory>
+#include <mutex>
+
+namespace sdv {
+
+/**
+ * @brief Bounded lock-free multi-producer / single-consumer ring buffer
+ *
+ * Each cell carries a sequence number (Vyukov's bounded queue), so producers
+ * claim a slot with one CAS and never block each other or the consumer.
+ * Capacity is rounded up to a power of two.
+ *
+ * @tparam T Trivially copyable element type
+ */
+template<typename T>
+class MpscRingBuffer {
+public:
+    explicit MpscRingBuffer(std::size_t capacity) {
+        std::size_t size = 2;
+        while (size < capacity) {
+            size <<= 1;
+        }
+        mask_ = size - 1;
+        cells_ = std::make_unique<Cell[]>(size);
+        for (std::size_t i = 0; i < size; ++i) {
+            cells_[i].sequence.store(i, std::memory_order_relaxed);
+        }
+    }
+
+    MpscRingBuffer(const MpscRingBuffer&) = delete;
+    MpscRingBuffer& operator=(const MpscRingBuffer&) = delete;
+
+    /**
+     * @brief Enqueue from any thread
+     *
+     * @return false if the buffer is full
+     */
+    bool try_push(const T& value) {
+        Cell* cell;
+        auto pos = enqueue_pos_.load(std::memory_order_relaxed);
+        for (;;) {
+            cell = &cells_[pos & mask_];
+            auto seq = cell->sequence.load(std::memory_order_acquire);
+            auto diff = static_cast<std::intptr_t>(seq) - static_cast<std::intptr_t>(pos);
+            if (diff == 0) {
+                if (enqueue_pos_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    break;
+                }
+            } else if (diff < 0) {
+                return false;
+            } else {
+                pos = enqueue_pos_.load(std::memory_order_relaxed);
+            }
+        }
+        cell->value = value;
+        cell->sequence.store(pos + 1, std::memory_order_release);
+        return true;
+    }
+
+    /**
+     * @brief Dequeue; only the single consumer thread may call this
+     *
+     * @return false if the buffer is empty
+     */
+    bool try_pop(T& value) {
+        auto pos = dequeue_pos_.load(std::memory_order_relaxed);
+        Cell& cell = cells_[pos & mask_];
+        auto seq = cell.sequence.load(std::memory_order_acquire);
+        if (seq != pos + 1) {
+            return false;
+        }
+        value = cell.value;
+        cell.sequence.store(pos + mask_ + 1, std::memory_order_release);
+        dequeue_pos_.store(pos + 1, std::memory_order_relaxed);
+        return true;
+    }
+
+    /**
+     * @brief Approximate number of queued elements
+     */
+    std::size_t size() const {
+        auto enqueued = enqueue_pos_.load(std::memory_order_relaxed);
+        auto dequeued = dequeue_pos_.load(std::memory_order_relaxed);
+        return enqueued >= dequeued ? enqueued - dequeued : 0;
+    }
+
+    bool empty() const {
+        return size() == 0;
+    }
+
+    std::size_t capacity() const {
+        return mask_ + 1;
+    }
+
+private:
+    struct Cell {
+        std::atomic<std::size_t> sequence{0};
+        T value{};
+    };
+
+    std::unique_ptr<Cell[]> cells_;
+    std::size_t mask_ = 0;
+    alignas(64) std::atomic<std::size_t> enqueue_pos_{0};
+    alignas(64) std::atomic<std::size_t> dequeue_pos_{0};
+};
+
+/**
+ * @brief Configuration of a state machine's event queue
+ */
+struct EventQueueOptions {
+    /// Maximum number of pending events (rounded up to a power of two)
+    std::size_t capacity = 1024;
+
+    /// Drop a posted event if the same trigger is already pending
+    bool coalesce_duplicates = false;
+};
+
+/**
+ * @brief Snapshot of event queue counters
+ */
+struct EventQueueStats {
+    std::size_t depth = 0;          ///< Events currently pending
+    std::size_t capacity = 0;
+    std::uint64_t posted = 0;       ///< Events accepted into the queue
+    std::uint64_t processed = 0;    ///< Events dispatched by the worker
+    std::uint64_t coalesced = 0;    ///< Posted duplicates collapsed into a pending event
+    std::uint64_t dropped = 0;      ///< Posted events rejected because the queue was full
+    std::chrono::nanoseconds last_latency{0};  ///< Enqueue-to-dispatch latency
+    std::chrono::nanoseconds max_latency{0};
+    std::chrono::nanoseconds mean_latency{0};
+};
+
+namespace detail {
+
+/**
+ * @brief Completion record for a caller blocked in trigger() while queued
+ *
+ * Lives on the caller's stack; the worker signals it after dispatch.
+ */
+struct EventCompletion {
+    std::mutex mutex;
+    std::condition_variable cv;
+    bool done = false;
+    bool result = false;
+    std::exception_ptr error;
+
+    void complete(bool value, std::exception_ptr exception = nullptr) {
+        std::lock_guard<std::mutex> lock(mutex);
+        result = value;
+        error = std::move(exception);
+        done = true;
+        cv.notify_one();
+    }
+
+    bool wait() {
+        std::unique_lock<std::mutex> lock(mutex);
+        cv.wait(lock, [this]() { return done; });
+        if (error) {
+            std::rethrow_exception(error);
+        }
+        return result;
+    }
+};
+
+/**
+ * @brief Queued event record (trivially copyable)
+ */
+template<typename ContextT>
+struct QueuedEvent {
+    std::uint32_t trigger = 0;
+    const ContextT* context = nullptr;       ///< nullptr: use the bound context
+    EventCompletion* completion = nullptr;   ///< nullptr: fire-and-forget post()
+    std::chrono::steady_clock::time_point enqueued{};
+};
+
+} // namespace detail
+
+} // namespace sdv
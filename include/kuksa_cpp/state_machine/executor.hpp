@@ -0,0 +1,182 @@
+/**
+ * @file executor.hpp
+ * @brief Reusable worker pool for asynchronous state machine work
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace sdv {
+
+/**
+ * @brief Fixed-size pool of worker threads draining a shared task queue
+ *
+ * Threads are created once in the constructor and reused for every posted
+ * task, so asynchronous triggers no longer pay for an OS thread per event.
+ * Pending tasks are drained before the destructor joins the workers.
+ */
+class Executor {
+public:
+    using Task = std::function<void()>;
+
+    /**
+     * @brief Construct an executor
+     *
+     * @param num_threads Number of worker threads (at least one)
+     */
+    explicit Executor(std::size_t num_threads = default_thread_count()) {
+        num_threads = std::max<std::size_t>(1, num_threads);
+        workers_.reserve(num_threads);
+        for (std::size_t i = 0; i < num_threads; ++i) {
+            workers_.emplace_back([this]() { worker_loop(); });
+        }
+    }
+
+    ~Executor() {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            stopping_ = true;
+        }
+        cv_.notify_all();
+        for (auto& worker : workers_) {
+            if (worker.joinable()) {
+                worker.join();
+            }
+        }
+    }
+
+    Executor(const Executor&) = delete;
+    Executor& operator=(const Executor&) = delete;
+
+    /**
+     * @brief Queue a task for execution on one of the workers
+     */
+    void post(Task task) {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            tasks_.push_back(std::move(task));
+        }
+        cv_.notify_one();
+    }
+
+    /**
+     * @brief Number of worker threads
+     */
+    std::size_t size() const {
+        return workers_.size();
+    }
+
+    /**
+     * @brief Process-wide executor shared by all state machines by default
+     */
+    static Executor& default_executor() {
+        static Executor instance;
+        return instance;
+    }
+
+private:
+    static std::size_t default_thread_count() {
+        return std::clamp<std::size_t>(std::thread::hardware_concurrency(), 2, 8);
+    }
+
+    void worker_loop() {
+        for (;;) {
+            Task task;
+            {
+                std::unique_lock<std::mutex> lock(mutex_);
+                cv_.wait(lock, [this]() { return stopping_ || !tasks_.empty(); });
+                if (tasks_.empty()) {
+                    return;  // stopping and drained
+                }
+                task = std::move(tasks_.front());
+                tasks_.pop_front();
+            }
+            task();
+        }
+    }
+
+    std::mutex mutex_;
+    std::condition_variable cv_;
+    std::deque<Task> tasks_;
+    std::vector<std::thread> workers_;
+    bool stopping_ = false;
+};
+
+/**
+ * @brief Runs posted tasks one at a time, in order, on an underlying Executor
+ *
+ * Used by StateMachine so that trigger_async() calls on the same machine are
+ * processed in submission order even though the pool has several workers.
+ * The destructor waits until all queued tasks have finished.
+ */
+class SerialExecutor {
+public:
+    explicit SerialExecutor(Executor& executor = Executor::default_executor())
+        : executor_(executor) {}
+
+    ~SerialExecutor() {
+        wait_idle();
+    }
+
+    SerialExecutor(const SerialExecutor&) = delete;
+    SerialExecutor& operator=(const SerialExecutor&) = delete;
+
+    void post(Executor::Task task) {
+        bool schedule = false;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            tasks_.push_back(std::move(task));
+            if (!running_) {
+                running_ = true;
+                schedule = true;
+            }
+        }
+        if (schedule) {
+            executor_.post([this]() { drain(); });
+        }
+    }
+
+    /**
+     * @brief Wait until every task posted so far has finished
+     *
+     * Must not be called from one of the tasks.
+     */
+    void wait_idle() {
+        std::unique_lock<std::mutex> lock(mutex_);
+        idle_cv_.wait(lock, [this]() { return !running_; });
+    }
+
+private:
+    void drain() {
+        for (;;) {
+            Executor::Task task;
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                if (tasks_.empty()) {
+                    running_ = false;
+                    idle_cv_.notify_all();
+                    return;
+                }
+                task = std::move(tasks_.front());
+                tasks_.pop_front();
+            }
+            task();
+        }
+    }
+
+    Executor& executor_;
+    std::mutex mutex_;
+    std::condition_variable idle_cv_;
+    std::deque<Executor::Task> tasks_;
+    bool running_ = false;
+};
+
+} // namespace sdv
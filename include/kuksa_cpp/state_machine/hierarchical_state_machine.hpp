@@ -8,89 +8,135 @@ namespace sdv {
 
 /**
  * @brief Hierarchical state machine with composite state support
- * 
+ *
  * Extends the base StateMachine to support:
- * - Nested states (composite states with substates)
- * - Automatic parent state entry/exit
+ * - Nested states (composite states with substates of the same enum)
+ * - Automatic parent state entry/exit along the LCA path
+ * - Event bubbling: a substate inherits its ancestors' transitions
  * - State hierarchy queries
- * 
+ *
+ * The hierarchy is folded into the compiled transition table, so bubbling
+ * and entry/exit path computation cost nothing at dispatch time.
+ *
  * @tparam StateT Primary state enum type
+ * @tparam ContextT Context type passed to guards and actions
  */
-template<typename StateT>
-class HierarchicalStateMachine : public StateMachine<StateT> {
+template<typename StateT, typename ContextT = Context>
+class HierarchicalStateMachine : public StateMachine<StateT, ContextT> {
 public:
-    using StateMachine<StateT>::StateMachine;
-    
+    using StateMachine<StateT, ContextT>::StateMachine;
+
     /**
      * @brief Define a composite state with substates
-     * 
-     * @tparam SubstateT Enum type for substates
+     *
+     * Substates are states of the same enum. Entering parent enters
+     * initial_substate (recursively, if it is itself composite); the current
+     * state is always the innermost active state.
+     *
      * @param parent Parent composite state
      * @param substates List of substates
      * @param initial_substate Default substate to enter
      */
+    void add_composite_state(StateT parent,
+                           const std::vector<StateT>& substates,
+                           StateT initial_substate) {
+        std::lock_guard<std::mutex> lock(this->mutex_);
+        for (auto substate : substates) {
+            this->parent_states_[substate] = parent;
+        }
+        this->initial_substates_[parent] = initial_substate;
+        composite_states_.insert(parent);
+        this->table_dirty_ = true;
+
+        LOG(INFO) << "[SM:" << this->name_ << "] COMPOSITE_STATE: Added " << this->state_name(parent)
+                  << " with " << substates.size() << " substates";
+    }
+
+    /**
+     * @brief Mark a state as composite over a separate substate enum
+     *
+     * Substates of a different enum are not tracked by this machine; wrap
+     * them in their own StateMachine (see USAGE.md, Wrapped State Machine
+     * Pattern). Kept for source compatibility.
+     */
     template<typename SubstateT>
     void add_composite_state(StateT parent,
                            const std::vector<SubstateT>& substates,
-                           SubstateT initial_substate) {
-        parent_states_.insert(parent);
-        
-        // Store substate info (would need proper implementation)
-        LOG(INFO) << "[SM:" << this->name_ << "] COMPOSITE_STATE: Added " << this->state_name(parent) 
+                           SubstateT /*initial_substate*/) {
+        std::lock_guard<std::mutex> lock(this->mutex_);
+        composite_states_.insert(parent);
+
+        LOG(INFO) << "[SM:" << this->name_ << "] COMPOSITE_STATE: Added " << this->state_name(parent)
                   << " with " << substates.size() << " substates";
-                  
-        // In full implementation, would track parent-child relationships
     }
-    
+
     /**
      * @brief Check if state machine is currently in a given state
-     * 
+     *
      * For hierarchical states, returns true if:
      * - The current state matches exactly
-     * - The current state is a child of the queried state
+     * - The current state is a descendant of the queried state
      */
     bool is_in_state(StateT state) const {
-        if (this->current_state() == state) {
-            return true;
+        std::lock_guard<std::mutex> lock(this->mutex_);
+        this->compile_table();
+        for (auto active : active_chain()) {
+            if (active == state) {
+                return true;
+            }
         }
-        
-        // Check if current state is a child of queried state
-        if (parent_states_.count(state) > 0) {
-            // In full implementation, check parent-child relationship
-            return false;
-        }
-        
         return false;
     }
-    
+
     /**
-     * @brief Get all currently active states (including parents)
+     * @brief Get all currently active states (current state and its ancestors)
      */
     std::unordered_set<StateT> get_active_states() const {
-        std::unordered_set<StateT> active;
-        active.insert(this->current_state());
-        
-        // In full implementation, would add parent states
-        
-        return active;
+        std::lock_guard<std::mutex> lock(this->mutex_);
+        this->compile_table();
+        auto chain = active_chain();
+        return std::unordered_set<StateT>(chain.begin(), chain.end());
     }
-    
+
     /**
-     * @brief Get the depth of current state in hierarchy
+     * @brief Get the depth of current state in hierarchy (0 = top level)
      */
     int get_state_depth() const {
-        // In full implementation, calculate actual depth
-        return parent_states_.count(this->current_state()) > 0 ? 1 : 0;
+        std::lock_guard<std::mutex> lock(this->mutex_);
+        this->compile_table();
+        auto chain = active_chain();
+        return chain.empty() ? 0 : static_cast<int>(chain.size()) - 1;
     }
-    
-    
+
+    /**
+     * @brief Parent of a state, if it was declared as a substate
+     */
+    std::optional<StateT> parent_state(StateT state) const {
+        std::lock_guard<std::mutex> lock(this->mutex_);
+        auto it = this->parent_states_.find(state);
+        if (it == this->parent_states_.end()) {
+            return std::nullopt;
+        }
+        return it->second;
+    }
+
+    /**
+     * @brief Check whether a state was declared composite
+     */
+    bool is_composite(StateT state) const {
+        std::lock_guard<std::mutex> lock(this->mutex_);
+        return composite_states_.count(state) > 0;
+    }
+
 private:
-    std::unordered_set<StateT> parent_states_;
-    std::unordered_set<StateT> active_states_;
-    
-    // Note: Cannot override private enter_state/exit_state from base class
-    // Would need to refactor base class to have protected virtual methods
-    
+    /**
+     * @brief Current state followed by its ancestors (mutex_ held, table compiled)
+     */
+    auto active_chain() const {
+        return this->table_.ancestors(this->current_state_.load());
+    }
+
+    std::unordered_set<StateT> composite_states_;
 };
 
-} // namespace kuksa
\ No newline at end of file
+} // namespace kuksa
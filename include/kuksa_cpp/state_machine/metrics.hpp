@@ -0,0 +1,214 @@
+/**
+ * @file metrics.hpp
+ * @brief Built-in state machine metrics: counters, latency histograms, exporters
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace sdv {
+
+/**
+ * @brief Number of log2 latency buckets; bucket i counts durations in [2^i, 2^(i+1)) ns
+ *
+ * The last bucket also takes everything above 2^31 ns (about 2 s).
+ */
+inline constexpr std::size_t kLatencyBuckets = 32;
+
+/**
+ * @brief Bucket index for a duration in nanoseconds
+ */
+inline std::size_t latency_bucket(std::uint64_t ns) {
+    if (ns < 2) {
+        return 0;
+    }
+#if defined(__GNUC__) || defined(__clang__)
+    std::size_t bucket = 63 - static_cast<std::size_t>(__builtin_clzll(ns));
+#else
+    std::size_t bucket = 0;
+    while (ns >>= 1) {
+        ++bucket;
+    }
+#endif
+    return bucket < kLatencyBuckets ? bucket : kLatencyBuckets - 1;
+}
+
+/**
+ * @brief Upper bound (exclusive) of a latency bucket
+ */
+inline std::chrono::nanoseconds latency_bucket_bound(std::size_t bucket) {
+    return std::chrono::nanoseconds(std::int64_t{2} << bucket);
+}
+
+/**
+ * @brief Snapshot of a latency histogram
+ */
+struct LatencyHistogram {
+    std::array<std::uint64_t, kLatencyBuckets> buckets{};
+    std::uint64_t count = 0;
+    std::chrono::nanoseconds sum{0};
+    std::chrono::nanoseconds max{0};
+
+    /**
+     * @brief Approximate quantile (upper bound of the containing bucket)
+     */
+    std::chrono::nanoseconds quantile(double q) const {
+        if (count == 0) {
+            return std::chrono::nanoseconds(0);
+        }
+        auto rank = static_cast<std::uint64_t>(q * static_cast<double>(count - 1)) + 1;
+        std::uint64_t seen = 0;
+        for (std::size_t i = 0; i < kLatencyBuckets; ++i) {
+            seen += buckets[i];
+            if (seen >= rank) {
+                return std::min(latency_bucket_bound(i), max);
+            }
+        }
+        return max;
+    }
+
+    std::chrono::nanoseconds mean() const {
+        return count > 0 ? sum / static_cast<std::int64_t>(count) : std::chrono::nanoseconds(0);
+    }
+};
+
+/**
+ * @brief Per-transition metrics (one entry per add_transition)
+ */
+struct TransitionMetrics {
+    std::string from;
+    std::string to;
+    std::string trigger;
+    LatencyHistogram latency;   ///< Exit + action + entry duration; count = transitions taken
+    std::uint64_t blocked = 0;  ///< Guard evaluated to false
+};
+
+/**
+ * @brief Per-state metrics
+ */
+struct StateMetrics {
+    std::string state;
+    std::uint64_t entries = 0;
+    std::chrono::nanoseconds time_in_state{0};  ///< Total over completed visits
+};
+
+/**
+ * @brief Point-in-time copy of a state machine's metrics
+ */
+struct MetricsSnapshot {
+    std::string machine;
+    std::string current_state;
+    std::uint64_t transitions = 0;  ///< Transitions taken
+    std::uint64_t ignored = 0;      ///< Events that caused no transition (unknown, unmatched or blocked)
+    std::vector<TransitionMetrics> transition_metrics;
+    std::vector<StateMetrics> state_metrics;
+};
+
+namespace detail {
+
+/**
+ * @brief Relaxed atomic counter for a single serialized writer
+ *
+ * StateMachine updates metrics with its mutex held, so increments need no
+ * read-modify-write instruction; readers take lock-free snapshots.
+ */
+class MetricCounter {
+public:
+    void add(std::uint64_t n = 1) {
+        value_.store(value_.load(std::memory_order_relaxed) + n, std::memory_order_relaxed);
+    }
+
+    void set_max(std::uint64_t n) {
+        if (n > value_.load(std::memory_order_relaxed)) {
+            value_.store(n, std::memory_order_relaxed);
+        }
+    }
+
+    std::uint64_t load() const {
+        return value_.load(std::memory_order_relaxed);
+    }
+
+    void reset() {
+        value_.store(0, std::memory_order_relaxed);
+    }
+
+private:
+    std::atomic<std::uint64_t> value_{0};
+};
+
+/**
+ * @brief Live latency histogram (see MetricCounter for the writer model)
+ */
+struct LatencyCounters {
+    std::array<MetricCounter, kLatencyBuckets> buckets;
+    MetricCounter count;
+    MetricCounter sum_ns;
+    MetricCounter max_ns;
+
+    void record(std::uint64_t ns) {
+        buckets[latency_bucket(ns)].add();
+        count.add();
+        sum_ns.add(ns);
+        max_ns.set_max(ns);
+    }
+
+    LatencyHistogram snapshot() const {
+        LatencyHistogram h;
+        for (std::size_t i = 0; i < kLatencyBuckets; ++i) {
+            h.buckets[i] = buckets[i].load();
+        }
+        h.count = count.load();
+        h.sum = std::chrono::nanoseconds(sum_ns.load());
+        h.max = std::chrono::nanoseconds(max_ns.load());
+        return h;
+    }
+
+    void reset() {
+        for (auto& bucket : buckets) {
+            bucket.reset();
+        }
+        count.reset();
+        sum_ns.reset();
+        max_ns.reset();
+    }
+};
+
+/**
+ * @brief Live per-state counters
+ */
+struct StateCounters {
+    MetricCounter entries;
+    MetricCounter time_ns;
+    std::chrono::steady_clock::time_point entered{};  ///< Last entry (writer only)
+
+    void reset() {
+        entries.reset();
+        time_ns.reset();
+    }
+};
+
+} // namespace detail
+
+/**
+ * @brief Render a snapshot in the Prometheus text exposition format
+ *
+ * Metric names are prefixed with "sdv_state_machine_" and labelled with the
+ * machine, state and trigger names. Serve the result from any HTTP endpoint
+ * or write it to a node_exporter textfile collector.
+ */
+std::string to_prometheus_text(const MetricsSnapshot& snapshot);
+
+/**
+ * @brief Render a snapshot as a human-readable table
+ */
+std::string to_text(const MetricsSnapshot& snapshot);
+
+} // namespace sdv
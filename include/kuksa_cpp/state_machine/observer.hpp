@@ -0,0 +1,142 @@
+/**
+ * @file observer.hpp
+ * @brief Transition observers with copy-on-write registration
+ */
+
+#pragma once
+
+#include <kuksa_cpp/state_machine/transition_table.hpp>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string_view>
+#include <vector>
+#include <glog/logging.h>
+
+namespace sdv {
+
+/**
+ * @brief A completed transition, as delivered to observers
+ *
+ * The string views point into the machine and are valid only for the
+ * duration of the callback; copy what you keep.
+ */
+template<typename StateT>
+struct TransitionEvent {
+    std::string_view machine;
+    StateT from{};
+    StateT to{};
+    std::string_view from_name;
+    std::string_view to_name;
+    TriggerId trigger = kInvalidTriggerId;
+    std::string_view trigger_name;
+    std::chrono::steady_clock::time_point timestamp;  ///< Transition start
+    std::chrono::nanoseconds duration{0};             ///< Exit + action + entry
+};
+
+/**
+ * @brief Handle of a registered observer (0 is never a valid handle)
+ */
+using ObserverId = std::uint64_t;
+
+inline constexpr ObserverId kInvalidObserverId = 0;
+
+/**
+ * @brief Observer callbacks behind an atomically swapped, immutable list
+ *
+ * add() and remove() copy the list under a writer mutex and publish the
+ * copy; notify() only loads the current pointer, so registration never
+ * waits for a running notification and a callback may remove itself (it
+ * still sees the list it started with). With no observers, notify() is a
+ * single relaxed load.
+ *
+ * This is not lock-free: std::atomic_load/atomic_store on a shared_ptr
+ * take a short internal lock in libstdc++, held only for the pointer copy.
+ * notify() never takes the writer mutex, so it does not wait for a writer
+ * copying the list.
+ */
+template<typename EventT>
+class ObserverList {
+public:
+    using Callback = std::function<void(const EventT&)>;
+
+    ObserverId add(Callback callback) {
+        std::lock_guard<std::mutex> lock(write_mutex_);
+        auto current = std::atomic_load_explicit(&list_, std::memory_order_acquire);
+        auto next = current ? std::make_shared<List>(*current) : std::make_shared<List>();
+        auto id = ++next_id_;
+        next->push_back(Entry{id, std::move(callback)});
+        publish(std::move(next));
+        return id;
+    }
+
+    bool remove(ObserverId id) {
+        std::lock_guard<std::mutex> lock(write_mutex_);
+        auto current = std::atomic_load_explicit(&list_, std::memory_order_acquire);
+        if (!current) {
+            return false;
+        }
+        auto next = std::make_shared<List>();
+        next->reserve(current->size());
+        for (const auto& entry : *current) {
+            if (entry.id != id) {
+                next->push_back(entry);
+            }
+        }
+        if (next->size() == current->size()) {
+            return false;
+        }
+        publish(next->empty() ? nullptr : std::move(next));
+        return true;
+    }
+
+    bool empty() const {
+        return !active_.load(std::memory_order_relaxed);
+    }
+
+    /**
+     * @brief Invoke every observer; exceptions are logged and swallowed
+     */
+    void notify(const EventT& event) const {
+        if (empty()) {
+            return;
+        }
+        auto list = std::atomic_load_explicit(&list_, std::memory_order_acquire);
+        if (!list) {
+            return;
+        }
+        for (const auto& entry : *list) {
+            try {
+                entry.callback(event);
+            } catch (const std::exception& e) {
+                LOG(ERROR) << "[Observer] callback threw: " << e.what();
+            } catch (...) {
+                LOG(ERROR) << "[Observer] callback threw an unknown exception";
+            }
+        }
+    }
+
+private:
+    struct Entry {
+        ObserverId id;
+        Callback callback;
+    };
+    using List = std::vector<Entry>;
+
+    void publish(std::shared_ptr<List> next) {
+        active_.store(next != nullptr, std::memory_order_relaxed);
+        std::atomic_store_explicit(&list_, std::shared_ptr<const List>(std::move(next)),
+                                   std::memory_order_release);
+    }
+
+    std::mutex write_mutex_;
+    std::shared_ptr<const List> list_;
+    std::atomic<bool> active_{false};
+    ObserverId next_id_ = kInvalidObserverId;
+};
+
+} // namespace sdv
@@ -0,0 +1,138 @@
+/**
+ * @file snapshot.hpp
+ * @brief State machine snapshots and a crash-safe memory-mapped snapshot file
+ */
+
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace sdv {
+
+/**
+ * @brief A pending timer of a snapshotted machine
+ *
+ * Triggers are stored by name and deadlines as wall-clock time, so both
+ * stay meaningful in a new process.
+ */
+struct SnapshotTimer {
+    std::string trigger;
+    std::chrono::system_clock::time_point deadline;
+    bool state_timeout = false;  ///< Armed by a state's timeout(); owner is that state
+    std::int64_t owner = 0;      ///< Underlying value of the owning state
+};
+
+/**
+ * @brief Everything StateMachine::restore() needs to resume a machine
+ *
+ * Produced by StateMachine::snapshot() (or the snapshot sink). The state
+ * is its underlying enum value, so the enum must keep its values across
+ * versions that share snapshot files.
+ */
+struct StateSnapshot {
+    std::string machine;                             ///< Machine name, checked on restore
+    std::int64_t state = 0;                          ///< Underlying value of the current state
+    std::chrono::system_clock::time_point entered;   ///< When the current state was entered
+    std::chrono::system_clock::time_point taken;     ///< When the snapshot was taken
+    std::vector<SnapshotTimer> timers;
+    std::string context;                             ///< Opaque bytes from the context saver
+};
+
+/**
+ * @brief Serialize a snapshot into a compact binary record
+ */
+std::string encode_snapshot(const StateSnapshot& snapshot);
+
+/**
+ * @brief Parse a record produced by encode_snapshot()
+ *
+ * @return std::nullopt if the record is truncated or not a snapshot
+ */
+std::optional<StateSnapshot> decode_snapshot(const std::string& data);
+
+/**
+ * @brief Memory-mapped file holding the latest snapshot of one machine
+ *
+ * The file has two fixed-size slots. write() fills the older slot and then
+ * publishes it by writing its header (sequence number, length, CRC-32)
+ * last, so a crash in the middle of a write leaves the other slot intact.
+ * read() returns the newest slot whose checksum matches.
+ *
+ * Writes are plain memory copies into the page cache, which survives a
+ * process crash or restart; pass sync = true to also msync() each write
+ * for power loss, at the cost of a disk flush per write.
+ *
+ * Not thread-safe; the snapshot sink of a machine is called with the
+ * machine's mutex held, which serializes writes from that machine.
+ */
+class SnapshotFile {
+public:
+    static constexpr std::size_t kDefaultSlotSize = 4096;
+
+    /**
+     * @brief Open or create the file at path
+     *
+     * An existing file with a different slot size is reinitialized.
+     *
+     * @throws std::runtime_error if the file cannot be opened or mapped
+     */
+    explicit SnapshotFile(const std::string& path, std::size_t slot_size = kDefaultSlotSize, bool sync = false);
+    ~SnapshotFile();
+
+    SnapshotFile(const SnapshotFile&) = delete;
+    SnapshotFile& operator=(const SnapshotFile&) = delete;
+
+    /**
+     * @brief Store snapshot, replacing the previous one
+     *
+     * @return false if the encoded snapshot does not fit in a slot
+     */
+    bool write(const StateSnapshot& snapshot);
+
+    /**
+     * @brief The latest intact snapshot, if any
+     */
+    std::optional<StateSnapshot> read() const;
+
+    /**
+     * @brief Maximum encoded snapshot size
+     */
+    std::size_t capacity() const;
+
+    const std::string& path() const { return path_; }
+
+private:
+    struct SlotHeader;
+
+    SlotHeader* slot(std::size_t index) const;
+
+    std::string path_;
+    std::size_t slot_size_ = 0;
+    bool sync_ = false;
+    int fd_ = -1;
+    void* mapping_ = nullptr;
+    std::size_t mapping_size_ = 0;
+    std::uint64_t sequence_ = 0;  // of the newest slot
+};
+
+/**
+ * @brief Write a snapshot of machine to file after every transition
+ *
+ * Sets machine's snapshot sink; the file must outlive the machine or the
+ * sink must be cleared first. Write a snapshot periodically as well if
+ * timers or context change without transitions.
+ */
+template<typename Machine>
+void persist_snapshots(Machine& machine, SnapshotFile& file) {
+    machine.set_snapshot_sink([&file](const StateSnapshot& snapshot) {
+        file.write(snapshot);
+    });
+}
+
+} // namespace sdv
@@ -1,66 +1,139 @@
 #pragma once
 
+#include <algorithm>
 #include <atomic>
 #include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <exception>
 #include <functional>
 #include <future>
 #include <memory>
 #include <mutex>
 #include <string>
+#include <thread>
+#include <type_traits>
 #include <unordered_map>
 #include <unordered_set>
 #include <vector>
 #include <optional>
 #include <any>
 #include <iomanip>
+#include <ostream>
+#include <sstream>
 #include <glog/logging.h>
 
-#ifdef SDV_WITH_PROMETHEUS
-#include <prometheus/counter.h>
-#include <prometheus/histogram.h>
-#include <prometheus/info.h>
-#include <prometheus/registry.h>
-#endif
+#include <kuksa_cpp/state_machine/event_queue.hpp>
+#include <kuksa_cpp/state_machine/executor.hpp>
+#include <kuksa_cpp/state_machine/metrics.hpp>
+#include <kuksa_cpp/state_machine/observer.hpp>
+#include <kuksa_cpp/state_machine/snapshot.hpp>
+#include <kuksa_cpp/state_machine/timer_service.hpp>
+#include <kuksa_cpp/state_machine/trace.hpp>
+#include <kuksa_cpp/state_machine/transition_table.hpp>
 
 namespace sdv {
 
+// Default (dynamic) transition context
+using Context = std::unordered_map<std::string, std::any>;
+
 // Forward declarations
 template<typename StateT>
 class StateDefinition;
 
-template<typename StateT>
+template<typename StateT, typename ContextT = Context>
 class Transition;
 
 // Type aliases
-using Context = std::unordered_map<std::string, std::any>;
+template<typename StateT, typename ContextT = Context>
+using ConditionFunc = std::function<bool(const ContextT&)>;
 
-template<typename StateT>
-using ConditionFunc = std::function<bool(const Context&)>;
+template<typename StateT, typename ContextT = Context>
+using ConditionAsyncFunc = std::function<std::future<bool>(const ContextT&)>;
 
-template<typename StateT>
-using ConditionAsyncFunc = std::function<std::future<bool>(const Context&)>;
+template<typename StateT, typename ContextT = Context>
+using ActionFunc = std::function<void(const ContextT&)>;
 
-template<typename StateT>
-using ActionFunc = std::function<void(const Context&)>;
+template<typename StateT, typename ContextT = Context>
+using ActionAsyncFunc = std::function<std::future<void>(const ContextT&)>;
 
-template<typename StateT>
-using ActionAsyncFunc = std::function<std::future<void>(const Context&)>;
+// Completion of an asynchronous action: nullptr on success, else the failure
+using CompletionFunc = std::function<void(std::exception_ptr)>;
+
+template<typename StateT, typename ContextT = Context>
+using ActionCallbackFunc = std::function<void(const ContextT&, CompletionFunc)>;
 
 template<typename StateT>
 using StateNameFunc = std::function<std::string(StateT)>;
 
+namespace detail {
+
+/**
+ * @brief Shared with pending asynchronous completions, which may outlive the machine
+ *
+ * Completions hold the mutex while they run; the destructor takes it to
+ * clear alive, so no completion touches a destroyed machine. Recursive
+ * because a completion may run another transition whose action completes
+ * inline.
+ */
+struct AsyncLifetime {
+    std::recursive_mutex mutex;
+    std::atomic<bool> alive{true};
+};
+
+} // namespace detail
+
 
 /**
- * @brief Thread-safe state machine with Prometheus metrics and structured logging
+ * @brief Thread-safe state machine with built-in metrics and structured logging
  * 
  * Provides full observability through structured log output:
  * - [SM:name] TRANSITION: from -> to | trigger=event
  * - [SM:name] STATE: current=state
  * - [SM:name] BLOCKED: trigger='event' from=X to=Y reason=...
  * 
+ * trigger() runs the transition on the caller's thread. trigger_async()
+ * queues it on an Executor; async triggers of one machine run in order.
+ * 
+ * Trigger names are interned to TriggerId on registration and transitions
+ * are compiled lazily into a dense [state][trigger] table, so dispatch by
+ * TriggerId performs no hashing or allocation. The string API looks up the
+ * ID and forwards.
+ * 
+ * Guards and actions receive the transition context by const reference.
+ * The default context is the dynamic sdv::Context map; a user struct can be
+ * used instead (ContextT) so guards become plain field accesses. A context
+ * bound with bind_context() is used when trigger() is called without one.
+ * 
+ * Metrics are always collected: per-transition counts and log2 latency
+ * histograms, guard rejections, ignored events and per-state entry counts
+ * and dwell time. Updates are relaxed atomic stores made under the machine
+ * mutex; metrics() takes a snapshot, and to_prometheus_text()/to_text()
+ * (metrics.hpp) render it.
+ * 
+ * enable_trace() records every transition as a fixed-size binary record in
+ * a lock-free ring (see trace.hpp); with set_text_logging(false) the
+ * per-transition LOG(INFO) lines are skipped and the trace is the only
+ * record. Text logging is on by default.
+ * 
+ * add_observer() registers a callback that receives every completed
+ * transition (see observer.hpp); with no observers the cost is one relaxed
+ * load per transition.
+ * 
+ * add_async_transition() registers transitions whose guard or action
+ * completes later (a future or a completion callback). While one is in
+ * progress the machine is "in transition": events are deferred, in order,
+ * without blocking the caller, and dispatched once it completes. trigger()
+ * returns true for a deferred event whether or not it will transition.
+ * 
+ * start_event_queue() switches the machine to run-to-completion mode: all
+ * events are funnelled through a lock-free MPSC queue and dispatched one at
+ * a time by a dedicated worker thread (see start_event_queue()).
+ * 
  * @tparam StateT Enum class defining the states
+ * @tparam ContextT Context type passed to guards and actions
  */
-template<typename StateT>
+template<typename StateT, typename ContextT = Context>
 class StateMachine {
     static_assert(std::is_enum_v<StateT>, "StateT must be an enum type");
     
@@ -70,335 +143,1900 @@ public:
      * 
      * @param name Name of the state machine (used for metrics and logging)
      * @param initial_state Initial state
+     * @param executor Executor used by trigger_async() (shared default pool)
      */
-    explicit StateMachine(std::string name, StateT initial_state)
+    explicit StateMachine(std::string name, StateT initial_state,
+                          Executor& executor = Executor::default_executor())
         : name_(std::move(name))
         , current_state_(initial_state)
-        , state_entry_time_(std::chrono::system_clock::now()) {
-        
-        init_metrics();
+        , state_entry_time_(std::chrono::steady_clock::now())
+        , created_(state_entry_time_)
+        , async_queue_(executor) {
+    }
+    
+    ~StateMachine() {
+        {
+            // Pending asynchronous completions become no-ops
+            std::lock_guard<std::recursive_mutex> lock(lifetime_->mutex);
+            lifetime_->alive.store(false);
+        }
+        // Events still queued may enter timed states; run them before the timers go
+        stop_event_queue();
+        async_queue_.wait_idle();
+        cancel_all_timers();
     }
     
     /**
      * @brief Set custom state name function for logging
      */
     void set_state_name_function(StateNameFunc<StateT> func) {
-        state_name_func_ = std::move(func);
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            state_name_func_ = std::move(func);
+            table_dirty_ = true;  // refresh cached state names
+        }
         
         // Log initial state with proper name
         LOG(INFO) << "[SM:" << name_ << "] INIT: state=" << state_name(current_state_);
     }
     
+    /**
+     * @brief Register a trigger name and return its interned ID
+     * 
+     * Registering an existing name returns the same ID. IDs are stable for
+     * the lifetime of the machine.
+     */
+    TriggerId register_trigger(const std::string& trigger) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return intern_trigger(trigger);
+    }
+    
+    /**
+     * @brief Look up the ID of a registered trigger
+     * 
+     * @return kInvalidTriggerId if the trigger is unknown
+     */
+    TriggerId trigger_id(const std::string& trigger) const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return triggers_.find(trigger);
+    }
+    
+    /**
+     * @brief Get the name of a registered trigger
+     */
+    std::string trigger_name(TriggerId trigger) const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return triggers_.name(trigger);
+    }
+    
     /**
      * @brief Add a transition between states
      */
     void add_transition(StateT from_state,
                        StateT to_state,
                        std::string trigger,
-                       ConditionFunc<StateT> condition = {},
-                       ActionFunc<StateT> action = {}) {
+                       ConditionFunc<StateT, ContextT> condition = {},
+                       ActionFunc<StateT, ContextT> action = {}) {
         std::lock_guard<std::mutex> lock(mutex_);
         
-        auto key = make_transition_key(from_state, trigger);
-        transitions_[key].push_back(
-            std::make_unique<Transition<StateT>>(
-                from_state, to_state, std::move(trigger),
-                std::move(condition), std::move(action)
-            )
-        );
+        auto id = intern_trigger(trigger);
+        add_transition_locked(from_state, to_state, id, std::move(trigger),
+                              std::move(condition), std::move(action));
     }
     
     /**
-     * @brief Define a state with entry/exit actions
+     * @brief Add a transition using a previously registered trigger ID
+     * 
+     * IDs not returned by this machine's register_trigger() are rejected
+     * (logged, no transition added).
      */
-    StateDefinition<StateT>& define_state(StateT state) {
+    void add_transition(StateT from_state,
+                       StateT to_state,
+                       TriggerId trigger,
+                       ConditionFunc<StateT, ContextT> condition = {},
+                       ActionFunc<StateT, ContextT> action = {}) {
         std::lock_guard<std::mutex> lock(mutex_);
         
-        auto [it, inserted] = state_definitions_.emplace(
-            state,
-            std::make_unique<StateDefinition<StateT>>(state_name(state))
-        );
+        if (trigger >= triggers_.size()) {
+            LOG(ERROR) << "[SM:" << name_ << "] ERROR: add_transition() with unregistered trigger ID " << trigger;
+            return;
+        }
+        add_transition_locked(from_state, to_state, trigger, triggers_.name(trigger),
+                              std::move(condition), std::move(action));
+    }
+    
+    /**
+     * @brief Add a transition whose action completes through a future
+     * 
+     * Exit actions run, then action is called and the machine is in
+     * transition until the future is ready; entry actions and the state
+     * change follow on the machine's waiter thread. If the future throws,
+     * the error is logged and the machine stays in the source state (as
+     * with a throwing synchronous action).
+     * 
+     * The context reference is only valid during the call; copy what the
+     * asynchronous work needs.
+     */
+    void add_async_transition(StateT from_state,
+                              StateT to_state,
+                              std::string trigger,
+                              ActionAsyncFunc<StateT, ContextT> action,
+                              ConditionFunc<StateT, ContextT> condition = {}) {
+        std::lock_guard<std::mutex> lock(mutex_);
         
-        return *it->second;
+        auto id = intern_trigger(trigger);
+        auto& transition = add_transition_locked(from_state, to_state, id, std::move(trigger),
+                                                 std::move(condition), {});
+        transition.action_async = std::move(action);
+        ensure_future_waiter();
     }
     
     /**
-     * @brief Trigger a state transition
+     * @brief Add a transition whose action reports completion through a callback
      * 
-     * @param event The trigger event
-     * @param context Optional context data
-     * @return true if transition occurred, false otherwise
+     * action receives a CompletionFunc; call it once, from any thread, with
+     * nullptr on success or the failure's exception_ptr. It may be called
+     * before action returns. Do not call it while holding a lock an entry
+     * action or observer of this machine may take.
      */
-    bool trigger(const std::string& event, const Context& context = {}) {
-        auto future = trigger_async(event, context);
-        return future.get();
+    void add_async_transition(StateT from_state,
+                              StateT to_state,
+                              std::string trigger,
+                              ActionCallbackFunc<StateT, ContextT> action,
+                              ConditionFunc<StateT, ContextT> condition = {}) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        
+        auto id = intern_trigger(trigger);
+        auto& transition = add_transition_locked(from_state, to_state, id, std::move(trigger),
+                                                 std::move(condition), {});
+        transition.action_callback = std::move(action);
     }
     
     /**
-     * @brief Trigger a state transition asynchronously
+     * @brief Add a transition with an asynchronous guard
+     * 
+     * The machine is in transition from the event until the guard's future
+     * is ready. If it yields true, the transition proceeds (action may be
+     * empty, or itself asynchronous). If it yields false or throws, the
+     * remaining candidates for the event are tried, as for a synchronous
+     * guard. The context is copied for the duration.
      */
-    std::future<bool> trigger_async(const std::string& event, 
-                                   const Context& context = {}) {
-        return std::async(std::launch::async, [this, event, context]() {
-            return execute_transition(event, context);
-        });
+    void add_async_transition(StateT from_state,
+                              StateT to_state,
+                              std::string trigger,
+                              ConditionAsyncFunc<StateT, ContextT> condition,
+                              ActionAsyncFunc<StateT, ContextT> action = {}) {
+        static_assert(std::is_copy_constructible_v<ContextT>,
+                      "Asynchronous guards need a copyable context");
+        std::lock_guard<std::mutex> lock(mutex_);
+        
+        auto id = intern_trigger(trigger);
+        auto& transition = add_transition_locked(from_state, to_state, id, std::move(trigger), {}, {});
+        transition.condition_async = std::move(condition);
+        transition.action_async = std::move(action);
+        ensure_future_waiter();
     }
     
     /**
-     * @brief Get current state
+     * @brief Whether an asynchronous guard or action is in progress
      */
-    StateT current_state() const {
+    bool in_transition() const {
         std::lock_guard<std::mutex> lock(mutex_);
-        return current_state_;
+        return pending_async_.has_value();
     }
     
     /**
-     * @brief Get current state name as string
+     * @brief Events waiting for the current asynchronous transition
      */
-    std::string current_state_name() const {
+    std::size_t deferred_events() const {
         std::lock_guard<std::mutex> lock(mutex_);
-        return state_name(current_state_);
+        return deferred_.size();
     }
     
     /**
-     * @brief Get available triggers from current state
+     * @brief Define a state with entry/exit actions
      */
-    std::vector<std::string> available_triggers() const {
+    StateDefinition<StateT>& define_state(StateT state) {
         std::lock_guard<std::mutex> lock(mutex_);
         
-        std::vector<std::string> triggers;
-        auto prefix = std::to_string(static_cast<int>(current_state_.load())) + ":";
+        auto [it, inserted] = state_definitions_.emplace(
+            state,
+            std::make_unique<StateDefinition<StateT>>(state_name(state))
+        );
+        if (inserted) {
+            table_dirty_ = true;
+        }
         
-        for (const auto& [key, _] : transitions_) {
-            if (key.find(prefix) == 0) {
-                triggers.push_back(key.substr(prefix.length()));
+        return *it->second;
+    }
+    
+    /**
+     * @brief Bind a context used by triggers that do not pass one
+     * 
+     * The machine keeps a reference; the context must outlive it (or be
+     * unbound with nullptr). Guards and actions of trigger() see the
+     * caller's updates to the bound object directly, without copying.
+     * trigger_async() copies it when the trigger is queued. Events queued
+     * with post() or deferred read it on the worker at dispatch time, so
+     * do not modify it while such events may be pending.
+     */
+    void bind_context(const ContextT* context) {
+        bound_context_.store(context, std::memory_order_release);
+    }
+    
+    /**
+     * @brief Trigger a state transition with the bound (or empty) context
+     */
+    bool trigger(const std::string& event) {
+        return trigger(event, default_context());
+    }
+    
+    /**
+     * @brief Trigger a state transition
+     * 
+     * Executes synchronously on the calling thread. Exceptions thrown by
+     * transition actions propagate to the caller. While an asynchronous
+     * transition is in progress the event is deferred (the context is
+     * copied) and the call returns true immediately.
+     * 
+     * A deferred event is never dropped, but true then only means it was
+     * accepted: it is dispatched when the asynchronous transition completes
+     * and may still be ignored (no matching transition, guard rejects).
+     * Its outcome is not reported to the caller; follow it with an
+     * observer (add_observer()) or metrics() if it matters.
+     * 
+     * @param event The trigger event
+     * @param context Context data passed by reference to guards and actions
+     * @return true if the transition occurred or started, or the event was
+     *         deferred (see above); false if it was ignored
+     */
+    bool trigger(const std::string& event, const ContextT& context) {
+        std::unique_lock<std::mutex> lock(mutex_);
+        auto id = triggers_.find(event);
+        if (id == kInvalidTriggerId) {
+            VLOG(1) << "[SM:" << name_ << "] IGNORED: trigger='" << event << "' state=" << state_name(current_state_) << " reason=unknown_trigger";
+            ignored_.add();
+            return false;
+        }
+        if (queue_running_.load(std::memory_order_acquire)) {
+            lock.unlock();
+            if (auto result = dispatch_to_queue(id, &context)) {
+                return *result;
             }
+            lock.lock();
         }
-        
-        return triggers;
+        return execute_transition(lock, id, context);
     }
     
+    /**
+     * @brief Trigger a state transition by interned ID
+     * 
+     * Allocation-free fast path; see register_trigger().
+     */
+    bool trigger(TriggerId event, const ContextT& context) {
+        if (queue_running_.load(std::memory_order_acquire)) {
+            if (auto result = dispatch_to_queue(event, &context)) {
+                return *result;
+            }
+        }
+        std::unique_lock<std::mutex> lock(mutex_);
+        return execute_transition(lock, event, context);
+    }
     
+    bool trigger(TriggerId event) {
+        return trigger(event, default_context());
+    }
     
-#ifdef SDV_WITH_PROMETHEUS
     /**
-     * @brief Get Prometheus metrics registry
+     * @brief Trigger a state transition asynchronously
+     * 
+     * The transition is queued on the machine's executor. Async triggers of
+     * the same machine are executed one at a time in submission order.
+     * The context is copied into the queued task.
      */
-    prometheus::Registry& metrics_registry() {
-        return *metrics_registry_;
+    std::future<bool> trigger_async(const std::string& event, 
+                                   const ContextT& context) {
+        auto task = std::make_shared<std::packaged_task<bool()>>(
+            [this, event, context]() {
+                return trigger(event, context);
+            });
+        auto future = task->get_future();
+        async_queue_.post([task]() { (*task)(); });
+        return future;
     }
-#endif
     
-protected:
-    std::string name_;
-    mutable std::mutex mutex_;
-    std::atomic<StateT> current_state_;
-    StateNameFunc<StateT> state_name_func_;
+    /**
+     * @brief Trigger a state transition asynchronously by interned ID
+     */
+    std::future<bool> trigger_async(TriggerId event, const ContextT& context) {
+        auto task = std::make_shared<std::packaged_task<bool()>>(
+            [this, event, context]() {
+                return trigger(event, context);
+            });
+        auto future = task->get_future();
+        async_queue_.post([task]() { (*task)(); });
+        return future;
+    }
     
-    // State management
-    std::unordered_map<StateT, std::unique_ptr<StateDefinition<StateT>>> state_definitions_;
-    std::unordered_map<std::string, std::vector<std::unique_ptr<Transition<StateT>>>> transitions_;
-    std::chrono::system_clock::time_point state_entry_time_;
-    
-#ifdef SDV_WITH_PROMETHEUS
-    // Prometheus metrics
-    std::shared_ptr<prometheus::Registry> metrics_registry_;
-    prometheus::Gauge* state_gauge_;
-    prometheus::Histogram* state_duration_;
-    prometheus::Counter* transition_counter_;
-    prometheus::Histogram* transition_latency_;
-    prometheus::Info* state_info_;
-#endif
-    
-    void init_metrics() {
-#ifdef SDV_WITH_PROMETHEUS
-        metrics_registry_ = std::make_shared<prometheus::Registry>();
-        
-        auto metric_name = name_;
-        std::transform(metric_name.begin(), metric_name.end(), metric_name.begin(), ::tolower);
-        
-        // Current state gauge
-        auto& state_gauge_family = prometheus::BuildGauge()
-            .Name(metric_name + "_state")
-            .Help("Current state of " + name_)
-            .Register(*metrics_registry_);
-        state_gauge_ = &state_gauge_family.Add({});
-        
-        // State duration histogram
-        auto& state_duration_family = prometheus::BuildHistogram()
-            .Name(metric_name + "_state_duration_seconds")
-            .Help("Time spent in each state")
-            .Register(*metrics_registry_);
-        state_duration_ = &state_duration_family.Add({{"state", ""}}, 
-            prometheus::Histogram::BucketBoundaries{0.1, 0.5, 1, 5, 10, 30, 60, 120, 300, 600});
-        
-        // Transition counter
-        auto& transition_counter_family = prometheus::BuildCounter()
-            .Name(metric_name + "_transitions_total")
-            .Help("Total state transitions")
-            .Register(*metrics_registry_);
-        transition_counter_ = &transition_counter_family.Add({{"from_state", ""}, {"to_state", ""}, {"trigger", ""}});
-        
-        // Transition latency histogram
-        auto& transition_latency_family = prometheus::BuildHistogram()
-            .Name(metric_name + "_transition_latency_seconds")
-            .Help("Latency of state transitions")
-            .Register(*metrics_registry_);
-        transition_latency_ = &transition_latency_family.Add({{"from_state", ""}, {"to_state", ""}},
-            prometheus::Histogram::BucketBoundaries{0.001, 0.005, 0.01, 0.05, 0.1, 0.5, 1});
-#endif
-    }
-    
-    
-    std::string make_transition_key(StateT state, const std::string& trigger) const {
-        return std::to_string(static_cast<int>(state)) + ":" + trigger;
+    /**
+     * @brief Trigger asynchronously with a copy of the bound (or empty) context
+     * 
+     * The bound context is copied on the calling thread, so the caller may
+     * keep modifying it while the transition is queued.
+     */
+    std::future<bool> trigger_async(const std::string& event) {
+        return trigger_async(event, default_context());
     }
     
-protected:
-    std::string state_name(StateT state) const {
-        if (state_name_func_) {
-            return state_name_func_(state);
-        }
-        // Fallback to numeric representation
-        return "State_" + std::to_string(static_cast<int>(state));
+    std::future<bool> trigger_async(TriggerId event) {
+        return trigger_async(event, default_context());
     }
     
-private:
-    bool execute_transition(const std::string& event, const Context& context) {
-        auto start_time = std::chrono::steady_clock::now();
-        
+    // ========================================================================
+    // Run-to-completion event queue
+    // ========================================================================
+    
+    /**
+     * @brief Switch to run-to-completion mode with a dedicated worker thread
+     * 
+     * While running:
+     * - post() enqueues an event without blocking (lock-free) and returns
+     *   false only if the queue is full.
+     * - trigger() from other threads enqueues the event and waits for its
+     *   result, so every transition executes on the worker, one at a time.
+     *   If the queue is full, the caller blocks until the worker frees a slot.
+     * - trigger()/post() from within guards, actions or state hooks (i.e. on
+     *   the worker) are deferred until the current transition completes.
+     *   trigger() then returns only whether the event was queued, not
+     *   whether it will cause a transition; false means the queue was full
+     *   and the event was dropped (counted in EventQueueStats::dropped).
+     * 
+     * Queued events without an explicit context (post(), deferred triggers)
+     * see the context bound with bind_context() at dispatch time.
+     */
+    void start_event_queue(EventQueueOptions options = {}) {
+        std::lock_guard<std::mutex> control(queue_control_mutex_);
+        if (queue_) {
+            LOG(WARNING) << "[SM:" << name_ << "] EVENT_QUEUE: already running";
+            return;
+        }
         
-        std::unique_lock<std::mutex> lock(mutex_);
+        std::size_t num_triggers;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            num_triggers = triggers_.size();
+        }
         
-        auto key = make_transition_key(current_state_, event);
-        auto it = transitions_.find(key);
+        queue_ = std::make_unique<EventQueueState>(options, num_triggers);
+        auto* q = queue_.get();
+        q->worker = std::thread([this, q]() { event_queue_loop(*q); });
+        q->worker_id = q->worker.get_id();
+        queue_running_.store(true, std::memory_order_release);
         
-        if (it == transitions_.end()) {
-            VLOG(1) << "[SM:" << name_ << "] IGNORED: trigger='" << event << "' state=" << state_name(current_state_) << " reason=no_transition";
-            return false;
+        LOG(INFO) << "[SM:" << name_ << "] EVENT_QUEUE: started capacity=" << q->ring.capacity()
+                  << " coalesce=" << (options.coalesce_duplicates ? "true" : "false");
+    }
+    
+    /**
+     * @brief Drain pending events, stop the worker and return to direct dispatch
+     * 
+     * Must not be called from the worker thread (guards, actions, hooks).
+     */
+    void stop_event_queue() {
+        std::lock_guard<std::mutex> control(queue_control_mutex_);
+        if (!queue_) {
+            return;
+        }
+        if (std::this_thread::get_id() == queue_->worker_id) {
+            LOG(ERROR) << "[SM:" << name_ << "] EVENT_QUEUE: stop_event_queue() called from worker thread";
+            return;
         }
         
-        // Find valid transition
-        for (const auto& transition : it->second) {
-            // Check condition
-            if (transition->condition && !transition->condition(context)) {
-                VLOG(1) << "[SM:" << name_ << "] BLOCKED: trigger='" << event << "' from=" << state_name(current_state_) << " to=" << state_name(transition->to_state) << " reason=condition_failed";
-                continue;
-            }
-            
-            // Valid transition found
-            auto old_state = current_state_.load();
-            
-            LOG(INFO) << "[SM:" << name_ << "] TRANSITION: " 
-                      << state_name(old_state) << " -> " << state_name(transition->to_state) 
-                      << " | trigger=" << event;
-            
-            // Exit current state
-            exit_state(old_state);
-            
-            // Execute transition action
-            if (transition->action) {
-                lock.unlock();
-                transition->action(context);
-                lock.lock();
-            }
-            
-            // Enter new state
-            enter_state(transition->to_state);
-            current_state_ = transition->to_state;
-            
-            // Record metrics
-            record_metrics(start_time);
-            
-            // Log current state for test framework
-            LOG(INFO) << "[SM:" << name_ << "] STATE: current=" << state_name(current_state_);
-            
-            return true;
+        // No new producers; wait for in-flight ones to finish pushing
+        queue_running_.store(false, std::memory_order_seq_cst);
+        while (queue_producers_.load(std::memory_order_seq_cst) > 0) {
+            std::this_thread::yield();
         }
         
-        return false;
+        {
+            std::lock_guard<std::mutex> lock(queue_->wake_mutex);
+            queue_->stopping.store(true, std::memory_order_release);
+        }
+        queue_->wake_cv.notify_all();
+        queue_->worker.join();
+        queue_.reset();
     }
     
-    void enter_state(StateT state) {
-        state_entry_time_ = std::chrono::system_clock::now();
-        
-        // Execute entry action
-        auto it = state_definitions_.find(state);
-        if (it != state_definitions_.end() && it->second->entry_action) {
-            it->second->entry_action();
+    /**
+     * @brief Check if run-to-completion mode is active
+     */
+    bool event_queue_running() const {
+        return queue_running_.load(std::memory_order_acquire);
+    }
+    
+    /**
+     * @brief Post an event without waiting for it to be processed
+     * 
+     * Without a running event queue the event is dispatched synchronously.
+     * 
+     * @return true if the event was queued (or coalesced with a pending
+     *         duplicate), false if the queue was full
+     */
+    bool post(TriggerId event) {
+        ProducerScope scope(queue_producers_);
+        if (!queue_running_.load(std::memory_order_seq_cst)) {
+            scope.release();
+            return trigger(event);
         }
-        
-        // Update metrics
-#ifdef SDV_WITH_PROMETHEUS
-        state_gauge_->Set(static_cast<double>(state));
-#endif
-        
+        return enqueue(*queue_, event, nullptr, nullptr);
     }
     
-    void exit_state(StateT state) {
-        // Record time in state
-        auto duration = std::chrono::duration<double>(
-            std::chrono::system_clock::now() - state_entry_time_
-        ).count();
-        
-#ifdef SDV_WITH_PROMETHEUS
-        state_duration_->Observe(duration);
-#endif
-        
-        // Execute exit action
-        auto it = state_definitions_.find(state);
-        if (it != state_definitions_.end() && it->second->exit_action) {
-            it->second->exit_action();
+    bool post(const std::string& event) {
+        auto id = trigger_id(event);
+        if (id == kInvalidTriggerId) {
+            VLOG(1) << "[SM:" << name_ << "] IGNORED: trigger='" << event << "' reason=unknown_trigger";
+            return false;
         }
+        return post(id);
     }
     
-    void record_metrics(std::chrono::steady_clock::time_point start_time) {
-#ifdef SDV_WITH_PROMETHEUS
-        auto latency = std::chrono::duration<double>(
-            std::chrono::steady_clock::now() - start_time
-        ).count();
-        
-        transition_counter_->Increment();
-        transition_latency_->Observe(latency);
-#endif
+    /**
+     * @brief Queue depth, counters and enqueue-to-dispatch latency
+     */
+    EventQueueStats event_queue_stats() const {
+        std::lock_guard<std::mutex> control(queue_control_mutex_);
+        EventQueueStats stats;
+        if (!queue_) {
+            return stats;
+        }
+        const auto& q = *queue_;
+        stats.depth = q.ring.size();
+        stats.capacity = q.ring.capacity();
+        stats.posted = q.posted.load(std::memory_order_relaxed);
+        stats.processed = q.processed.load(std::memory_order_relaxed);
+        stats.coalesced = q.coalesced.load(std::memory_order_relaxed);
+        stats.dropped = q.dropped.load(std::memory_order_relaxed);
+        stats.last_latency = std::chrono::nanoseconds(q.last_latency_ns.load(std::memory_order_relaxed));
+        stats.max_latency = std::chrono::nanoseconds(q.max_latency_ns.load(std::memory_order_relaxed));
+        if (stats.processed > 0) {
+            stats.mean_latency = std::chrono::nanoseconds(
+                q.total_latency_ns.load(std::memory_order_relaxed) / stats.processed);
+        }
+        return stats;
     }
     
-};
-
-// State definition builder
-template<typename StateT>
-class StateDefinition {
-public:
-    explicit StateDefinition(std::string name) : name_(std::move(name)) {}
+    /**
+     * @brief Use a dedicated timer service instead of the shared default
+     * 
+     * Call before any timer is scheduled (after() or state timeouts).
+     */
+    void set_timer_service(TimerService& service) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        timer_service_ = &service;
+    }
     
-    StateDefinition& on_entry(std::function<void()> action) {
-        entry_action = std::move(action);
-        return *this;
+    /**
+     * @brief Fire a trigger once after a delay
+     * 
+     * The event is dispatched on the timer thread (posted if the event
+     * queue is running) with the bound context.
+     * 
+     * @return Handle for cancel_timer(), or kInvalidTimerId while the machine
+     *         is being destroyed
+     */
+    TimerId after(std::chrono::nanoseconds delay, TriggerId event) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return schedule_locked(delay, event);
     }
     
-    StateDefinition& on_exit(std::function<void()> action) {
-        exit_action = std::move(action);
-        return *this;
+    TimerId after(std::chrono::nanoseconds delay, const std::string& event) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return schedule_locked(delay, intern_trigger(event));
     }
     
-    std::string name_;
-    std::function<void()> entry_action;
-    std::function<void()> exit_action;
-};
-
-// Transition definition
-template<typename StateT>
-class Transition {
-public:
-    StateT from_state;
-    StateT to_state;
-    std::string trigger;
-    ConditionFunc<StateT> condition;
-    ActionFunc<StateT> action;
+    /**
+     * @brief Cancel a pending after() event
+     * 
+     * @return true if the event was pending and will not fire
+     */
+    bool cancel_timer(TimerId id) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return cancel_timer_locked(id);
+    }
+    
+    /**
+     * @brief Capture current state, entry time, pending timers and context
+     * 
+     * See snapshot.hpp for persisting it (SnapshotFile) and restore() for
+     * resuming from it.
+     */
+    StateSnapshot snapshot() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return snapshot_locked();
+    }
+    
+    /**
+     * @brief Resume from a snapshot, e.g. after a process restart
+     * 
+     * Sets the current state without running exit or entry actions (the
+     * state was entered before the snapshot), backdates its entry time and
+     * re-arms the pending timers and state timeouts with their remaining
+     * time (overdue ones fire immediately). Timers pending before the call
+     * are cancelled. The context string is handed to the loader set with
+     * set_context_snapshot().
+     * 
+     * Call before events flow. Fails if the snapshot belongs to another
+     * machine name, names a state this machine does not know (see
+     * is_known_state()) or an asynchronous transition is in progress.
+     * 
+     * @return true if restored
+     */
+    bool restore(const StateSnapshot& snapshot) {
+        if (snapshot.machine != name_) {
+            LOG(WARNING) << "[SM:" << name_ << "] RESTORE: rejected snapshot of '" << snapshot.machine << "'";
+            return false;
+        }
+        using Underlying = std::underlying_type_t<StateT>;
+        const auto restored_state = static_cast<StateT>(static_cast<Underlying>(snapshot.state));
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (static_cast<std::int64_t>(static_cast<Underlying>(snapshot.state)) != snapshot.state ||
+                !is_known_state(restored_state)) {
+                LOG(ERROR) << "[SM:" << name_ << "] ERROR: restore() with unknown state " << snapshot.state;
+                return false;
+            }
+            if (pending_async_) {
+                LOG(WARNING) << "[SM:" << name_ << "] RESTORE: rejected, asynchronous transition in progress";
+                return false;
+            }
+        }
+        cancel_all_timers();
+        
+        std::function<void(const std::string&)> loader;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            auto system_now = std::chrono::system_clock::now();
+            auto steady_now = std::chrono::steady_clock::now();
+            auto remaining = [&](std::chrono::system_clock::time_point deadline) {
+                return std::max(std::chrono::nanoseconds(0),
+                                std::chrono::duration_cast<std::chrono::nanoseconds>(deadline - system_now));
+            };
+            
+            current_state_ = restored_state;
+            state_entry_time_ = steady_now - std::max(std::chrono::nanoseconds(0),
+                std::chrono::duration_cast<std::chrono::nanoseconds>(system_now - snapshot.entered));
+            
+            for (auto& [state, definition] : state_definitions_) {
+                definition->timeout_timer = kInvalidTimerId;
+            }
+            for (const auto& timer : snapshot.timers) {
+                auto handle = schedule_locked(remaining(timer.deadline), intern_trigger(timer.trigger));
+                if (timer.state_timeout) {
+                    auto owner = static_cast<StateT>(static_cast<Underlying>(timer.owner));
+                    auto it = state_definitions_.find(owner);
+                    if (it != state_definitions_.end()) {
+                        it->second->timeout_timer = handle;
+                    }
+                }
+            }
+            
+            table_dirty_ = true;
+            compile_table();
+            if (auto* counters = state_counters(current_state_)) {
+                counters->entered = state_entry_time_;
+            }
+            
+            LOG(INFO) << "[SM:" << name_ << "] RESTORED: state=" << cached_state_name(current_state_)
+                      << " timers=" << snapshot.timers.size();
+            if (!snapshot.context.empty()) {
+                loader = context_loader_;
+            }
+        }
+        if (loader) {
+            loader(snapshot.context);
+        }
+        return true;
+    }
+    
+    /**
+     * @brief Receive a snapshot after every completed transition
+     * 
+     * Called on the transitioning thread with the machine's mutex held,
+     * right after the observers; keep it short (SnapshotFile::write is a
+     * memory copy) and do not call back into the machine. Pass an empty
+     * function to stop.
+     */
+    void set_snapshot_sink(std::function<void(const StateSnapshot&)> sink) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        snapshot_sink_ = std::move(sink);
+    }
+    
+    /**
+     * @brief Include the application's context in snapshots
+     * 
+     * save is called (mutex held) whenever a snapshot is taken and returns
+     * opaque bytes; restore() passes them to load.
+     */
+    void set_context_snapshot(std::function<std::string()> save,
+                              std::function<void(const std::string&)> load) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        context_saver_ = std::move(save);
+        context_loader_ = std::move(load);
+    }
+    
+    /**
+     * @brief Machine name, as used in log lines and metrics
+     */
+    const std::string& name() const {
+        return name_;
+    }
+    
+    /**
+     * @brief Get current state
+     */
+    StateT current_state() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return current_state_;
+    }
+    
+    /**
+     * @brief Get current state name as string
+     */
+    std::string current_state_name() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return state_name(current_state_);
+    }
+    
+    /**
+     * @brief Get available triggers from current state
+     */
+    std::vector<std::string> available_triggers() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        compile_table();
+        
+        std::vector<std::string> triggers;
+        for (auto id : table_.triggers_for(current_state_)) {
+            triggers.push_back(triggers_.name(id));
+        }
+        
+        return triggers;
+    }
+    
+    /**
+     * @brief Record transitions into a binary trace ring
+     * 
+     * Replaces any previous trace; readers holding the old ring keep it.
+     * 
+     * @param capacity Records kept (rounded up to a power of two)
+     */
+    void enable_trace(std::size_t capacity = 1024) {
+        auto ring = std::make_shared<TraceRing<StateT>>(capacity);
+        std::lock_guard<std::mutex> lock(mutex_);
+        trace_ = std::move(ring);
+    }
+    
+    /**
+     * @brief The trace ring, or nullptr if tracing is disabled
+     * 
+     * Reading the ring is lock-free and safe while transitions run.
+     */
+    std::shared_ptr<const TraceRing<StateT>> trace() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return trace_;
+    }
+    
+    /**
+     * @brief Enable or disable the per-transition TRANSITION/STATE log lines
+     * 
+     * Log scrapers depend on these lines; in-process tests should use
+     * add_observer() (or sdv::testing::TestRunner::watch_state_machine())
+     * instead.
+     */
+    void set_text_logging(bool enabled) {
+        text_logging_.store(enabled, std::memory_order_relaxed);
+    }
+    
+    /**
+     * @brief Format one trace record with state and trigger names
+     * 
+     * Timestamps are relative to the machine's construction.
+     */
+    std::string format_trace_record(const TransitionRecord<StateT>& record) const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        compile_table();
+        std::ostringstream out;
+        format_record_locked(out, record);
+        return out.str();
+    }
+    
+    /**
+     * @brief Write the most recent trace records as text, oldest first
+     */
+    void dump_trace(std::ostream& out, std::size_t max_records = 64) const {
+        auto ring = trace();
+        if (!ring) {
+            out << "[SM:" << name_ << "] trace disabled\n";
+            return;
+        }
+        auto records = ring->latest(max_records);
+        
+        std::lock_guard<std::mutex> lock(mutex_);
+        compile_table();
+        for (const auto& record : records) {
+            format_record_locked(out, record);
+            out << "\n";
+        }
+    }
+    
+    /**
+     * @brief Call observer after every completed transition
+     * 
+     * Observers run on the transitioning thread with the machine locked,
+     * in transition order, after exit, action and entry. They must not call
+     * back into this machine synchronously; trigger_async(), and
+     * post(TriggerId) while the event queue runs, are fine.
+     * remove_observer() may be called from anywhere, including the observer
+     * itself.
+     * 
+     * @return Handle for remove_observer()
+     */
+    ObserverId add_observer(std::function<void(const TransitionEvent<StateT>&)> observer) {
+        return observers_.add(std::move(observer));
+    }
+    
+    /**
+     * @brief Unregister an observer
+     * 
+     * @return false if the handle is unknown
+     */
+    bool remove_observer(ObserverId id) {
+        return observers_.remove(id);
+    }
+    
+    /**
+     * @brief Snapshot of the machine's metrics
+     * 
+     * Transitions are listed in definition order, states in enum order.
+     */
+    MetricsSnapshot metrics() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        compile_table();
+        
+        MetricsSnapshot snapshot;
+        snapshot.machine = name_;
+        snapshot.current_state = cached_state_name(current_state_);
+        snapshot.transitions = transitions_taken_.load();
+        snapshot.ignored = ignored_.load();
+        
+        snapshot.transition_metrics.reserve(transitions_.size());
+        for (const auto& transition : transitions_) {
+            TransitionMetrics t;
+            t.from = cached_state_name(transition->from_state);
+            t.to = cached_state_name(transition->to_state);
+            t.trigger = transition->trigger;
+            t.latency = transition->latency.snapshot();
+            t.blocked = transition->blocked.load();
+            snapshot.transition_metrics.push_back(std::move(t));
+        }
+        
+        for (std::size_t i = 0; i < state_counter_index_.size(); ++i) {
+            const auto* counters = state_counter_index_[i];
+            if (!counters) {
+                continue;
+            }
+            StateMetrics s;
+            s.state = state_names_[i];
+            s.entries = counters->entries.load();
+            s.time_in_state = std::chrono::nanoseconds(counters->time_ns.load());
+            snapshot.state_metrics.push_back(std::move(s));
+        }
+        return snapshot;
+    }
+    
+    /**
+     * @brief Reset all counters and histograms to zero
+     */
+    void reset_metrics() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (auto& transition : transitions_) {
+            transition->latency.reset();
+            transition->blocked.reset();
+        }
+        for (auto& [state, counters] : state_counters_) {
+            counters->reset();
+        }
+        transitions_taken_.reset();
+        ignored_.reset();
+    }
+    
+protected:
+    std::string name_;
+    mutable std::mutex mutex_;
+    std::atomic<StateT> current_state_;
+    StateNameFunc<StateT> state_name_func_;
+    
+    // State management
+    std::unordered_map<StateT, std::unique_ptr<StateDefinition<StateT>>> state_definitions_;
+    std::vector<std::unique_ptr<Transition<StateT, ContextT>>> transitions_;
+    TriggerRegistry triggers_;
+    
+    // Compiled dispatch table, rebuilt on first use after a definition change
+    mutable TransitionTable<StateT, Transition<StateT, ContextT>> table_;
+    mutable std::vector<std::string> state_names_;  // indexed like table_ rows
+    mutable bool table_dirty_ = true;
+    
+    // State hierarchy (empty for flat machines), folded into table_ on compile
+    std::unordered_map<StateT, StateT> parent_states_;
+    std::unordered_map<StateT, StateT> initial_substates_;
+    int actions_in_flight_ = 0;  // compiled paths stay pinned while an action runs unlocked
+    
+    // Delayed events and state timeouts, by machine-local handle
+    struct PendingTimer {
+        TimerId id;                                      // timer service id
+        TriggerId event;
+        std::chrono::steady_clock::time_point deadline;  // for snapshots
+    };
+    TimerService* timer_service_ = nullptr;
+    std::unordered_map<TimerId, PendingTimer> timers_;
+    TimerId next_timer_handle_ = kInvalidTimerId;
+    int timers_firing_ = 0;             // on_timer() calls past the timers_ check
+    std::condition_variable timers_idle_;
+    std::thread::id timer_thread_;      // thread of the last on_timer() call
+    
+    // Snapshots (see set_snapshot_sink)
+    std::function<void(const StateSnapshot&)> snapshot_sink_;
+    std::function<std::string()> context_saver_;
+    std::function<void(const std::string&)> context_loader_;
+    
+    std::atomic<const ContextT*> bound_context_{nullptr};
+    
+    // Run-to-completion event queue (see start_event_queue)
+    struct EventQueueState {
+        EventQueueState(const EventQueueOptions& opts, std::size_t num_triggers)
+            : options(opts)
+            , ring(opts.capacity)
+            , pending(std::make_unique<std::atomic<bool>[]>(num_triggers))
+            , pending_size(num_triggers) {
+            for (std::size_t i = 0; i < num_triggers; ++i) {
+                pending[i].store(false, std::memory_order_relaxed);
+            }
+        }
+        
+        EventQueueOptions options;
+        MpscRingBuffer<detail::QueuedEvent<ContextT>> ring;
+        std::unique_ptr<std::atomic<bool>[]> pending;  // coalescing flags per trigger
+        std::size_t pending_size;
+        
+        std::thread worker;
+        std::thread::id worker_id;
+        std::mutex wake_mutex;
+        std::condition_variable wake_cv;
+        std::atomic<bool> worker_waiting{false};
+        std::atomic<bool> stopping{false};
+        
+        // Blocking producers wait here for the worker to free a slot
+        std::mutex space_mutex;
+        std::condition_variable space_cv;
+        std::atomic<int> space_waiters{0};
+        
+        std::atomic<std::uint64_t> posted{0};
+        std::atomic<std::uint64_t> processed{0};
+        std::atomic<std::uint64_t> coalesced{0};
+        std::atomic<std::uint64_t> dropped{0};
+        std::atomic<std::uint64_t> last_latency_ns{0};
+        std::atomic<std::uint64_t> max_latency_ns{0};
+        std::atomic<std::uint64_t> total_latency_ns{0};
+    };
+    
+    // Counts threads between checking queue_running_ and finishing a push
+    class ProducerScope {
+    public:
+        explicit ProducerScope(std::atomic<int>& count) : count_(&count) {
+            count_->fetch_add(1, std::memory_order_seq_cst);
+        }
+        ~ProducerScope() { release(); }
+        void release() {
+            if (count_) {
+                count_->fetch_sub(1, std::memory_order_seq_cst);
+                count_ = nullptr;
+            }
+        }
+    private:
+        std::atomic<int>* count_;
+    };
+    
+    mutable std::mutex queue_control_mutex_;
+    std::unique_ptr<EventQueueState> queue_;
+    std::atomic<bool> queue_running_{false};
+    std::atomic<int> queue_producers_{0};
+    std::chrono::steady_clock::time_point state_entry_time_;
+    const std::chrono::steady_clock::time_point created_;
+    
+    // Binary transition trace (written with mutex_ held) and text log switch
+    std::shared_ptr<TraceRing<StateT>> trace_;
+    std::atomic<bool> text_logging_{true};
+    
+    // Asynchronous transition in progress (see add_async_transition)
+    struct PendingAsync {
+        std::uint64_t sequence = 0;
+        typename TransitionTable<StateT, Transition<StateT, ContextT>>::Candidates candidates;
+        const typename TransitionTable<StateT, Transition<StateT, ContextT>>::Entry* entry = nullptr;
+        StateT from{};
+        std::chrono::steady_clock::time_point start_time;
+        bool guarding = false;
+        std::unique_ptr<ContextT> context;  // copy, while an asynchronous guard runs
+    };
+    
+    struct DeferredEvent {
+        TriggerId trigger = kInvalidTriggerId;
+        std::unique_ptr<ContextT> context;  // nullptr: bound context at dispatch
+    };
+    
+    std::optional<PendingAsync> pending_async_;
+    std::deque<DeferredEvent> deferred_;
+    bool draining_deferred_ = false;
+    std::uint64_t async_sequence_ = 0;
+    std::shared_ptr<detail::AsyncLifetime> lifetime_ = std::make_shared<detail::AsyncLifetime>();
+    std::unique_ptr<Executor> future_waiter_;  // waits on futures of asynchronous guards and actions
+    
+    // Transition observers (notified with mutex_ held, registered without it)
+    ObserverList<TransitionEvent<StateT>> observers_;
+    
+    // Metrics (written with mutex_ held; per-transition counters live in Transition)
+    mutable std::unordered_map<StateT, std::unique_ptr<detail::StateCounters>> state_counters_;
+    mutable std::vector<detail::StateCounters*> state_counter_index_;  // indexed like table_ rows
+    detail::MetricCounter transitions_taken_;
+    mutable detail::MetricCounter ignored_;
+    
+    TriggerId intern_trigger(const std::string& trigger) {
+        auto before = triggers_.size();
+        auto id = triggers_.intern(trigger);
+        if (triggers_.size() != before) {
+            table_dirty_ = true;
+        }
+        return id;
+    }
+    
+    Transition<StateT, ContextT>& add_transition_locked(StateT from_state, StateT to_state, TriggerId id,
+                                                        std::string trigger,
+                                                        ConditionFunc<StateT, ContextT> condition,
+                                                        ActionFunc<StateT, ContextT> action) {
+        auto transition = std::make_unique<Transition<StateT, ContextT>>(
+            from_state, to_state, std::move(trigger),
+            std::move(condition), std::move(action)
+        );
+        transition->trigger_id = id;
+        transitions_.push_back(std::move(transition));
+        table_dirty_ = true;
+        return *transitions_.back();
+    }
+    
+    /**
+     * @brief Rebuild the dense dispatch table and state name cache if stale
+     * 
+     * Must be called with mutex_ held.
+     */
+    void compile_table() const {
+        if (!table_dirty_ || actions_in_flight_ > 0) {
+            return;
+        }
+        
+        std::vector<const Transition<StateT, ContextT>*> transitions;
+        transitions.reserve(transitions_.size());
+        for (const auto& transition : transitions_) {
+            transitions.push_back(transition.get());
+        }
+        
+        std::vector<StateT> states{current_state_.load()};
+        for (const auto& [state, _] : state_definitions_) {
+            states.push_back(state);
+        }
+        for (const auto& [child, parent] : parent_states_) {
+            states.push_back(child);
+            states.push_back(parent);
+        }
+        for (const auto& [parent, initial] : initial_substates_) {
+            states.push_back(parent);
+            states.push_back(initial);
+        }
+        
+        auto lookup = [](const std::unordered_map<StateT, StateT>& map) {
+            return [&map](StateT state) -> std::optional<StateT> {
+                auto it = map.find(state);
+                if (it == map.end()) {
+                    return std::nullopt;
+                }
+                return it->second;
+            };
+        };
+        table_.build(transitions, states, triggers_.size(),
+                     lookup(parent_states_), lookup(initial_substates_));
+        
+        state_names_.clear();
+        state_names_.reserve(table_.num_states());
+        state_counter_index_.assign(table_.num_states(), nullptr);
+        for (std::size_t i = 0; i < table_.num_states(); ++i) {
+            auto state = table_.state_at(i);
+            state_names_.push_back(state_name(state));
+            
+            // Counters survive rebuilds
+            auto it = state_counters_.find(state);
+            if (it == state_counters_.end() && is_known_state(state)) {
+                auto entry = std::make_unique<detail::StateCounters>();
+                entry->entered = state_entry_time_;
+                it = state_counters_.emplace(state, std::move(entry)).first;
+            }
+            if (it != state_counters_.end()) {
+                state_counter_index_[i] = it->second.get();
+            }
+        }
+        
+        table_dirty_ = false;
+    }
+    
+    TimerService& timer_service() {
+        if (!timer_service_) {
+            timer_service_ = &TimerService::default_service();
+        }
+        return *timer_service_;
+    }
+    
+    /**
+     * @brief Schedule a delayed trigger (mutex_ held)
+     * 
+     * Handles are machine-local; a handle removed from timers_ (cancelled
+     * or fired) turns a callback that is already running into a no-op.
+     * Nothing is scheduled once the machine is being destroyed.
+     */
+    TimerId schedule_locked(std::chrono::nanoseconds delay, TriggerId event) {
+        if (!lifetime_->alive.load()) {
+            return kInvalidTimerId;
+        }
+        auto handle = ++next_timer_handle_;
+        auto id = timer_service().after(delay, [this, handle, event]() {
+            on_timer(handle, event);
+        });
+        timers_.emplace(handle, PendingTimer{id, event, std::chrono::steady_clock::now() + delay});
+        return handle;
+    }
+    
+    bool cancel_timer_locked(TimerId handle) {
+        auto it = timers_.find(handle);
+        if (it == timers_.end()) {
+            return false;
+        }
+        timer_service().cancel(it->second.id);
+        timers_.erase(it);
+        return true;
+    }
+    
+    void on_timer(TimerId handle, TriggerId event) {
+        std::unique_lock<std::mutex> lock(mutex_);
+        timer_thread_ = std::this_thread::get_id();
+        if (timers_.erase(handle) == 0) {
+            return;  // cancelled (e.g. state exited) while the callback was queued
+        }
+        // The handle is gone, so cancel_all_timers() waits on the count instead
+        ++timers_firing_;
+        VLOG(1) << "[SM:" << name_ << "] TIMER: trigger='" << triggers_.name(event) << "'";
+        try {
+            if (queue_running_.load(std::memory_order_acquire)) {
+                lock.unlock();
+                post(event);
+            } else {
+                execute_transition(lock, event, default_context());
+            }
+        } catch (const std::exception& e) {
+            LOG(ERROR) << "[SM:" << name_ << "] TIMER: trigger='" << triggers_.name(event) << "' threw: " << e.what();
+        }
+        if (!lock.owns_lock()) {
+            lock.lock();
+        }
+        --timers_firing_;
+        timers_idle_.notify_all();
+    }
+    
+    /**
+     * @brief Cancel every timer and wait for callbacks that are running
+     * 
+     * A firing timer may schedule new ones (state timeouts), so this repeats
+     * until none are left. From the timer thread itself (an action of a
+     * timed trigger) it does not wait for that callback.
+     */
+    void cancel_all_timers() {
+        for (;;) {
+            std::vector<TimerId> pending;
+            {
+                std::unique_lock<std::mutex> lock(mutex_);
+                if (!timer_service_) {
+                    return;
+                }
+                if (std::this_thread::get_id() != timer_thread_) {
+                    timers_idle_.wait(lock, [this]() { return timers_firing_ == 0; });
+                }
+                if (timers_.empty()) {
+                    return;
+                }
+                for (const auto& [handle, timer] : timers_) {
+                    pending.push_back(timer.id);
+                }
+                timers_.clear();
+            }
+            for (auto id : pending) {
+                timer_service_->cancel_and_wait(id);
+            }
+        }
+    }
+    
+    /**
+     * @brief Whether a state is referenced by a transition, definition or the hierarchy
+     */
+    bool is_known_state(StateT state) const {
+        if (state == current_state_.load() || state_definitions_.count(state) ||
+            parent_states_.count(state) || initial_substates_.count(state)) {
+            return true;
+        }
+        for (const auto& transition : transitions_) {
+            if (transition->from_state == state || transition->to_state == state) {
+                return true;
+            }
+        }
+        return false;
+    }
+    
+    detail::StateCounters* state_counters(StateT state) const {
+        auto index = table_.index_of(state);
+        return index >= 0 ? state_counter_index_[static_cast<std::size_t>(index)] : nullptr;
+    }
+    
+    const ContextT& default_context() const {
+        if (const auto* bound = bound_context_.load(std::memory_order_acquire)) {
+            return *bound;
+        }
+        static const ContextT empty{};
+        return empty;
+    }
+    
+    /**
+     * @brief Route a trigger through the event queue
+     * 
+     * @return std::nullopt if the queue is not running (dispatch directly)
+     */
+    std::optional<bool> dispatch_to_queue(TriggerId event, const ContextT* context) {
+        ProducerScope scope(queue_producers_);
+        if (!queue_running_.load(std::memory_order_seq_cst)) {
+            return std::nullopt;
+        }
+        auto& q = *queue_;
+        
+        if (std::this_thread::get_id() == q.worker_id) {
+            // Run-to-completion: defer until the current transition finishes.
+            // The caller's context may not outlive this call, so it is not kept.
+            return enqueue(q, event, nullptr, nullptr);
+        }
+        
+        detail::EventCompletion completion;
+        enqueue(q, event, context, &completion);
+        scope.release();
+        return completion.wait();
+    }
+    
+    bool enqueue(EventQueueState& q, TriggerId event, const ContextT* context,
+                 detail::EventCompletion* completion) {
+        detail::QueuedEvent<ContextT> queued{event, context, completion, std::chrono::steady_clock::now()};
+        
+        if (!completion) {
+            bool coalesce = q.options.coalesce_duplicates && event < q.pending_size;
+            if (coalesce && q.pending[event].exchange(true, std::memory_order_acq_rel)) {
+                q.coalesced.fetch_add(1, std::memory_order_relaxed);
+                return true;
+            }
+            if (!q.ring.try_push(queued)) {
+                if (coalesce) {
+                    q.pending[event].store(false, std::memory_order_release);
+                }
+                q.dropped.fetch_add(1, std::memory_order_relaxed);
+                VLOG(1) << "[SM:" << name_ << "] EVENT_QUEUE: dropped trigger_id=" << event << " reason=queue_full";
+                return false;
+            }
+        } else {
+            // Blocking callers wait for space rather than lose the event
+            if (!q.ring.try_push(queued)) {
+                std::unique_lock<std::mutex> lock(q.space_mutex);
+                q.space_waiters.fetch_add(1, std::memory_order_seq_cst);
+                // Pairs with the fence in free_slot: either the worker sees
+                // this waiter, or this push sees the slot it freed
+                std::atomic_thread_fence(std::memory_order_seq_cst);
+                q.space_cv.wait(lock, [&q, &queued]() { return q.ring.try_push(queued); });
+                q.space_waiters.fetch_sub(1, std::memory_order_relaxed);
+            }
+        }
+        
+        q.posted.fetch_add(1, std::memory_order_relaxed);
+        
+        // Pairs with the fence in event_queue_loop: either we see the worker
+        // waiting, or the worker sees our event before it blocks.
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (q.worker_waiting.load(std::memory_order_relaxed)) {
+            { std::lock_guard<std::mutex> lock(q.wake_mutex); }
+            q.wake_cv.notify_one();
+        }
+        return true;
+    }
+    
+    // Wake producers blocked on a full queue after a pop
+    static void free_slot(EventQueueState& q) {
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (q.space_waiters.load(std::memory_order_relaxed) > 0) {
+            { std::lock_guard<std::mutex> lock(q.space_mutex); }
+            q.space_cv.notify_all();
+        }
+    }
+    
+    void event_queue_loop(EventQueueState& q) {
+        detail::QueuedEvent<ContextT> event;
+        for (;;) {
+            if (q.ring.try_pop(event)) {
+                free_slot(q);
+                process_queued(q, event);
+                continue;
+            }
+            if (q.stopping.load(std::memory_order_acquire)) {
+                // Producers have quiesced; drain what is left and exit
+                while (q.ring.try_pop(event)) {
+                    process_queued(q, event);
+                }
+                return;
+            }
+            
+            std::unique_lock<std::mutex> lock(q.wake_mutex);
+            q.worker_waiting.store(true, std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            q.wake_cv.wait(lock, [&q]() {
+                return !q.ring.empty() || q.stopping.load(std::memory_order_acquire);
+            });
+            q.worker_waiting.store(false, std::memory_order_relaxed);
+        }
+    }
+    
+    void process_queued(EventQueueState& q, const detail::QueuedEvent<ContextT>& event) {
+        auto latency = static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now() - event.enqueued).count());
+        q.last_latency_ns.store(latency, std::memory_order_relaxed);
+        q.total_latency_ns.fetch_add(latency, std::memory_order_relaxed);
+        if (latency > q.max_latency_ns.load(std::memory_order_relaxed)) {
+            q.max_latency_ns.store(latency, std::memory_order_relaxed);
+        }
+        
+        if (!event.completion && q.options.coalesce_duplicates && event.trigger < q.pending_size) {
+            q.pending[event.trigger].store(false, std::memory_order_release);
+        }
+        
+        const ContextT& context = event.context ? *event.context : default_context();
+        try {
+            std::unique_lock<std::mutex> lock(mutex_);
+            bool result = execute_transition(lock, event.trigger, context);
+            q.processed.fetch_add(1, std::memory_order_relaxed);
+            if (event.completion) {
+                event.completion->complete(result);
+            }
+        } catch (...) {
+            q.processed.fetch_add(1, std::memory_order_relaxed);
+            if (event.completion) {
+                event.completion->complete(false, std::current_exception());
+            } else {
+                LOG(ERROR) << "[SM:" << name_ << "] ERROR: trigger='" << trigger_name(event.trigger)
+                           << "' reason=action_exception";
+            }
+        }
+    }
+    
+    /**
+     * @brief Cached state name (mutex_ held, table compiled)
+     */
+    const std::string& cached_state_name(StateT state) const {
+        static const std::string unknown = "UNKNOWN";
+        auto index = table_.index_of(state);
+        return index >= 0 ? state_names_[static_cast<std::size_t>(index)] : unknown;
+    }
+    
+protected:
+    std::string state_name(StateT state) const {
+        if (state_name_func_) {
+            return state_name_func_(state);
+        }
+        // Fallback to numeric representation
+        return "State_" + std::to_string(static_cast<int>(state));
+    }
+    
+private:
+    using TableEntry = typename TransitionTable<StateT, Transition<StateT, ContextT>>::Entry;
+    using TableCandidates = typename TransitionTable<StateT, Transition<StateT, ContextT>>::Candidates;
+    
+    bool execute_transition(std::unique_lock<std::mutex>& lock, TriggerId event,
+                            const ContextT& context) {
+        if (pending_async_ || draining_deferred_) {
+            defer_event(event, context);
+            return true;
+        }
+        return dispatch_event(lock, event, context);
+    }
+    
+    bool dispatch_event(std::unique_lock<std::mutex>& lock, TriggerId event,
+                        const ContextT& context) {
+        auto start_time = std::chrono::steady_clock::now();
+        
+        compile_table();
+        
+        auto candidates = table_.find(current_state_, event);
+        
+        if (candidates.empty()) {
+            VLOG(1) << "[SM:" << name_ << "] IGNORED: trigger='" << triggers_.name(event) << "' state=" << cached_state_name(current_state_) << " reason=no_transition";
+            ignored_.add();
+            return false;
+        }
+        
+        return run_candidates(lock, context, candidates, candidates.begin(), start_time);
+    }
+    
+    /**
+     * @brief Take the first enabled candidate from first on (own transitions first, then ancestors')
+     */
+    bool run_candidates(std::unique_lock<std::mutex>& lock, const ContextT& context,
+                        TableCandidates candidates, const TableEntry* first,
+                        std::chrono::steady_clock::time_point start_time) {
+        for (auto it = first; it != candidates.end(); ++it) {
+            const auto& entry = *it;
+            const auto* transition = entry.transition;
+            if (transition->condition_async) {
+                start_async(lock, candidates, it, context, start_time);
+                return true;
+            }
+            
+            // Check condition
+            if (transition->condition && !transition->condition(context)) {
+                VLOG(1) << "[SM:" << name_ << "] BLOCKED: trigger='" << transition->trigger << "' from=" << cached_state_name(current_state_) << " to=" << cached_state_name(entry.target) << " reason=condition_failed";
+                transition->blocked.add();
+                continue;
+            }
+            
+            if (transition->action_async || transition->action_callback) {
+                start_async(lock, candidates, it, context, start_time);
+                return true;
+            }
+            
+            // Valid transition found
+            auto old_state = current_state_.load();
+            begin_transition(entry, old_state, start_time);
+            
+            // Execute transition action
+            if (transition->action) {
+                ++actions_in_flight_;
+                lock.unlock();
+                try {
+                    transition->action(context);
+                } catch (...) {
+                    lock.lock();
+                    --actions_in_flight_;
+                    throw;
+                }
+                lock.lock();
+                --actions_in_flight_;
+            }
+            
+            finish_transition(entry, old_state, start_time);
+            return true;
+        }
+        
+        ignored_.add();  // every candidate was blocked
+        return false;
+    }
+    
+    /**
+     * @brief Log the transition and exit the current state and any ancestors it leaves
+     */
+    void begin_transition(const TableEntry& entry, StateT old_state,
+                          std::chrono::steady_clock::time_point start_time) {
+        if (text_logging_.load(std::memory_order_relaxed)) {
+            LOG(INFO) << "[SM:" << name_ << "] TRANSITION: " 
+                      << cached_state_name(old_state) << " -> " << cached_state_name(entry.target) 
+                      << " | trigger=" << entry.transition->trigger;
+        }
+        
+        for (auto state : table_.exits(entry)) {
+            exit_state(state, start_time);
+        }
+    }
+    
+    /**
+     * @brief Enter the target path, switch state, record and notify
+     */
+    void finish_transition(const TableEntry& entry, StateT old_state,
+                           std::chrono::steady_clock::time_point start_time) {
+        // Enter target ancestors, the target, then initial substates
+        for (auto state : table_.entries(entry)) {
+            enter_state(state, start_time);
+        }
+        current_state_ = entry.target;
+        
+        // Record metrics
+        auto latency = record_metrics(*entry.transition, old_state, entry.target, start_time);
+        
+        // Log current state for test framework
+        if (text_logging_.load(std::memory_order_relaxed)) {
+            LOG(INFO) << "[SM:" << name_ << "] STATE: current=" << cached_state_name(current_state_);
+        }
+        
+        if (!observers_.empty()) {
+            TransitionEvent<StateT> event;
+            event.machine = name_;
+            event.from = old_state;
+            event.to = entry.target;
+            event.from_name = cached_state_name(old_state);
+            event.to_name = cached_state_name(entry.target);
+            event.trigger = entry.transition->trigger_id;
+            event.trigger_name = entry.transition->trigger;
+            event.timestamp = start_time;
+            event.duration = latency;
+            observers_.notify(event);
+        }
+        
+        if (snapshot_sink_) {
+            try {
+                snapshot_sink_(snapshot_locked());
+            } catch (const std::exception& e) {
+                LOG(ERROR) << "[SM:" << name_ << "] SNAPSHOT: sink threw: " << e.what();
+            }
+        }
+    }
+    
+    StateSnapshot snapshot_locked() const {
+        auto system_now = std::chrono::system_clock::now();
+        auto steady_now = std::chrono::steady_clock::now();
+        auto to_system = [&](std::chrono::steady_clock::time_point time) {
+            return system_now + std::chrono::duration_cast<std::chrono::system_clock::duration>(time - steady_now);
+        };
+        
+        StateSnapshot snapshot;
+        snapshot.machine = name_;
+        snapshot.state = static_cast<std::int64_t>(static_cast<std::underlying_type_t<StateT>>(current_state_.load()));
+        snapshot.entered = to_system(state_entry_time_);
+        snapshot.taken = system_now;
+        snapshot.timers.reserve(timers_.size());
+        for (const auto& [handle, timer] : timers_) {
+            SnapshotTimer entry;
+            entry.trigger = triggers_.name(timer.event);
+            entry.deadline = to_system(timer.deadline);
+            for (const auto& [state, definition] : state_definitions_) {
+                if (definition->timeout_timer == handle) {
+                    entry.state_timeout = true;
+                    entry.owner = static_cast<std::int64_t>(static_cast<std::underlying_type_t<StateT>>(state));
+                    break;
+                }
+            }
+            snapshot.timers.push_back(std::move(entry));
+        }
+        if (context_saver_) {
+            snapshot.context = context_saver_();
+        }
+        return snapshot;
+    }
+    
+    // ========================================================================
+    // Asynchronous transitions
+    // ========================================================================
+    
+    void ensure_future_waiter() {
+        if (!future_waiter_) {
+            future_waiter_ = std::make_unique<Executor>(1);
+        }
+    }
+    
+    static std::unique_ptr<ContextT> copy_context(const ContextT& context) {
+        if constexpr (std::is_copy_constructible_v<ContextT>) {
+            return std::make_unique<ContextT>(context);
+        } else {
+            return nullptr;
+        }
+    }
+    
+    void defer_event(TriggerId event, const ContextT& context) {
+        DeferredEvent deferred;
+        deferred.trigger = event;
+        if (&context != &default_context()) {
+            deferred.context = copy_context(context);
+        }
+        deferred_.push_back(std::move(deferred));
+        VLOG(1) << "[SM:" << name_ << "] DEFERRED: trigger='" << triggers_.name(event) << "' reason=in_transition";
+    }
+    
+    /**
+     * @brief Enter the in-transition status for candidate entry (mutex_ held)
+     * 
+     * The table stays pinned (actions_in_flight_) until the transition
+     * completes, so the candidate range and paths remain valid.
+     */
+    void start_async(std::unique_lock<std::mutex>& lock, TableCandidates candidates,
+                     const TableEntry* entry, const ContextT& context,
+                     std::chrono::steady_clock::time_point start_time) {
+        auto& pending = pending_async_.emplace();
+        pending.sequence = ++async_sequence_;
+        pending.candidates = candidates;
+        pending.entry = entry;
+        pending.from = current_state_.load();
+        pending.start_time = start_time;
+        ++actions_in_flight_;
+        
+        const auto* transition = entry->transition;
+        if (!transition->condition_async) {
+            launch_action(lock, context);
+            return;
+        }
+        
+        // The guard's context must outlive the caller's
+        pending.guarding = true;
+        pending.context = copy_context(context);
+        auto sequence = pending.sequence;
+        const ContextT& guard_context = *pending.context;
+        VLOG(1) << "[SM:" << name_ << "] GUARD_PENDING: trigger='" << transition->trigger << "' from=" << cached_state_name(pending.from) << " to=" << cached_state_name(entry->target);
+        
+        std::future<bool> future;
+        lock.unlock();
+        try {
+            future = transition->condition_async(guard_context);
+        } catch (...) {
+            lock.lock();
+            guard_done(lock, sequence, false, std::current_exception());
+            return;
+        }
+        lock.lock();
+        
+        watch_future(std::move(future), [this, sequence](std::future<bool>& ready) {
+            bool passed = false;
+            std::exception_ptr error;
+            try {
+                passed = ready.get();
+            } catch (...) {
+                error = std::current_exception();
+            }
+            std::unique_lock<std::mutex> lock(mutex_);
+            guard_done(lock, sequence, passed, error);
+        });
+    }
+    
+    /**
+     * @brief Exit the source and start the action of pending_async_ (mutex_ held)
+     */
+    void launch_action(std::unique_lock<std::mutex>& lock, const ContextT& context) {
+        const auto& pending = *pending_async_;
+        auto sequence = pending.sequence;
+        const auto& entry = *pending.entry;
+        const auto* transition = entry.transition;
+        begin_transition(entry, pending.from, pending.start_time);
+        
+        // pending_async_ may be completed by another thread once unlocked
+        std::exception_ptr error;
+        bool done_inline = false;
+        lock.unlock();
+        try {
+            if (transition->action_async) {
+                watch_future(transition->action_async(context), [this, sequence](std::future<void>& ready) {
+                    std::exception_ptr error;
+                    try {
+                        ready.get();
+                    } catch (...) {
+                        error = std::current_exception();
+                    }
+                    std::unique_lock<std::mutex> lock(mutex_);
+                    action_done(lock, sequence, error);
+                });
+            } else if (transition->action_callback) {
+                transition->action_callback(context, make_completion(sequence));
+            } else {
+                if (transition->action) {
+                    transition->action(context);
+                }
+                done_inline = true;
+            }
+        } catch (...) {
+            error = std::current_exception();
+            done_inline = true;
+        }
+        lock.lock();
+        
+        if (done_inline) {
+            action_done(lock, sequence, error);
+        }
+    }
+    
+    void guard_done(std::unique_lock<std::mutex>& lock, std::uint64_t sequence, bool passed,
+                    std::exception_ptr error) {
+        if (!pending_async_ || pending_async_->sequence != sequence || !pending_async_->guarding) {
+            return;
+        }
+        auto& pending = *pending_async_;
+        auto context = std::move(pending.context);
+        
+        if (passed && !error) {
+            pending.guarding = false;
+            launch_action(lock, *context);
+            return;
+        }
+        
+        const auto* transition = pending.entry->transition;
+        if (error) {
+            try {
+                std::rethrow_exception(error);
+            } catch (const std::exception& e) {
+                LOG(ERROR) << "[SM:" << name_ << "] ERROR: trigger='" << transition->trigger << "' reason=guard_exception: " << e.what();
+            } catch (...) {
+                LOG(ERROR) << "[SM:" << name_ << "] ERROR: trigger='" << transition->trigger << "' reason=guard_exception";
+            }
+        }
+        VLOG(1) << "[SM:" << name_ << "] BLOCKED: trigger='" << transition->trigger << "' from=" << cached_state_name(pending.from) << " to=" << cached_state_name(pending.entry->target) << " reason=condition_failed";
+        transition->blocked.add();
+        
+        // Fall through to the remaining candidates, still covered by the pin
+        auto candidates = pending.candidates;
+        auto next = pending.entry + 1;
+        auto start_time = pending.start_time;
+        pending_async_.reset();
+        try {
+            run_candidates(lock, *context, candidates, next, start_time);
+        } catch (...) {
+            --actions_in_flight_;
+            drain_deferred(lock);
+            throw;
+        }
+        --actions_in_flight_;
+        drain_deferred(lock);
+    }
+    
+    void action_done(std::unique_lock<std::mutex>& lock, std::uint64_t sequence, std::exception_ptr error) {
+        if (!pending_async_ || pending_async_->sequence != sequence || pending_async_->guarding) {
+            return;
+        }
+        auto pending = std::move(*pending_async_);
+        pending_async_.reset();
+        
+        if (error) {
+            // Like a throwing synchronous action: source exited, state unchanged
+            try {
+                std::rethrow_exception(error);
+            } catch (const std::exception& e) {
+                LOG(ERROR) << "[SM:" << name_ << "] ERROR: trigger='" << pending.entry->transition->trigger << "' reason=action_exception: " << e.what();
+            } catch (...) {
+                LOG(ERROR) << "[SM:" << name_ << "] ERROR: trigger='" << pending.entry->transition->trigger << "' reason=action_exception";
+            }
+        } else {
+            try {
+                finish_transition(*pending.entry, pending.from, pending.start_time);
+            } catch (...) {
+                --actions_in_flight_;
+                drain_deferred(lock);
+                throw;
+            }
+        }
+        --actions_in_flight_;
+        drain_deferred(lock);
+    }
+    
+    /**
+     * @brief Dispatch deferred events in order until one starts another asynchronous transition
+     */
+    void drain_deferred(std::unique_lock<std::mutex>& lock) {
+        if (draining_deferred_) {
+            return;  // an outer drain on this stack continues
+        }
+        draining_deferred_ = true;
+        while (!pending_async_ && !deferred_.empty()) {
+            auto deferred = std::move(deferred_.front());
+            deferred_.pop_front();
+            try {
+                dispatch_event(lock, deferred.trigger,
+                               deferred.context ? *deferred.context : default_context());
+            } catch (const std::exception& e) {
+                LOG(ERROR) << "[SM:" << name_ << "] ERROR: trigger='" << triggers_.name(deferred.trigger) << "' reason=action_exception: " << e.what();
+            } catch (...) {
+                LOG(ERROR) << "[SM:" << name_ << "] ERROR: trigger='" << triggers_.name(deferred.trigger) << "' reason=action_exception";
+            }
+        }
+        draining_deferred_ = false;
+    }
+    
+    CompletionFunc make_completion(std::uint64_t sequence) {
+        std::weak_ptr<detail::AsyncLifetime> weak = lifetime_;
+        return [this, weak, sequence](std::exception_ptr error) {
+            auto lifetime = weak.lock();
+            if (!lifetime) {
+                return;
+            }
+            std::lock_guard<std::recursive_mutex> alive(lifetime->mutex);
+            if (!lifetime->alive.load()) {
+                return;
+            }
+            std::unique_lock<std::mutex> lock(mutex_);
+            action_done(lock, sequence, error);
+        };
+    }
+    
+    /**
+     * @brief Run handler on the waiter thread once future is ready
+     * 
+     * The wait wakes periodically only to notice that the machine is gone.
+     */
+    template<typename T, typename Handler>
+    void watch_future(std::future<T> future, Handler handler) {
+        auto shared = std::make_shared<std::future<T>>(std::move(future));
+        std::weak_ptr<detail::AsyncLifetime> weak = lifetime_;
+        future_waiter_->post([this, weak, shared, handler]() mutable {
+            if (shared->valid()) {
+                while (shared->wait_for(std::chrono::milliseconds(100)) != std::future_status::ready) {
+                    auto lifetime = weak.lock();
+                    if (!lifetime || !lifetime->alive.load()) {
+                        return;
+                    }
+                }
+            }
+            auto lifetime = weak.lock();
+            if (!lifetime) {
+                return;
+            }
+            std::lock_guard<std::recursive_mutex> alive(lifetime->mutex);
+            if (!lifetime->alive.load()) {
+                return;
+            }
+            try {
+                handler(*shared);
+            } catch (const std::exception& e) {
+                LOG(ERROR) << "[SM:" << name_ << "] ERROR: reason=async_completion_exception: " << e.what();
+            } catch (...) {
+                LOG(ERROR) << "[SM:" << name_ << "] ERROR: reason=async_completion_exception";
+            }
+        });
+    }
+    
+    void enter_state(StateT state, std::chrono::steady_clock::time_point now) {
+        state_entry_time_ = now;
+        if (auto* counters = state_counters(state)) {
+            counters->entries.add();
+            counters->entered = now;
+        }
+        
+        auto it = state_definitions_.find(state);
+        if (it != state_definitions_.end()) {
+            auto& definition = *it->second;
+            
+            // Arm state timeout; cancelled again in exit_state
+            if (!definition.timeout_trigger.empty()) {
+                if (definition.timeout_trigger_id == kInvalidTriggerId) {
+                    definition.timeout_trigger_id = intern_trigger(definition.timeout_trigger);
+                }
+                definition.timeout_timer = schedule_locked(definition.timeout_after,
+                                                           definition.timeout_trigger_id);
+            }
+            
+            // Execute entry action
+            if (definition.entry_action) {
+                definition.entry_action();
+            }
+        }
+    }
+    
+    void exit_state(StateT state, std::chrono::steady_clock::time_point now) {
+        // Record time in state
+        if (auto* counters = state_counters(state)) {
+            counters->time_ns.add(static_cast<std::uint64_t>(
+                std::chrono::duration_cast<std::chrono::nanoseconds>(now - counters->entered).count()));
+        }
+        
+        auto it = state_definitions_.find(state);
+        if (it != state_definitions_.end()) {
+            auto& definition = *it->second;
+            
+            if (definition.timeout_timer != kInvalidTimerId) {
+                cancel_timer_locked(definition.timeout_timer);
+                definition.timeout_timer = kInvalidTimerId;
+            }
+            
+            // Execute exit action
+            if (definition.exit_action) {
+                definition.exit_action();
+            }
+        }
+    }
+    
+    std::chrono::nanoseconds record_metrics(const Transition<StateT, ContextT>& transition,
+                                            StateT from, StateT to,
+                                            std::chrono::steady_clock::time_point start_time) {
+        auto latency = std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now() - start_time
+        );
+        
+        transition.latency.record(static_cast<std::uint64_t>(latency.count()));
+        transitions_taken_.add();
+        
+        if (trace_) {
+            trace_->push(start_time, latency, from, to, transition.trigger_id);
+        }
+        return latency;
+    }
+    
+    void format_record_locked(std::ostream& out, const TransitionRecord<StateT>& record) const {
+        auto offset = std::chrono::duration<double>(record.timestamp - created_).count();
+        out << "[SM:" << name_ << "] #" << record.sequence
+            << " +" << std::fixed << std::setprecision(6) << offset << "s "
+            << cached_state_name(record.from) << " -> " << cached_state_name(record.to)
+            << " | trigger=" << triggers_.name(record.trigger)
+            << " (" << record.duration.count() << "ns)";
+        out.unsetf(std::ios::fixed);
+    }
+    
+    // Declared last so pending async triggers drain before members go away
+    SerialExecutor async_queue_;
+};
+
+// State definition builder
+template<typename StateT>
+class StateDefinition {
+public:
+    explicit StateDefinition(std::string name) : name_(std::move(name)) {}
+    
+    StateDefinition& on_entry(std::function<void()> action) {
+        entry_action = std::move(action);
+        return *this;
+    }
+    
+    StateDefinition& on_exit(std::function<void()> action) {
+        exit_action = std::move(action);
+        return *this;
+    }
+    
+    /**
+     * @brief Fire trigger if the state is still active after the given time
+     * 
+     * Armed on every entry, cancelled automatically on exit.
+     */
+    StateDefinition& timeout(std::chrono::nanoseconds after, std::string trigger) {
+        timeout_after = after;
+        timeout_trigger = std::move(trigger);
+        timeout_trigger_id = kInvalidTriggerId;
+        return *this;
+    }
+    
+    std::string name_;
+    std::function<void()> entry_action;
+    std::function<void()> exit_action;
+    
+    std::chrono::nanoseconds timeout_after{0};
+    std::string timeout_trigger;
+    TriggerId timeout_trigger_id = kInvalidTriggerId;
+    TimerId timeout_timer = kInvalidTimerId;
+};
+
+// Transition definition
+template<typename StateT, typename ContextT>
+class Transition {
+public:
+    StateT from_state;
+    StateT to_state;
+    std::string trigger;
+    ConditionFunc<StateT, ContextT> condition;
+    ActionFunc<StateT, ContextT> action;
+    TriggerId trigger_id = kInvalidTriggerId;
+    
+    // Asynchronous variants (see StateMachine::add_async_transition)
+    ConditionAsyncFunc<StateT, ContextT> condition_async;
+    ActionAsyncFunc<StateT, ContextT> action_async;
+    ActionCallbackFunc<StateT, ContextT> action_callback;
+    
+    // Metrics, updated with the owning machine's mutex held
+    mutable detail::LatencyCounters latency;
+    mutable detail::MetricCounter blocked;
     
     Transition(StateT from, StateT to, std::string trig,
-              ConditionFunc<StateT> cond = {},
-              ActionFunc<StateT> act = {})
+              ConditionFunc<StateT, ContextT> cond = {},
+              ActionFunc<StateT, ContextT> act = {})
         : from_state(from)
         , to_state(to)
         , trigger(std::move(trig))
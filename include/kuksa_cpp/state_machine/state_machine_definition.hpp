@@ -0,0 +1,388 @@
+/**
+ * @file state_machine_definition.hpp
+ * @brief Immutable state machine definitions shared by many lightweight instances
+ */
+
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <type_traits>
+#include <unordered_map>
+#include <vector>
+#include <glog/logging.h>
+
+#include <kuksa_cpp/state_machine/state_machine.hpp>
+#include <kuksa_cpp/state_machine/transition_table.hpp>
+
+namespace sdv {
+
+/**
+ * @brief Per-instance state of a machine described by a StateMachineDefinition
+ *
+ * Just the current state and when it was entered; everything else lives in
+ * the shared definition. Instances are plain values: keep them in a vector,
+ * embed them in your own structs, copy them to snapshot.
+ */
+template<typename StateT>
+struct MachineInstance {
+    StateT state{};
+    std::chrono::steady_clock::time_point entered;
+};
+
+/**
+ * @brief One event of a batch dispatch
+ */
+template<typename ContextT = Context>
+struct BatchEvent {
+    std::uint32_t instance = 0;                 ///< Index into the instance vector
+    TriggerId trigger = kInvalidTriggerId;
+    const ContextT* context = nullptr;          ///< nullptr: the batch's context
+};
+
+/**
+ * @brief Immutable transitions, states and hooks of a state machine
+ *
+ * StateMachine bundles definition and state in one object with its own
+ * mutex, metrics, timers and queue, which costs kilobytes per machine. When
+ * thousands of machines share one shape (a door, seat or window per
+ * vehicle in a fleet simulation), describe the shape once here and keep a
+ * MachineInstance (a state and a timestamp) per machine.
+ *
+ * A definition is built once by a Builder and shared as
+ * std::shared_ptr<const StateMachineDefinition>. Dispatch is const and
+ * takes no lock, so any number of threads may dispatch concurrently as long
+ * as each instance is only touched by one thread at a time (shard the
+ * instance vector). Guards, actions and entry/exit hooks are shared by all
+ * instances: guards and actions get the context, hooks the instance and the
+ * context, which is how they tell which machine they act for.
+ *
+ * Usage:
+ * @code
+ *   sdv::StateMachineDefinition<DoorState>::Builder builder("Door", DoorState::Closed);
+ *   auto open = builder.add_transition(DoorState::Closed, DoorState::Open, "open");
+ *   builder.add_transition(DoorState::Open, DoorState::Closed, "close");
+ *   auto doors_def = builder.build();
+ *
+ *   std::vector<sdv::MachineInstance<DoorState>> doors(100000, doors_def->make_instance());
+ *   doors_def->dispatch(doors[42], open);
+ *   doors_def->broadcast(doors, open);   // every door, one pass
+ * @endcode
+ *
+ * Unlike StateMachine there is no logging per transition, no metrics, no
+ * hierarchy, no state timeouts and no asynchronous actions.
+ */
+template<typename StateT, typename ContextT = Context>
+class StateMachineDefinition {
+    // Transition as stored in the definition: no name, no metrics
+    struct Row {
+        StateT from_state;
+        StateT to_state;
+        TriggerId trigger_id;
+        ConditionFunc<StateT, ContextT> condition;
+        ActionFunc<StateT, ContextT> action;
+    };
+
+public:
+    using Instance = MachineInstance<StateT>;
+    using Event = BatchEvent<ContextT>;
+
+    /**
+     * @brief Entry and exit actions of a state, shared by all instances
+     *
+     * Returned by Builder::define_state(). Definitions have no state
+     * timeouts, so unlike StateMachine's state definition there is no
+     * timeout().
+     *
+     * A hook is called as hook(instance, context), with the instance as it
+     * was before the transition (instance.state is still the source state)
+     * and the context of the dispatch; a hook that needs neither may take no
+     * arguments.
+     */
+    class StateHooks {
+    public:
+        using Hook = std::function<void(const Instance&, const ContextT&)>;
+
+        explicit StateHooks(std::string name) : name_(std::move(name)) {}
+
+        template<typename F>
+        StateHooks& on_entry(F action) {
+            entry_action = make_hook(std::move(action));
+            return *this;
+        }
+
+        template<typename F>
+        StateHooks& on_exit(F action) {
+            exit_action = make_hook(std::move(action));
+            return *this;
+        }
+
+    private:
+        friend class StateMachineDefinition;
+
+        template<typename F>
+        static Hook make_hook(F action) {
+            if constexpr (std::is_invocable_v<F&, const Instance&, const ContextT&>) {
+                return Hook(std::move(action));
+            } else {
+                static_assert(std::is_invocable_v<F&>,
+                              "A hook takes (const Instance&, const ContextT&) or no arguments");
+                return [action = std::move(action)](const Instance&, const ContextT&) mutable { action(); };
+            }
+        }
+
+        std::string name_;
+        Hook entry_action;
+        Hook exit_action;
+    };
+
+    /**
+     * @brief Mutable description, turned into a shared definition by build()
+     */
+    class Builder {
+    public:
+        Builder(std::string name, StateT initial_state)
+            : name_(std::move(name)), initial_state_(initial_state) {}
+
+        void set_state_name_function(StateNameFunc<StateT> func) {
+            state_name_func_ = std::move(func);
+        }
+
+        TriggerId register_trigger(const std::string& name) {
+            return triggers_.intern(name);
+        }
+
+        /**
+         * @brief Add a transition; returns the trigger's ID
+         *
+         * Transitions from the same state on the same trigger are tried in
+         * the order they were added; the first whose guard passes is taken.
+         */
+        TriggerId add_transition(StateT from_state, StateT to_state, const std::string& trigger,
+                                 ConditionFunc<StateT, ContextT> condition = {},
+                                 ActionFunc<StateT, ContextT> action = {}) {
+            auto id = triggers_.intern(trigger);
+            transitions_.push_back(std::make_unique<Row>(
+                Row{from_state, to_state, id, std::move(condition), std::move(action)}));
+            return id;
+        }
+
+        StateHooks& define_state(StateT state) {
+            auto it = states_.find(state);
+            if (it == states_.end()) {
+                it = states_.emplace(state, std::make_unique<StateHooks>(name_of(state))).first;
+            }
+            return *it->second;
+        }
+
+        /**
+         * @brief Compile into an immutable definition
+         *
+         * The builder is left empty.
+         */
+        std::shared_ptr<const StateMachineDefinition> build() {
+            return std::shared_ptr<const StateMachineDefinition>(new StateMachineDefinition(std::move(*this)));
+        }
+
+    private:
+        friend class StateMachineDefinition;
+
+        std::string name_of(StateT state) const {
+            if (state_name_func_) {
+                return state_name_func_(state);
+            }
+            return "State_" + std::to_string(static_cast<int>(state));
+        }
+
+        std::string name_;
+        StateT initial_state_;
+        StateNameFunc<StateT> state_name_func_;
+        TriggerRegistry triggers_;
+        std::vector<std::unique_ptr<Row>> transitions_;
+        std::unordered_map<StateT, std::unique_ptr<StateHooks>> states_;
+    };
+
+    StateMachineDefinition(const StateMachineDefinition&) = delete;
+    StateMachineDefinition& operator=(const StateMachineDefinition&) = delete;
+
+    const std::string& name() const { return name_; }
+    StateT initial_state() const { return initial_state_; }
+
+    /**
+     * @brief A new instance in the initial state (entry hooks are not run)
+     */
+    Instance make_instance() const {
+        return Instance{initial_state_, std::chrono::steady_clock::now()};
+    }
+
+    /**
+     * @brief ID of a trigger (kInvalidTriggerId if no transition uses it)
+     */
+    TriggerId trigger_id(const std::string& name) const {
+        return triggers_.find(name);
+    }
+
+    const std::string& trigger_name(TriggerId id) const {
+        return triggers_.name(id);
+    }
+
+    const std::string& state_name(StateT state) const {
+        static const std::string unknown = "<unknown>";
+        auto index = table_.index_of(state);
+        return index < 0 ? unknown : state_names_[static_cast<std::size_t>(index)];
+    }
+
+    /**
+     * @brief Apply one event to one instance
+     *
+     * Exceptions from guards, actions and hooks propagate; the instance then
+     * keeps its previous state.
+     *
+     * @return true if a transition was taken
+     */
+    bool dispatch(Instance& instance, TriggerId trigger) const {
+        return dispatch(instance, trigger, empty_context(), std::chrono::steady_clock::now());
+    }
+
+    bool dispatch(Instance& instance, TriggerId trigger, const ContextT& context) const {
+        return dispatch(instance, trigger, context, std::chrono::steady_clock::now());
+    }
+
+    /**
+     * @brief Apply a batch of (instance, trigger) events in order
+     *
+     * All transitions of the batch share one timestamp. Events naming an
+     * instance outside the vector are ignored.
+     *
+     * @return Number of transitions taken
+     */
+    std::size_t dispatch_batch(std::vector<Instance>& instances, const std::vector<Event>& events) const {
+        return dispatch_batch(instances, events, empty_context());
+    }
+
+    std::size_t dispatch_batch(std::vector<Instance>& instances, const std::vector<Event>& events,
+                               const ContextT& context) const {
+        auto now = std::chrono::steady_clock::now();
+        std::size_t taken = 0;
+        for (const auto& event : events) {
+            if (event.instance >= instances.size()) {
+                continue;
+            }
+            const auto& event_context = event.context ? *event.context : context;
+            taken += dispatch(instances[event.instance], event.trigger, event_context, now) ? 1 : 0;
+        }
+        return taken;
+    }
+
+    /**
+     * @brief Apply one event to every instance
+     *
+     * @return Number of transitions taken
+     */
+    std::size_t broadcast(std::vector<Instance>& instances, TriggerId trigger) const {
+        return broadcast(instances, trigger, empty_context());
+    }
+
+    std::size_t broadcast(std::vector<Instance>& instances, TriggerId trigger, const ContextT& context) const {
+        auto now = std::chrono::steady_clock::now();
+        std::size_t taken = 0;
+        for (auto& instance : instances) {
+            taken += dispatch(instance, trigger, context, now) ? 1 : 0;
+        }
+        return taken;
+    }
+
+    /**
+     * @brief Triggers that have a transition from state
+     */
+    std::vector<TriggerId> available_triggers(StateT state) const {
+        return table_.triggers_for(state);
+    }
+
+private:
+    explicit StateMachineDefinition(Builder&& builder)
+        : name_(std::move(builder.name_)),
+          initial_state_(builder.initial_state_),
+          triggers_(std::move(builder.triggers_)),
+          transitions_(std::move(builder.transitions_)) {
+        std::vector<const Row*> rows;
+        rows.reserve(transitions_.size());
+        for (const auto& row : transitions_) {
+            rows.push_back(row.get());
+        }
+        std::vector<StateT> states{initial_state_};
+        for (const auto& [state, _] : builder.states_) {
+            states.push_back(state);
+        }
+        table_.build(rows, states, triggers_.size());
+
+        // Hooks and names indexed like the table's rows
+        hooks_.resize(table_.num_states());
+        state_names_.reserve(table_.num_states());
+        for (std::size_t i = 0; i < table_.num_states(); ++i) {
+            auto state = table_.state_at(i);
+            auto it = builder.states_.find(state);
+            if (it != builder.states_.end()) {
+                hooks_[i] = std::move(it->second);
+            }
+            state_names_.push_back(hooks_[i] ? hooks_[i]->name_ : builder.name_of(state));
+        }
+        builder.states_.clear();
+
+        VLOG(1) << "[SMDef:" << name_ << "] built: states=" << table_.num_states()
+                << " triggers=" << triggers_.size() << " transitions=" << transitions_.size();
+    }
+
+    static const ContextT& empty_context() {
+        static const ContextT context{};
+        return context;
+    }
+
+    bool dispatch(Instance& instance, TriggerId trigger, const ContextT& context,
+                  std::chrono::steady_clock::time_point now) const {
+        for (const auto& entry : table_.find(instance.state, trigger)) {
+            const auto* row = entry.transition;
+            if (row->condition && !row->condition(context)) {
+                continue;
+            }
+            for (auto state : table_.exits(entry)) {
+                hook(state, &StateHooks::exit_action, instance, context);
+            }
+            if (row->action) {
+                row->action(context);
+            }
+            for (auto state : table_.entries(entry)) {
+                hook(state, &StateHooks::entry_action, instance, context);
+            }
+            instance.state = entry.target;
+            instance.entered = now;
+            return true;
+        }
+        return false;
+    }
+
+    void hook(StateT state, typename StateHooks::Hook StateHooks::*action,
+              const Instance& instance, const ContextT& context) const {
+        auto index = table_.index_of(state);
+        if (index >= 0) {
+            const auto& definition = hooks_[static_cast<std::size_t>(index)];
+            if (definition && (*definition).*action) {
+                ((*definition).*action)(instance, context);
+            }
+        }
+    }
+
+    std::string name_;
+    StateT initial_state_;
+    TriggerRegistry triggers_;
+    std::vector<std::unique_ptr<Row>> transitions_;
+    TransitionTable<StateT, Row> table_;
+    std::vector<std::unique_ptr<StateHooks>> hooks_;  // indexed like table_ rows
+    std::vector<std::string> state_names_;
+};
+
+} // namespace sdv
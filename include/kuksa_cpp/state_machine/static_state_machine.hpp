@@ -0,0 +1,480 @@
+/**
+ * @file static_state_machine.hpp
+ * @brief Compile-time state machine with constexpr jump-table dispatch
+ */
+
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+#include <glog/logging.h>
+
+#include <kuksa_cpp/state_machine/state_machine.hpp>
+
+namespace sdv {
+
+/// Row without a guard: the transition is always taken
+struct NoGuard {};
+
+/// Row without an action
+struct NoAction {};
+
+/// StaticStateMachine without a user context
+struct NoContext {};
+
+/**
+ * @brief One row of a compile-time transition table
+ *
+ * @tparam From   Source state type
+ * @tparam Event  Event type
+ * @tparam To     Target state type
+ * @tparam Guard  Default-constructible predicate (optional)
+ * @tparam Action Default-constructible callable (optional)
+ *
+ * Guards and actions are invoked with (Context&, const Event&), (const Event&)
+ * or (), whichever they accept. State types may provide static on_entry() /
+ * on_exit() hooks with the same optional (Context&) parameter, and states and
+ * events may provide `static constexpr const char* name` for logging.
+ */
+template<typename From, typename Event, typename To, typename Guard = NoGuard, typename Action = NoAction>
+struct Row {
+    using from = From;
+    using event = Event;
+    using to = To;
+    using guard = Guard;
+    using action = Action;
+};
+
+/**
+ * @brief Ordered list of rows; earlier rows win when several guards pass
+ */
+template<typename... Rows>
+struct StaticTransitionTable {};
+
+namespace detail {
+
+template<typename... Ts>
+struct type_list {};
+
+// Index of T in Ts... (sizeof...(Ts) if absent)
+template<typename T, typename... Ts>
+struct type_index : std::integral_constant<std::size_t, 0> {};
+
+template<typename T, typename First, typename... Rest>
+struct type_index<T, First, Rest...>
+    : std::integral_constant<std::size_t,
+          std::is_same_v<T, First> ? 0 : 1 + type_index<T, Rest...>::value> {};
+
+template<std::size_t I, typename List>
+struct type_at;
+
+template<std::size_t I, typename First, typename... Rest>
+struct type_at<I, type_list<First, Rest...>> : type_at<I - 1, type_list<Rest...>> {};
+
+template<typename First, typename... Rest>
+struct type_at<0, type_list<First, Rest...>> {
+    using type = First;
+};
+
+// Append Ts... to List, skipping duplicates (first occurrence keeps its position)
+template<typename List, typename... Ts>
+struct unique_append;
+
+template<typename... Us>
+struct unique_append<type_list<Us...>> {
+    using type = type_list<Us...>;
+};
+
+template<typename... Us, typename T, typename... Ts>
+struct unique_append<type_list<Us...>, T, Ts...>
+    : std::conditional_t<(std::is_same_v<T, Us> || ...),
+                         unique_append<type_list<Us...>, Ts...>,
+                         unique_append<type_list<Us..., T>, Ts...>> {};
+
+// All states referenced by a table, in order of first appearance
+template<typename Table>
+struct table_states;
+
+template<typename... Rows>
+struct table_states<StaticTransitionTable<Rows...>>
+    : unique_append<type_list<>, typename Rows::from..., typename Rows::to...> {};
+
+template<typename T, typename List>
+struct list_index;
+
+template<typename T, typename... Ts>
+struct list_index<T, type_list<Ts...>> : type_index<T, Ts...> {};
+
+template<typename List>
+struct list_size;
+
+template<typename... Ts>
+struct list_size<type_list<Ts...>> : std::integral_constant<std::size_t, sizeof...(Ts)> {};
+
+// Optional static `name` member
+template<typename T, typename = void>
+struct has_name : std::false_type {};
+
+template<typename T>
+struct has_name<T, std::void_t<decltype(std::string_view(T::name))>> : std::true_type {};
+
+template<typename T>
+constexpr std::string_view name_of() {
+    if constexpr (has_name<T>::value) {
+        return std::string_view(T::name);
+    } else {
+        return {};
+    }
+}
+
+// Optional static on_entry/on_exit hooks, with or without context
+template<typename S, typename Ctx, typename = void>
+struct has_entry_ctx : std::false_type {};
+template<typename S, typename Ctx>
+struct has_entry_ctx<S, Ctx, std::void_t<decltype(S::on_entry(std::declval<Ctx&>()))>> : std::true_type {};
+
+template<typename S, typename = void>
+struct has_entry : std::false_type {};
+template<typename S>
+struct has_entry<S, std::void_t<decltype(S::on_entry())>> : std::true_type {};
+
+template<typename S, typename Ctx, typename = void>
+struct has_exit_ctx : std::false_type {};
+template<typename S, typename Ctx>
+struct has_exit_ctx<S, Ctx, std::void_t<decltype(S::on_exit(std::declval<Ctx&>()))>> : std::true_type {};
+
+template<typename S, typename = void>
+struct has_exit : std::false_type {};
+template<typename S>
+struct has_exit<S, std::void_t<decltype(S::on_exit())>> : std::true_type {};
+
+} // namespace detail
+
+/**
+ * @brief State machine whose states, events, guards and actions are types
+ *
+ * The transition table is fixed at compile time. Each event type gets a
+ * constexpr jump table of function pointers indexed by the current state;
+ * each entry tries the matching rows in table order. Dispatch performs no
+ * hashing, and no heap allocation once set_text_logging(false) turns off
+ * the log lines (formatting them allocates).
+ *
+ * Uses the same structured log lines as StateMachine:
+ * - [SM:name] TRANSITION: from -> to | trigger=event
+ * - [SM:name] STATE: current=state
+ *
+ * Not internally synchronized: drive each instance from a single thread (or
+ * serialize externally). Hooks must not call process() re-entrantly.
+ *
+ * Example:
+ * @code
+ *   struct Off { static constexpr const char* name = "OFF"; };
+ *   struct On  { static constexpr const char* name = "ON"; };
+ *   struct Toggle { static constexpr const char* name = "toggle"; };
+ *
+ *   using Table = sdv::StaticTransitionTable<
+ *       sdv::Row<Off, Toggle, On>,
+ *       sdv::Row<On,  Toggle, Off>>;
+ *
+ *   sdv::StaticStateMachine<Table> sm("Switch");
+ *   sm.set_text_logging(false);   // optional: keep dispatch allocation-free
+ *   sm.process(Toggle{});         // OFF -> ON
+ * @endcode
+ *
+ * @tparam Table   StaticTransitionTable<Row<...>...>
+ * @tparam Context Type passed by reference to guards, actions and hooks
+ */
+template<typename Table, typename Context = NoContext>
+class StaticStateMachine;
+
+template<typename... Rows, typename Context>
+class StaticStateMachine<StaticTransitionTable<Rows...>, Context> {
+    static_assert(sizeof...(Rows) > 0, "transition table must not be empty");
+
+    using Self = StaticStateMachine;
+    using States = typename detail::table_states<StaticTransitionTable<Rows...>>::type;
+
+public:
+    static constexpr std::size_t num_states = detail::list_size<States>::value;
+
+    /**
+     * @brief State type at index I (index order = first appearance in the table)
+     */
+    template<std::size_t I>
+    using state_type = typename detail::type_at<I, States>::type;
+
+    /**
+     * @brief Index of a state type
+     */
+    template<typename S>
+    static constexpr std::size_t state_index() {
+        constexpr auto index = detail::list_index<S, States>::value;
+        static_assert(index < num_states, "state is not part of the transition table");
+        return index;
+    }
+
+    /**
+     * @brief Construct a machine in the first row's source state
+     *
+     * Only available when no Context is used.
+     */
+    template<typename C = Context, typename = std::enable_if_t<std::is_same_v<C, NoContext>>>
+    explicit StaticStateMachine(std::string name)
+        : name_(std::move(name))
+        , context_(&default_context()) {
+    }
+
+    /**
+     * @brief Construct a machine bound to a user context
+     *
+     * @param name Name used in log lines
+     * @param context Passed by reference to guards, actions and state hooks;
+     *        must outlive the machine
+     *
+     * Starts in the first row's source state.
+     */
+    StaticStateMachine(std::string name, Context& context)
+        : name_(std::move(name))
+        , context_(&context) {
+    }
+
+    /**
+     * @brief Start in a specific state instead of the first row's source
+     */
+    template<typename Initial>
+    void reset() {
+        current_ = static_cast<std::uint16_t>(state_index<Initial>());
+    }
+
+    /**
+     * @brief Dispatch an event
+     *
+     * @return true if a transition was taken, false if ignored or all guards failed
+     */
+    template<typename Event>
+    bool process(const Event& event) {
+        constexpr auto table = make_jump_table<Event>(std::make_index_sequence<num_states>{});
+        return table[current_](*this, event);
+    }
+
+    /**
+     * @brief Check whether the machine is in state S
+     */
+    template<typename S>
+    bool is_in() const {
+        return current_ == state_index<S>();
+    }
+
+    /**
+     * @brief Index of the current state
+     */
+    std::size_t current_state_index() const {
+        return current_;
+    }
+
+    /**
+     * @brief Current state name
+     */
+    std::string current_state_name() const {
+        return state_name(current_);
+    }
+
+    /**
+     * @brief Name of the state at index (name hook, static name or State_<index>)
+     */
+    std::string state_name(std::size_t index) const {
+        if (!custom_names_[index].empty()) {
+            return custom_names_[index];
+        }
+        if (!static_names_[index].empty()) {
+            return std::string(static_names_[index]);
+        }
+        return "State_" + std::to_string(index);
+    }
+
+    /**
+     * @brief Override state names for logging, keyed by state index
+     *
+     * Names are resolved once here, so dispatch stays allocation-free.
+     */
+    void set_state_name_function(StateNameFunc<std::size_t> func) {
+        for (std::size_t i = 0; i < num_states; ++i) {
+            custom_names_[i] = func ? func(i) : std::string();
+        }
+        LOG(INFO) << "[SM:" << name_ << "] INIT: state=" << state_name(current_);
+    }
+
+    /**
+     * @brief Turn the per-transition TRANSITION/STATE log lines on or off
+     *
+     * On by default, like StateMachine::set_text_logging().
+     */
+    void set_text_logging(bool enabled) {
+        text_logging_ = enabled;
+    }
+
+    const std::string& name() const {
+        return name_;
+    }
+
+private:
+    template<typename Event>
+    using EventHandler = bool (*)(Self&, const Event&);
+
+    template<typename Event, std::size_t... I>
+    static constexpr std::array<EventHandler<Event>, num_states>
+    make_jump_table(std::index_sequence<I...>) {
+        return {{&handle<Event, I>...}};
+    }
+
+    template<typename Event, std::size_t I>
+    static bool handle(Self& self, const Event& event) {
+        using State = state_type<I>;
+        constexpr bool has_rows =
+            ((std::is_same_v<typename Rows::from, State> &&
+              std::is_same_v<typename Rows::event, Event>) || ...);
+
+        if constexpr (!has_rows) {
+            VLOG(1) << "[SM:" << self.name_ << "] IGNORED: trigger='" << event_label<Event>()
+                    << "' state=" << self.label(I) << " reason=no_transition";
+            return false;
+        } else {
+            return (self.template try_row<Rows, State, I>(event) || ...);
+        }
+    }
+
+    template<typename Row, typename State, std::size_t From, typename Event>
+    bool try_row(const Event& event) {
+        if constexpr (std::is_same_v<typename Row::from, State> &&
+                      std::is_same_v<typename Row::event, Event>) {
+            using To = typename Row::to;
+            constexpr std::size_t to = state_index<To>();
+
+            if (!call_guard<typename Row::guard>(event)) {
+                VLOG(1) << "[SM:" << name_ << "] BLOCKED: trigger='" << event_label<Event>()
+                        << "' from=" << label(From) << " to=" << label(to) << " reason=condition_failed";
+                return false;
+            }
+
+            if (text_logging_) {
+                LOG(INFO) << "[SM:" << name_ << "] TRANSITION: "
+                          << label(From) << " -> " << label(to)
+                          << " | trigger=" << event_label<Event>();
+            }
+
+            call_exit<State>();
+            call_action<typename Row::action>(event);
+            call_entry<To>();
+            current_ = static_cast<std::uint16_t>(to);
+
+            if (text_logging_) {
+                LOG(INFO) << "[SM:" << name_ << "] STATE: current=" << label(to);
+            }
+            return true;
+        } else {
+            return false;
+        }
+    }
+
+    template<typename Guard, typename Event>
+    bool call_guard(const Event& event) {
+        if constexpr (std::is_same_v<Guard, NoGuard>) {
+            return true;
+        } else {
+            Guard guard{};
+            if constexpr (std::is_invocable_v<Guard&, Context&, const Event&>) {
+                return guard(*context_, event);
+            } else if constexpr (std::is_invocable_v<Guard&, const Event&>) {
+                return guard(event);
+            } else {
+                return guard();
+            }
+        }
+    }
+
+    template<typename Action, typename Event>
+    void call_action(const Event& event) {
+        if constexpr (!std::is_same_v<Action, NoAction>) {
+            Action action{};
+            if constexpr (std::is_invocable_v<Action&, Context&, const Event&>) {
+                action(*context_, event);
+            } else if constexpr (std::is_invocable_v<Action&, const Event&>) {
+                action(event);
+            } else {
+                action();
+            }
+        }
+    }
+
+    template<typename S>
+    void call_entry() {
+        if constexpr (detail::has_entry_ctx<S, Context>::value) {
+            S::on_entry(*context_);
+        } else if constexpr (detail::has_entry<S>::value) {
+            S::on_entry();
+        }
+    }
+
+    template<typename S>
+    void call_exit() {
+        if constexpr (detail::has_exit_ctx<S, Context>::value) {
+            S::on_exit(*context_);
+        } else if constexpr (detail::has_exit<S>::value) {
+            S::on_exit();
+        }
+    }
+
+    template<typename Event>
+    static constexpr std::string_view event_label() {
+        constexpr auto name = detail::name_of<Event>();
+        return name.empty() ? std::string_view("event") : name;
+    }
+
+    /// Stream-able state label that never allocates
+    struct Label {
+        std::string_view name;
+        std::size_t index;
+
+        friend std::ostream& operator<<(std::ostream& os, const Label& l) {
+            if (!l.name.empty()) {
+                return os << l.name;
+            }
+            return os << "State_" << l.index;
+        }
+    };
+
+    Label label(std::size_t index) const {
+        if (!custom_names_[index].empty()) {
+            return Label{custom_names_[index], index};
+        }
+        return Label{static_names_[index], index};
+    }
+
+    template<std::size_t... I>
+    static constexpr std::array<std::string_view, num_states> make_names(std::index_sequence<I...>) {
+        return {{detail::name_of<state_type<I>>()...}};
+    }
+
+    static Context& default_context() {
+        static Context context;
+        return context;
+    }
+
+    static constexpr std::array<std::string_view, num_states> static_names_ =
+        make_names(std::make_index_sequence<num_states>{});
+
+    std::string name_;
+    Context* context_;
+    std::uint16_t current_ = 0;  // starts in the first row's source state
+    bool text_logging_ = true;
+    std::array<std::string, num_states> custom_names_{};
+};
+
+} // namespace sdv
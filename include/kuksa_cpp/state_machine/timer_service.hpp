@@ -0,0 +1,381 @@
+/**
+ * @file timer_service.hpp
+ * @brief Hierarchical timing wheel for delayed state machine events
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <limits>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <glog/logging.h>
+
+namespace sdv {
+
+/**
+ * @brief Handle of a scheduled timer (0 is never a valid handle)
+ */
+using TimerId = std::uint64_t;
+
+inline constexpr TimerId kInvalidTimerId = 0;
+
+/**
+ * @brief One-shot timers on a single thread, backed by a hierarchical timing wheel
+ *
+ * Four wheels of 256 slots each cover 2^32 ticks (about 49 days at the
+ * default 1 ms tick). Scheduling and cancellation are O(1): timers are
+ * nodes in a pooled, index-linked list per slot, and a TimerId carries the
+ * node index plus a generation so stale handles are rejected. Timers in the
+ * outer wheels cascade inward as time advances.
+ *
+ * The service thread sleeps until the next occupied slot (or the next
+ * cascade point), so an idle wheel costs no wakeups. Callbacks run on the
+ * service thread one at a time without the internal lock held; keep them
+ * short, e.g. post an event to a state machine.
+ */
+class TimerService {
+public:
+    using Clock = std::chrono::steady_clock;
+    using Callback = std::function<void()>;
+
+    /**
+     * @brief Construct a timer service and start its thread
+     *
+     * @param tick Wheel resolution; delays are rounded up to whole ticks
+     */
+    explicit TimerService(std::chrono::nanoseconds tick = std::chrono::milliseconds(1))
+        : tick_(tick.count() > 0 ? tick : std::chrono::nanoseconds(1))
+        , start_(Clock::now()) {
+        heads_.fill(kNone);
+        thread_ = std::thread([this]() { run(); });
+    }
+
+    /**
+     * @brief Stop the service thread; pending timers are discarded
+     */
+    ~TimerService() {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            stopping_ = true;
+        }
+        cv_.notify_all();
+        if (thread_.joinable()) {
+            thread_.join();
+        }
+    }
+
+    TimerService(const TimerService&) = delete;
+    TimerService& operator=(const TimerService&) = delete;
+
+    /**
+     * @brief Run callback once after delay
+     *
+     * @return Handle for cancel()
+     */
+    TimerId after(std::chrono::nanoseconds delay, Callback callback) {
+        std::lock_guard<std::mutex> lock(mutex_);
+
+        auto now = now_tick();
+        if (pending_ == 0 && current_tick_ < now) {
+            current_tick_ = now;  // empty wheel: nothing to catch up on
+        }
+        // now is rounded down, so add one tick to never fire early
+        auto ticks = delay.count() > 0
+            ? static_cast<std::uint64_t>((delay.count() + tick_.count() - 1) / tick_.count()) + 1
+            : 0;
+        auto expires = std::max(now + ticks, current_tick_);
+
+        std::uint32_t index;
+        if (!free_.empty()) {
+            index = free_.back();
+            free_.pop_back();
+        } else {
+            index = static_cast<std::uint32_t>(nodes_.size());
+            nodes_.emplace_back();
+        }
+        auto& node = nodes_[index];
+        node.callback = std::move(callback);
+        node.expires = expires;
+        link(index);
+        ++pending_;
+
+        if (expires < wake_tick_) {
+            cv_.notify_one();
+        }
+        return make_id(index, node.generation);
+    }
+
+    /**
+     * @brief Cancel a pending timer
+     *
+     * @return true if the timer was pending and will not run; false if it
+     *         already ran, is running, or the handle is unknown
+     */
+    bool cancel(TimerId id) {
+        Callback discarded;  // destroyed after the lock is released
+        std::lock_guard<std::mutex> lock(mutex_);
+        return cancel_locked(id, discarded);
+    }
+
+    /**
+     * @brief Cancel a timer and wait for its callback if it is running
+     *
+     * Safe to call from the timer's own callback (does not wait then).
+     * Must not be called while holding a lock the callback may acquire.
+     */
+    bool cancel_and_wait(TimerId id) {
+        Callback discarded;
+        std::unique_lock<std::mutex> lock(mutex_);
+        if (cancel_locked(id, discarded)) {
+            return true;
+        }
+        if (std::this_thread::get_id() != thread_.get_id()) {
+            idle_cv_.wait(lock, [this, id]() { return running_ != id; });
+        }
+        return false;
+    }
+
+    /**
+     * @brief Number of timers waiting to fire
+     */
+    std::size_t pending() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return pending_;
+    }
+
+    std::chrono::nanoseconds tick() const {
+        return tick_;
+    }
+
+    /**
+     * @brief Process-wide timer service shared by all state machines by default
+     */
+    static TimerService& default_service() {
+        static TimerService service;
+        return service;
+    }
+
+private:
+    static constexpr std::size_t kLevels = 4;
+    static constexpr std::size_t kBits = 8;
+    static constexpr std::size_t kSlots = std::size_t{1} << kBits;
+    static constexpr std::uint64_t kMask = kSlots - 1;
+    static constexpr std::uint32_t kNone = std::numeric_limits<std::uint32_t>::max();
+    static constexpr std::uint64_t kMaxDelta = (std::uint64_t{1} << (kLevels * kBits)) - 1;
+
+    struct Node {
+        Callback callback;
+        std::uint64_t expires = 0;
+        std::uint32_t generation = 1;
+        std::uint32_t slot = kNone;  // kNone: free or running
+        std::uint32_t prev = kNone;
+        std::uint32_t next = kNone;
+    };
+
+    static TimerId make_id(std::uint32_t index, std::uint32_t generation) {
+        return (static_cast<TimerId>(generation) << 32) | index;
+    }
+
+    std::uint64_t now_tick() const {
+        return static_cast<std::uint64_t>((Clock::now() - start_) / tick_);
+    }
+
+    Clock::time_point time_of(std::uint64_t tick) const {
+        return start_ + std::chrono::duration_cast<Clock::duration>(tick_ * tick);
+    }
+
+    void link(std::uint32_t index) {
+        auto& node = nodes_[index];
+        auto delta = node.expires > current_tick_ ? std::min(node.expires - current_tick_, kMaxDelta) : 0;
+        auto placed = current_tick_ + delta;
+
+        std::size_t level = 0;
+        while (level + 1 < kLevels && delta >= (std::uint64_t{1} << ((level + 1) * kBits))) {
+            ++level;
+        }
+        auto slot = static_cast<std::uint32_t>(level * kSlots + ((placed >> (level * kBits)) & kMask));
+
+        node.slot = slot;
+        node.prev = kNone;
+        node.next = heads_[slot];
+        if (node.next != kNone) {
+            nodes_[node.next].prev = index;
+        }
+        heads_[slot] = index;
+    }
+
+    void unlink(std::uint32_t index) {
+        auto& node = nodes_[index];
+        if (node.prev != kNone) {
+            nodes_[node.prev].next = node.next;
+        } else {
+            heads_[node.slot] = node.next;
+        }
+        if (node.next != kNone) {
+            nodes_[node.next].prev = node.prev;
+        }
+        node.slot = kNone;
+        node.prev = node.next = kNone;
+    }
+
+    void release(std::uint32_t index) {
+        auto& node = nodes_[index];
+        node.slot = kNone;
+        if (++node.generation == 0) {
+            node.generation = 1;
+        }
+        free_.push_back(index);
+    }
+
+    bool cancel_locked(TimerId id, Callback& discarded) {
+        auto index = static_cast<std::uint32_t>(id & 0xffffffffu);
+        auto generation = static_cast<std::uint32_t>(id >> 32);
+        if (index >= nodes_.size()) {
+            return false;
+        }
+        auto& node = nodes_[index];
+        if (node.generation != generation || node.slot == kNone) {
+            return false;
+        }
+        unlink(index);
+        discarded = std::move(node.callback);
+        node.callback = nullptr;
+        release(index);
+        --pending_;
+        return true;
+    }
+
+    /**
+     * @brief Re-place every timer of an outer wheel slot relative to current_tick_
+     */
+    void cascade(std::size_t level, std::uint64_t slot) {
+        auto head = static_cast<std::uint32_t>(level * kSlots + slot);
+        auto index = heads_[head];
+        heads_[head] = kNone;
+        while (index != kNone) {
+            auto next = nodes_[index].next;
+            link(index);
+            index = next;
+        }
+    }
+
+    /**
+     * @brief Process current_tick_: cascade outer wheels, then fire its slot
+     */
+    void process_tick(std::unique_lock<std::mutex>& lock) {
+        auto tick = current_tick_;
+        for (std::size_t level = 1; level < kLevels; ++level) {
+            if (((tick >> ((level - 1) * kBits)) & kMask) != 0) {
+                break;
+            }
+            cascade(level, (tick >> (level * kBits)) & kMask);
+        }
+
+        // Pop one timer at a time so the rest stay cancellable while a
+        // callback runs unlocked
+        auto slot = static_cast<std::uint32_t>(tick & kMask);
+        std::uint32_t deferred = kNone;
+        while (heads_[slot] != kNone && !stopping_) {
+            auto index = heads_[slot];
+            unlink(index);
+            auto& node = nodes_[index];
+            if (node.expires > tick) {
+                // Clamped beyond the wheel's range; re-place after this slot
+                node.next = deferred;
+                deferred = index;
+                continue;
+            }
+
+            auto callback = std::move(node.callback);
+            node.callback = nullptr;
+            running_ = make_id(index, node.generation);
+            release(index);
+            --pending_;
+
+            lock.unlock();
+            try {
+                callback();
+            } catch (const std::exception& e) {
+                LOG(ERROR) << "[TimerService] callback threw: " << e.what();
+            } catch (...) {
+                LOG(ERROR) << "[TimerService] callback threw an unknown exception";
+            }
+            callback = nullptr;
+            lock.lock();
+
+            running_ = kInvalidTimerId;
+            idle_cv_.notify_all();
+        }
+
+        ++current_tick_;
+        while (deferred != kNone) {
+            auto next = nodes_[deferred].next;
+            link(deferred);
+            deferred = next;
+        }
+    }
+
+    /**
+     * @brief Next tick worth waking up for: first occupied level-0 slot or cascade point
+     */
+    std::uint64_t next_wake_tick() const {
+        auto boundary = (current_tick_ | kMask) + 1;
+        for (auto tick = current_tick_; tick < boundary; ++tick) {
+            if (heads_[tick & kMask] != kNone) {
+                return tick;
+            }
+        }
+        return boundary;
+    }
+
+    void run() {
+        std::unique_lock<std::mutex> lock(mutex_);
+        while (!stopping_) {
+            if (pending_ == 0) {
+                wake_tick_ = std::numeric_limits<std::uint64_t>::max();
+                cv_.wait(lock, [this]() { return stopping_ || pending_ > 0; });
+                continue;
+            }
+
+            auto now = now_tick();
+            while (current_tick_ <= now && pending_ > 0 && !stopping_) {
+                process_tick(lock);
+            }
+            if (pending_ == 0 || stopping_) {
+                continue;
+            }
+
+            wake_tick_ = next_wake_tick();
+            cv_.wait_until(lock, time_of(wake_tick_));
+        }
+    }
+
+    const std::chrono::nanoseconds tick_;
+    const Clock::time_point start_;
+
+    mutable std::mutex mutex_;
+    std::condition_variable cv_;
+    std::condition_variable idle_cv_;
+
+    std::vector<Node> nodes_;
+    std::vector<std::uint32_t> free_;
+    std::array<std::uint32_t, kLevels * kSlots> heads_;
+    std::uint64_t current_tick_ = 0;   // next tick to process
+    std::uint64_t wake_tick_ = std::numeric_limits<std::uint64_t>::max();
+    std::size_t pending_ = 0;
+    TimerId running_ = kInvalidTimerId;
+    bool stopping_ = false;
+
+    std::thread thread_;  // started last, after all members are initialized
+};
+
+} // namespace sdv
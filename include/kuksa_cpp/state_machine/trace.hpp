@@ -0,0 +1,183 @@
+/**
+ * @file trace.hpp
+ * @brief Fixed-size binary transition trace with lock-free readers
+ */
+
+#pragma once
+
+#include <kuksa_cpp/state_machine/transition_table.hpp>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <type_traits>
+#include <vector>
+
+namespace sdv {
+
+/**
+ * @brief One recorded transition
+ */
+template<typename StateT>
+struct TransitionRecord {
+    std::uint64_t sequence = 0;                       ///< Position in the trace, from 0
+    std::chrono::steady_clock::time_point timestamp;  ///< Transition start
+    std::chrono::nanoseconds duration{0};             ///< Exit + action + entry
+    StateT from{};
+    StateT to{};
+    TriggerId trigger = kInvalidTriggerId;
+};
+
+/**
+ * @brief Overwriting ring of TransitionRecords
+ *
+ * One writer (the state machine, with its mutex held) and any number of
+ * lock-free readers. Each slot is a small seqlock: the writer marks it odd
+ * while writing, and a reader skips a slot whose version moved under it.
+ * When the writer laps a slow reader the oldest records are lost and
+ * reported as such. Capacity is rounded up to a power of two.
+ */
+template<typename StateT>
+class TraceRing {
+public:
+    using Record = TransitionRecord<StateT>;
+
+    explicit TraceRing(std::size_t capacity) {
+        std::size_t size = 2;
+        while (size < capacity) {
+            size <<= 1;
+        }
+        mask_ = size - 1;
+        slots_ = std::make_unique<Slot[]>(size);
+    }
+
+    TraceRing(const TraceRing&) = delete;
+    TraceRing& operator=(const TraceRing&) = delete;
+
+    /**
+     * @brief Append a record (single writer)
+     */
+    void push(std::chrono::steady_clock::time_point timestamp, std::chrono::nanoseconds duration,
+              StateT from, StateT to, TriggerId trigger) {
+        auto position = head_.load(std::memory_order_relaxed);
+        auto& slot = slots_[position & mask_];
+
+        slot.version.store(2 * position + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        slot.words[0].store(static_cast<std::uint64_t>(timestamp.time_since_epoch().count()), std::memory_order_relaxed);
+        slot.words[1].store(static_cast<std::uint64_t>(duration.count()), std::memory_order_relaxed);
+        slot.words[2].store(to_word(from), std::memory_order_relaxed);
+        slot.words[3].store(to_word(to), std::memory_order_relaxed);
+        slot.words[4].store(trigger, std::memory_order_relaxed);
+        slot.version.store(2 * position + 2, std::memory_order_release);
+
+        head_.store(position + 1, std::memory_order_release);
+    }
+
+    /**
+     * @brief Read records from cursor onwards and advance the cursor
+     *
+     * Start with cursor = 0 to read everything still buffered. Records
+     * overwritten before they could be read are skipped.
+     *
+     * @param cursor In: next sequence to read. Out: one past the last read.
+     * @param out Records are appended here
+     * @param max_records Upper bound on records appended
+     * @return Number of records lost to overwriting
+     */
+    std::uint64_t read(std::uint64_t& cursor, std::vector<Record>& out,
+                       std::size_t max_records = static_cast<std::size_t>(-1)) const {
+        std::uint64_t lost = 0;
+        auto head = head_.load(std::memory_order_acquire);
+        if (head > capacity() && cursor < head - capacity()) {
+            lost += head - capacity() - cursor;
+            cursor = head - capacity();
+        }
+
+        std::size_t appended = 0;
+        while (cursor < head && appended < max_records) {
+            Record record;
+            if (load(cursor, record)) {
+                out.push_back(record);
+                ++appended;
+            } else {
+                ++lost;  // overwritten while we were reading
+            }
+            ++cursor;
+        }
+        return lost;
+    }
+
+    /**
+     * @brief Most recent records, oldest first
+     */
+    std::vector<Record> latest(std::size_t count) const {
+        auto head = head_.load(std::memory_order_acquire);
+        count = std::min<std::size_t>(count, capacity());
+        std::uint64_t cursor = head > count ? head - count : 0;
+        std::vector<Record> out;
+        out.reserve(static_cast<std::size_t>(head - cursor));
+        read(cursor, out);
+        return out;
+    }
+
+    /**
+     * @brief Total records ever written
+     */
+    std::uint64_t written() const {
+        return head_.load(std::memory_order_acquire);
+    }
+
+    std::size_t capacity() const {
+        return mask_ + 1;
+    }
+
+private:
+    using Underlying = std::underlying_type_t<StateT>;
+
+    struct Slot {
+        std::atomic<std::uint64_t> version{0};  // 2n+1 while writing record n, 2n+2 when done
+        std::atomic<std::uint64_t> words[5] = {};
+    };
+
+    static std::uint64_t to_word(StateT state) {
+        return static_cast<std::uint64_t>(static_cast<std::int64_t>(static_cast<Underlying>(state)));
+    }
+
+    static StateT from_word(std::uint64_t word) {
+        return static_cast<StateT>(static_cast<Underlying>(static_cast<std::int64_t>(word)));
+    }
+
+    bool load(std::uint64_t position, Record& record) const {
+        const auto& slot = slots_[position & mask_];
+        auto expected = 2 * position + 2;
+        if (slot.version.load(std::memory_order_acquire) != expected) {
+            return false;
+        }
+        std::uint64_t words[5];
+        for (std::size_t i = 0; i < 5; ++i) {
+            words[i] = slot.words[i].load(std::memory_order_relaxed);
+        }
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (slot.version.load(std::memory_order_relaxed) != expected) {
+            return false;
+        }
+
+        record.sequence = position;
+        record.timestamp = std::chrono::steady_clock::time_point(
+            std::chrono::steady_clock::duration(static_cast<std::chrono::steady_clock::rep>(words[0])));
+        record.duration = std::chrono::nanoseconds(static_cast<std::int64_t>(words[1]));
+        record.from = from_word(words[2]);
+        record.to = from_word(words[3]);
+        record.trigger = static_cast<TriggerId>(words[4]);
+        return true;
+    }
+
+    std::unique_ptr<Slot[]> slots_;
+    std::size_t mask_ = 0;
+    alignas(64) std::atomic<std::uint64_t> head_{0};
+};
+
+} // namespace sdv
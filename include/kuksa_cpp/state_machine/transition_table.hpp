@@ -0,0 +1,399 @@
+/**
+ * @file transition_table.hpp
+ * @brief Interned trigger IDs and dense [state][trigger] transition lookup
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <deque>
+#include <limits>
+#include <optional>
+#include <string>
+#include <type_traits>
+#include <unordered_map>
+#include <vector>
+
+namespace sdv {
+
+/**
+ * @brief Interned trigger identifier
+ *
+ * Obtained once from StateMachine::register_trigger() (or implicitly via
+ * add_transition) and then used for allocation-free dispatch.
+ */
+using TriggerId = std::uint32_t;
+
+inline constexpr TriggerId kInvalidTriggerId = std::numeric_limits<TriggerId>::max();
+
+/**
+ * @brief Bidirectional trigger name <-> TriggerId mapping
+ *
+ * IDs are dense and assigned in registration order starting at 0.
+ * Returned name references stay valid for the registry's lifetime.
+ */
+class TriggerRegistry {
+public:
+    /**
+     * @brief Return the ID for a name, registering it if new
+     */
+    TriggerId intern(const std::string& name) {
+        auto it = ids_.find(name);
+        if (it != ids_.end()) {
+            return it->second;
+        }
+        auto id = static_cast<TriggerId>(names_.size());
+        names_.push_back(name);
+        ids_.emplace(name, id);
+        return id;
+    }
+
+    /**
+     * @brief Look up an existing ID (kInvalidTriggerId if unknown)
+     */
+    TriggerId find(const std::string& name) const {
+        auto it = ids_.find(name);
+        return it != ids_.end() ? it->second : kInvalidTriggerId;
+    }
+
+    const std::string& name(TriggerId id) const {
+        static const std::string unknown = "<unknown>";
+        return id < names_.size() ? names_[id] : unknown;
+    }
+
+    std::size_t size() const {
+        return names_.size();
+    }
+
+private:
+    std::unordered_map<std::string, TriggerId> ids_;
+    std::deque<std::string> names_;  // deque keeps references stable on growth
+};
+
+/**
+ * @brief Dense transition lookup compiled from a list of transitions
+ *
+ * Only the states in use get a row, so the table grows with the states and
+ * triggers used, not with the range of the enum's values. Rows are found by
+ * direct indexation when the values are dense (the usual enum) and by binary
+ * search over the used states when they are sparse (e.g. OK = 0, FAULT =
+ * 100000). Triggers are indexed by TriggerId. Each cell references a
+ * contiguous run of candidate entries, so find() never allocates.
+ *
+ * Hierarchy (optional) is flattened at build time:
+ * - a state's cell also lists the transitions of its ancestors, innermost
+ *   first, so events bubble to parent transitions without a tree walk;
+ * - every entry carries its exit path (current state up to, excluding, the
+ *   lowest common proper ancestor of source and target) and entry path
+ *   (down to the target, then through initial substates to a leaf).
+ * For flat machines these degenerate to "exit source, enter target".
+ *
+ * @tparam StateT State enum type
+ * @tparam TransitionT Transition record type (exposes from_state, to_state, trigger_id)
+ */
+template<typename StateT, typename TransitionT>
+class TransitionTable {
+public:
+    using Underlying = std::underlying_type_t<StateT>;
+
+    /// Contiguous run of states (exit path, entry path or ancestor chain)
+    struct StateSpan {
+        const StateT* first = nullptr;
+        const StateT* last = nullptr;
+
+        const StateT* begin() const { return first; }
+        const StateT* end() const { return last; }
+        bool empty() const { return first == last; }
+        std::size_t size() const { return static_cast<std::size_t>(last - first); }
+    };
+
+    /// One compiled candidate transition
+    struct Entry {
+        const TransitionT* transition = nullptr;
+        StateT target{};                ///< State that becomes current (leaf after initial substates)
+        std::uint32_t exit_first = 0;   ///< Exit path, innermost first
+        std::uint32_t exit_count = 0;
+        std::uint32_t entry_first = 0;  ///< Entry path, outermost first
+        std::uint32_t entry_count = 0;
+    };
+
+    /// Half-open range of candidate entries for one (state, trigger) cell
+    struct Candidates {
+        const Entry* first = nullptr;
+        const Entry* last = nullptr;
+
+        const Entry* begin() const { return first; }
+        const Entry* end() const { return last; }
+        bool empty() const { return first == last; }
+    };
+
+    /**
+     * @brief Rebuild a flat (non-hierarchical) table
+     *
+     * @param transitions All transitions, in insertion order
+     * @param states Additional states that must be indexable (e.g. initial state)
+     * @param num_triggers Number of registered triggers
+     */
+    void build(const std::vector<const TransitionT*>& transitions,
+               const std::vector<StateT>& states,
+               std::size_t num_triggers) {
+        auto none = [](StateT) -> std::optional<StateT> { return std::nullopt; };
+        build(transitions, states, num_triggers, none, none);
+    }
+
+    /**
+     * @brief Rebuild the table with a state hierarchy
+     *
+     * @param parent_of   StateT -> std::optional<StateT> parent
+     * @param initial_of  StateT -> std::optional<StateT> initial substate
+     */
+    template<typename ParentFn, typename InitialFn>
+    void build(const std::vector<const TransitionT*>& transitions,
+               const std::vector<StateT>& states,
+               std::size_t num_triggers,
+               ParentFn&& parent_of,
+               InitialFn&& initial_of) {
+        num_triggers_ = num_triggers;
+        index_states(transitions, states);
+
+        build_ancestors(parent_of);
+
+        // Transitions grouped by source state, insertion order preserved
+        std::vector<std::vector<const TransitionT*>> by_source(num_states_);
+        for (const auto* t : transitions) {
+            by_source[static_cast<std::size_t>(index_of(t->from_state))].push_back(t);
+        }
+
+        // Stage entries per cell: own transitions first, then each ancestor's
+        paths_.clear();
+        std::vector<std::pair<std::size_t, Entry>> staged;
+        for (std::size_t i = 0; i < num_states_; ++i) {
+            for (auto source : ancestors_at(i)) {
+                for (const auto* t : by_source[static_cast<std::size_t>(index_of(source))]) {
+                    if (t->trigger_id >= num_triggers_) {
+                        continue;
+                    }
+                    staged.emplace_back(cell(i, t->trigger_id),
+                                        make_entry(i, t, initial_of));
+                }
+            }
+        }
+        std::stable_sort(staged.begin(), staged.end(),
+                         [](const auto& a, const auto& b) { return a.first < b.first; });
+
+        offsets_.assign(num_states_ * num_triggers_ + 1, 0);
+        entries_.clear();
+        entries_.reserve(staged.size());
+        for (const auto& [c, entry] : staged) {
+            offsets_[c + 1]++;
+            entries_.push_back(entry);
+        }
+        for (std::size_t i = 1; i < offsets_.size(); ++i) {
+            offsets_[i] += offsets_[i - 1];
+        }
+    }
+
+    /**
+     * @brief Candidate entries for (state, trigger); empty if none
+     */
+    Candidates find(StateT state, TriggerId trigger) const {
+        auto index = index_of(state);
+        if (index < 0 || trigger >= num_triggers_) {
+            return {};
+        }
+        auto c = cell(static_cast<std::size_t>(index), trigger);
+        return {entries_.data() + offsets_[c], entries_.data() + offsets_[c + 1]};
+    }
+
+    StateSpan exits(const Entry& entry) const {
+        return {paths_.data() + entry.exit_first, paths_.data() + entry.exit_first + entry.exit_count};
+    }
+
+    StateSpan entries(const Entry& entry) const {
+        return {paths_.data() + entry.entry_first, paths_.data() + entry.entry_first + entry.entry_count};
+    }
+
+    /**
+     * @brief State followed by its ancestors (innermost first); empty if unknown
+     */
+    StateSpan ancestors(StateT state) const {
+        auto index = index_of(state);
+        if (index < 0) {
+            return {};
+        }
+        return ancestors_at(static_cast<std::size_t>(index));
+    }
+
+    /**
+     * @brief Triggers that have at least one transition from state (or its ancestors)
+     */
+    std::vector<TriggerId> triggers_for(StateT state) const {
+        std::vector<TriggerId> result;
+        auto index = index_of(state);
+        if (index < 0) {
+            return result;
+        }
+        for (TriggerId trigger = 0; trigger < num_triggers_; ++trigger) {
+            auto c = cell(static_cast<std::size_t>(index), trigger);
+            if (offsets_[c + 1] != offsets_[c]) {
+                result.push_back(trigger);
+            }
+        }
+        return result;
+    }
+
+    /**
+     * @brief Dense row index of a state, or -1 if it is not in the table
+     */
+    std::int64_t index_of(StateT state) const {
+        auto v = value_of(state);
+        if (num_states_ == 0 || v < min_ || v > max_) {
+            return -1;
+        }
+        if (!direct_.empty()) {
+            return direct_[static_cast<std::size_t>(v - min_)];
+        }
+        auto it = std::lower_bound(states_.begin(), states_.end(), v,
+                                   [](StateT s, std::int64_t value) { return value_of(s) < value; });
+        return it != states_.end() && *it == state ? it - states_.begin() : -1;
+    }
+
+    /**
+     * @brief State for a dense row index
+     */
+    StateT state_at(std::size_t index) const {
+        return states_[index];
+    }
+
+    std::size_t num_states() const { return num_states_; }
+    std::size_t num_triggers() const { return num_triggers_; }
+
+private:
+    static std::int64_t value_of(StateT state) {
+        return static_cast<std::int64_t>(static_cast<Underlying>(state));
+    }
+
+    // Sorted states in use; a direct value -> row map unless they are sparse
+    void index_states(const std::vector<const TransitionT*>& transitions, const std::vector<StateT>& states) {
+        states_ = states;
+        for (const auto* t : transitions) {
+            states_.push_back(t->from_state);
+            states_.push_back(t->to_state);
+        }
+        std::sort(states_.begin(), states_.end(),
+                  [](StateT a, StateT b) { return value_of(a) < value_of(b); });
+        states_.erase(std::unique(states_.begin(), states_.end()), states_.end());
+        num_states_ = states_.size();
+
+        direct_.clear();
+        if (states_.empty()) {
+            return;
+        }
+        min_ = value_of(states_.front());
+        max_ = value_of(states_.back());
+        // A direct map of a few times the used rows costs less than the searches
+        auto range = static_cast<std::uint64_t>(max_ - min_) + 1;
+        if (range <= 4 * num_states_ + 64) {
+            direct_.assign(static_cast<std::size_t>(range), -1);
+            for (std::size_t i = 0; i < num_states_; ++i) {
+                direct_[static_cast<std::size_t>(value_of(states_[i]) - min_)] = static_cast<std::int32_t>(i);
+            }
+        }
+    }
+
+    template<typename ParentFn>
+    void build_ancestors(ParentFn& parent_of) {
+        ancestors_.clear();
+        ancestor_offsets_.assign(num_states_ + 1, 0);
+        for (std::size_t i = 0; i < num_states_; ++i) {
+            auto state = state_at(i);
+            ancestors_.push_back(state);
+            // Bounded walk guards against accidental cycles
+            for (std::size_t depth = 0; depth < num_states_; ++depth) {
+                auto parent = parent_of(state);
+                if (!parent || index_of(*parent) < 0) {
+                    break;
+                }
+                state = *parent;
+                ancestors_.push_back(state);
+            }
+            ancestor_offsets_[i + 1] = static_cast<std::uint32_t>(ancestors_.size());
+        }
+    }
+
+    StateSpan ancestors_at(std::size_t index) const {
+        return {ancestors_.data() + ancestor_offsets_[index],
+                ancestors_.data() + ancestor_offsets_[index + 1]};
+    }
+
+    static bool contains(StateSpan span, StateT state) {
+        return std::find(span.begin(), span.end(), state) != span.end();
+    }
+
+    template<typename InitialFn>
+    Entry make_entry(std::size_t current, const TransitionT* t, InitialFn& initial_of) {
+        auto source = ancestors(t->from_state);
+        auto target = ancestors(t->to_state);
+
+        // Lowest state that is a proper ancestor of both source and target
+        std::optional<StateT> domain;
+        for (auto it = source.begin() + 1; it < source.end(); ++it) {
+            if (*it != t->to_state && contains(target, *it)) {
+                domain = *it;
+                break;
+            }
+        }
+
+        Entry entry;
+        entry.transition = t;
+
+        entry.exit_first = static_cast<std::uint32_t>(paths_.size());
+        for (auto state : ancestors_at(current)) {
+            if (domain && state == *domain) {
+                break;
+            }
+            paths_.push_back(state);
+        }
+        entry.exit_count = static_cast<std::uint32_t>(paths_.size()) - entry.exit_first;
+
+        entry.entry_first = static_cast<std::uint32_t>(paths_.size());
+        std::size_t outer = target.size();
+        if (domain) {
+            outer = static_cast<std::size_t>(std::find(target.begin(), target.end(), *domain) - target.begin());
+        }
+        for (std::size_t k = outer; k-- > 0;) {
+            paths_.push_back(target.first[k]);
+        }
+        auto leaf = t->to_state;
+        for (std::size_t depth = 0; depth < num_states_; ++depth) {
+            auto initial = initial_of(leaf);
+            if (!initial || index_of(*initial) < 0) {
+                break;
+            }
+            leaf = *initial;
+            paths_.push_back(leaf);
+        }
+        entry.entry_count = static_cast<std::uint32_t>(paths_.size()) - entry.entry_first;
+        entry.target = leaf;
+        return entry;
+    }
+
+    std::size_t cell(std::size_t state_index, TriggerId trigger) const {
+        return state_index * num_triggers_ + trigger;
+    }
+
+    std::int64_t min_ = 0;
+    std::int64_t max_ = 0;
+    std::vector<StateT> states_;                   // states in use, by value; row i is states_[i]
+    std::vector<std::int32_t> direct_;             // value - min_ -> row or -1; empty if sparse
+    std::size_t num_states_ = 0;
+    std::size_t num_triggers_ = 0;
+    std::vector<std::uint32_t> offsets_;           // num_states * num_triggers + 1
+    std::vector<Entry> entries_;                   // grouped by cell
+    std::vector<StateT> paths_;                    // exit/entry paths referenced by entries
+    std::vector<StateT> ancestors_;                // per state: self, parent, ...
+    std::vector<std::uint32_t> ancestor_offsets_;  // num_states + 1
+};
+
+} // namespace sdv
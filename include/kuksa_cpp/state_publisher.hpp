@@ -0,0 +1,182 @@
+/**
+ * @file state_publisher.hpp
+ * @brief Publishes state machine states to VSS signals in coalesced batches
+ */
+
+#pragma once
+
+#include "client.hpp"
+#include <kuksa_cpp/state_machine/state_machine.hpp>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+namespace kuksa {
+
+/**
+ * @brief Counters of a StatePublisher
+ */
+struct StatePublisherStats {
+    uint64_t changes = 0;    ///< State changes recorded (including initial states)
+    uint64_t coalesced = 0;  ///< Changes replaced by a newer one before publishing
+    uint64_t published = 0;  ///< Signal values sent
+    uint64_t batches = 0;    ///< publish_batch() calls
+    uint64_t errors = 0;     ///< Batches that failed outright, plus per-signal errors reported back
+};
+
+/**
+ * @brief Mirrors state machine states into VSS signals
+ *
+ * Each added machine is watched through a transition observer, which only
+ * records the new value. A flush thread publishes whatever changed every
+ * interval, in one Client::publish_batch() call. A machine that changes
+ * several times within an interval is published once, with its latest
+ * state, so the cost is at most one PublishValue RPC per changed signal
+ * per interval, however many transitions there were. Signals the broker
+ * rejects are retried at the next flush; accepted ones are not sent again.
+ *
+ * A machine maps to a string signal (the state name, as used in logs) or
+ * to an integer signal (the state's underlying enum value). The current
+ * state is published when the machine is added.
+ *
+ * Usage:
+ * @code
+ *   kuksa::StatePublisher publisher(*client, std::chrono::milliseconds(200));
+ *   publisher.add(protection_sm, *resolver->get<std::string>("Vehicle.Private.Climate.ProtectionState"));
+ *   publisher.add(engine_sm, *resolver->get<int32_t>("Vehicle.Private.Engine.ManagementState"));
+ *   publisher.start();   // after client->start()
+ * @endcode
+ *
+ * Machines may be destroyed before the publisher and vice versa, but not
+ * concurrently with it. The publisher's destructor removes its observers
+ * from the machines that are still alive.
+ */
+class StatePublisher {
+public:
+    explicit StatePublisher(Client& client,
+                            std::chrono::milliseconds interval = std::chrono::milliseconds(100));
+
+    /**
+     * @brief Stops the flush thread, removes the observers and flushes
+     *
+     * Pending changes are published even if start() was never called.
+     */
+    ~StatePublisher();
+
+    StatePublisher(const StatePublisher&) = delete;
+    StatePublisher& operator=(const StatePublisher&) = delete;
+
+    /**
+     * @brief Publish the state names of machine to a string signal
+     */
+    template<typename StateT, typename ContextT>
+    void add(sdv::StateMachine<StateT, ContextT>& machine, const SignalHandle<std::string>& signal) {
+        auto id = track(signal);
+        observe(machine, [id](Shared& shared, const sdv::TransitionEvent<StateT>& event) {
+            shared.record(id, vss::types::Value{std::string(event.to_name)});
+        });
+        shared_->record(id, vss::types::Value{machine.current_state_name()});
+    }
+
+    /**
+     * @brief Publish the underlying enum values of machine's states to an integer signal
+     */
+    template<typename StateT, typename ContextT, typename T>
+    void add(sdv::StateMachine<StateT, ContextT>& machine, const SignalHandle<T>& signal) {
+        static_assert(std::is_integral_v<T> && !std::is_same_v<T, bool>,
+                      "State signals must be strings or integers");
+        auto id = track(signal);
+        observe(machine, [id](Shared& shared, const sdv::TransitionEvent<StateT>& event) {
+            shared.record(id, vss::types::Value{to_signal<T>(event.to)});
+        });
+        shared_->record(id, vss::types::Value{to_signal<T>(machine.current_state())});
+    }
+
+    /**
+     * @brief Start publishing every interval
+     */
+    void start();
+
+    /**
+     * @brief Stop the flush thread (pending changes are flushed first)
+     */
+    void stop();
+
+    /**
+     * @brief Publish pending changes now
+     *
+     * @return Number of signal values sent
+     */
+    size_t flush();
+
+    StatePublisherStats stats() const;
+
+private:
+    // Shared with the observers, which may outlive the publisher
+    struct Shared {
+        std::mutex mutex;
+        std::map<int32_t, vss::types::DynamicQualifiedValue> pending;
+        StatePublisherStats stats;
+
+        void record(int32_t signal_id, vss::types::Value value);
+    };
+
+    // Removes one observer; owned by that observer, so it expires with the machine
+    struct Attachment {
+        std::function<void()> detach;
+    };
+
+    template<typename StateT, typename ContextT, typename Record>
+    void observe(sdv::StateMachine<StateT, ContextT>& machine, Record record) {
+        auto attachment = std::make_shared<Attachment>();
+        std::weak_ptr<Shared> weak = shared_;
+        auto observer = machine.add_observer(
+            [weak, attachment, record](const sdv::TransitionEvent<StateT>& event) {
+                if (auto shared = weak.lock()) {
+                    record(*shared, event);
+                }
+            });
+        attachment->detach = [&machine, observer]() { machine.remove_observer(observer); };
+        std::lock_guard<std::mutex> lock(shared_->mutex);
+        attachments_.push_back(attachment);
+    }
+
+    template<typename T, typename StateT>
+    static T to_signal(StateT state) {
+        return static_cast<T>(static_cast<std::underlying_type_t<StateT>>(state));
+    }
+
+    template<typename T>
+    int32_t track(const SignalHandle<T>& signal) {
+        if (!signal.is_valid()) {
+            throw std::invalid_argument("Cannot publish state to an invalid signal handle");
+        }
+        std::lock_guard<std::mutex> lock(shared_->mutex);
+        handles_[signal.id()] = signal.dynamic_handle();
+        return signal.id();
+    }
+
+    void run();
+
+    Client& client_;
+    std::chrono::milliseconds interval_;
+    std::shared_ptr<Shared> shared_;
+    std::map<int32_t, std::shared_ptr<DynamicSignalHandle>> handles_;  // guarded by shared_->mutex
+    std::vector<std::weak_ptr<Attachment>> attachments_;                // guarded by shared_->mutex
+
+    std::mutex thread_mutex_;
+    std::condition_variable wake_;
+    bool stopping_ = false;
+    std::thread thread_;
+};
+
+} // namespace kuksa
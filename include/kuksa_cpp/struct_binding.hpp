@@ -0,0 +1,207 @@
+/**
+ * @file struct_binding.hpp
+ * @brief Binds signals to the fields of a struct read as lock-free snapshots
+ */
+
+#pragma once
+
+#include "client.hpp"
+#include <kuksa_cpp/signal_cells.hpp>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <stdexcept>
+#include <type_traits>
+#include <unordered_map>
+#include <vector>
+
+namespace kuksa {
+
+/**
+ * @brief Keeps the fields of S up to date with signals
+ *
+ * Each update is written into S on the subscription thread under one
+ * seqlock for the whole struct, and read() returns a consistent snapshot:
+ * every field as of the same moment, never half of an update. Readers take
+ * no lock and do not block the subscription thread or each other, so a
+ * control loop can copy dozens of signals per cycle for the cost of a
+ * memcpy.
+ *
+ * A field bound to a signal of type T can be declared as:
+ * - T: set by valid updates; keeps its last value otherwise
+ * - std::optional<T>: the value of a valid update, std::nullopt otherwise
+ * - vss::types::QualifiedValue<T>: the update as received
+ *
+ * S must be trivially copyable, so string and array signals cannot be
+ * bound. Its default member initializers are the values until the first
+ * updates arrive.
+ *
+ * Usage:
+ * @code
+ *   struct Dynamics {
+ *       float speed = 0.0f;
+ *       std::optional<float> yaw_rate;
+ *       vss::types::QualifiedValue<bool> brake;
+ *   };
+ *
+ *   kuksa::StructBinding<Dynamics> dynamics;
+ *   dynamics
+ *       .bind(&Dynamics::speed, speed)
+ *       .bind(&Dynamics::yaw_rate, yaw_rate)
+ *       .bind(&Dynamics::brake, brake_pedal);
+ *   dynamics.subscribe(*client);   // before client->start()
+ *
+ *   Dynamics now = dynamics.read();   // any thread, every cycle
+ * @endcode
+ */
+template<typename S>
+class StructBinding {
+    static_assert(std::is_trivially_copyable_v<S>, "StructBinding needs a trivially copyable struct");
+
+public:
+    StructBinding() : state_(std::make_shared<State>()) {}
+
+    /**
+     * @brief Keep field up to date with signal
+     *
+     * A signal can be bound to several fields.
+     *
+     * @throws std::invalid_argument for an invalid handle
+     * @throws std::logic_error after subscribe()
+     */
+    template<typename F, typename T>
+    StructBinding& bind(F S::*field, const SignalHandle<T>& signal) {
+        static_assert(std::is_same_v<F, T> || std::is_same_v<F, std::optional<T>> ||
+                          std::is_same_v<F, vss::types::QualifiedValue<T>>,
+                      "Bind a field of type T, std::optional<T> or QualifiedValue<T>");
+        if (subscribed_) {
+            throw std::logic_error("Cannot bind fields after StructBinding::subscribe()");
+        }
+        if (!signal.is_valid()) {
+            throw std::invalid_argument("Cannot bind an invalid signal handle");
+        }
+        auto& entry = state_->signals[signal.id()];
+        if (!entry.handle) {
+            entry.handle = signal.dynamic_handle();
+        }
+        entry.setters.push_back([field](S& target, const vss::types::DynamicQualifiedValue& qv) {
+            std::optional<T> value;
+            if (!vss::types::is_empty(qv.value)) {
+                value = detail::try_extract_value<T>(qv.value);
+            }
+            if constexpr (std::is_same_v<F, vss::types::QualifiedValue<T>>) {
+                auto& out = target.*field;
+                out.value = value;
+                out.quality = qv.quality;
+                out.timestamp = qv.timestamp;
+            } else {
+                bool valid = value && qv.quality == vss::types::SignalQuality::VALID;
+                if constexpr (std::is_same_v<F, std::optional<T>>) {
+                    target.*field = valid ? value : std::nullopt;
+                } else if (valid) {
+                    target.*field = *value;
+                }
+            }
+        });
+        return *this;
+    }
+
+    /**
+     * @brief Subscribe every bound signal on client (one subscription per signal)
+     *
+     * Like Client::subscribe(), must be called before client.start().
+     *
+     * @throws std::logic_error if called twice or if the client is running
+     */
+    void subscribe(Client& client) {
+        if (subscribed_) {
+            throw std::logic_error("StructBinding already subscribed");
+        }
+        for (const auto& [signal_id, signal] : state_->signals) {
+            client.subscribe(*signal.handle, [state = state_, signal_id = signal_id](
+                                                 const vss::types::DynamicQualifiedValue& qv) {
+                state->dispatch(signal_id, qv);
+            });
+        }
+        subscribed_ = true;
+    }
+
+    /**
+     * @brief Apply an update to the bound fields
+     *
+     * Called by the subscriptions set up in subscribe(); also usable to feed
+     * updates from another source. Thread-safe: concurrent updates are
+     * applied one after the other.
+     */
+    void dispatch(int32_t signal_id, const vss::types::DynamicQualifiedValue& qv) {
+        state_->dispatch(signal_id, qv);
+    }
+
+    /**
+     * @brief Consistent snapshot of all fields (lock-free, any thread)
+     */
+    S read() const {
+        return state_->snapshot.load();
+    }
+
+    /**
+     * @brief Snapshot into out if any update was applied since version
+     *
+     * Start with version 0; it is advanced to the version of out.
+     *
+     * @return false if nothing changed, leaving out untouched
+     */
+    bool read_if_changed(S& out, uint64_t& version) const {
+        return state_->snapshot.load_if_changed(out, version);
+    }
+
+    /// Number of updates applied
+    uint64_t version() const {
+        return state_->snapshot.version();
+    }
+
+    /**
+     * @brief Number of bound fields
+     */
+    size_t size() const {
+        size_t count = 0;
+        for (const auto& [id, signal] : state_->signals) {
+            count += signal.setters.size();
+        }
+        return count;
+    }
+
+private:
+    using Setter = std::function<void(S&, const vss::types::DynamicQualifiedValue&)>;
+
+    struct Signal {
+        std::shared_ptr<DynamicSignalHandle> handle;
+        std::vector<Setter> setters;
+    };
+
+    struct State {
+        std::unordered_map<int32_t, Signal> signals;
+        std::mutex writer;  // the seqlock allows one writer at a time
+        Seqlock<S> snapshot;
+
+        void dispatch(int32_t signal_id, const vss::types::DynamicQualifiedValue& qv) {
+            auto it = signals.find(signal_id);
+            if (it == signals.end()) {
+                return;
+            }
+            std::lock_guard<std::mutex> lock(writer);
+            snapshot.write([&](S& target) {
+                for (auto& setter : it->second.setters) {
+                    setter(target, qv);
+                }
+            });
+        }
+    };
+
+    std::shared_ptr<State> state_;
+    bool subscribed_ = false;
+};
+
+} // namespace kuksa
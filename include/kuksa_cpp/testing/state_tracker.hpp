@@ -0,0 +1,103 @@
+#pragma once
+
+#include <kuksa_cpp/state_machine/state_machine.hpp>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <unordered_map>
+
+namespace sdv {
+namespace testing {
+
+/**
+ * @brief Follows in-process state machines through their transition observers
+ *
+ * Backs the expect_state and expect_transition test steps. Each watched
+ * machine pushes its transitions here as they happen, and waiters are woken
+ * on the condition variable: no polling and no log parsing.
+ *
+ * Machines are identified by name, as in the YAML "machine" field. A
+ * machine may outlive the tracker; its observer then does nothing.
+ */
+class StateTracker : public std::enable_shared_from_this<StateTracker> {
+public:
+    /// Transitions kept per machine for expect_transition
+    static constexpr std::size_t kHistoryLimit = 1024;
+
+    /**
+     * @brief Start following a state machine
+     *
+     * Registers an observer and records the machine's current state.
+     */
+    template<typename StateT, typename ContextT>
+    void watch(StateMachine<StateT, ContextT>& machine) {
+        std::weak_ptr<StateTracker> weak = shared_from_this();
+        machine.add_observer([weak](const TransitionEvent<StateT>& event) {
+            if (auto tracker = weak.lock()) {
+                tracker->record_transition(std::string(event.machine),
+                                           std::string(event.from_name),
+                                           std::string(event.to_name));
+            }
+        });
+        // After registering, so a transition in between is not missed
+        set_initial_state(machine.name(), machine.current_state_name());
+    }
+
+    /**
+     * @brief Record a transition (normally called by the observer)
+     */
+    void record_transition(const std::string& machine, const std::string& from, const std::string& to);
+
+    /**
+     * @brief Record the state of a machine that has not transitioned yet
+     */
+    void set_initial_state(const std::string& machine, const std::string& state);
+
+    bool is_watched(const std::string& machine) const;
+
+    std::optional<std::string> current_state(const std::string& machine) const;
+
+    /**
+     * @brief Wait until machine is in state
+     *
+     * @return true if it is, or enters it before the timeout
+     */
+    bool wait_for_state(const std::string& machine, const std::string& state,
+                        std::chrono::nanoseconds timeout);
+
+    /**
+     * @brief Wait for a from -> to transition not matched by an earlier call
+     *
+     * Transitions recorded before the call count, so a transition caused by
+     * a preceding inject step is found even if it completed first. An empty
+     * from or to matches any state.
+     *
+     * @return true if a matching transition was consumed before the timeout
+     */
+    bool wait_for_transition(const std::string& machine, const std::string& from,
+                             const std::string& to, std::chrono::nanoseconds timeout);
+
+private:
+    struct Transition {
+        std::string from;
+        std::string to;
+    };
+
+    struct MachineState {
+        std::string current;
+        bool transitioned = false;
+        std::deque<Transition> history;  // not yet consumed by wait_for_transition
+    };
+
+    mutable std::mutex mutex_;
+    std::condition_variable cv_;
+    std::unordered_map<std::string, MachineState> machines_;
+};
+
+} // namespace testing
+} // namespace sdv
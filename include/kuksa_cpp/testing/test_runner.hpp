@@ -2,6 +2,7 @@
 
 #include "test_models.hpp"
 #include "kuksa_client_wrapper.hpp"
+#include "state_tracker.hpp"
 #include <memory>
 
 namespace sdv {
@@ -14,8 +15,20 @@ public:
     TestSuiteResult run_suite(const TestSuite& suite);
     TestCaseResult run_test_case(const TestCase& test_case);
 
+    /**
+     * @brief Make an in-process state machine available to expect_state
+     *        and expect_transition steps, matched by its name
+     *
+     * Steps naming a machine that is not watched are skipped.
+     */
+    template<typename StateT, typename ContextT>
+    void watch_state_machine(StateMachine<StateT, ContextT>& machine) {
+        tracker_->watch(machine);
+    }
+
 private:
     std::shared_ptr<KuksaClientWrapper> client_;
+    std::shared_ptr<StateTracker> tracker_;
 
     StepResult run_step(const TestStep& step);
 
@@ -41,6 +41,21 @@ enum class SignalClass {
     UNKNOWN
 };
 
+/**
+ * @brief Traffic class of a signal (see Client::set_priority)
+ *
+ * Each class travels on its own lane: a separate gRPC channel (connection)
+ * and separate subscription streams, so high-priority traffic never queues
+ * behind bulk transfers.
+ */
+enum class Priority : uint8_t {
+    HIGH = 0,    // Safety-critical (brake lights, door locks, ...)
+    NORMAL = 1,  // Default
+    BULK = 2     // Large or frequent telemetry
+};
+
+constexpr size_t PRIORITY_COUNT = 3;
+
 // Forward declaration of the canonical handle type
 class DynamicSignalHandle;
 
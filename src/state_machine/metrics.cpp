@@ -0,0 +1,126 @@
+/**
+ * @file metrics.cpp
+ * @brief Prometheus and text exporters for state machine metrics
+ */
+
+#include <kuksa_cpp/state_machine/metrics.hpp>
+#include <iomanip>
+#include <sstream>
+
+namespace sdv {
+
+namespace {
+
+std::string escape_label(const std::string& value) {
+    std::string escaped;
+    escaped.reserve(value.size());
+    for (char c : value) {
+        switch (c) {
+            case '\\': escaped += "\\\\"; break;
+            case '"':  escaped += "\\\""; break;
+            case '\n': escaped += "\\n"; break;
+            default:   escaped += c; break;
+        }
+    }
+    return escaped;
+}
+
+double seconds(std::chrono::nanoseconds ns) {
+    return std::chrono::duration<double>(ns).count();
+}
+
+} // namespace
+
+std::string to_prometheus_text(const MetricsSnapshot& snapshot) {
+    std::ostringstream out;
+    out << std::setprecision(9);
+    const auto machine = "machine=\"" + escape_label(snapshot.machine) + "\"";
+
+    out << "# HELP sdv_state_machine_current_state Current state (1 for the active state)\n"
+        << "# TYPE sdv_state_machine_current_state gauge\n"
+        << "sdv_state_machine_current_state{" << machine
+        << ",state=\"" << escape_label(snapshot.current_state) << "\"} 1\n";
+
+    out << "# HELP sdv_state_machine_ignored_events_total Events with no matching transition\n"
+        << "# TYPE sdv_state_machine_ignored_events_total counter\n"
+        << "sdv_state_machine_ignored_events_total{" << machine << "} " << snapshot.ignored << "\n";
+
+    out << "# HELP sdv_state_machine_transitions_total State transitions taken\n"
+        << "# TYPE sdv_state_machine_transitions_total counter\n";
+    for (const auto& t : snapshot.transition_metrics) {
+        out << "sdv_state_machine_transitions_total{" << machine
+            << ",from=\"" << escape_label(t.from) << "\",to=\"" << escape_label(t.to)
+            << "\",trigger=\"" << escape_label(t.trigger) << "\"} " << t.latency.count << "\n";
+    }
+
+    out << "# HELP sdv_state_machine_blocked_total Transitions rejected by their guard\n"
+        << "# TYPE sdv_state_machine_blocked_total counter\n";
+    for (const auto& t : snapshot.transition_metrics) {
+        out << "sdv_state_machine_blocked_total{" << machine
+            << ",from=\"" << escape_label(t.from) << "\",to=\"" << escape_label(t.to)
+            << "\",trigger=\"" << escape_label(t.trigger) << "\"} " << t.blocked << "\n";
+    }
+
+    out << "# HELP sdv_state_machine_transition_latency_seconds Duration of exit, action and entry\n"
+        << "# TYPE sdv_state_machine_transition_latency_seconds histogram\n";
+    for (const auto& t : snapshot.transition_metrics) {
+        const auto labels = machine + ",from=\"" + escape_label(t.from) + "\",to=\"" +
+                            escape_label(t.to) + "\",trigger=\"" + escape_label(t.trigger) + "\"";
+        std::uint64_t cumulative = 0;
+        for (std::size_t i = 0; i + 1 < kLatencyBuckets; ++i) {
+            cumulative += t.latency.buckets[i];
+            out << "sdv_state_machine_transition_latency_seconds_bucket{" << labels
+                << ",le=\"" << seconds(latency_bucket_bound(i)) << "\"} " << cumulative << "\n";
+        }
+        out << "sdv_state_machine_transition_latency_seconds_bucket{" << labels
+            << ",le=\"+Inf\"} " << t.latency.count << "\n"
+            << "sdv_state_machine_transition_latency_seconds_sum{" << labels << "} "
+            << seconds(t.latency.sum) << "\n"
+            << "sdv_state_machine_transition_latency_seconds_count{" << labels << "} "
+            << t.latency.count << "\n";
+    }
+
+    out << "# HELP sdv_state_machine_state_entries_total Times each state was entered\n"
+        << "# TYPE sdv_state_machine_state_entries_total counter\n";
+    for (const auto& s : snapshot.state_metrics) {
+        out << "sdv_state_machine_state_entries_total{" << machine
+            << ",state=\"" << escape_label(s.state) << "\"} " << s.entries << "\n";
+    }
+
+    out << "# HELP sdv_state_machine_time_in_state_seconds_total Time spent in each state (completed visits)\n"
+        << "# TYPE sdv_state_machine_time_in_state_seconds_total counter\n";
+    for (const auto& s : snapshot.state_metrics) {
+        out << "sdv_state_machine_time_in_state_seconds_total{" << machine
+            << ",state=\"" << escape_label(s.state) << "\"} " << seconds(s.time_in_state) << "\n";
+    }
+
+    return out.str();
+}
+
+std::string to_text(const MetricsSnapshot& snapshot) {
+    std::ostringstream out;
+    out << "State machine " << snapshot.machine << " (state=" << snapshot.current_state
+        << ", transitions=" << snapshot.transitions << ", ignored=" << snapshot.ignored << ")\n";
+
+    out << "  Transitions:\n";
+    for (const auto& t : snapshot.transition_metrics) {
+        out << "    " << std::left << std::setw(40) << (t.from + " -> " + t.to + " [" + t.trigger + "]")
+            << std::right << " count=" << t.latency.count
+            << " blocked=" << t.blocked
+            << " mean=" << t.latency.mean().count() << "ns"
+            << " p99<=" << t.latency.quantile(0.99).count() << "ns"
+            << " max=" << t.latency.max.count() << "ns\n";
+    }
+
+    out << "  States:\n";
+    for (const auto& s : snapshot.state_metrics) {
+        out << "    " << std::left << std::setw(40) << s.state << std::right
+            << " entries=" << s.entries
+            << " time=" << std::fixed << std::setprecision(3) << seconds(s.time_in_state) << "s\n";
+        out.unsetf(std::ios::fixed);
+    }
+
+    return out.str();
+}
+
+} // namespace sdv
@@ -0,0 +1,282 @@
+/**
+ * @file snapshot.cpp
+ * @brief Snapshot encoding and the double-slot snapshot file
+ */
+
+#include <kuksa_cpp/state_machine/snapshot.hpp>
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+#include <glog/logging.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace sdv {
+
+namespace {
+
+constexpr std::uint32_t kRecordMagic = 0x31534d53;  // "SMS1"
+constexpr std::uint32_t kSlotMagic = 0x544f4c53;    // "SLOT"
+
+class Writer {
+public:
+    template<typename T>
+    void put(T value) {
+        out_.append(reinterpret_cast<const char*>(&value), sizeof(value));
+    }
+
+    void put_string(const std::string& value) {
+        put(static_cast<std::uint32_t>(value.size()));
+        out_.append(value);
+    }
+
+    void put_time(std::chrono::system_clock::time_point time) {
+        put(static_cast<std::int64_t>(
+            std::chrono::duration_cast<std::chrono::nanoseconds>(time.time_since_epoch()).count()));
+    }
+
+    std::string take() { return std::move(out_); }
+
+private:
+    std::string out_;
+};
+
+class Reader {
+public:
+    explicit Reader(const std::string& in) : in_(in) {}
+
+    template<typename T>
+    bool get(T& value) {
+        if (in_.size() - pos_ < sizeof(value)) {
+            return false;
+        }
+        std::memcpy(&value, in_.data() + pos_, sizeof(value));
+        pos_ += sizeof(value);
+        return true;
+    }
+
+    bool get_string(std::string& value) {
+        std::uint32_t size = 0;
+        if (!get(size) || in_.size() - pos_ < size) {
+            return false;
+        }
+        value.assign(in_, pos_, size);
+        pos_ += size;
+        return true;
+    }
+
+    bool get_time(std::chrono::system_clock::time_point& time) {
+        std::int64_t ns = 0;
+        if (!get(ns)) {
+            return false;
+        }
+        time = std::chrono::system_clock::time_point(
+            std::chrono::duration_cast<std::chrono::system_clock::duration>(std::chrono::nanoseconds(ns)));
+        return true;
+    }
+
+private:
+    const std::string& in_;
+    std::size_t pos_ = 0;
+};
+
+std::uint32_t crc32(const void* data, std::size_t size, std::uint32_t crc = 0) {
+    static const auto table = [] {
+        std::array<std::uint32_t, 256> t{};
+        for (std::uint32_t i = 0; i < 256; ++i) {
+            std::uint32_t c = i;
+            for (int k = 0; k < 8; ++k) {
+                c = (c & 1) ? 0xedb88320u ^ (c >> 1) : c >> 1;
+            }
+            t[i] = c;
+        }
+        return t;
+    }();
+    const auto* bytes = static_cast<const unsigned char*>(data);
+    crc = ~crc;
+    for (std::size_t i = 0; i < size; ++i) {
+        crc = table[(crc ^ bytes[i]) & 0xff] ^ (crc >> 8);
+    }
+    return ~crc;
+}
+
+std::string errno_message(const std::string& what, const std::string& path) {
+    return what + " " + path + ": " + std::strerror(errno);
+}
+
+} // namespace
+
+std::string encode_snapshot(const StateSnapshot& snapshot) {
+    Writer out;
+    out.put(kRecordMagic);
+    out.put_string(snapshot.machine);
+    out.put(snapshot.state);
+    out.put_time(snapshot.entered);
+    out.put_time(snapshot.taken);
+    out.put(static_cast<std::uint32_t>(snapshot.timers.size()));
+    for (const auto& timer : snapshot.timers) {
+        out.put_string(timer.trigger);
+        out.put_time(timer.deadline);
+        out.put(static_cast<std::uint8_t>(timer.state_timeout ? 1 : 0));
+        out.put(timer.owner);
+    }
+    out.put_string(snapshot.context);
+    return out.take();
+}
+
+std::optional<StateSnapshot> decode_snapshot(const std::string& data) {
+    Reader in(data);
+    StateSnapshot snapshot;
+    std::uint32_t magic = 0;
+    std::uint32_t timers = 0;
+    if (!in.get(magic) || magic != kRecordMagic ||
+        !in.get_string(snapshot.machine) ||
+        !in.get(snapshot.state) ||
+        !in.get_time(snapshot.entered) ||
+        !in.get_time(snapshot.taken) ||
+        !in.get(timers)) {
+        return std::nullopt;
+    }
+    for (std::uint32_t i = 0; i < timers; ++i) {
+        SnapshotTimer timer;
+        std::uint8_t state_timeout = 0;
+        if (!in.get_string(timer.trigger) || !in.get_time(timer.deadline) ||
+            !in.get(state_timeout) || !in.get(timer.owner)) {
+            return std::nullopt;
+        }
+        timer.state_timeout = state_timeout != 0;
+        snapshot.timers.push_back(std::move(timer));
+    }
+    if (!in.get_string(snapshot.context)) {
+        return std::nullopt;
+    }
+    return snapshot;
+}
+
+// ============================================================================
+// SnapshotFile
+// ============================================================================
+
+struct SnapshotFile::SlotHeader {
+    std::uint32_t magic;
+    std::uint32_t length;
+    std::uint64_t sequence;
+    std::uint32_t crc;  // over sequence, length and payload
+    std::uint32_t reserved;
+};
+
+namespace {
+
+template<typename Header>
+std::uint32_t slot_crc(const Header& header) {
+    auto crc = crc32(&header.sequence, sizeof(header.sequence));
+    crc = crc32(&header.length, sizeof(header.length), crc);
+    return crc32(&header + 1, header.length, crc);
+}
+
+} // namespace
+
+SnapshotFile::SnapshotFile(const std::string& path, std::size_t slot_size, bool sync)
+    : path_(path), slot_size_(slot_size), sync_(sync) {
+    if (slot_size_ <= sizeof(SlotHeader)) {
+        throw std::invalid_argument("Snapshot slot size too small");
+    }
+    fd_ = ::open(path.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+    if (fd_ < 0) {
+        throw std::runtime_error(errno_message("Cannot open snapshot file", path));
+    }
+
+    mapping_size_ = 2 * slot_size_;
+    struct stat info {};
+    if (::fstat(fd_, &info) != 0 ||
+        (static_cast<std::size_t>(info.st_size) != mapping_size_ &&
+         (::ftruncate(fd_, 0) != 0 || ::ftruncate(fd_, static_cast<off_t>(mapping_size_)) != 0))) {
+        auto message = errno_message("Cannot size snapshot file", path);
+        ::close(fd_);
+        throw std::runtime_error(message);
+    }
+
+    mapping_ = ::mmap(nullptr, mapping_size_, PROT_READ | PROT_WRITE, MAP_SHARED, fd_, 0);
+    if (mapping_ == MAP_FAILED) {
+        auto message = errno_message("Cannot map snapshot file", path);
+        ::close(fd_);
+        throw std::runtime_error(message);
+    }
+
+    for (std::size_t i = 0; i < 2; ++i) {
+        const auto* header = slot(i);
+        if (header->magic == kSlotMagic && header->length <= capacity() && header->crc == slot_crc(*header)) {
+            sequence_ = std::max(sequence_, header->sequence);
+        }
+    }
+    VLOG(1) << "[Snapshot] opened " << path << " slot_size=" << slot_size_ << " sequence=" << sequence_;
+}
+
+SnapshotFile::~SnapshotFile() {
+    if (mapping_ && mapping_ != MAP_FAILED) {
+        ::munmap(mapping_, mapping_size_);
+    }
+    if (fd_ >= 0) {
+        ::close(fd_);
+    }
+}
+
+std::size_t SnapshotFile::capacity() const {
+    return slot_size_ - sizeof(SlotHeader);
+}
+
+SnapshotFile::SlotHeader* SnapshotFile::slot(std::size_t index) const {
+    return reinterpret_cast<SlotHeader*>(static_cast<char*>(mapping_) + index * slot_size_);
+}
+
+bool SnapshotFile::write(const StateSnapshot& snapshot) {
+    auto record = encode_snapshot(snapshot);
+    if (record.size() > capacity()) {
+        LOG(WARNING) << "[Snapshot] " << snapshot.machine << ": " << record.size()
+                     << " bytes exceed slot capacity " << capacity();
+        return false;
+    }
+
+    // Overwrite the older slot; the newer one stays valid until we are done
+    auto sequence = sequence_ + 1;
+    auto* header = slot(sequence % 2);
+    header->magic = 0;
+    std::atomic_signal_fence(std::memory_order_seq_cst);
+    std::memcpy(header + 1, record.data(), record.size());
+    header->length = static_cast<std::uint32_t>(record.size());
+    header->sequence = sequence;
+    header->crc = slot_crc(*header);
+    header->reserved = 0;
+    std::atomic_signal_fence(std::memory_order_seq_cst);  // publish the slot last
+    header->magic = kSlotMagic;
+    sequence_ = sequence;
+
+    if (sync_ && ::msync(mapping_, mapping_size_, MS_SYNC) != 0) {
+        LOG(WARNING) << "[Snapshot] msync " << path_ << ": " << std::strerror(errno);
+    }
+    return true;
+}
+
+std::optional<StateSnapshot> SnapshotFile::read() const {
+    const SlotHeader* newest = nullptr;
+    for (std::size_t i = 0; i < 2; ++i) {
+        const auto* header = slot(i);
+        if (header->magic != kSlotMagic || header->length > capacity() || header->crc != slot_crc(*header)) {
+            continue;
+        }
+        if (!newest || header->sequence > newest->sequence) {
+            newest = header;
+        }
+    }
+    if (!newest) {
+        return std::nullopt;
+    }
+    return decode_snapshot(std::string(reinterpret_cast<const char*>(newest + 1), newest->length));
+}
+
+} // namespace sdv
@@ -0,0 +1,76 @@
+#include "kuksa_cpp/testing/state_tracker.hpp"
+
+namespace sdv {
+namespace testing {
+
+void StateTracker::record_transition(const std::string& machine, const std::string& from,
+                                     const std::string& to) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto& state = machines_[machine];
+        state.current = to;
+        state.transitioned = true;
+        state.history.push_back(Transition{from, to});
+        if (state.history.size() > kHistoryLimit) {
+            state.history.pop_front();
+        }
+    }
+    cv_.notify_all();
+}
+
+void StateTracker::set_initial_state(const std::string& machine, const std::string& state) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto& entry = machines_[machine];
+        if (entry.transitioned) {
+            return;  // the observer already reported a newer state
+        }
+        entry.current = state;
+    }
+    cv_.notify_all();
+}
+
+bool StateTracker::is_watched(const std::string& machine) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return machines_.count(machine) > 0;
+}
+
+std::optional<std::string> StateTracker::current_state(const std::string& machine) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = machines_.find(machine);
+    if (it == machines_.end()) {
+        return std::nullopt;
+    }
+    return it->second.current;
+}
+
+bool StateTracker::wait_for_state(const std::string& machine, const std::string& state,
+                                  std::chrono::nanoseconds timeout) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    return cv_.wait_for(lock, timeout, [&]() {
+        auto it = machines_.find(machine);
+        return it != machines_.end() && it->second.current == state;
+    });
+}
+
+bool StateTracker::wait_for_transition(const std::string& machine, const std::string& from,
+                                       const std::string& to, std::chrono::nanoseconds timeout) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    return cv_.wait_for(lock, timeout, [&]() {
+        auto it = machines_.find(machine);
+        if (it == machines_.end()) {
+            return false;
+        }
+        auto& history = it->second.history;
+        for (auto t = history.begin(); t != history.end(); ++t) {
+            if ((from.empty() || t->from == from) && (to.empty() || t->to == to)) {
+                history.erase(history.begin(), t + 1);
+                return true;
+            }
+        }
+        return false;
+    });
+}
+
+} // namespace testing
+} // namespace sdv
@@ -8,7 +8,8 @@ namespace sdv {
 namespace testing {
 
 TestRunner::TestRunner(std::shared_ptr<KuksaClientWrapper> client)
-    : client_(client) {
+    : client_(client)
+    , tracker_(std::make_shared<StateTracker>()) {
 }
 
 bool TestRunner::values_match(const TestValue& a, const TestValue& b) {
@@ -95,11 +96,25 @@ StepResult TestRunner::execute_expect_state(const ExpectStateData& data, double
     StepResult result;
     result.status = TestStatus::RUNNING;
 
-    // TODO: Implement state machine tracking
-    LOG(WARNING) << "expect_state not yet implemented";
+    if (!tracker_->is_watched(data.state_machine)) {
+        LOG(WARNING) << "expect_state: state machine '" << data.state_machine << "' is not watched";
+        result.status = TestStatus::SKIPPED;
+        result.message = "State machine '" + data.state_machine + "' is not watched";
+        return result;
+    }
+
+    auto timeout_duration = std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::duration<double>(timeout));
+
+    if (tracker_->wait_for_state(data.state_machine, data.state, timeout_duration)) {
+        result.status = TestStatus::PASSED;
+        return result;
+    }
 
-    result.status = TestStatus::SKIPPED;
-    result.message = "State machine tracking not implemented";
+    result.status = TestStatus::FAILED;
+    result.message = "State machine '" + data.state_machine + "' not in state " + data.state +
+                     " within " + std::to_string(timeout) + "s (current: " +
+                     tracker_->current_state(data.state_machine).value_or("unknown") + ")";
 
     return result;
 }
@@ -108,11 +123,25 @@ StepResult TestRunner::execute_expect_transition(const ExpectTransitionData& dat
     StepResult result;
     result.status = TestStatus::RUNNING;
 
-    // TODO: Implement state machine tracking
-    LOG(WARNING) << "expect_transition not yet implemented";
+    if (!tracker_->is_watched(data.state_machine)) {
+        LOG(WARNING) << "expect_transition: state machine '" << data.state_machine << "' is not watched";
+        result.status = TestStatus::SKIPPED;
+        result.message = "State machine '" + data.state_machine + "' is not watched";
+        return result;
+    }
+
+    auto timeout_duration = std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::duration<double>(timeout));
+
+    if (tracker_->wait_for_transition(data.state_machine, data.from_state, data.to_state,
+                                      timeout_duration)) {
+        result.status = TestStatus::PASSED;
+        return result;
+    }
 
-    result.status = TestStatus::SKIPPED;
-    result.message = "State machine tracking not implemented";
+    result.status = TestStatus::FAILED;
+    result.message = "Transition " + data.from_state + " -> " + data.to_state + " of '" +
+                     data.state_machine + "' not observed within " + std::to_string(timeout) + "s";
 
     return result;
 }
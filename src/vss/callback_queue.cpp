@@ -0,0 +1,128 @@
+/**
+ * @file callback_queue.cpp
+ * @brief Callback queue signalled through an eventfd or an executor
+ */
+
+#include "callback_queue.hpp"
+#include <glog/logging.h>
+#include <cerrno>
+#include <cstring>
+#include <sys/eventfd.h>
+#include <unistd.h>
+
+namespace kuksa {
+
+Result<std::shared_ptr<CallbackQueue>> CallbackQueue::with_event_fd() {
+    int fd = ::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (fd < 0) {
+        return absl::InternalError(std::string("eventfd: ") + std::strerror(errno));
+    }
+    return std::shared_ptr<CallbackQueue>(new CallbackQueue(fd, nullptr));
+}
+
+std::shared_ptr<CallbackQueue> CallbackQueue::with_executor(Client::Executor executor) {
+    return std::shared_ptr<CallbackQueue>(new CallbackQueue(-1, std::move(executor)));
+}
+
+CallbackQueue::CallbackQueue(int fd, Client::Executor executor)
+    : fd_(fd)
+    , executor_(std::move(executor)) {
+}
+
+CallbackQueue::~CallbackQueue() {
+    if (fd_ >= 0) {
+        ::close(fd_);
+    }
+}
+
+void CallbackQueue::push(std::function<void()> callback) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (closed_) {
+            return;
+        }
+        pending_.push_back(std::move(callback));
+        if (pending_.size() > 1) {
+            // Already signalled; the next dispatch() takes this one too
+            return;
+        }
+    }
+    wake();
+}
+
+void CallbackQueue::wake() {
+    wakeups_.fetch_add(1, std::memory_order_relaxed);
+    if (fd_ >= 0) {
+        uint64_t one = 1;
+        if (::write(fd_, &one, sizeof(one)) != sizeof(one)) {
+            LOG(ERROR) << "Cannot signal callback eventfd: " << std::strerror(errno);
+        }
+        return;
+    }
+    // The executor may run the task after the client is gone
+    executor_([weak = weak_from_this()]() {
+        if (auto queue = weak.lock()) {
+            queue->dispatch(SIZE_MAX);
+        }
+    });
+}
+
+size_t CallbackQueue::dispatch(size_t max_callbacks) {
+    if (dispatcher_.load() == std::this_thread::get_id()) {
+        // dispatching_ is ours already; taking it again would deadlock
+        return 0;
+    }
+    if (fd_ >= 0) {
+        // Reset the eventfd before taking the batch: later pushes signal again
+        uint64_t count;
+        (void)::read(fd_, &count, sizeof(count));
+    }
+
+    std::lock_guard<std::mutex> dispatching(dispatching_);
+    std::deque<std::function<void()>> batch;
+    bool more = false;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (pending_.size() <= max_callbacks) {
+            batch.swap(pending_);
+        } else {
+            auto end = pending_.begin() + static_cast<std::ptrdiff_t>(max_callbacks);
+            batch.assign(std::make_move_iterator(pending_.begin()), std::make_move_iterator(end));
+            pending_.erase(pending_.begin(), end);
+            more = true;
+        }
+    }
+    if (more) {
+        wake();
+    }
+
+    size_t ran = 0;
+    dispatcher_ = std::this_thread::get_id();
+    for (auto& callback : batch) {
+        if (closed_.load(std::memory_order_relaxed)) {
+            break;  // closed by a callback of this batch
+        }
+        try {
+            callback();
+        } catch (const std::exception& e) {
+            LOG(ERROR) << "Exception in callback: " << e.what();
+        }
+        ++ran;
+    }
+    dispatcher_ = std::thread::id();
+    return ran;
+}
+
+void CallbackQueue::close() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        closed_ = true;
+        pending_.clear();
+    }
+    if (dispatcher_.load() == std::this_thread::get_id()) {
+        return;
+    }
+    std::lock_guard<std::mutex> dispatching(dispatching_);
+}
+
+} // namespace kuksa
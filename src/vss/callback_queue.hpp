@@ -0,0 +1,86 @@
+/**
+ * @file callback_queue.hpp
+ * @brief Hands a client's callbacks to the application's event loop
+ */
+
+#pragma once
+
+#include <kuksa_cpp/client.hpp>
+#include <kuksa_cpp/error.hpp>
+#include <atomic>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+namespace kuksa {
+
+/**
+ * @brief Callbacks queued by runtime threads and run by the application
+ *
+ * The application is woken once per batch, not once per callback: only a
+ * push into an empty queue writes the eventfd or posts to the executor, and
+ * dispatch() then runs everything queued until then.
+ */
+class CallbackQueue : public std::enable_shared_from_this<CallbackQueue> {
+public:
+    /**
+     * @brief Signal pending callbacks on a non-blocking eventfd
+     */
+    static Result<std::shared_ptr<CallbackQueue>> with_event_fd();
+
+    /**
+     * @brief Post a dispatch() to executor when callbacks are pending
+     */
+    static std::shared_ptr<CallbackQueue> with_executor(Client::Executor executor);
+
+    ~CallbackQueue();
+
+    CallbackQueue(const CallbackQueue&) = delete;
+    CallbackQueue& operator=(const CallbackQueue&) = delete;
+
+    void push(std::function<void()> callback);
+
+    /**
+     * @brief Run up to max_callbacks queued callbacks on the calling thread
+     *
+     * If callbacks remain, the application is woken again. Called from one
+     * of the callbacks, it runs nothing and returns 0: the batch in progress
+     * continues when that callback returns.
+     */
+    size_t dispatch(size_t max_callbacks);
+
+    /**
+     * @brief Drop queued callbacks and wait for a dispatch() in progress
+     *
+     * Called from a callback, it does not wait; the dispatch() in progress
+     * stops when that callback returns.
+     */
+    void close();
+
+    /// The eventfd, or -1 with an executor
+    int fd() const { return fd_; }
+
+    /// Times the application was woken
+    uint64_t wakeups() const { return wakeups_.load(std::memory_order_relaxed); }
+
+private:
+    CallbackQueue(int fd, Client::Executor executor);
+
+    void wake();
+
+    const int fd_;
+    const Client::Executor executor_;
+
+    std::mutex mutex_;
+    std::deque<std::function<void()>> pending_;  // guarded by mutex_
+    std::atomic<bool> closed_{false};            // written under mutex_
+
+    std::mutex dispatching_;  // held while callbacks run, so close() can wait
+    std::atomic<std::thread::id> dispatcher_{};  // thread running callbacks, if any
+    std::atomic<uint64_t> wakeups_{0};
+};
+
+} // namespace kuksa
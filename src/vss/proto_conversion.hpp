@@ -0,0 +1,236 @@
+/**
+ * @file proto_conversion.hpp
+ * @brief Conversions between VSS values and kuksa.val.v2 protobuf types
+ */
+
+#pragma once
+
+#include <kuksa_cpp/error.hpp>
+#include <kuksa_cpp/type_mapping.hpp>
+#include <absl/strings/str_format.h>
+#include <chrono>
+#include <limits>
+#include <string>
+#include <vector>
+
+#include "kuksa/val/v2/types.pb.h"
+
+namespace kuksa {
+
+// ============================================================================
+// Conversions between VSS values and kuksa.val.v2 protobuf types
+// ============================================================================
+
+/**
+ * @brief Safely narrow a value from physical type to logical type with range checking
+ *
+ * Used when converting from KUKSA protobuf types (int32/uint32) to VSS logical types
+ * (int8/uint8/int16/uint16). Validates that the value fits in the target range.
+ *
+ * @tparam LogicalT Target VSS logical type (e.g., uint8_t)
+ * @tparam PhysicalT Source KUKSA physical type (e.g., uint32_t)
+ * @param value Value to narrow
+ * @return Result<LogicalT> Success with narrowed value, or error if out of range
+ */
+template<typename LogicalT, typename PhysicalT>
+inline Result<LogicalT> narrow_cast(PhysicalT value) {
+    if (value < std::numeric_limits<LogicalT>::min() ||
+        value > std::numeric_limits<LogicalT>::max()) {
+        return absl::OutOfRangeError(
+            absl::StrFormat("Value %d out of range for type [%d, %d]",
+                           static_cast<int64_t>(value),
+                           static_cast<int64_t>(std::numeric_limits<LogicalT>::min()),
+                           static_cast<int64_t>(std::numeric_limits<LogicalT>::max()))
+        );
+    }
+    return static_cast<LogicalT>(value);
+}
+
+// Convert vss::types::Value to protobuf Value
+// Handles widening conversions for int8/uint8/int16/uint16 -> int32/uint32
+inline kuksa::val::v2::Value to_proto_value(const vss::types::Value& value) {
+    kuksa::val::v2::Value proto_value;
+
+    std::visit([&proto_value](auto&& v) {
+        using T = std::decay_t<decltype(v)>;
+
+        if constexpr (std::is_same_v<T, std::monostate>) {
+            // Empty value - don't set anything in protobuf
+        } else if constexpr (std::is_same_v<T, bool>) {
+            proto_value.set_bool_(v);
+        }
+        // Narrowing scalar types (widen to protobuf physical type)
+        else if constexpr (std::is_same_v<T, int8_t>) {
+            proto_value.set_int32(static_cast<int32_t>(v));  // Widen
+        } else if constexpr (std::is_same_v<T, uint8_t>) {
+            proto_value.set_uint32(static_cast<uint32_t>(v));  // Widen
+        } else if constexpr (std::is_same_v<T, int16_t>) {
+            proto_value.set_int32(static_cast<int32_t>(v));  // Widen
+        } else if constexpr (std::is_same_v<T, uint16_t>) {
+            proto_value.set_uint32(static_cast<uint32_t>(v));  // Widen
+        }
+        // Direct scalar types (no conversion)
+        else if constexpr (std::is_same_v<T, int32_t>) {
+            proto_value.set_int32(v);
+        } else if constexpr (std::is_same_v<T, uint32_t>) {
+            proto_value.set_uint32(v);
+        } else if constexpr (std::is_same_v<T, int64_t>) {
+            proto_value.set_int64(v);
+        } else if constexpr (std::is_same_v<T, uint64_t>) {
+            proto_value.set_uint64(v);
+        } else if constexpr (std::is_same_v<T, float>) {
+            proto_value.set_float_(v);
+        } else if constexpr (std::is_same_v<T, double>) {
+            proto_value.set_double_(v);
+        } else if constexpr (std::is_same_v<T, std::string>) {
+            proto_value.set_string(v);
+        }
+        // Narrowing array types (widen elements to protobuf physical type)
+        else if constexpr (std::is_same_v<T, std::vector<int8_t>>) {
+            auto* arr = proto_value.mutable_int32_array();
+            for (int8_t val : v) arr->add_values(static_cast<int32_t>(val));
+        } else if constexpr (std::is_same_v<T, std::vector<uint8_t>>) {
+            auto* arr = proto_value.mutable_uint32_array();
+            for (uint8_t val : v) arr->add_values(static_cast<uint32_t>(val));
+        } else if constexpr (std::is_same_v<T, std::vector<int16_t>>) {
+            auto* arr = proto_value.mutable_int32_array();
+            for (int16_t val : v) arr->add_values(static_cast<int32_t>(val));
+        } else if constexpr (std::is_same_v<T, std::vector<uint16_t>>) {
+            auto* arr = proto_value.mutable_uint32_array();
+            for (uint16_t val : v) arr->add_values(static_cast<uint32_t>(val));
+        }
+        // Direct array types (no conversion)
+        else if constexpr (std::is_same_v<T, std::vector<bool>>) {
+            auto* arr = proto_value.mutable_bool_array();
+            for (bool val : v) arr->add_values(val);
+        } else if constexpr (std::is_same_v<T, std::vector<int32_t>>) {
+            auto* arr = proto_value.mutable_int32_array();
+            for (int32_t val : v) arr->add_values(val);
+        } else if constexpr (std::is_same_v<T, std::vector<uint32_t>>) {
+            auto* arr = proto_value.mutable_uint32_array();
+            for (uint32_t val : v) arr->add_values(val);
+        } else if constexpr (std::is_same_v<T, std::vector<int64_t>>) {
+            auto* arr = proto_value.mutable_int64_array();
+            for (int64_t val : v) arr->add_values(val);
+        } else if constexpr (std::is_same_v<T, std::vector<uint64_t>>) {
+            auto* arr = proto_value.mutable_uint64_array();
+            for (uint64_t val : v) arr->add_values(val);
+        } else if constexpr (std::is_same_v<T, std::vector<float>>) {
+            auto* arr = proto_value.mutable_float_array();
+            for (float val : v) arr->add_values(val);
+        } else if constexpr (std::is_same_v<T, std::vector<double>>) {
+            auto* arr = proto_value.mutable_double_array();
+            for (double val : v) arr->add_values(val);
+        } else if constexpr (std::is_same_v<T, std::vector<std::string>>) {
+            auto* arr = proto_value.mutable_string_array();
+            for (const auto& val : v) arr->add_values(val);
+        }
+    }, value);
+
+    return proto_value;
+}
+
+// Convert protobuf Value to vss::types::Value
+inline vss::types::Value from_proto_value(const kuksa::val::v2::Value& proto_value) {
+    if (proto_value.has_bool_()) return proto_value.bool_();
+    if (proto_value.has_int32()) return proto_value.int32();
+    if (proto_value.has_uint32()) return proto_value.uint32();
+    if (proto_value.has_int64()) return proto_value.int64();
+    if (proto_value.has_uint64()) return proto_value.uint64();
+    if (proto_value.has_float_()) return proto_value.float_();
+    if (proto_value.has_double_()) return proto_value.double_();
+    if (proto_value.has_string()) return proto_value.string();
+
+    // Array types
+    if (proto_value.has_bool_array()) {
+        std::vector<bool> values;
+        for (bool v : proto_value.bool_array().values()) values.push_back(v);
+        return values;
+    }
+    if (proto_value.has_int32_array()) {
+        std::vector<int32_t> values;
+        for (int32_t v : proto_value.int32_array().values()) values.push_back(v);
+        return values;
+    }
+    if (proto_value.has_uint32_array()) {
+        std::vector<uint32_t> values;
+        for (uint32_t v : proto_value.uint32_array().values()) values.push_back(v);
+        return values;
+    }
+    if (proto_value.has_int64_array()) {
+        std::vector<int64_t> values;
+        for (int64_t v : proto_value.int64_array().values()) values.push_back(v);
+        return values;
+    }
+    if (proto_value.has_uint64_array()) {
+        std::vector<uint64_t> values;
+        for (uint64_t v : proto_value.uint64_array().values()) values.push_back(v);
+        return values;
+    }
+    if (proto_value.has_float_array()) {
+        std::vector<float> values;
+        for (float v : proto_value.float_array().values()) values.push_back(v);
+        return values;
+    }
+    if (proto_value.has_double_array()) {
+        std::vector<double> values;
+        for (double v : proto_value.double_array().values()) values.push_back(v);
+        return values;
+    }
+    if (proto_value.has_string_array()) {
+        std::vector<std::string> values;
+        for (const auto& v : proto_value.string_array().values()) values.push_back(v);
+        return values;
+    }
+
+    return vss::types::Value{std::monostate{}};  // Default to empty
+}
+
+// Convert protobuf datapoint to DynamicQualifiedValue (with quality inference)
+inline vss::types::DynamicQualifiedValue datapoint_to_qualified_value(const kuksa::val::v2::Datapoint& dp) {
+    vss::types::DynamicQualifiedValue qvalue;
+
+    // Set timestamp
+    if (dp.has_timestamp()) {
+        auto seconds = dp.timestamp().seconds();
+        auto nanos = dp.timestamp().nanos();
+        qvalue.timestamp = std::chrono::system_clock::time_point(
+            std::chrono::seconds(seconds) + std::chrono::nanoseconds(nanos)
+        );
+    } else {
+        qvalue.timestamp = std::chrono::system_clock::now();
+    }
+
+    // Infer quality from presence of value
+    if (dp.has_value()) {
+        qvalue.value = from_proto_value(dp.value());
+        qvalue.quality = vss::types::SignalQuality::VALID;
+    } else {
+        qvalue.value = vss::types::Value{std::monostate{}};
+        qvalue.quality = vss::types::SignalQuality::NOT_AVAILABLE;
+    }
+
+    return qvalue;
+}
+
+// Convert QualifiedValue to protobuf Datapoint (with quality handling)
+inline kuksa::val::v2::Datapoint qualified_value_to_datapoint(const vss::types::DynamicQualifiedValue& qvalue) {
+    kuksa::val::v2::Datapoint dp;
+
+    // Set timestamp
+    auto time_since_epoch = qvalue.timestamp.time_since_epoch();
+    auto seconds = std::chrono::duration_cast<std::chrono::seconds>(time_since_epoch);
+    auto nanos = std::chrono::duration_cast<std::chrono::nanoseconds>(time_since_epoch - seconds);
+    dp.mutable_timestamp()->set_seconds(seconds.count());
+    dp.mutable_timestamp()->set_nanos(nanos.count());
+
+    // Only set value if quality is VALID and value is not empty
+    if (qvalue.quality == vss::types::SignalQuality::VALID && !vss::types::is_empty(qvalue.value)) {
+        *dp.mutable_value() = to_proto_value(qvalue.value);
+    }
+    // Otherwise leave value unset (empty datapoint)
+
+    return dp;
+}
+
+} // namespace kuksa
@@ -0,0 +1,268 @@
+/**
+ * @file runtime.cpp
+ * @brief Shared channel pool and completion queue threads
+ */
+
+#include "runtime_impl.hpp"
+#include "shared_memory_bus.hpp"
+#include "subscription_hub.hpp"
+#include <glog/logging.h>
+#include <algorithm>
+
+namespace kuksa {
+
+Runtime::Impl::Impl(const RuntimeOptions& options)
+    : loopback_(options.loopback)
+    , keepalive_interval_(options.keepalive_interval)
+    , keepalive_timeout_(options.keepalive_timeout) {
+    auto threads = std::max<size_t>(options.threads, 1);
+    threads_.reserve(threads);
+    for (size_t i = 0; i < threads; ++i) {
+        threads_.emplace_back([this]() { poll(); });
+    }
+    LOG(INFO) << "[Runtime] started with " << threads << " thread(s)"
+              << (loopback_ ? ", loopback" : "");
+}
+
+Runtime::Impl::~Impl() {
+    // Stops the watcher
+    shared_memory_.reset();
+
+    // Clients hold the runtime alive, so no operation is outstanding here
+    queue_.Shutdown();
+    for (auto& thread : threads_) {
+        thread.join();
+    }
+}
+
+void Runtime::Impl::share(std::unique_ptr<SharedMemoryBus> bus) {
+    shared_memory_ = std::move(bus);
+    shared_memory_->watch([this]() {
+        std::vector<std::shared_ptr<SubscriptionHub>> hubs;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            for (const auto& [key, pooled] : connections_) {
+                hubs.push_back(pooled.connection.subscriptions);
+            }
+        }
+        for (const auto& hub : hubs) {
+            hub->receive_shared(*shared_memory_);
+        }
+    });
+}
+
+void Runtime::Impl::poll() {
+    void* tag = nullptr;
+    bool ok = false;
+    while (queue_.Next(&tag, &ok)) {
+        std::unique_ptr<Completion> completion(static_cast<Completion*>(tag));
+        (*completion)(ok);
+        operations_.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+Runtime::Impl::Connection Runtime::Impl::attach(const std::string& address, Priority lane) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto& pooled = connections_[{address, lane}];
+    if (!pooled.connection.channel) {
+        grpc::ChannelArguments args;
+        if (keepalive_interval_.count() > 0) {
+            // A streaming connection carries no data while nothing changes; ping it anyway
+            args.SetInt(GRPC_ARG_KEEPALIVE_TIME_MS, static_cast<int>(keepalive_interval_.count()));
+            args.SetInt(GRPC_ARG_KEEPALIVE_TIMEOUT_MS, static_cast<int>(keepalive_timeout_.count()));
+            args.SetInt(GRPC_ARG_KEEPALIVE_PERMIT_WITHOUT_CALLS, 1);
+            args.SetInt(GRPC_ARG_HTTP2_MAX_PINGS_WITHOUT_DATA, 0);
+        }
+        if (lane != Priority::NORMAL) {
+            // Own connection: bulk frames must not share an HTTP/2 connection with critical ones
+            args.SetInt(GRPC_ARG_USE_LOCAL_SUBCHANNEL_POOL, 1);
+            args.SetInt("kuksa.priority_lane", static_cast<int>(lane));
+        }
+        pooled.connection.channel = grpc::CreateCustomChannel(
+            address, grpc::InsecureChannelCredentials(), args);
+        pooled.connection.stub = kuksa::val::v2::VAL::NewStub(pooled.connection.channel);
+        pooled.connection.subscriptions = std::make_shared<SubscriptionHub>(
+            *this, pooled.connection.channel, pooled.connection.stub, lane);
+        if (lane != Priority::NORMAL) {
+            prioritized_ = true;
+        }
+        LOG(INFO) << "[Runtime] created channel for " << address << " (lane " << static_cast<int>(lane) << ")";
+    }
+    ++pooled.clients;
+    return pooled.connection;
+}
+
+void Runtime::Impl::detach(const std::string& address, Priority lane) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = connections_.find({address, lane});
+    if (it != connections_.end() && --it->second.clients == 0) {
+        connections_.erase(it);
+        LOG(INFO) << "[Runtime] released channel for " << address << " (lane " << static_cast<int>(lane) << ")";
+    }
+}
+
+void Runtime::Impl::schedule(Priority priority, std::vector<std::function<void()>> tasks) {
+    {
+        std::lock_guard<std::mutex> lock(scheduled_mutex_);
+        auto& scheduled = scheduled_[static_cast<size_t>(priority)];
+        for (auto& task : tasks) {
+            scheduled.push_back(std::move(task));
+        }
+        if (!drainer_needed_locked()) {
+            return;
+        }
+        ++drainers_;
+    }
+    drain();
+}
+
+bool Runtime::Impl::drainer_needed_locked() const {
+    // One drainer per priority that has tasks and is not running one
+    size_t runnable = 0;
+    size_t running = 0;
+    for (size_t priority = 0; priority < PRIORITY_COUNT; ++priority) {
+        running += running_[priority] ? 1 : 0;
+        runnable += !running_[priority] && !scheduled_[priority].empty() ? 1 : 0;
+    }
+    return drainers_ - running < runnable;
+}
+
+void Runtime::Impl::drain() {
+    while (true) {
+        std::function<void()> task;
+        size_t priority = 0;
+        {
+            std::lock_guard<std::mutex> lock(scheduled_mutex_);
+            while (priority < PRIORITY_COUNT && (running_[priority] || scheduled_[priority].empty())) {
+                ++priority;
+            }
+            if (priority == PRIORITY_COUNT) {
+                --drainers_;
+                return;
+            }
+            running_[priority] = true;
+            task = std::move(scheduled_[priority].front());
+            scheduled_[priority].pop_front();
+        }
+
+        task();
+
+        std::lock_guard<std::mutex> lock(scheduled_mutex_);
+        running_[priority] = false;
+        if (priority != static_cast<size_t>(Priority::HIGH)) {
+            // Updates that arrived meanwhile may be more urgent than the rest
+            --drainers_;
+            if (drainer_needed_locked()) {
+                // A lone thread only polls the sockets when it has to wait
+                ++drainers_;
+                auto delay = threads_.size() > 1 ? std::chrono::microseconds(0) : std::chrono::microseconds(50);
+                post([this](bool) { drain(); }, delay);
+            }
+            return;
+        }
+    }
+}
+
+void Runtime::Impl::record_dispatch(Priority priority, std::chrono::steady_clock::duration latency) {
+    auto& histogram = latency_[static_cast<size_t>(priority)];
+    auto ns = static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(latency).count());
+    size_t bucket = 0;
+    for (uint64_t us = ns / 1000; us != 0 && bucket < histogram.buckets.size() - 1; us >>= 1) {
+        ++bucket;
+    }
+    histogram.buckets[bucket].fetch_add(1, std::memory_order_relaxed);
+
+    uint64_t max = histogram.max_ns.load(std::memory_order_relaxed);
+    while (ns > max && !histogram.max_ns.compare_exchange_weak(max, ns, std::memory_order_relaxed)) {
+    }
+}
+
+std::vector<std::shared_ptr<SubscriptionHub>> Runtime::Impl::hubs(const std::string& address) const {
+    std::vector<std::shared_ptr<SubscriptionHub>> hubs;
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (auto it = connections_.lower_bound({address, Priority::HIGH});
+         it != connections_.end() && it->first.first == address; ++it) {
+        hubs.push_back(it->second.connection.subscriptions);
+    }
+    return hubs;
+}
+
+RuntimeStats Runtime::Impl::stats() const {
+    RuntimeStats stats;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stats.channels = connections_.size();
+        for (const auto& [key, pooled] : connections_) {
+            stats.clients += pooled.clients;
+            pooled.connection.subscriptions->add_stats(stats);
+        }
+    }
+    for (size_t priority = 0; priority < PRIORITY_COUNT; ++priority) {
+        const auto& histogram = latency_[priority];
+        auto& latency = stats.dispatch[priority];
+        std::array<uint64_t, 32> counts;
+        for (size_t bucket = 0; bucket < counts.size(); ++bucket) {
+            counts[bucket] = histogram.buckets[bucket].load(std::memory_order_relaxed);
+            latency.callbacks += counts[bucket];
+        }
+        auto percentile = [&](double q) {
+            uint64_t rank = static_cast<uint64_t>(q * static_cast<double>(latency.callbacks - 1));
+            for (size_t bucket = 0; bucket < counts.size(); ++bucket) {
+                if (rank < counts[bucket]) {
+                    return static_cast<double>(uint64_t{1} << bucket);
+                }
+                rank -= counts[bucket];
+            }
+            return 0.0;
+        };
+        if (latency.callbacks > 0) {
+            latency.p50_us = percentile(0.50);
+            latency.p99_us = percentile(0.99);
+            latency.max_us = static_cast<double>(histogram.max_ns.load(std::memory_order_relaxed)) / 1000.0;
+        }
+    }
+    stats.threads = threads_.size();
+    stats.streams = streams_.load();
+    stats.operations = operations_.load(std::memory_order_relaxed);
+    if (shared_memory_) {
+        stats.shared_written = shared_memory_->written();
+        stats.shared_dropped = shared_memory_->dropped();
+    }
+    return stats;
+}
+
+// ============================================================================
+// Runtime
+// ============================================================================
+
+std::shared_ptr<Runtime> Runtime::create(size_t threads) {
+    RuntimeOptions options;
+    options.threads = threads;
+    return std::shared_ptr<Runtime>(new Runtime(options));
+}
+
+Result<std::shared_ptr<Runtime>> Runtime::create(const RuntimeOptions& options) {
+    std::unique_ptr<SharedMemoryBus> bus;
+    if (!options.shared_memory.empty()) {
+        auto opened = SharedMemoryBus::open(options.shared_memory);
+        if (!opened.ok()) {
+            return opened.status();
+        }
+        bus = std::move(*opened);
+    }
+    auto runtime = std::shared_ptr<Runtime>(new Runtime(options));
+    if (bus) {
+        runtime->impl_->share(std::move(bus));
+    }
+    return runtime;
+}
+
+Runtime::Runtime(const RuntimeOptions& options) : impl_(std::make_unique<Impl>(options)) {}
+
+Runtime::~Runtime() = default;
+
+RuntimeStats Runtime::stats() const {
+    return impl_->stats();
+}
+
+} // namespace kuksa
@@ -0,0 +1,184 @@
+/**
+ * @file runtime_impl.hpp
+ * @brief Runtime internals used by the client implementation
+ */
+
+#pragma once
+
+#include <kuksa_cpp/runtime.hpp>
+#include <kuksa_cpp/types.hpp>
+#include <grpcpp/grpcpp.h>
+#include <grpcpp/alarm.h>
+#include <array>
+#include <chrono>
+#include <atomic>
+#include <deque>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "kuksa/val/v2/val.grpc.pb.h"
+
+namespace kuksa {
+
+class SharedMemoryBus;
+class SubscriptionHub;
+
+class Runtime::Impl {
+public:
+    /// Called with the operation's ok flag on a runtime thread
+    using Completion = std::function<void(bool)>;
+
+    /// A pooled channel, the stub bound to it and the subscriptions multiplexed over it
+    struct Connection {
+        std::shared_ptr<grpc::Channel> channel;
+        std::shared_ptr<kuksa::val::v2::VAL::Stub> stub;
+        std::shared_ptr<SubscriptionHub> subscriptions;
+    };
+
+    /// State of one asynchronous unary RPC
+    template<typename Request, typename Response>
+    struct UnaryCall {
+        grpc::ClientContext context;
+        Request request;
+        Response response;
+        grpc::Status status;
+        std::unique_ptr<grpc::ClientAsyncResponseReader<Response>> reader;
+    };
+
+    explicit Impl(const RuntimeOptions& options);
+    ~Impl();
+
+    /**
+     * @brief Attach a client to address, creating the channel on first use
+     *
+     * Each priority lane of an address has its own channel and hub. Lanes
+     * other than NORMAL use a private subchannel pool, so they get their own
+     * connection instead of sharing one with the other lanes. Every channel
+     * sends keepalive pings as configured in RuntimeOptions.
+     */
+    Connection attach(const std::string& address, Priority lane = Priority::NORMAL);
+
+    /**
+     * @brief Detach a client; the channel is closed with its last client
+     */
+    void detach(const std::string& address, Priority lane = Priority::NORMAL);
+
+    /**
+     * @brief Subscription hubs of every lane of address
+     */
+    std::vector<std::shared_ptr<SubscriptionHub>> hubs(const std::string& address) const;
+
+    grpc::CompletionQueue* queue() { return &queue_; }
+
+    /**
+     * @brief Wrap completion into a completion queue tag
+     *
+     * The tag must be handed to exactly one asynchronous operation; it is
+     * invoked and freed by a runtime thread when the operation completes.
+     */
+    static void* tag(Completion completion) {
+        return new Completion(std::move(completion));
+    }
+
+    /**
+     * @brief Run completion on a runtime thread as soon as possible, or after delay
+     *
+     * An immediate post is queued behind the completions already in the
+     * queue, and the thread that takes it does not poll the sockets first,
+     * so reads that have arrived but were not polled yet complete later. A
+     * delay makes the thread poll while it waits.
+     */
+    void post(Completion completion, std::chrono::microseconds delay = std::chrono::microseconds(0)) {
+        auto alarm = std::make_shared<grpc::Alarm>();
+        alarm->Set(&queue_, std::chrono::system_clock::now() + delay,
+                   tag([alarm, completion = std::move(completion)](bool ok) { completion(ok); }));
+    }
+
+    /**
+     * @brief Start call.request on stub; tag completes when the response arrives
+     */
+    template<typename Request, typename Response, typename Prepare>
+    void start_unary(kuksa::val::v2::VAL::Stub& stub, Prepare prepare, UnaryCall<Request, Response>& call, void* tag) {
+        // Set a deadline to prevent hanging forever on slow/stuck RPCs
+        call.context.set_deadline(std::chrono::system_clock::now() + std::chrono::seconds(5));
+        call.reader = (stub.*prepare)(&call.context, call.request, &queue_);
+        call.reader->StartCall();
+        call.reader->Finish(&call.response, &call.status, tag);
+    }
+
+    /**
+     * @brief Run tasks on a runtime thread, after every pending task of higher priority
+     *
+     * Tasks of one priority run in order, one at a time; tasks of different
+     * priorities run concurrently when the runtime has the threads. After a
+     * task below HIGH the thread returns to the queue, so an update that
+     * arrived meanwhile is scheduled before the next task runs. With several
+     * threads the rest is posted at once, as the other threads keep polling
+     * the sockets; a single thread posts it with a short delay so that it
+     * polls them itself.
+     */
+    void schedule(Priority priority, std::vector<std::function<void()>> tasks);
+
+    /// Whether callbacks go through schedule(): set once a lane other than NORMAL is used
+    bool prioritized() const { return prioritized_.load(std::memory_order_relaxed); }
+
+    void record_dispatch(Priority priority, std::chrono::steady_clock::duration latency);
+
+    bool loopback() const { return loopback_; }
+
+    /// Segment shared with runtimes in other processes, or null
+    SharedMemoryBus* shared_memory() const { return shared_memory_.get(); }
+
+    /**
+     * @brief Use bus and deliver its updates to the subscriptions of every connection
+     */
+    void share(std::unique_ptr<SharedMemoryBus> bus);
+
+    void stream_opened() { ++streams_; }
+    void stream_closed() { --streams_; }
+
+    RuntimeStats stats() const;
+
+private:
+    void poll();
+    void drain();
+    bool drainer_needed_locked() const;
+
+    // Power-of-two microsecond buckets
+    struct LatencyHistogram {
+        std::array<std::atomic<uint64_t>, 32> buckets{};
+        std::atomic<uint64_t> max_ns{0};
+    };
+
+    const bool loopback_;
+    const std::chrono::milliseconds keepalive_interval_;
+    const std::chrono::milliseconds keepalive_timeout_;
+    grpc::CompletionQueue queue_;
+    std::vector<std::thread> threads_;
+
+    mutable std::mutex mutex_;
+    struct Pooled {
+        Connection connection;
+        size_t clients = 0;
+    };
+    std::map<std::pair<std::string, Priority>, Pooled> connections_;  // guarded by mutex_
+
+    std::atomic<bool> prioritized_{false};
+    std::mutex scheduled_mutex_;
+    std::array<std::deque<std::function<void()>>, PRIORITY_COUNT> scheduled_;  // guarded by scheduled_mutex_
+    std::array<bool, PRIORITY_COUNT> running_{};  // a task of the priority runs; guarded by scheduled_mutex_
+    size_t drainers_ = 0;  // drain() calls running or posted; guarded by scheduled_mutex_
+    std::array<LatencyHistogram, PRIORITY_COUNT> latency_;
+
+    std::atomic<size_t> streams_{0};
+    std::atomic<uint64_t> operations_{0};
+
+    std::unique_ptr<SharedMemoryBus> shared_memory_;
+};
+
+} // namespace kuksa
@@ -0,0 +1,412 @@
+/**
+ * @file shared_memory_bus.cpp
+ * @brief Seqlock slot table in POSIX shared memory with futex wakeups
+ */
+
+#include "shared_memory_bus.hpp"
+#include <glog/logging.h>
+#include <cerrno>
+#include <climits>
+#include <cstring>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <fcntl.h>
+#include <linux/futex.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+namespace kuksa {
+
+namespace {
+
+constexpr uint32_t kSegmentMagic = 0x4d485356;  // "VSHM"
+constexpr uint32_t kSegmentVersion = 1;
+
+std::string errno_message(const std::string& what, const std::string& name) {
+    return what + " " + name + ": " + std::strerror(errno);
+}
+
+void futex_wait(std::atomic<uint32_t>* word, uint32_t expected, std::chrono::milliseconds timeout) {
+    timespec ts{};
+    ts.tv_sec = timeout.count() / 1000;
+    ts.tv_nsec = (timeout.count() % 1000) * 1000000;
+    syscall(SYS_futex, reinterpret_cast<uint32_t*>(word), FUTEX_WAIT, expected, &ts, nullptr, 0);
+}
+
+void futex_wake_all(std::atomic<uint32_t>* word) {
+    syscall(SYS_futex, reinterpret_cast<uint32_t*>(word), FUTEX_WAKE, INT_MAX, nullptr, nullptr, 0);
+}
+
+// ============================================================================
+// Native value encoding
+// ============================================================================
+
+// Arrays of numbers (not bools, strings or structs) are stored as their elements' bytes
+template<typename T>
+struct is_number_array : std::false_type {};
+template<typename T>
+struct is_number_array<std::vector<T>>
+    : std::bool_constant<std::is_arithmetic_v<T> && !std::is_same_v<T, bool>> {};
+
+template<typename T>
+bool encode_value(const T& value, unsigned char* out, size_t capacity, size_t& size) {
+    if constexpr (std::is_same_v<T, std::monostate>) {
+        size = 0;
+        return true;
+    } else if constexpr (std::is_arithmetic_v<T>) {
+        size = sizeof(T);
+        std::memcpy(out, &value, sizeof(T));
+        return true;
+    } else if constexpr (std::is_same_v<T, std::string>) {
+        size = value.size();
+        if (size > capacity) {
+            return false;
+        }
+        std::memcpy(out, value.data(), size);
+        return true;
+    } else if constexpr (std::is_same_v<T, std::vector<bool>>) {
+        size = value.size();
+        if (size > capacity) {
+            return false;
+        }
+        for (size_t i = 0; i < size; ++i) {
+            out[i] = value[i] ? 1 : 0;
+        }
+        return true;
+    } else if constexpr (is_number_array<T>::value) {
+        size = value.size() * sizeof(typename T::value_type);
+        if (size > capacity) {
+            return false;
+        }
+        std::memcpy(out, value.data(), size);
+        return true;
+    } else {
+        return false;  // string arrays and structs
+    }
+}
+
+template<typename T>
+bool decode_value(const unsigned char* in, size_t size, vss::types::Value& value) {
+    if constexpr (std::is_same_v<T, std::monostate>) {
+        value = std::monostate{};
+        return size == 0;
+    } else if constexpr (std::is_arithmetic_v<T>) {
+        if (size != sizeof(T)) {
+            return false;
+        }
+        T scalar;
+        std::memcpy(&scalar, in, sizeof(T));
+        value = scalar;
+        return true;
+    } else if constexpr (std::is_same_v<T, std::string>) {
+        value = std::string(reinterpret_cast<const char*>(in), size);
+        return true;
+    } else if constexpr (std::is_same_v<T, std::vector<bool>>) {
+        std::vector<bool> bools(size);
+        for (size_t i = 0; i < size; ++i) {
+            bools[i] = in[i] != 0;
+        }
+        value = std::move(bools);
+        return true;
+    } else if constexpr (is_number_array<T>::value) {
+        using Element = typename T::value_type;
+        if (size % sizeof(Element) != 0) {
+            return false;
+        }
+        T elements(size / sizeof(Element));
+        std::memcpy(elements.data(), in, size);
+        value = std::move(elements);
+        return true;
+    } else {
+        return false;
+    }
+}
+
+template<size_t... I>
+bool decode_alternative(size_t index, const unsigned char* in, size_t size, vss::types::Value& value,
+                        std::index_sequence<I...>) {
+    bool ok = false;
+    ((index == I && (ok = decode_value<std::variant_alternative_t<I, vss::types::Value>>(in, size, value), true)) || ...);
+    return ok;
+}
+
+} // namespace
+
+// ============================================================================
+// Segment layout
+// ============================================================================
+
+struct SharedMemoryBus::Header {
+    std::atomic<uint32_t> magic;  // set last by the creator
+    uint32_t version;
+    uint32_t slot_count;
+    uint32_t slot_size;
+    std::atomic<uint32_t> generation;  // futex word, bumped by every write
+    std::atomic<uint32_t> waiters;     // watchers blocked on generation
+    unsigned char reserved[40];
+};
+
+struct SharedMemoryBus::Slot {
+    std::atomic<int32_t> key;          // signal id + 1; 0 while free
+    std::atomic<uint32_t> sequence;    // odd while being written
+    uint64_t writer;
+    int64_t timestamp;                 // ns since epoch
+    uint8_t type;                      // index into vss::types::Value
+    uint8_t quality;
+    uint16_t size;
+    uint32_t reserved;
+    unsigned char payload[SLOT_SIZE - 32];
+};
+
+static_assert(sizeof(std::atomic<uint32_t>) == sizeof(uint32_t), "futex word must be a plain 32-bit integer");
+
+Result<std::unique_ptr<SharedMemoryBus>> SharedMemoryBus::open(const std::string& name) {
+    static_assert(sizeof(Header) == 64);
+    static_assert(sizeof(Slot) == SLOT_SIZE);
+    const size_t size = sizeof(Header) + SLOT_COUNT * sizeof(Slot);
+
+    bool created = true;
+    int fd = ::shm_open(name.c_str(), O_RDWR | O_CREAT | O_EXCL | O_CLOEXEC, 0600);
+    if (fd < 0 && errno == EEXIST) {
+        created = false;
+        fd = ::shm_open(name.c_str(), O_RDWR | O_CLOEXEC, 0600);
+    }
+    if (fd < 0) {
+        return absl::UnavailableError(errno_message("Cannot open shared memory", name));
+    }
+
+    if (created && ::ftruncate(fd, static_cast<off_t>(size)) != 0) {
+        auto message = errno_message("Cannot size shared memory", name);
+        ::close(fd);
+        return absl::UnavailableError(message);
+    }
+
+    // Another runtime may still be creating the segment
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(1);
+    struct stat info {};
+    while (::fstat(fd, &info) == 0 && static_cast<size_t>(info.st_size) < size &&
+           std::chrono::steady_clock::now() < deadline) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    if (static_cast<size_t>(info.st_size) != size) {
+        ::close(fd);
+        return absl::FailedPreconditionError("Shared memory " + name + " has an incompatible size");
+    }
+
+    void* mapping = ::mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (mapping == MAP_FAILED) {
+        auto message = errno_message("Cannot map shared memory", name);
+        ::close(fd);
+        return absl::UnavailableError(message);
+    }
+
+    auto* header = static_cast<Header*>(mapping);
+    if (created) {
+        header->version = kSegmentVersion;
+        header->slot_count = SLOT_COUNT;
+        header->slot_size = SLOT_SIZE;
+        header->magic.store(kSegmentMagic, std::memory_order_release);
+    } else {
+        while (header->magic.load(std::memory_order_acquire) != kSegmentMagic &&
+               std::chrono::steady_clock::now() < deadline) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        if (header->magic.load(std::memory_order_acquire) != kSegmentMagic ||
+            header->version != kSegmentVersion || header->slot_count != SLOT_COUNT ||
+            header->slot_size != SLOT_SIZE) {
+            ::munmap(mapping, size);
+            ::close(fd);
+            return absl::FailedPreconditionError("Shared memory " + name + " has an incompatible layout");
+        }
+    }
+
+    LOG(INFO) << "[SharedMemoryBus] " << (created ? "created " : "opened ") << name;
+    return std::unique_ptr<SharedMemoryBus>(new SharedMemoryBus(name, fd, mapping, size));
+}
+
+SharedMemoryBus::SharedMemoryBus(std::string name, int fd, void* mapping, size_t size)
+    : name_(std::move(name))
+    , fd_(fd)
+    , mapping_(mapping)
+    , size_(size)
+    , header_(static_cast<Header*>(mapping))
+    , slots_(reinterpret_cast<Slot*>(static_cast<char*>(mapping) + sizeof(Header))) {
+    static std::atomic<uint32_t> instances{0};
+    writer_ = (static_cast<uint64_t>(::getpid()) << 32) | instances.fetch_add(1);
+}
+
+SharedMemoryBus::~SharedMemoryBus() {
+    stopping_ = true;
+    if (watcher_.joinable()) {
+        futex_wake_all(&header_->generation);
+        watcher_.join();
+    }
+    // The segment stays for the other runtimes; shm_unlink() removes it
+    ::munmap(mapping_, size_);
+    ::close(fd_);
+}
+
+SharedMemoryBus::Slot* SharedMemoryBus::find(int32_t signal_id) const {
+    const int32_t key = signal_id + 1;
+    const uint32_t start = static_cast<uint32_t>(signal_id) * 2654435761u % SLOT_COUNT;
+    for (uint32_t i = 0; i < SLOT_COUNT; ++i) {
+        auto& slot = slots_[(start + i) % SLOT_COUNT];
+        auto current = slot.key.load(std::memory_order_acquire);
+        if (current == key) {
+            return &slot;
+        }
+        if (current == 0) {
+            return nullptr;
+        }
+    }
+    return nullptr;
+}
+
+SharedMemoryBus::Slot* SharedMemoryBus::claim(int32_t signal_id) {
+    const int32_t key = signal_id + 1;
+    const uint32_t start = static_cast<uint32_t>(signal_id) * 2654435761u % SLOT_COUNT;
+    for (uint32_t i = 0; i < SLOT_COUNT; ++i) {
+        auto& slot = slots_[(start + i) % SLOT_COUNT];
+        int32_t current = 0;
+        if (slot.key.compare_exchange_strong(current, key, std::memory_order_acq_rel) || current == key) {
+            return &slot;
+        }
+    }
+    return nullptr;
+}
+
+bool SharedMemoryBus::write(int32_t signal_id, const vss::types::DynamicQualifiedValue& value) {
+    if (signal_id < 0) {
+        return false;
+    }
+    unsigned char payload[sizeof(Slot::payload)];
+    size_t size = 0;
+    bool encoded = std::visit([&](const auto& alternative) {
+        return encode_value(alternative, payload, sizeof(payload), size);
+    }, value.value);
+    if (!encoded) {
+        return false;
+    }
+
+    Slot* slot = claim(signal_id);
+    if (!slot) {
+        LOG(WARNING) << "[SharedMemoryBus] " << name_ << " is full";
+        return false;
+    }
+
+    // Take the slot: even -> odd. Another writer of the signal is waited for,
+    // briefly; a slot that stays odd (its writer died mid-write) is never taken
+    // over, since that writer may only be descheduled. The value is dropped and
+    // the signal then only travels through the databroker.
+    const int SPIN_ATTEMPTS = 64;
+    const int MAX_ATTEMPTS = 4096;  // yielding after the spins: milliseconds
+    uint32_t sequence = slot->sequence.load(std::memory_order_relaxed);
+    for (int attempt = 0;; ++attempt) {
+        if ((sequence & 1) == 0 &&
+            slot->sequence.compare_exchange_weak(sequence, sequence + 1, std::memory_order_acquire)) {
+            break;
+        }
+        if (attempt == MAX_ATTEMPTS) {
+            if (dropped_.fetch_add(1, std::memory_order_relaxed) == 0) {
+                LOG(WARNING) << "[SharedMemoryBus] " << name_ << ": slot of signal " << signal_id
+                             << " stays locked; dropping its writes";
+            }
+            return false;
+        }
+        if (attempt >= SPIN_ATTEMPTS) {
+            std::this_thread::yield();
+        }
+        sequence = slot->sequence.load(std::memory_order_relaxed);
+    }
+    std::atomic_thread_fence(std::memory_order_release);
+
+    slot->writer = writer_;
+    slot->timestamp = std::chrono::duration_cast<std::chrono::nanoseconds>(
+        value.timestamp.time_since_epoch()).count();
+    slot->type = static_cast<uint8_t>(value.value.index());
+    slot->quality = static_cast<uint8_t>(value.quality);
+    slot->size = static_cast<uint16_t>(size);
+    std::memcpy(slot->payload, payload, size);
+
+    slot->sequence.store(sequence + 2, std::memory_order_release);
+    written_.fetch_add(1, std::memory_order_relaxed);
+
+    header_->generation.fetch_add(1, std::memory_order_release);
+    if (header_->waiters.load(std::memory_order_acquire) > 0) {
+        futex_wake_all(&header_->generation);
+    }
+    return true;
+}
+
+bool SharedMemoryBus::read(int32_t signal_id, uint32_t& sequence, vss::types::DynamicQualifiedValue& value) const {
+    Slot* slot = find(signal_id);
+    if (!slot) {
+        return false;
+    }
+
+    for (int attempt = 0; attempt < 64; ++attempt) {
+        uint32_t before = slot->sequence.load(std::memory_order_acquire);
+        if (before & 1) {
+            std::this_thread::yield();
+            continue;
+        }
+        if (before == sequence) {
+            return false;
+        }
+
+        uint64_t writer = slot->writer;
+        int64_t timestamp = slot->timestamp;
+        uint8_t type = slot->type;
+        uint8_t quality = slot->quality;
+        size_t size = std::min<size_t>(slot->size, sizeof(slot->payload));
+        unsigned char payload[sizeof(Slot::payload)];
+        std::memcpy(payload, slot->payload, size);
+
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (slot->sequence.load(std::memory_order_relaxed) != before) {
+            continue;  // torn read
+        }
+
+        sequence = before;
+        if (writer == writer_) {
+            return false;  // this runtime's own write
+        }
+        vss::types::Value decoded;
+        if (!decode_alternative(type, payload, size, decoded,
+                                std::make_index_sequence<std::variant_size_v<vss::types::Value>>{})) {
+            return false;
+        }
+        value.value = std::move(decoded);
+        value.quality = static_cast<vss::types::SignalQuality>(quality);
+        value.timestamp = std::chrono::system_clock::time_point(
+            std::chrono::duration_cast<std::chrono::system_clock::duration>(std::chrono::nanoseconds(timestamp)));
+        return true;
+    }
+    return false;
+}
+
+uint32_t SharedMemoryBus::sequence(int32_t signal_id) const {
+    Slot* slot = find(signal_id);
+    return slot ? slot->sequence.load(std::memory_order_acquire) & ~1u : 0;
+}
+
+void SharedMemoryBus::watch(std::function<void()> on_change) {
+    watcher_ = std::thread([this, on_change = std::move(on_change)]() {
+        while (!stopping_) {
+            // Writes after this load make the wait below return at once
+            uint32_t seen = header_->generation.load(std::memory_order_acquire);
+            on_change();
+
+            header_->waiters.fetch_add(1, std::memory_order_acq_rel);
+            if (!stopping_) {
+                futex_wait(&header_->generation, seen, std::chrono::milliseconds(100));
+            }
+            header_->waiters.fetch_sub(1, std::memory_order_acq_rel);
+        }
+    });
+}
+
+} // namespace kuksa
@@ -0,0 +1,109 @@
+/**
+ * @file shared_memory_bus.hpp
+ * @brief Same-host fast path: latest value per signal in a shared memory segment
+ */
+
+#pragma once
+
+#include <kuksa_cpp/error.hpp>
+#include <vss/types/types.hpp>
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <thread>
+
+namespace kuksa {
+
+/**
+ * @brief POSIX shared memory table of the latest value of each signal
+ *
+ * Every runtime opened on the same segment name maps the same table: a fixed
+ * number of slots, each holding one signal's latest value behind a seqlock.
+ * Writers never block readers; a reader copies a slot and retries if its
+ * sequence changed meanwhile. Writes bump a futex word that wakes the
+ * watcher of every runtime, which then reads the slots of the signals it
+ * subscribes to.
+ *
+ * Values are stored in their native representation, without protobuf.
+ * Scalars, strings and arrays of numbers or bools that fit a slot are
+ * supported; other values (string arrays, structs, large arrays) are not
+ * written and only reach other processes through the databroker.
+ *
+ * Signal ids are databroker ids, so a segment must only be shared by
+ * runtimes talking to the same databroker.
+ */
+class SharedMemoryBus {
+public:
+    static constexpr uint32_t SLOT_COUNT = 1024;
+    static constexpr size_t SLOT_SIZE = 256;
+
+    /**
+     * @brief Open segment name (e.g. "/kuksa-vehicle"), creating it if needed
+     */
+    static Result<std::unique_ptr<SharedMemoryBus>> open(const std::string& name);
+
+    ~SharedMemoryBus();
+
+    SharedMemoryBus(const SharedMemoryBus&) = delete;
+    SharedMemoryBus& operator=(const SharedMemoryBus&) = delete;
+
+    /**
+     * @brief Store value as signal_id's latest and wake the watchers
+     *
+     * Waits briefly while another runtime writes the same signal. A slot
+     * left locked by a writer that died is never taken over; the value is
+     * dropped and counted in dropped().
+     *
+     * @return false if the value cannot be stored (see class comment), the
+     *         table is full or the value was dropped
+     */
+    bool write(int32_t signal_id, const vss::types::DynamicQualifiedValue& value);
+
+    /**
+     * @brief Read signal_id if another runtime wrote it since sequence
+     *
+     * @param sequence Last sequence seen; updated when a new value is returned
+     */
+    bool read(int32_t signal_id, uint32_t& sequence, vss::types::DynamicQualifiedValue& value) const;
+
+    /**
+     * @brief Current sequence of signal_id, to skip values written before a subscription
+     */
+    uint32_t sequence(int32_t signal_id) const;
+
+    /**
+     * @brief Call on_change on a watcher thread after writes by any runtime
+     */
+    void watch(std::function<void()> on_change);
+
+    uint64_t written() const { return written_.load(std::memory_order_relaxed); }
+
+    /// Writes dropped because their slot stayed locked
+    uint64_t dropped() const { return dropped_.load(std::memory_order_relaxed); }
+
+private:
+    struct Header;
+    struct Slot;
+
+    SharedMemoryBus(std::string name, int fd, void* mapping, size_t size);
+
+    Slot* find(int32_t signal_id) const;
+    Slot* claim(int32_t signal_id);
+
+    std::string name_;
+    int fd_ = -1;
+    void* mapping_ = nullptr;
+    size_t size_ = 0;
+    Header* header_ = nullptr;
+    Slot* slots_ = nullptr;
+    uint64_t writer_;  // identifies this runtime's writes
+
+    std::atomic<bool> stopping_{false};
+    std::thread watcher_;
+    std::atomic<uint64_t> written_{0};
+    std::atomic<uint64_t> dropped_{0};
+};
+
+} // namespace kuksa
@@ -0,0 +1,136 @@
+/**
+ * @file state_publisher.cpp
+ * @brief Batched state machine state publishing
+ */
+
+#include "kuksa_cpp/state_publisher.hpp"
+#include <glog/logging.h>
+#include <vector>
+
+namespace kuksa {
+
+void StatePublisher::Shared::record(int32_t signal_id, vss::types::Value value) {
+    std::lock_guard<std::mutex> lock(mutex);
+    auto [it, inserted] = pending.insert_or_assign(
+        signal_id, vss::types::DynamicQualifiedValue{std::move(value), vss::types::SignalQuality::VALID});
+    ++stats.changes;
+    if (!inserted) {
+        ++stats.coalesced;
+    }
+}
+
+StatePublisher::StatePublisher(Client& client, std::chrono::milliseconds interval)
+    : client_(client), interval_(interval), shared_(std::make_shared<Shared>()) {}
+
+StatePublisher::~StatePublisher() {
+    stop();
+    std::vector<std::weak_ptr<Attachment>> attachments;
+    {
+        std::lock_guard<std::mutex> lock(shared_->mutex);
+        attachments.swap(attachments_);
+    }
+    for (const auto& weak : attachments) {
+        if (auto attachment = weak.lock()) {
+            attachment->detach();
+        }
+    }
+    flush();
+}
+
+void StatePublisher::start() {
+    std::lock_guard<std::mutex> lock(thread_mutex_);
+    if (thread_.joinable()) {
+        return;
+    }
+    stopping_ = false;
+    thread_ = std::thread([this]() { run(); });
+}
+
+void StatePublisher::stop() {
+    {
+        std::lock_guard<std::mutex> lock(thread_mutex_);
+        if (!thread_.joinable()) {
+            return;
+        }
+        stopping_ = true;
+    }
+    wake_.notify_all();
+    thread_.join();
+    flush();
+}
+
+void StatePublisher::run() {
+    std::unique_lock<std::mutex> lock(thread_mutex_);
+    while (!stopping_) {
+        wake_.wait_for(lock, interval_, [this]() { return stopping_; });
+        if (stopping_) {
+            break;
+        }
+        lock.unlock();
+        flush();
+        lock.lock();
+    }
+}
+
+size_t StatePublisher::flush() {
+    std::map<int32_t, vss::types::DynamicQualifiedValue> batch;
+    std::vector<Client::PublishEntry> entries;
+    {
+        std::lock_guard<std::mutex> lock(shared_->mutex);
+        if (shared_->pending.empty()) {
+            return 0;
+        }
+        batch.swap(shared_->pending);
+        entries.reserve(batch.size());
+        for (const auto& [id, qvalue] : batch) {
+            entries.emplace_back(*handles_.at(id), qvalue);
+        }
+    }
+
+    // The callback runs before publish_batch() returns, on this thread
+    std::map<int32_t, Status> failed;
+    auto status = client_.publish_batch(entries, [&failed](const std::map<int32_t, Status>& errors) {
+        failed = errors;
+    });
+    for (const auto& [id, error] : failed) {
+        LOG(WARNING) << "[StatePublisher] signal " << id << " failed: " << error;
+    }
+
+    std::lock_guard<std::mutex> lock(shared_->mutex);
+    if (status.ok() && failed.empty()) {
+        ++shared_->stats.batches;
+        shared_->stats.published += entries.size();
+        return entries.size();
+    }
+
+    // Keep the values that were not accepted for the next flush, unless a
+    // newer change arrived. Signals the broker did accept are not sent again.
+    if (failed.empty()) {
+        // Nothing was sent, so the whole batch is retried
+        LOG(WARNING) << "[StatePublisher] publish_batch failed: " << status;
+        ++shared_->stats.errors;
+        for (auto& [id, qvalue] : batch) {
+            shared_->pending.emplace(id, std::move(qvalue));
+        }
+        return 0;
+    }
+    shared_->stats.errors += failed.size();
+    size_t sent = entries.size();
+    for (const auto& [id, error] : failed) {
+        auto it = batch.find(id);
+        if (it != batch.end()) {
+            shared_->pending.emplace(id, std::move(it->second));
+            --sent;
+        }
+    }
+    ++shared_->stats.batches;
+    shared_->stats.published += sent;
+    return sent;
+}
+
+StatePublisherStats StatePublisher::stats() const {
+    std::lock_guard<std::mutex> lock(shared_->mutex);
+    return shared_->stats;
+}
+
+} // namespace kuksa
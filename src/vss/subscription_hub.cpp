@@ -0,0 +1,1038 @@
+/**
+ * @file subscription_hub.cpp
+ * @brief Shared SubscribeById streams with local fan-out
+ */
+
+#include "subscription_hub.hpp"
+#include "proto_conversion.hpp"
+#include "shared_memory_bus.hpp"
+#include <kuksa_cpp/connection_state_machine.hpp>
+#include <glog/logging.h>
+#include <algorithm>
+#include <set>
+
+using grpc::ClientContext;
+using kuksa::val::v2::VAL;
+using kuksa::val::v2::Datapoint;
+using kuksa::val::v2::GetValueRequest;
+using kuksa::val::v2::GetValueResponse;
+using kuksa::val::v2::SubscribeByIdRequest;
+using kuksa::val::v2::SubscribeByIdResponse;
+
+namespace kuksa {
+
+struct SubscriptionHub::Membership {
+    std::vector<int32_t> signal_ids;
+    Callback callback;
+    std::function<void()> on_down;
+
+    // Guarded by the hub's mutex_
+    std::set<int32_t> catching_up;  // still owed the cached value
+    Status refused;                 // why the databroker refused one of signal_ids
+    bool left = false;
+};
+
+struct SubscriptionHub::Delivery {
+    std::shared_ptr<Membership> membership;
+    int32_t signal_id;
+    size_t value;
+};
+
+namespace {
+
+// Callbacks of lower priority run a slice at a time
+const size_t DISPATCH_SLICE = 16;
+
+// Slices a hub may have scheduled before its streams stop reading; the
+// databroker is then held back by gRPC flow control instead of the queue growing
+const size_t MAX_QUEUED_SLICES = 64;
+
+// The databroker will never stream this signal to this client; retrying is pointless
+bool is_refusal(const grpc::Status& status) {
+    return status.error_code() == grpc::StatusCode::NOT_FOUND ||
+           status.error_code() == grpc::StatusCode::PERMISSION_DENIED;
+}
+
+Status to_status(const grpc::Status& status) {
+    return Status(static_cast<absl::StatusCode>(status.error_code()), status.error_message());
+}
+
+} // namespace
+
+// ============================================================================
+// Stream
+// ============================================================================
+//
+// One SubscribeById stream, driven like the client's former subscriber
+// stream: wait for the channel, subscribe, fetch initial values, read until
+// the stream ends, then back off and reconnect. Methods ending in _locked
+// expect mutex_ to be held; the hub is only called without it, except for
+// signals_for(), stream_ended(), isolate(), settled() and pause() (lock
+// order: stream, then hub).
+//
+// A signal the databroker refuses (NOT_FOUND or PERMISSION_DENIED) would fail
+// the whole stream, and with it every client's other signals. Refusals seen
+// while fetching initial values are handed to the hub, which drops those
+// signals, and the stream resubscribes at once to the rest. If the stream
+// itself is refused without a culprit, half of its signals are moved to a new
+// stream, and a refused half is split again until the refused single signal
+// is identified and dropped. Once every half streams, the hub merges the
+// healthy signals back into one stream.
+
+class SubscriptionHub::Stream : public std::enable_shared_from_this<SubscriptionHub::Stream> {
+public:
+    explicit Stream(std::shared_ptr<SubscriptionHub> hub)
+        : hub_(std::move(hub))
+        , sm_("Subscriber", "SUBSCRIBING", "STREAMING") {
+        sm_.trigger_start();
+    }
+
+    void start() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (cancelled_) {
+            end_locked();
+            return;
+        }
+        LOG(INFO) << "Subscriber stream started";
+        retry_attempt_ = 0;
+        connect_locked();
+    }
+
+    /**
+     * @brief Cancel the stream; it ends (stream_ended) shortly after
+     */
+    void cancel() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        cancelled_ = true;
+        for (auto* context : contexts_) {
+            context->TryCancel();
+        }
+        if (retry_alarm_) {
+            retry_alarm_->Cancel();
+        }
+        if (paused_) {
+            // No read is pending that would notice the cancellation
+            paused_ = false;
+            finish_locked();
+        }
+    }
+
+    /**
+     * @brief Read again after the hub's queued callbacks drained
+     */
+    void resume() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!paused_) {
+            return;
+        }
+        paused_ = false;
+        if (cancelled_) {
+            finish_locked();
+            return;
+        }
+        read_locked();
+    }
+
+    /**
+     * @brief Resubscribe to the signals the hub now assigns to the stream
+     */
+    void resubscribe() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (cancelled_) {
+            return;
+        }
+        resubscribe_ = true;
+        if (paused_) {
+            paused_ = false;
+            finish_locked();
+        } else if (context_) {
+            context_->TryCancel();
+        }
+    }
+
+    DatabrokerConnectionStateMachine& state() { return sm_; }
+
+    bool live = false;  // initial values delivered; guarded by the hub's mutex_
+
+private:
+    Runtime::Impl& runtime() { return hub_->runtime_; }
+
+    void* completion(std::function<void(bool)> handler) {
+        return Runtime::Impl::tag([self = shared_from_this(), handler = std::move(handler)](bool ok) {
+            handler(ok);
+        });
+    }
+
+    void end_locked() {
+        sm_.trigger_stop();
+        LOG(INFO) << "Subscriber stream ended";
+        hub_->stream_ended(*this);
+    }
+
+    void connect_locked() {
+        connect_deadline_ = std::chrono::system_clock::now() + std::chrono::seconds(5);
+        wait_for_channel_locked();
+    }
+
+    // Watch the channel in short slices so cancel() is never held up for long
+    void wait_for_channel_locked() {
+        auto state = hub_->channel_->GetState(true);
+        if (state == GRPC_CHANNEL_READY) {
+            open_locked();
+            return;
+        }
+
+        auto now = std::chrono::system_clock::now();
+        if (now >= connect_deadline_) {
+            LOG(WARNING) << "Subscriber connection timeout";
+            sm_.trigger_connect_failed(absl::UnavailableError("Connection timeout"));
+            schedule_retry_locked();
+            return;
+        }
+
+        auto slice = std::min(now + std::chrono::milliseconds(100), connect_deadline_);
+        hub_->channel_->NotifyOnStateChange(state, slice, runtime().queue(), completion([this](bool) {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (cancelled_) {
+                end_locked();
+                return;
+            }
+            wait_for_channel_locked();
+        }));
+    }
+
+    void schedule_retry_locked() {
+        ++retry_attempt_;
+        sm_.trigger_retry();
+
+        // Exponential backoff
+        const int MAX_RETRY_DELAY_MS = 30000;
+        int delay_ms = std::min(100 * (1 << std::min(retry_attempt_ - 1, 16)), MAX_RETRY_DELAY_MS);
+        LOG(INFO) << "Waiting " << delay_ms << "ms before reconnection";
+
+        retry_alarm_ = std::make_unique<grpc::Alarm>();
+        retry_alarm_->Set(runtime().queue(),
+                          std::chrono::system_clock::now() + std::chrono::milliseconds(delay_ms),
+                          completion([this](bool) {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (cancelled_) {
+                end_locked();
+                return;
+            }
+            connect_locked();
+        }));
+    }
+
+    void open_locked() {
+        // Resubscribe only to signals that still have subscribers
+        signal_ids_ = hub_->signals_for(*this);
+        if (cancelled_ || signal_ids_.empty()) {
+            end_locked();
+            return;
+        }
+
+        if (sm_.current_state() == ConnectionState::CONNECTING) {
+            sm_.trigger_channel_ready();  // not when resubscribing without refused signals
+        }
+        reader_.reset();  // lives in the previous call's arena, freed with its context
+        context_ = std::make_unique<ClientContext>();
+        contexts_.insert(context_.get());
+        ready_ = false;
+        resubscribe_ = false;  // signals_for() already has the hub's latest assignment
+
+        SubscribeByIdRequest request;
+        for (int32_t signal_id : signal_ids_) {
+            request.add_signal_ids(signal_id);
+        }
+
+        reader_ = hub_->stub_->PrepareAsyncSubscribeById(context_.get(), request, runtime().queue());
+        runtime().stream_opened();
+        reader_->StartCall(completion([this](bool ok) {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (!ok || cancelled_) {
+                finish_locked();
+                return;
+            }
+            fetch_initial_values_locked();
+        }));
+    }
+
+    void fetch_initial_values_locked() {
+        initial_values_.clear();
+        pending_initial_values_ = signal_ids_.size();
+
+        for (int32_t signal_id : signal_ids_) {
+            auto call = std::make_shared<Runtime::Impl::UnaryCall<GetValueRequest, GetValueResponse>>();
+            call->request.mutable_signal_id()->set_id(signal_id);
+            contexts_.insert(&call->context);
+
+            runtime().start_unary(*hub_->stub_, &VAL::Stub::PrepareAsyncGetValue, *call,
+                                  completion([this, call, signal_id](bool) {
+                std::unique_lock<std::mutex> lock(mutex_);
+                contexts_.erase(&call->context);
+                if (call->status.ok() && call->response.data_point().has_timestamp()) {
+                    initial_values_.emplace_back(signal_id, call->response.data_point());
+                } else if (is_refusal(call->status)) {
+                    refused_.emplace_back(signal_id, to_status(call->status));
+                }
+                if (--pending_initial_values_ == 0) {
+                    initial_values_fetched(lock);
+                }
+            }));
+        }
+    }
+
+    void initial_values_fetched(std::unique_lock<std::mutex>& lock) {
+        if (!refused_.empty() && !cancelled_) {
+            auto refused = std::move(refused_);
+            refused_.clear();
+            lock.unlock();
+            hub_->refuse(refused);
+            lock.lock();
+            resubscribe_ = true;
+            context_->TryCancel();
+            finish_locked();
+            return;
+        }
+
+        if (!cancelled_) {
+            auto initial_values = std::move(initial_values_);
+            initial_values_.clear();
+
+            lock.unlock();
+            hub_->dispatch(initial_values, this);
+            lock.lock();
+        }
+
+        if (cancelled_) {
+            finish_locked();
+            return;
+        }
+
+        ready_ = true;
+        sm_.trigger_stream_ready();
+        hub_->settled(*this);
+        read_next_locked();
+    }
+
+    // Read unless the hub has too many callbacks queued; resume() reads then
+    void read_next_locked() {
+        if (hub_->pause(shared_from_this())) {
+            paused_ = true;
+            return;
+        }
+        read_locked();
+    }
+
+    void read_locked() {
+        reader_->Read(&response_, completion([this](bool ok) {
+            std::unique_lock<std::mutex> lock(mutex_);
+            if (!ok || cancelled_) {
+                finish_locked();
+                return;
+            }
+
+            retry_attempt_ = 0;
+            std::vector<std::pair<int32_t, Datapoint>> updates;
+            updates.reserve(response_.entries().size());
+            for (auto& [signal_id, datapoint] : *response_.mutable_entries()) {
+                updates.emplace_back(signal_id, std::move(datapoint));
+            }
+
+            lock.unlock();
+            hub_->dispatch(updates);
+            lock.lock();
+
+            if (cancelled_) {
+                finish_locked();
+                return;
+            }
+            read_next_locked();
+        }));
+    }
+
+    void finish_locked() {
+        reader_->Finish(&status_, completion([this](bool) {
+            std::unique_lock<std::mutex> lock(mutex_);
+            contexts_.erase(context_.get());
+            runtime().stream_closed();
+
+            if (cancelled_) {
+                end_locked();
+                return;
+            }
+
+            if (resubscribe_) {
+                resubscribe_ = false;
+                open_locked();
+                return;
+            }
+
+            if (is_refusal(status_)) {
+                if (signal_ids_.size() == 1) {
+                    lock.unlock();
+                    hub_->refuse({{signal_ids_.front(), to_status(status_)}});
+                    lock.lock();
+                    if (cancelled_) {
+                        end_locked();
+                        return;
+                    }
+                    open_locked();  // ends the stream if no signal is left
+                    return;
+                }
+                // Not a broker failure: retry at once with half of the signals
+                hub_->isolate(*this);
+                open_locked();
+                return;
+            }
+
+            LOG(WARNING) << "Subscription stream ended: " << status_.error_message();
+            auto error = absl::UnavailableError(status_.error_message());
+            if (ready_) {
+                sm_.trigger_stream_ended(error);
+            } else {
+                sm_.trigger_stream_failed(error, true);
+            }
+            schedule_retry_locked();
+
+            runtime().post([hub = hub_, self = shared_from_this()](bool) {
+                hub->stream_down(*self);
+            });
+        }));
+    }
+
+    std::shared_ptr<SubscriptionHub> hub_;  // released by the hub when the stream ends
+    DatabrokerConnectionStateMachine sm_;
+
+    std::mutex mutex_;
+    bool cancelled_ = false;
+    std::set<ClientContext*> contexts_;  // cancelled by cancel()
+    std::vector<int32_t> signal_ids_;
+    std::unique_ptr<ClientContext> context_;
+    std::unique_ptr<grpc::ClientAsyncReader<SubscribeByIdResponse>> reader_;
+    SubscribeByIdResponse response_;
+    grpc::Status status_;
+    std::unique_ptr<grpc::Alarm> retry_alarm_;
+    std::chrono::system_clock::time_point connect_deadline_;
+    int retry_attempt_ = 0;
+    bool ready_ = false;
+    bool resubscribe_ = false;  // reopen at once after cancelling for refused or merged signals
+    bool paused_ = false;       // not reading until resume()
+    size_t pending_initial_values_ = 0;
+    std::vector<std::pair<int32_t, Datapoint>> initial_values_;
+    std::vector<std::pair<int32_t, Status>> refused_;
+};
+
+// ============================================================================
+// SubscriptionHub
+// ============================================================================
+
+SubscriptionHub::SubscriptionHub(Runtime::Impl& runtime,
+                                 std::shared_ptr<grpc::Channel> channel,
+                                 std::shared_ptr<VAL::Stub> stub,
+                                 Priority lane)
+    : runtime_(runtime)
+    , channel_(std::move(channel))
+    , stub_(std::move(stub))
+    , lane_(lane) {
+}
+
+SubscriptionHub::~SubscriptionHub() = default;
+
+std::shared_ptr<SubscriptionHub::Membership> SubscriptionHub::join(const std::vector<int32_t>& signal_ids,
+                                                                   Callback callback,
+                                                                   std::function<void()> on_down) {
+    auto membership = std::make_shared<Membership>();
+    membership->signal_ids = signal_ids;
+    membership->callback = std::move(callback);
+    membership->on_down = std::move(on_down);
+
+    std::shared_ptr<Stream> opening;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (int32_t signal_id : signal_ids) {
+            auto [it, added] = entries_.try_emplace(signal_id);
+            auto& entry = it->second;
+            if (added && runtime_.shared_memory()) {
+                // Values already in shared memory predate the subscription
+                entry.shared_sequence = runtime_.shared_memory()->sequence(signal_id);
+            }
+            entry.members.push_back(membership);
+            if (entry.stream) {
+                // Already on the wire: owed the latest value unless a fresher one arrives first
+                if (entry.stream->live && entry.last) {
+                    membership->catching_up.insert(signal_id);
+                }
+                continue;
+            }
+            if (!forming_) {
+                forming_ = std::make_shared<Stream>(shared_from_this());
+                streams_.push_back(forming_);
+                opening = forming_;
+            }
+            entry.stream = forming_;
+        }
+    }
+
+    // Joins before the runtime gets here share the stream
+    if (opening) {
+        runtime_.post([self = shared_from_this(), opening](bool) {
+            {
+                std::lock_guard<std::mutex> lock(self->mutex_);
+                if (self->forming_ == opening) {
+                    self->forming_.reset();
+                }
+            }
+            opening->start();
+        });
+    }
+    if (!membership->catching_up.empty()) {
+        runtime_.post([self = shared_from_this(), membership](bool) {
+            self->deliver_cached(membership);
+        });
+    }
+    return membership;
+}
+
+void SubscriptionHub::leave(const std::shared_ptr<Membership>& membership) {
+    std::vector<std::shared_ptr<Stream>> idle;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        membership->left = true;
+        for (int32_t signal_id : membership->signal_ids) {
+            auto it = entries_.find(signal_id);
+            if (it == entries_.end()) {
+                continue;
+            }
+            auto& members = it->second.members;
+            members.erase(std::remove(members.begin(), members.end(), membership), members.end());
+            if (members.empty()) {
+                entries_.erase(it);
+            }
+        }
+
+        // Streams left without subscribed signals are cancelled
+        for (const auto& stream : streams_) {
+            bool used = std::any_of(entries_.begin(), entries_.end(), [&](const auto& entry) {
+                return entry.second.stream == stream;
+            });
+            if (!used) {
+                idle.push_back(stream);
+            }
+        }
+        if (forming_ && std::find(idle.begin(), idle.end(), forming_) != idle.end()) {
+            forming_.reset();
+        }
+    }
+
+    for (const auto& stream : idle) {
+        stream->cancel();
+    }
+
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        ended_.wait(lock, [&]() {
+            return std::none_of(idle.begin(), idle.end(), [&](const auto& stream) {
+                return std::find(streams_.begin(), streams_.end(), stream) != streams_.end();
+            });
+        });
+    }
+
+    // Wait out callbacks that may still be running for membership
+    std::lock_guard<std::recursive_mutex> dispatching(dispatch_mutex_);
+}
+
+Status SubscriptionHub::status(const Membership& membership) const {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!membership.refused.ok()) {
+            return membership.refused;
+        }
+    }
+    for (const auto& stream : streams_of(membership)) {
+        auto status = stream->state().status();
+        if (!status.ok()) {
+            return status;
+        }
+    }
+    return absl::OkStatus();
+}
+
+Status SubscriptionHub::wait_until_active(const Membership& membership, std::chrono::milliseconds timeout) const {
+    auto deadline = std::chrono::steady_clock::now() + timeout;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!membership.refused.ok()) {
+            return membership.refused;
+        }
+    }
+    for (const auto& stream : streams_of(membership)) {
+        auto remaining = std::chrono::duration_cast<std::chrono::milliseconds>(
+            deadline - std::chrono::steady_clock::now());
+        auto status = stream->state().wait_until_active(remaining);
+        if (!status.ok()) {
+            return status;
+        }
+    }
+    return absl::OkStatus();
+}
+
+void SubscriptionHub::add_stats(RuntimeStats& stats) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stats.subscriptions += streams_.size();
+    stats.signals += entries_.size();
+    stats.decoded += decoded_;
+    stats.delivered += delivered_;
+    stats.looped_back += looped_back_;
+    stats.shared_received += shared_received_;
+    stats.paused_reads += paused_reads_;
+}
+
+bool SubscriptionHub::loop_back(int32_t signal_id, const vss::types::DynamicQualifiedValue& value) {
+    std::vector<std::shared_ptr<Membership>> members;
+
+    std::lock_guard<std::recursive_mutex> dispatching(dispatch_mutex_);
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = entries_.find(signal_id);
+        if (it == entries_.end()) {
+            return false;
+        }
+        auto& entry = it->second;
+        entry.last = value;
+        members = entry.members;
+        for (const auto& membership : members) {
+            membership->catching_up.erase(signal_id);
+        }
+        ++looped_back_;
+        delivered_ += members.size();
+    }
+
+    for (const auto& membership : members) {
+        try {
+            membership->callback(signal_id, value);
+        } catch (const std::exception& e) {
+            LOG(ERROR) << "Exception in subscription callback for ID " << signal_id << ": " << e.what();
+        }
+    }
+    return true;
+}
+
+void SubscriptionHub::expect_echo(int32_t signal_id, const Datapoint& datapoint) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = entries_.find(signal_id);
+    if (it == entries_.end()) {
+        return;
+    }
+    remember_echo(it->second, datapoint.SerializeAsString());
+}
+
+void SubscriptionHub::remember_echo(Entry& entry, std::string echo) {
+    // Echoes the databroker changed or never sends age out
+    const size_t MAX_PENDING_ECHOES = 64;
+
+    entry.echoes.push_back(std::move(echo));
+    if (entry.echoes.size() > MAX_PENDING_ECHOES) {
+        entry.echoes.pop_front();
+    }
+}
+
+void SubscriptionHub::receive_shared(const SharedMemoryBus& bus) {
+    std::vector<std::pair<int32_t, vss::types::DynamicQualifiedValue>> values;
+    std::vector<std::pair<std::shared_ptr<Membership>, size_t>> deliveries;
+
+    std::lock_guard<std::recursive_mutex> dispatching(dispatch_mutex_);
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (auto& [signal_id, entry] : entries_) {
+            vss::types::DynamicQualifiedValue value;
+            if (!bus.read(signal_id, entry.shared_sequence, value)) {
+                continue;
+            }
+            if (entry.last && entry.last->timestamp == value.timestamp &&
+                entry.last->quality == value.quality && entry.last->value == value.value) {
+                continue;  // the databroker was faster
+            }
+            // The databroker's copy of this value is on its way; it must not be delivered twice
+            remember_echo(entry, qualified_value_to_datapoint(value).SerializeAsString());
+            entry.last = value;
+            values.emplace_back(signal_id, std::move(value));
+            for (const auto& membership : entry.members) {
+                membership->catching_up.erase(signal_id);
+                deliveries.emplace_back(membership, values.size() - 1);
+            }
+        }
+        shared_received_ += values.size();
+        delivered_ += deliveries.size();
+    }
+
+    for (const auto& [membership, index] : deliveries) {
+        const auto& [signal_id, value] = values[index];
+        try {
+            membership->callback(signal_id, value);
+        } catch (const std::exception& e) {
+            LOG(ERROR) << "Exception in subscription callback for ID " << signal_id << ": " << e.what();
+        }
+    }
+}
+
+bool SubscriptionHub::is_echo(Entry& entry, const Datapoint& datapoint) {
+    if (entry.echoes.empty()) {
+        return false;
+    }
+    auto echo = std::find(entry.echoes.begin(), entry.echoes.end(), datapoint.SerializeAsString());
+    if (echo == entry.echoes.end()) {
+        return false;
+    }
+    // Earlier echoes were superseded or lost
+    entry.echoes.erase(entry.echoes.begin(), echo + 1);
+    return true;
+}
+
+std::vector<std::shared_ptr<SubscriptionHub::Stream>> SubscriptionHub::streams_of(const Membership& membership) const {
+    std::vector<std::shared_ptr<Stream>> streams;
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (int32_t signal_id : membership.signal_ids) {
+        auto it = entries_.find(signal_id);
+        if (it != entries_.end() &&
+            std::find(streams.begin(), streams.end(), it->second.stream) == streams.end()) {
+            streams.push_back(it->second.stream);
+        }
+    }
+    return streams;
+}
+
+std::vector<int32_t> SubscriptionHub::signals_for(const Stream& stream) {
+    std::vector<int32_t> signal_ids;
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (const auto& [signal_id, entry] : entries_) {
+        if (entry.stream.get() == &stream) {
+            signal_ids.push_back(signal_id);
+        }
+    }
+    return signal_ids;
+}
+
+void SubscriptionHub::stream_ended(const Stream& stream) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        streams_.erase(std::remove_if(streams_.begin(), streams_.end(),
+                                      [&](const auto& s) { return s.get() == &stream; }),
+                       streams_.end());
+        auto split = std::find_if(splits_.begin(), splits_.end(),
+                                  [&](const auto& s) { return s.get() == &stream; });
+        if (split != splits_.end()) {
+            // Typically the refused signal, dropped once it was on its own
+            splits_.erase(split);
+            unsettled_.erase(&stream);
+            narrowed_ = true;
+            merge_when_settled_locked();
+        }
+    }
+    ended_.notify_all();
+}
+
+void SubscriptionHub::refuse(const std::vector<std::pair<int32_t, Status>>& refused) {
+    std::vector<std::shared_ptr<Membership>> affected;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (const auto& [signal_id, status] : refused) {
+            auto it = entries_.find(signal_id);
+            if (it == entries_.end()) {
+                continue;
+            }
+            LOG(ERROR) << "Databroker refused subscription to ID " << signal_id << ": " << status;
+            for (const auto& membership : it->second.members) {
+                if (membership->refused.ok()) {
+                    membership->refused = status;
+                }
+                if (membership->on_down &&
+                    std::find(affected.begin(), affected.end(), membership) == affected.end()) {
+                    affected.push_back(membership);
+                }
+            }
+            entries_.erase(it);
+        }
+    }
+
+    if (!affected.empty()) {
+        runtime_.post([self = shared_from_this(), affected = std::move(affected)](bool) {
+            std::lock_guard<std::recursive_mutex> dispatching(self->dispatch_mutex_);
+            for (const auto& membership : affected) {
+                membership->on_down();
+            }
+        });
+    }
+}
+
+void SubscriptionHub::isolate(const Stream& stream) {
+    std::shared_ptr<Stream> half;
+    size_t moved = 0;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        std::vector<Entry*> carried;
+        for (auto& [signal_id, entry] : entries_) {
+            if (entry.stream.get() == &stream) {
+                carried.push_back(&entry);
+            }
+        }
+        auto it = std::find_if(streams_.begin(), streams_.end(),
+                               [&](const auto& s) { return s.get() == &stream; });
+        if (carried.size() < 2 || it == streams_.end()) {
+            return;
+        }
+        auto original = *it;
+        if (splits_.empty()) {
+            narrowed_ = false;
+        }
+
+        // The second half goes to a new stream; the first stays on stream
+        half = std::make_shared<Stream>(shared_from_this());
+        streams_.push_back(half);
+        for (size_t i = carried.size() / 2; i < carried.size(); ++i) {
+            carried[i]->stream = half;
+            ++moved;
+        }
+
+        if (std::find(splits_.begin(), splits_.end(), original) == splits_.end()) {
+            splits_.push_back(original);
+        }
+        splits_.push_back(half);
+        unsettled_.insert(&stream);
+        unsettled_.insert(half.get());
+    }
+    LOG(WARNING) << "Subscription refused; moving " << moved << " signal(s) to a new stream to find the culprit";
+    runtime_.post([half](bool) { half->start(); });
+}
+
+void SubscriptionHub::settled(const Stream& stream) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (unsettled_.erase(&stream) != 0) {
+        merge_when_settled_locked();
+    }
+}
+
+void SubscriptionHub::merge_when_settled_locked() {
+    // A stream that is about to be refused may deliver its initial values
+    // first, so only a split that ended shows the refused signal was found
+    if (!narrowed_ || !unsettled_.empty()) {
+        return;
+    }
+    if (splits_.size() > 1) {
+        runtime_.post([self = shared_from_this()](bool) { self->merge_splits(); });
+    } else {
+        splits_.clear();
+        narrowed_ = false;
+    }
+}
+
+void SubscriptionHub::merge_splits() {
+    std::shared_ptr<Stream> home;
+    std::vector<std::shared_ptr<Stream>> merged;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!narrowed_ || !unsettled_.empty() || splits_.size() < 2) {
+            return;  // split again meanwhile, or merged already
+        }
+        for (auto& [signal_id, entry] : entries_) {
+            if (std::find(splits_.begin(), splits_.end(), entry.stream) == splits_.end()) {
+                continue;
+            }
+            if (!home) {
+                home = entry.stream;
+            }
+            entry.stream = home;
+        }
+        for (const auto& split : splits_) {
+            if (split != home) {
+                merged.push_back(split);
+            }
+        }
+        splits_.clear();
+        narrowed_ = false;
+    }
+    if (!home) {
+        return;
+    }
+
+    LOG(INFO) << "Merging the signals of " << merged.size() + 1 << " subscription streams into one";
+    for (const auto& stream : merged) {
+        stream->cancel();
+    }
+    home->resubscribe();
+}
+
+void SubscriptionHub::stream_down(const Stream& stream) {
+    std::vector<std::shared_ptr<Membership>> affected;
+
+    std::lock_guard<std::recursive_mutex> dispatching(dispatch_mutex_);
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (const auto& [signal_id, entry] : entries_) {
+            if (entry.stream.get() != &stream) {
+                continue;
+            }
+            for (const auto& membership : entry.members) {
+                if (membership->on_down &&
+                    std::find(affected.begin(), affected.end(), membership) == affected.end()) {
+                    affected.push_back(membership);
+                }
+            }
+        }
+    }
+
+    for (const auto& membership : affected) {
+        membership->on_down();
+    }
+}
+
+void SubscriptionHub::replay(const std::shared_ptr<Membership>& membership) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        membership->catching_up.insert(membership->signal_ids.begin(), membership->signal_ids.end());
+    }
+    deliver_cached(membership);
+}
+
+void SubscriptionHub::dispatch(const std::vector<std::pair<int32_t, Datapoint>>& datapoints,
+                               Stream* ready_stream) {
+    auto received = std::chrono::steady_clock::now();
+    auto shared_values = std::make_shared<std::vector<vss::types::DynamicQualifiedValue>>();
+    auto& values = *shared_values;
+    std::vector<Delivery> deliveries;
+
+    std::unique_lock<std::recursive_mutex> dispatching(dispatch_mutex_);
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        values.reserve(datapoints.size());
+        for (const auto& [signal_id, datapoint] : datapoints) {
+            auto it = entries_.find(signal_id);
+            if (it == entries_.end() || is_echo(it->second, datapoint)) {
+                continue;
+            }
+            try {
+                values.push_back(datapoint_to_qualified_value(datapoint));
+            } catch (const std::exception& e) {
+                LOG(ERROR) << "Cannot decode update for ID " << signal_id << ": " << e.what();
+                continue;
+            }
+            ++decoded_;
+
+            auto& entry = it->second;
+            entry.last = values.back();
+            for (const auto& membership : entry.members) {
+                membership->catching_up.erase(signal_id);
+                deliveries.push_back({membership, signal_id, values.size() - 1});
+            }
+        }
+        if (ready_stream) {
+            ready_stream->live = true;
+        }
+        delivered_ += deliveries.size();
+    }
+
+    if (!runtime_.prioritized()) {
+        deliver(deliveries, values, received);
+        return;
+    }
+
+    // Scheduled callbacks check for members that left in the meantime
+    dispatching.unlock();
+    std::vector<std::function<void()>> tasks;
+    for (size_t first = 0; first < deliveries.size(); first += DISPATCH_SLICE) {
+        auto last = std::min(first + DISPATCH_SLICE, deliveries.size());
+        std::vector<Delivery> slice(deliveries.begin() + first, deliveries.begin() + last);
+        tasks.push_back([self = shared_from_this(), shared_values, slice = std::move(slice), received]() {
+            self->deliver(slice, *shared_values, received);
+            self->slice_done();
+        });
+    }
+    if (!tasks.empty()) {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            queued_slices_ += tasks.size();
+        }
+        runtime_.schedule(lane_, std::move(tasks));
+    }
+}
+
+bool SubscriptionHub::pause(const std::shared_ptr<Stream>& stream) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (queued_slices_ < MAX_QUEUED_SLICES) {
+        return false;
+    }
+    paused_.push_back(stream);
+    ++paused_reads_;
+    return true;
+}
+
+void SubscriptionHub::slice_done() {
+    std::vector<std::shared_ptr<Stream>> paused;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        --queued_slices_;
+        if (queued_slices_ < MAX_QUEUED_SLICES) {
+            paused.swap(paused_);
+        }
+    }
+    for (const auto& stream : paused) {
+        stream->resume();
+    }
+}
+
+void SubscriptionHub::deliver(const std::vector<Delivery>& deliveries,
+                              const std::vector<vss::types::DynamicQualifiedValue>& values,
+                              std::chrono::steady_clock::time_point received) {
+    std::lock_guard<std::recursive_mutex> dispatching(dispatch_mutex_);
+    std::vector<bool> left;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        left.reserve(deliveries.size());
+        for (const auto& delivery : deliveries) {
+            left.push_back(delivery.membership->left);
+        }
+    }
+
+    for (size_t i = 0; i < deliveries.size(); ++i) {
+        if (left[i]) {
+            continue;
+        }
+        const auto& delivery = deliveries[i];
+        runtime_.record_dispatch(lane_, std::chrono::steady_clock::now() - received);
+        try {
+            delivery.membership->callback(delivery.signal_id, values[delivery.value]);
+        } catch (const std::exception& e) {
+            LOG(ERROR) << "Exception in subscription callback for ID " << delivery.signal_id << ": " << e.what();
+        }
+    }
+}
+
+void SubscriptionHub::deliver_cached(const std::shared_ptr<Membership>& membership) {
+    std::vector<std::pair<int32_t, vss::types::DynamicQualifiedValue>> values;
+
+    std::lock_guard<std::recursive_mutex> dispatching(dispatch_mutex_);
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (membership->left) {
+            return;
+        }
+        for (int32_t signal_id : membership->catching_up) {
+            auto it = entries_.find(signal_id);
+            if (it != entries_.end() && it->second.last) {
+                values.emplace_back(signal_id, *it->second.last);
+            }
+        }
+        membership->catching_up.clear();
+        delivered_ += values.size();
+    }
+
+    for (const auto& [signal_id, value] : values) {
+        try {
+            membership->callback(signal_id, value);
+        } catch (const std::exception& e) {
+            LOG(ERROR) << "Exception in subscription callback for ID " << signal_id << ": " << e.what();
+        }
+    }
+}
+
+} // namespace kuksa
@@ -0,0 +1,209 @@
+/**
+ * @file subscription_hub.hpp
+ * @brief Subscription multiplexer shared by the clients of one runtime and address
+ */
+
+#pragma once
+
+#include "runtime_impl.hpp"
+#include <kuksa_cpp/error.hpp>
+#include <vss/types/types.hpp>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <set>
+#include <string>
+#include <vector>
+
+namespace kuksa {
+
+class SharedMemoryBus;
+
+/**
+ * @brief Merges the subscriptions of all clients into as few SubscribeById streams as possible
+ *
+ * Clients join with the signal ids they subscribe to. A signal already on a
+ * wire stream is not subscribed again: the joining client is added to its
+ * subscribers and gets the latest value from the hub's cache. Signals not yet
+ * on the wire go to one new stream; joins that arrive before the runtime opens
+ * it share it, so clients started together end up on a single stream.
+ *
+ * Every received datapoint is decoded once and handed to each subscriber of
+ * its signal. Broker load and decode work therefore scale with the number of
+ * distinct signals, not with the number of subscribing clients.
+ *
+ * A stream whose signals have all lost their subscribers is cancelled; a
+ * stream that reconnects resubscribes only to signals that still have some.
+ * Signals the databroker refuses (unknown or not permitted) are dropped from
+ * the merged streams, and only the clients that subscribed to them see the
+ * error (status(), on_down); the other signals keep streaming, on a single
+ * stream again once the refused ones are found.
+ *
+ * With loopback, values published in the process are handed to the
+ * subscribers directly (loop_back) and the databroker's copy, announced with
+ * expect_echo(), is dropped when it arrives on the stream. Values other
+ * processes write to the runtime's shared memory are delivered the same way
+ * (receive_shared).
+ *
+ * On a prioritized runtime, updates are decoded as they arrive but their
+ * callbacks are scheduled on the runtime at the hub's lane priority, a
+ * slice at a time (see Runtime::Impl::schedule). While too many slices are
+ * queued the hub's streams stop reading, so a consumer that falls behind
+ * slows the databroker down through gRPC flow control.
+ */
+class SubscriptionHub : public std::enable_shared_from_this<SubscriptionHub> {
+public:
+    /// Called on a runtime thread with the decoded value of signal_id
+    using Callback = std::function<void(int32_t signal_id, const vss::types::DynamicQualifiedValue& value)>;
+
+    /// One client's subscriptions, from join() until leave()
+    struct Membership;
+
+    SubscriptionHub(Runtime::Impl& runtime,
+                    std::shared_ptr<grpc::Channel> channel,
+                    std::shared_ptr<kuksa::val::v2::VAL::Stub> stub,
+                    Priority lane = Priority::NORMAL);
+    ~SubscriptionHub();
+
+    /**
+     * @brief Subscribe to signal_ids; on_down is called on a runtime thread
+     *        whenever a stream carrying some of them fails
+     */
+    std::shared_ptr<Membership> join(const std::vector<int32_t>& signal_ids, Callback callback,
+                                     std::function<void()> on_down = {});
+
+    /**
+     * @brief Remove membership; no callback runs for it once this returns
+     *
+     * Must not be called from inside a subscription callback.
+     */
+    void leave(const std::shared_ptr<Membership>& membership);
+
+    /**
+     * @brief Why one of membership's signals was refused, else the first
+     *        non-OK status of the streams carrying them
+     */
+    Status status(const Membership& membership) const;
+
+    Status wait_until_active(const Membership& membership, std::chrono::milliseconds timeout) const;
+
+    /**
+     * @brief Deliver the latest cached value of each of membership's signals again
+     */
+    void replay(const std::shared_ptr<Membership>& membership);
+
+    /**
+     * @brief Deliver value to the subscribers of signal_id on the calling thread
+     *
+     * Not scheduled by priority, so that publish() returns after the callbacks ran.
+     *
+     * @return false if signal_id has no subscriber in this process
+     */
+    bool loop_back(int32_t signal_id, const vss::types::DynamicQualifiedValue& value);
+
+    /**
+     * @brief Drop datapoint once when the databroker sends it back for signal_id
+     */
+    void expect_echo(int32_t signal_id, const kuksa::val::v2::Datapoint& datapoint);
+
+    /**
+     * @brief Deliver values other runtimes wrote to bus for subscribed signals
+     *
+     * Runs the callbacks on the calling (watcher) thread, not scheduled by priority.
+     */
+    void receive_shared(const SharedMemoryBus& bus);
+
+    void add_stats(RuntimeStats& stats) const;
+
+private:
+    class Stream;
+    friend class Stream;
+    struct Delivery;
+
+    struct Entry {
+        std::vector<std::shared_ptr<Membership>> members;
+        std::shared_ptr<Stream> stream;
+        std::optional<vss::types::DynamicQualifiedValue> last;  // latest value, for late joiners
+        std::deque<std::string> echoes;  // serialized datapoints already looped back
+        uint32_t shared_sequence = 0;    // last shared memory value seen
+    };
+
+    std::vector<std::shared_ptr<Stream>> streams_of(const Membership& membership) const;
+
+    // Signals the stream carries, i.e. those that still have subscribers
+    std::vector<int32_t> signals_for(const Stream& stream);
+
+    void stream_ended(const Stream& stream);
+
+    // Drop signals the databroker refused; only their members see the error
+    void refuse(const std::vector<std::pair<int32_t, Status>>& refused);
+
+    // Move half of stream's signals to a new stream, to narrow down which
+    // one the databroker refused
+    void isolate(const Stream& stream);
+
+    // stream delivered its initial values; once a split ended and no other
+    // is still subscribing, the healthy signals are merged back into one stream
+    void settled(const Stream& stream);
+    void merge_when_settled_locked();
+    void merge_splits();
+
+    // Tell the members of stream's signals that it failed
+    void stream_down(const Stream& stream);
+
+    // Whether datapoint is the databroker's copy of a looped back value; guarded by mutex_
+    static bool is_echo(Entry& entry, const kuksa::val::v2::Datapoint& datapoint);
+
+    static void remember_echo(Entry& entry, std::string echo);
+
+    // Decode each datapoint once and hand it to every subscriber
+    void dispatch(const std::vector<std::pair<int32_t, kuksa::val::v2::Datapoint>>& datapoints,
+                  Stream* ready_stream = nullptr);
+
+    // Whether stream must wait for queued slices before reading again; if so
+    // it is resumed by the slice_done() that brings the queue below the limit
+    bool pause(const std::shared_ptr<Stream>& stream);
+
+    void slice_done();
+
+    // Run the callbacks of deliveries whose members have not left
+    void deliver(const std::vector<Delivery>& deliveries,
+                 const std::vector<vss::types::DynamicQualifiedValue>& values,
+                 std::chrono::steady_clock::time_point received);
+
+    // Hand membership the cached values it is still owed
+    void deliver_cached(const std::shared_ptr<Membership>& membership);
+
+    Runtime::Impl& runtime_;
+    std::shared_ptr<grpc::Channel> channel_;
+    std::shared_ptr<kuksa::val::v2::VAL::Stub> stub_;
+    const Priority lane_;
+
+    mutable std::mutex mutex_;
+    std::map<int32_t, Entry> entries_;
+    std::vector<std::shared_ptr<Stream>> streams_;
+    std::shared_ptr<Stream> forming_;  // created but not opened yet; takes new signals
+    std::vector<std::shared_ptr<Stream>> splits_;  // streams isolate() divided, until merged
+    std::set<const Stream*> unsettled_;            // splits_ not streaming yet
+    bool narrowed_ = false;                        // one of splits_ ended
+    std::condition_variable ended_;    // a stream left streams_
+    uint64_t decoded_ = 0;
+    uint64_t delivered_ = 0;
+    uint64_t looped_back_ = 0;
+    uint64_t shared_received_ = 0;
+    size_t queued_slices_ = 0;                   // scheduled and not yet delivered
+    std::vector<std::shared_ptr<Stream>> paused_;  // waiting for queued_slices_ to drop
+    uint64_t paused_reads_ = 0;
+
+    // Held while callbacks run, so leave() can wait for them; recursive
+    // because a callback may publish and so loop back
+    std::recursive_mutex dispatch_mutex_;
+};
+
+} // namespace kuksa
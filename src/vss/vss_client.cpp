@@ -4,21 +4,43 @@
  *
  * This is a new implementation that combines provider and subscriber
  * functionality in a single client with two concurrent streams over
- * one gRPC channel.
+ * one gRPC channel. The streams run asynchronously on the completion
+ * queue of the client's Runtime, which may be shared with other clients;
+ * subscriptions go through the runtime's SubscriptionHub, which shares
+ * SubscribeById streams between the clients of one address.
+ *
+ * A client may be given several (redundant) databrokers. It then subscribes
+ * on all of them and delivers the updates of one, the active endpoint,
+ * switching to a standby whose stream is already open when the active one
+ * fails.
+ *
+ * Signals can be given a Priority. Each priority is a lane with its own
+ * pooled channel and hub per databroker, so critical traffic does not share
+ * a connection or a subscription stream with bulk traffic.
  */
 
 #include <kuksa_cpp/client.hpp>
 #include <kuksa_cpp/error.hpp>
 #include <kuksa_cpp/connection_state_machine.hpp>
 #include <kuksa_cpp/type_mapping.hpp>
+#include "callback_queue.hpp"
+#include "proto_conversion.hpp"
+#include "runtime_impl.hpp"
+#include "shared_memory_bus.hpp"
+#include "subscription_hub.hpp"
 #include <grpcpp/grpcpp.h>
 #include <glog/logging.h>
 #include <absl/strings/str_format.h>
 #include <absl/strings/str_join.h>
-#include <thread>
+#include <algorithm>
+#include <array>
+#include <condition_variable>
+#include <deque>
 #include <mutex>
 #include <atomic>
 #include <map>
+#include <set>
+#include <thread>
 #include <limits>
 
 // Include KUKSA v2 protobuf definitions
@@ -38,8 +60,6 @@ using kuksa::val::v2::BatchActuateStreamRequest;
 using kuksa::val::v2::BatchActuateStreamResponse;
 using kuksa::val::v2::PublishValueRequest;
 using kuksa::val::v2::PublishValueResponse;
-using kuksa::val::v2::SubscribeByIdRequest;
-using kuksa::val::v2::SubscribeByIdResponse;
 using kuksa::val::v2::GetValueRequest;
 using kuksa::val::v2::GetValueResponse;
 using kuksa::val::v2::ActuateRequest;
@@ -51,260 +71,93 @@ using kuksa::val::v2::Datapoint;
 namespace kuksa {
 
 // ============================================================================
-// Helper functions (shared by both streams)
+// Client Implementation
 // ============================================================================
 
-/**
- * @brief Safely narrow a value from physical type to logical type with range checking
- *
- * Used when converting from KUKSA protobuf types (int32/uint32) to VSS logical types
- * (int8/uint8/int16/uint16). Validates that the value fits in the target range.
- *
- * @tparam LogicalT Target VSS logical type (e.g., uint8_t)
- * @tparam PhysicalT Source KUKSA physical type (e.g., uint32_t)
- * @param value Value to narrow
- * @return Result<LogicalT> Success with narrowed value, or error if out of range
- */
-template<typename LogicalT, typename PhysicalT>
-static Result<LogicalT> narrow_cast(PhysicalT value) {
-    if (value < std::numeric_limits<LogicalT>::min() ||
-        value > std::numeric_limits<LogicalT>::max()) {
-        return absl::OutOfRangeError(
-            absl::StrFormat("Value %d out of range for type [%d, %d]",
-                           static_cast<int64_t>(value),
-                           static_cast<int64_t>(std::numeric_limits<LogicalT>::min()),
-                           static_cast<int64_t>(std::numeric_limits<LogicalT>::max()))
-        );
-    }
-    return static_cast<LogicalT>(value);
-}
-
-// Convert vss::types::Value to protobuf Value
-// Handles widening conversions for int8/uint8/int16/uint16 -> int32/uint32
-static kuksa::val::v2::Value to_proto_value(const vss::types::Value& value) {
-    kuksa::val::v2::Value proto_value;
-
-    std::visit([&proto_value](auto&& v) {
-        using T = std::decay_t<decltype(v)>;
-
-        if constexpr (std::is_same_v<T, std::monostate>) {
-            // Empty value - don't set anything in protobuf
-        } else if constexpr (std::is_same_v<T, bool>) {
-            proto_value.set_bool_(v);
-        }
-        // Narrowing scalar types (widen to protobuf physical type)
-        else if constexpr (std::is_same_v<T, int8_t>) {
-            proto_value.set_int32(static_cast<int32_t>(v));  // Widen
-        } else if constexpr (std::is_same_v<T, uint8_t>) {
-            proto_value.set_uint32(static_cast<uint32_t>(v));  // Widen
-        } else if constexpr (std::is_same_v<T, int16_t>) {
-            proto_value.set_int32(static_cast<int32_t>(v));  // Widen
-        } else if constexpr (std::is_same_v<T, uint16_t>) {
-            proto_value.set_uint32(static_cast<uint32_t>(v));  // Widen
-        }
-        // Direct scalar types (no conversion)
-        else if constexpr (std::is_same_v<T, int32_t>) {
-            proto_value.set_int32(v);
-        } else if constexpr (std::is_same_v<T, uint32_t>) {
-            proto_value.set_uint32(v);
-        } else if constexpr (std::is_same_v<T, int64_t>) {
-            proto_value.set_int64(v);
-        } else if constexpr (std::is_same_v<T, uint64_t>) {
-            proto_value.set_uint64(v);
-        } else if constexpr (std::is_same_v<T, float>) {
-            proto_value.set_float_(v);
-        } else if constexpr (std::is_same_v<T, double>) {
-            proto_value.set_double_(v);
-        } else if constexpr (std::is_same_v<T, std::string>) {
-            proto_value.set_string(v);
-        }
-        // Narrowing array types (widen elements to protobuf physical type)
-        else if constexpr (std::is_same_v<T, std::vector<int8_t>>) {
-            auto* arr = proto_value.mutable_int32_array();
-            for (int8_t val : v) arr->add_values(static_cast<int32_t>(val));
-        } else if constexpr (std::is_same_v<T, std::vector<uint8_t>>) {
-            auto* arr = proto_value.mutable_uint32_array();
-            for (uint8_t val : v) arr->add_values(static_cast<uint32_t>(val));
-        } else if constexpr (std::is_same_v<T, std::vector<int16_t>>) {
-            auto* arr = proto_value.mutable_int32_array();
-            for (int16_t val : v) arr->add_values(static_cast<int32_t>(val));
-        } else if constexpr (std::is_same_v<T, std::vector<uint16_t>>) {
-            auto* arr = proto_value.mutable_uint32_array();
-            for (uint16_t val : v) arr->add_values(static_cast<uint32_t>(val));
-        }
-        // Direct array types (no conversion)
-        else if constexpr (std::is_same_v<T, std::vector<bool>>) {
-            auto* arr = proto_value.mutable_bool_array();
-            for (bool val : v) arr->add_values(val);
-        } else if constexpr (std::is_same_v<T, std::vector<int32_t>>) {
-            auto* arr = proto_value.mutable_int32_array();
-            for (int32_t val : v) arr->add_values(val);
-        } else if constexpr (std::is_same_v<T, std::vector<uint32_t>>) {
-            auto* arr = proto_value.mutable_uint32_array();
-            for (uint32_t val : v) arr->add_values(val);
-        } else if constexpr (std::is_same_v<T, std::vector<int64_t>>) {
-            auto* arr = proto_value.mutable_int64_array();
-            for (int64_t val : v) arr->add_values(val);
-        } else if constexpr (std::is_same_v<T, std::vector<uint64_t>>) {
-            auto* arr = proto_value.mutable_uint64_array();
-            for (uint64_t val : v) arr->add_values(val);
-        } else if constexpr (std::is_same_v<T, std::vector<float>>) {
-            auto* arr = proto_value.mutable_float_array();
-            for (float val : v) arr->add_values(val);
-        } else if constexpr (std::is_same_v<T, std::vector<double>>) {
-            auto* arr = proto_value.mutable_double_array();
-            for (double val : v) arr->add_values(val);
-        } else if constexpr (std::is_same_v<T, std::vector<std::string>>) {
-            auto* arr = proto_value.mutable_string_array();
-            for (const auto& val : v) arr->add_values(val);
-        }
-    }, value);
-
-    return proto_value;
-}
-
-// Convert protobuf Value to vss::types::Value
-static vss::types::Value from_proto_value(const kuksa::val::v2::Value& proto_value) {
-    if (proto_value.has_bool_()) return proto_value.bool_();
-    if (proto_value.has_int32()) return proto_value.int32();
-    if (proto_value.has_uint32()) return proto_value.uint32();
-    if (proto_value.has_int64()) return proto_value.int64();
-    if (proto_value.has_uint64()) return proto_value.uint64();
-    if (proto_value.has_float_()) return proto_value.float_();
-    if (proto_value.has_double_()) return proto_value.double_();
-    if (proto_value.has_string()) return proto_value.string();
-
-    // Array types
-    if (proto_value.has_bool_array()) {
-        std::vector<bool> values;
-        for (bool v : proto_value.bool_array().values()) values.push_back(v);
-        return values;
-    }
-    if (proto_value.has_int32_array()) {
-        std::vector<int32_t> values;
-        for (int32_t v : proto_value.int32_array().values()) values.push_back(v);
-        return values;
-    }
-    if (proto_value.has_uint32_array()) {
-        std::vector<uint32_t> values;
-        for (uint32_t v : proto_value.uint32_array().values()) values.push_back(v);
-        return values;
-    }
-    if (proto_value.has_int64_array()) {
-        std::vector<int64_t> values;
-        for (int64_t v : proto_value.int64_array().values()) values.push_back(v);
-        return values;
-    }
-    if (proto_value.has_uint64_array()) {
-        std::vector<uint64_t> values;
-        for (uint64_t v : proto_value.uint64_array().values()) values.push_back(v);
-        return values;
-    }
-    if (proto_value.has_float_array()) {
-        std::vector<float> values;
-        for (float v : proto_value.float_array().values()) values.push_back(v);
-        return values;
-    }
-    if (proto_value.has_double_array()) {
-        std::vector<double> values;
-        for (double v : proto_value.double_array().values()) values.push_back(v);
-        return values;
-    }
-    if (proto_value.has_string_array()) {
-        std::vector<std::string> values;
-        for (const auto& v : proto_value.string_array().values()) values.push_back(v);
-        return values;
-    }
-
-    return vss::types::Value{std::monostate{}};  // Default to empty
-}
-
-// Convert protobuf datapoint to DynamicQualifiedValue (with quality inference)
-static vss::types::DynamicQualifiedValue datapoint_to_qualified_value(const Datapoint& dp) {
-    vss::types::DynamicQualifiedValue qvalue;
-
-    // Set timestamp
-    if (dp.has_timestamp()) {
-        auto seconds = dp.timestamp().seconds();
-        auto nanos = dp.timestamp().nanos();
-        qvalue.timestamp = std::chrono::system_clock::time_point(
-            std::chrono::seconds(seconds) + std::chrono::nanoseconds(nanos)
-        );
-    } else {
-        qvalue.timestamp = std::chrono::system_clock::now();
-    }
-
-    // Infer quality from presence of value
-    if (dp.has_value()) {
-        qvalue.value = from_proto_value(dp.value());
-        qvalue.quality = vss::types::SignalQuality::VALID;
-    } else {
-        qvalue.value = vss::types::Value{std::monostate{}};
-        qvalue.quality = vss::types::SignalQuality::NOT_AVAILABLE;
-    }
-
-    return qvalue;
-}
-
-// Convert QualifiedValue to protobuf Datapoint (with quality handling)
-static Datapoint qualified_value_to_datapoint(const vss::types::DynamicQualifiedValue& qvalue) {
-    Datapoint dp;
-
-    // Set timestamp
-    auto time_since_epoch = qvalue.timestamp.time_since_epoch();
-    auto seconds = std::chrono::duration_cast<std::chrono::seconds>(time_since_epoch);
-    auto nanos = std::chrono::duration_cast<std::chrono::nanoseconds>(time_since_epoch - seconds);
-    dp.mutable_timestamp()->set_seconds(seconds.count());
-    dp.mutable_timestamp()->set_nanos(nanos.count());
+class VSSClientImpl : public Client {
+    // One priority lane of a databroker, with the client's share of its subscriber stream
+    struct Lane {
+        std::shared_ptr<Channel> channel;  // null until the client uses the lane
+        std::shared_ptr<VAL::Stub> stub;
+        std::shared_ptr<SubscriptionHub> subscriptions;  // shared through the runtime
+        std::shared_ptr<SubscriptionHub::Membership> membership;
+    };
 
-    // Only set value if quality is VALID and value is not empty
-    if (qvalue.quality == vss::types::SignalQuality::VALID && !vss::types::is_empty(qvalue.value)) {
-        *dp.mutable_value() = to_proto_value(qvalue.value);
-    }
-    // Otherwise leave value unset (empty datapoint)
+    // A databroker, indexed by priority
+    struct Endpoint {
+        std::string address;
+        std::array<Lane, PRIORITY_COUNT> lanes;
+    };
 
-    return dp;
-}
+    static constexpr size_t NORMAL_LANE = static_cast<size_t>(Priority::NORMAL);
 
-// ============================================================================
-// Client Implementation
-// ============================================================================
-
-class VSSClientImpl : public Client {
 public:
-    explicit VSSClientImpl(const std::string& address)
-        : address_(address)
+    VSSClientImpl(const std::vector<std::string>& addresses, std::shared_ptr<Runtime> runtime,
+                  const FailoverOptions& options)
+        : runtime_(std::move(runtime))
+        , options_(options)
         , running_(false)
         , provider_sm_(std::make_unique<DatabrokerConnectionStateMachine>(
               "Provider",
               "REGISTERING",
               "STREAMING"
-          ))
-        , subscriber_sm_(std::make_unique<DatabrokerConnectionStateMachine>(
-              "Subscriber",
-              "SUBSCRIBING",
-              "STREAMING"
           )) {
+        for (const auto& address : addresses) {
+            endpoints_.push_back(Endpoint{address, {}});
+        }
     }
 
     ~VSSClientImpl() override {
         if (running_) {
             stop();
         }
+        // Loopback forwards are not tied to start()/stop()
+        wait_for_operations();
+
+        // Callbacks the application has not dispatched yet are dropped
+        if (callbacks_) {
+            callbacks_->close();
+        }
 
         // Clean up gRPC resources
-        // Release stub first, then channel - let smart pointers handle cleanup
+        // Release stub first, then channel, then hand the channel back to the pool
+        provider_stub_.reset();
+        provider_channel_.reset();
         stub_.reset();
         channel_.reset();
+        for (auto& endpoint : endpoints_) {
+            for (size_t lane = 0; lane < PRIORITY_COUNT; ++lane) {
+                auto& l = endpoint.lanes[lane];
+                if (!l.channel) continue;
+                l.subscriptions.reset();
+                l.stub.reset();
+                l.channel.reset();
+                runtime_->impl_->detach(endpoint.address, static_cast<Priority>(lane));
+            }
+        }
     }
 
     void initialize_connection() {
-        // Create single gRPC channel (shared by both streams)
-        channel_ = grpc::CreateChannel(address_, grpc::InsecureChannelCredentials());
-        stub_ = VAL::NewStub(channel_);
-        LOG(INFO) << "Created unified client for " << address_;
+        // One gRPC channel per databroker (shared by both streams and by other clients of the runtime)
+        for (auto& endpoint : endpoints_) {
+            attach_lane(endpoint, NORMAL_LANE);
+            LOG(INFO) << "Created unified client for " << endpoint.address;
+        }
+        // Never reassigned: get/set/publish read stub_ without a lock
+        channel_ = endpoints_.front().lanes[NORMAL_LANE].channel;
+        stub_ = endpoints_.front().lanes[NORMAL_LANE].stub;
     }
 
+    void attach_lane(Endpoint& endpoint, size_t lane) {
+        auto& l = endpoint.lanes[lane];
+        if (l.channel) return;
+        auto connection = runtime_->impl_->attach(endpoint.address, static_cast<Priority>(lane));
+        l.channel = connection.channel;
+        l.stub = connection.stub;
+        l.subscriptions = connection.subscriptions;
+    }
+
+
     // ========================================================================
     // Actuator/Sensor Registration
     // ========================================================================
@@ -355,10 +208,11 @@ public:
     }
 
     void clear_subscriptions() override {
-        std::lock_guard<std::mutex> lock(subscriptions_mutex_);
+        // Stop first: stream callbacks take subscriptions_mutex_
         if (running_) {
             stop();
         }
+        std::lock_guard<std::mutex> lock(subscriptions_mutex_);
         subscriptions_.clear();
         id_to_handle_.clear();
         LOG(INFO) << "Cleared all subscriptions";
@@ -369,6 +223,72 @@ public:
         return subscriptions_.size();
     }
 
+    // ========================================================================
+    // Event Loop Integration
+    // ========================================================================
+
+    Result<int> enable_event_fd() override {
+        auto status = check_callback_delivery();
+        if (!status.ok()) return status;
+
+        auto queue = CallbackQueue::with_event_fd();
+        if (!queue.ok()) return queue.status();
+        callbacks_ = std::move(*queue);
+        return callbacks_->fd();
+    }
+
+    Status set_executor(Executor executor) override {
+        if (!executor) {
+            return absl::InvalidArgumentError("Executor must not be empty");
+        }
+        auto status = check_callback_delivery();
+        if (!status.ok()) return status;
+
+        callbacks_ = CallbackQueue::with_executor(std::move(executor));
+        return absl::OkStatus();
+    }
+
+    size_t dispatch_pending(size_t max_callbacks) override {
+        // A callback may destroy the client; the queue outlives this dispatch
+        auto callbacks = callbacks_;
+        return callbacks ? callbacks->dispatch(max_callbacks) : 0;
+    }
+
+    Status check_callback_delivery() const {
+        if (running_) {
+            return absl::FailedPreconditionError("Cannot change callback delivery after client has started");
+        }
+        if (callbacks_) {
+            return absl::FailedPreconditionError("Callbacks are already handed to the application");
+        }
+        return absl::OkStatus();
+    }
+
+    // ========================================================================
+    // Priority Lanes
+    // ========================================================================
+
+    void set_priority_impl(int32_t signal_id, Priority priority) override {
+        if (running_.load()) {
+            throw std::logic_error("Cannot change priorities after client has started");
+        }
+
+        size_t lane = static_cast<size_t>(priority);
+        for (auto& endpoint : endpoints_) {
+            attach_lane(endpoint, lane);
+        }
+        std::lock_guard<std::mutex> lock(priorities_mutex_);
+        priorities_[signal_id] = lane;
+        has_priorities_ = true;
+    }
+
+    size_t lane_of(int32_t signal_id) const {
+        if (!has_priorities_) return NORMAL_LANE;
+        std::lock_guard<std::mutex> lock(priorities_mutex_);
+        auto it = priorities_.find(signal_id);
+        return it == priorities_.end() ? NORMAL_LANE : it->second;
+    }
+
     // ========================================================================
     // Synchronous Read/Write
     // ========================================================================
@@ -379,24 +299,44 @@ public:
     // and designed for concurrent use from multiple threads. See:
     // https://grpc.io/docs/languages/cpp/basics/#thread-safety
     //
-    // stub_ is set once during construction and never modified, so concurrent
-    // reads are safe. All RPC calls (GetValue, Actuate, PublishValue) use
-    // per-call ClientContext which is not shared across threads.
+    // stub_ is set once in initialize_connection() and never modified, so concurrent
+    // reads are safe. The provider stream uses provider_stub_ instead, which
+    // start() sets under stream_mutex_. All RPC calls (GetValue, Actuate,
+    // PublishValue) use per-call ClientContext which is not shared across threads.
+    //
+    // With several databrokers a call goes to the active endpoint and, if that
+    // one is unavailable, to the next.
+
+    /**
+     * @brief Run a blocking RPC on the active endpoint, falling over to the others
+     */
+    template<typename Call>
+    grpc::Status call_with_failover(size_t lane, Call call) {
+        grpc::Status grpc_status;
+        size_t first = active_.load();
+        for (size_t n = 0; n < endpoints_.size(); ++n) {
+            ClientContext context;
+            // Set a deadline to prevent hanging forever on slow/stuck RPCs
+            context.set_deadline(std::chrono::system_clock::now() + std::chrono::seconds(5));
+
+            grpc_status = call(*endpoints_[(first + n) % endpoints_.size()].lanes[lane].stub, context);
+            if (grpc_status.error_code() != grpc::StatusCode::UNAVAILABLE) break;
+        }
+        return grpc_status;
+    }
 
     Result<vss::types::DynamicQualifiedValue> get_impl(int32_t signal_id) override {
         if (!stub_) {
             return absl::FailedPreconditionError("Not connected to databroker");
         }
 
-        ClientContext context;
-        // Set a deadline to prevent hanging forever on slow/stuck RPCs
-        context.set_deadline(std::chrono::system_clock::now() + std::chrono::seconds(5));
-
         GetValueRequest request;
         request.mutable_signal_id()->set_id(signal_id);
 
         GetValueResponse response;
-        grpc::Status grpc_status = stub_->GetValue(&context, request, &response);
+        grpc::Status grpc_status = call_with_failover(lane_of(signal_id), [&](VAL::Stub& stub, ClientContext& context) {
+            return stub.GetValue(&context, request, &response);
+        });
 
         if (!grpc_status.ok()) {
             return absl::Status(
@@ -437,16 +377,14 @@ public:
         using kuksa::val::v2::ActuateRequest;
         using kuksa::val::v2::ActuateResponse;
 
-        ClientContext context;
-        // Set a deadline to prevent hanging forever on slow/stuck RPCs
-        context.set_deadline(std::chrono::system_clock::now() + std::chrono::seconds(5));
-
         ActuateRequest request;
         request.mutable_signal_id()->set_id(signal_id);
         *request.mutable_value() = to_proto_value(value);
 
         ActuateResponse response;
-        grpc::Status grpc_status = stub_->Actuate(&context, request, &response);
+        grpc::Status grpc_status = call_with_failover(lane_of(signal_id), [&](VAL::Stub& stub, ClientContext& context) {
+            return stub.Actuate(&context, request, &response);
+        });
 
         if (!grpc_status.ok()) {
             return absl::Status(
@@ -468,9 +406,18 @@ public:
             return absl::FailedPreconditionError("Not connected to databroker");
         }
 
-        ClientContext context;
-        // Set a deadline to prevent hanging forever on slow/stuck RPCs
-        context.set_deadline(std::chrono::system_clock::now() + std::chrono::seconds(5));
+        // Shared memory: subscribers in other processes on this host get the value directly,
+        // before the databroker accepted it (see Runtime); the result below is the publisher's
+        if (auto* shared_memory = runtime_->impl_->shared_memory()) {
+            shared_memory->write(signal_id, qvalue);
+        }
+
+        size_t lane = lane_of(signal_id);
+
+        // Loopback: local subscribers get the value directly, the databroker(s) asynchronously
+        if (runtime_->impl_->loopback() && loop_back(signal_id, qvalue, lane)) {
+            return absl::OkStatus();
+        }
 
         PublishValueRequest request;
         auto* sig_id = request.mutable_signal_id();
@@ -479,8 +426,15 @@ public:
         // Convert QualifiedValue to protobuf Datapoint (with quality handling)
         *request.mutable_data_point() = qualified_value_to_datapoint(qvalue);
 
-        PublishValueResponse response;
-        grpc::Status grpc_status = stub_->PublishValue(&context, request, &response);
+        grpc::Status grpc_status;
+        if (options_.publish_to_all && endpoints_.size() > 1) {
+            grpc_status = publish_to_all(request, lane);
+        } else {
+            PublishValueResponse response;
+            grpc_status = call_with_failover(lane, [&](VAL::Stub& stub, ClientContext& context) {
+                return stub.PublishValue(&context, request, &response);
+            });
+        }
 
         if (!grpc_status.ok()) {
             LOG(ERROR) << "Failed to publish signal ID " << signal_id << ": " << grpc_status.error_message();
@@ -494,17 +448,106 @@ public:
         return absl::OkStatus();
     }
 
+    /**
+     * @brief Publish to every databroker at once; OK if at least one accepted
+     */
+    grpc::Status publish_to_all(const PublishValueRequest& request, size_t lane) {
+        struct Call {
+            ClientContext context;
+            PublishValueResponse response;
+            grpc::Status status;
+        };
+        std::vector<Call> calls(endpoints_.size());
+        std::mutex mutex;
+        std::condition_variable done;
+        size_t pending = calls.size();
+
+        for (size_t i = 0; i < calls.size(); ++i) {
+            calls[i].context.set_deadline(std::chrono::system_clock::now() + std::chrono::seconds(5));
+            endpoints_[i].lanes[lane].stub->async()->PublishValue(
+                &calls[i].context, &request, &calls[i].response,
+                [&, i](grpc::Status status) {
+                    std::lock_guard<std::mutex> lock(mutex);
+                    calls[i].status = std::move(status);
+                    if (--pending == 0) done.notify_all();
+                });
+        }
+
+        std::unique_lock<std::mutex> lock(mutex);
+        done.wait(lock, [&pending]() { return pending == 0; });
+
+        for (size_t i = 0; i < calls.size(); ++i) {
+            if (!calls[i].status.ok()) {
+                LOG(WARNING) << "Publish to " << endpoints_[i].address << " failed: "
+                             << calls[i].status.error_message();
+            }
+        }
+        for (const auto& call : calls) {
+            if (call.status.ok()) return call.status;
+        }
+        return calls.front().status;
+    }
+
+    /**
+     * @brief Hand value to the local subscribers on every lane, then forward it
+     *
+     * @return false if no client of the runtime subscribes to signal_id
+     */
+    bool loop_back(int32_t signal_id, const vss::types::DynamicQualifiedValue& qvalue, size_t lane) {
+        // Other clients may subscribe to the signal on another lane
+        auto& active = endpoints_[active_.load()];
+        std::vector<std::shared_ptr<SubscriptionHub>> looped;
+        for (auto& hub : runtime_->impl_->hubs(active.address)) {
+            if (hub->loop_back(signal_id, qvalue)) {
+                looped.push_back(std::move(hub));
+            }
+        }
+        if (looped.empty()) {
+            return false;
+        }
+
+        auto datapoint = qualified_value_to_datapoint(qvalue);
+        // The databroker sends the value back on the subscription streams; it was delivered already
+        for (const auto& hub : looped) {
+            hub->expect_echo(signal_id, datapoint);
+        }
+        for (auto& endpoint : endpoints_) {
+            if (options_.publish_to_all || &endpoint == &active) {
+                forward_async(*endpoint.lanes[lane].stub, signal_id, datapoint);
+            }
+        }
+        return true;
+    }
+
+    void forward_async(VAL::Stub& stub, int32_t signal_id, Datapoint datapoint) {
+        PublishValueRequest request;
+        request.mutable_signal_id()->set_id(signal_id);
+        *request.mutable_data_point() = std::move(datapoint);
+
+        std::lock_guard<std::mutex> lock(stream_mutex_);
+        call_async_locked<PublishValueRequest, PublishValueResponse>(
+            stub, &VAL::Stub::PrepareAsyncPublishValue, std::move(request),
+            [signal_id](std::unique_lock<std::mutex>&, const grpc::Status& status, const PublishValueResponse&) {
+                if (!status.ok()) {
+                    LOG(ERROR) << "Failed to forward signal ID " << signal_id << ": " << status.error_message();
+                }
+            });
+    }
+
     Status publish_batch_impl(
         const std::map<int32_t, vss::types::DynamicQualifiedValue>& values,
         std::function<void(const std::map<int32_t, absl::Status>&)> callback) override {
 
-        // Publish each value using standalone RPC
+        // Publish each value using standalone RPC, highest priority first
         std::map<int32_t, absl::Status> errors;
 
-        for (const auto& [signal_id, value] : values) {
-            auto status = publish_impl(signal_id, value);
-            if (!status.ok()) {
-                errors[signal_id] = status;
+        for (size_t lane = 0; lane < PRIORITY_COUNT; ++lane) {
+            for (const auto& [signal_id, value] : values) {
+                if (lane_of(signal_id) != lane) continue;
+                auto status = publish_impl(signal_id, value);
+                if (!status.ok()) {
+                    errors[signal_id] = status;
+                }
             }
         }
 
@@ -521,21 +564,30 @@ public:
     // ========================================================================
 
     Status start() override {
+        std::lock_guard<std::mutex> lock(stream_mutex_);
         if (running_) {
             return absl::FailedPreconditionError("Client is already running");
         }
 
         running_ = true;
 
-        // Start provider thread only if we have actuators
+        // Provider stream only if we have actuators
         // (Publishing uses standalone PublishValue RPCs, not the provider stream)
         if (!actuator_handlers_.empty()) {
-            provider_thread_ = std::thread([this]() { provider_loop(); });
+            // On the lane of the most critical actuator
+            size_t lane = PRIORITY_COUNT - 1;
+            for (const auto& handler : actuator_handlers_) {
+                lane = std::min(lane, lane_of(handler.signal_id));
+            }
+            attach_lane(endpoints_.front(), lane);
+            provider_channel_ = endpoints_.front().lanes[lane].channel;
+            provider_stub_ = endpoints_.front().lanes[lane].stub;
+            start_provider_locked();
         }
 
-        // Start subscriber thread (if we have subscriptions)
+        // Subscriber stream (if we have subscriptions), multiplexed by the runtime
         if (!subscriptions_.empty()) {
-            subscriber_thread_ = std::thread([this]() { subscriber_loop(); });
+            start_subscriptions();
         }
 
         LOG(INFO) << "Unified client started (actuators="
@@ -546,18 +598,30 @@ public:
     }
 
     void stop() override {
-        if (!running_) return;
+        {
+            std::lock_guard<std::mutex> lock(stream_mutex_);
+            if (!running_) return;
 
-        LOG(INFO) << "Stopping unified client";
-        running_ = false;
+            LOG(INFO) << "Stopping unified client";
+            running_ = false;
 
-        // Cancel contexts
-        if (provider_context_) provider_context_->TryCancel();
-        if (subscriber_context_) subscriber_context_->TryCancel();
+            // Cancel contexts; their operations complete promptly
+            for (auto* context : contexts_) {
+                context->TryCancel();
+            }
+        }
+
+        // Streams no other client needs are cancelled; no callback runs after this
+        joined_ = false;
+        for (auto& endpoint : endpoints_) {
+            for (auto& lane : endpoint.lanes) {
+                if (lane.membership) {
+                    lane.subscriptions->leave(lane.membership);
+                }
+            }
+        }
 
-        // Join threads
-        if (provider_thread_.joinable()) provider_thread_.join();
-        if (subscriber_thread_.joinable()) subscriber_thread_.join();
+        wait_for_operations();
 
         LOG(INFO) << "Unified client stopped";
     }
@@ -575,7 +639,9 @@ public:
 
         // If we have subscriptions, subscriber must be OK
         if (!subscriptions_.empty()) {
-            auto subscriber_status = subscriber_sm_->status();
+            auto subscriber_status = running_ && joined_
+                ? subscription_status()
+                : absl::FailedPreconditionError("Subscriber not started");
             if (!subscriber_status.ok()) return subscriber_status;
         }
 
@@ -601,7 +667,9 @@ public:
         if (!subscriptions_.empty()) {
             auto remaining = std::chrono::duration_cast<std::chrono::milliseconds>(
                 deadline - std::chrono::steady_clock::now());
-            auto status = subscriber_sm_->wait_until_active(remaining);
+            auto status = endpoints_.size() == 1
+                ? wait_for_lanes(endpoints_.front(), deadline)
+                : wait_for_any_subscription(deadline);
             if (!status.ok()) return status;
         }
 
@@ -609,75 +677,167 @@ public:
     }
 
 private:
+    struct ActuatorRegistration {
+        std::string path;
+        int32_t signal_id;       // Already resolved from handle
+        vss::types::ValueType type;
+        std::function<void(const vss::types::Value&)> handler;  // Handle already captured in closure
+    };
+
     // ========================================================================
-    // Provider Stream Thread
+    // Runtime Operations
     // ========================================================================
+    //
+    // Both streams are chains of asynchronous operations on the runtime's
+    // completion queue: each completion starts the next operation. Methods
+    // ending in _locked expect stream_mutex_ to be held; user callbacks are
+    // always invoked without it.
+
+    /**
+     * @brief Wrap a handler into a runtime tag that stop() waits for
+     */
+    void* completion(std::function<void(bool)> handler) {
+        {
+            std::lock_guard<std::mutex> lock(operations_mutex_);
+            ++pending_operations_;
+        }
+        return Runtime::Impl::tag([this, handler = std::move(handler)](bool ok) {
+            handler(ok);
+            std::lock_guard<std::mutex> lock(operations_mutex_);
+            if (--pending_operations_ == 0) {
+                operations_done_.notify_all();
+            }
+        });
+    }
 
-    void provider_loop() {
+    /**
+     * @brief Wait for the runtime to run every outstanding completion
+     */
+    void wait_for_operations() {
+        std::unique_lock<std::mutex> lock(operations_mutex_);
+        operations_done_.wait(lock, [this]() { return pending_operations_ == 0; });
+    }
+
+    template<typename Response>
+    using UnaryDone = std::function<void(std::unique_lock<std::mutex>&, const grpc::Status&, const Response&)>;
+
+    /**
+     * @brief Run a unary RPC on the runtime; done is called with stream_mutex_ held
+     */
+    template<typename Request, typename Response, typename Prepare>
+    void call_async_locked(VAL::Stub& stub, Prepare prepare, Request request, UnaryDone<Response> done) {
+        auto call = std::make_shared<Runtime::Impl::UnaryCall<Request, Response>>();
+        call->request = std::move(request);
+        contexts_.insert(&call->context);
+
+        runtime_->impl_->start_unary(stub, prepare, *call, completion([this, call, done](bool) {
+            std::unique_lock<std::mutex> lock(stream_mutex_);
+            contexts_.erase(&call->context);
+            done(lock, call->status, call->response);
+        }));
+    }
+
+    // ========================================================================
+    // Provider Stream
+    // ========================================================================
+
+    void start_provider_locked() {
         provider_sm_->trigger_start();
-        LOG(INFO) << "Provider stream thread started";
+        LOG(INFO) << "Provider stream started";
 
         // Step 1: Validate all actuators (signal_id already resolved from handle)
-        std::vector<std::string> errors;
+        pending_validations_ = actuator_handlers_.size();
+        validation_errors_.assign(actuator_handlers_.size(), std::string());
+
+        for (size_t i = 0; i < actuator_handlers_.size(); ++i) {
+            ListMetadataRequest request;
+            request.set_root(actuator_handlers_[i].path);
+            call_async_locked<ListMetadataRequest, ListMetadataResponse>(
+                *provider_stub_, &VAL::Stub::PrepareAsyncListMetadata, std::move(request),
+                [this, i](std::unique_lock<std::mutex>&, const grpc::Status& status,
+                          const ListMetadataResponse& response) {
+                    validation_errors_[i] = validate_actuator(actuator_handlers_[i], status, response);
+                    if (--pending_validations_ == 0) {
+                        open_provider_stream_locked();
+                    }
+                });
+        }
+    }
 
-        // Validate that all actuators exist and types match
-        for (const auto& handler : actuator_handlers_) {
-            auto metadata = query_signal_metadata(handler.path);
+    std::string validate_actuator(const ActuatorRegistration& handler,
+                                  const grpc::Status& status,
+                                  const ListMetadataResponse& response) {
+        if (!status.ok()) {
+            LOG(ERROR) << "Failed to query metadata for " << handler.path;
+        }
+        auto metadata = status.ok() ? find_signal_metadata(handler.path, response) : SignalMetadata{};
 
-            if (metadata.id <= 0) {
-                errors.push_back(absl::StrFormat("  - %s: Signal not found in VSS", handler.path));
-                continue;
-            }
+        if (metadata.id <= 0) {
+            return absl::StrFormat("  - %s: Signal not found in VSS", handler.path);
+        }
 
-            // Verify signal_id matches what resolver gave us
-            if (metadata.id != handler.signal_id) {
-                errors.push_back(absl::StrFormat("  - %s: Signal ID mismatch (expected %d, got %d)",
-                    handler.path, handler.signal_id, metadata.id));
-                continue;
-            }
+        // Verify signal_id matches what resolver gave us
+        if (metadata.id != handler.signal_id) {
+            return absl::StrFormat("  - %s: Signal ID mismatch (expected %d, got %d)",
+                handler.path, handler.signal_id, metadata.id);
+        }
 
-            if (metadata.type == vss::types::ValueType::UNSPECIFIED) {
-                errors.push_back(absl::StrFormat("  - %s: No type metadata", handler.path));
-                continue;
-            }
+        if (metadata.type == vss::types::ValueType::UNSPECIFIED) {
+            return absl::StrFormat("  - %s: No type metadata", handler.path);
+        }
 
-            if (!vss::types::are_types_compatible(handler.type, metadata.type)) {
-                errors.push_back(absl::StrFormat("  - %s: Type mismatch (expected %s, got %s)",
-                    handler.path,
-                    vss::types::value_type_to_string(handler.type),
-                    vss::types::value_type_to_string(metadata.type)));
-                continue;
-            }
+        if (!vss::types::are_types_compatible(handler.type, metadata.type)) {
+            return absl::StrFormat("  - %s: Type mismatch (expected %s, got %s)",
+                handler.path,
+                vss::types::value_type_to_string(handler.type),
+                vss::types::value_type_to_string(metadata.type));
         }
+        return std::string();
+    }
 
+    void open_provider_stream_locked() {
+        if (!running_) {
+            provider_sm_->trigger_stop();
+            return;
+        }
+
+        std::vector<std::string> errors;
+        for (auto& error : validation_errors_) {
+            if (!error.empty()) {
+                errors.push_back(std::move(error));
+            }
+        }
         if (!errors.empty()) {
             std::string error_msg = absl::StrFormat("Actuator validation failed:\n%s", absl::StrJoin(errors, "\n"));
             LOG(ERROR) << error_msg;
+            // The broker answered, so this is a permanent stream failure: stay FAILED
+            // so that wait_until_ready() reports it instead of timing out
+            provider_sm_->trigger_channel_ready();
             provider_sm_->trigger_stream_failed(absl::InvalidArgumentError(error_msg), false);
-            provider_sm_->trigger_stop();
             return;
         }
 
-        if (!actuator_handlers_.empty()) {
-            LOG(INFO) << "All actuators validated successfully";
-        } else {
-            LOG(INFO) << "No actuators to validate (sensor-only mode)";
-        }
-
+        LOG(INFO) << "All actuators validated successfully";
         provider_sm_->trigger_channel_ready();
 
         // Step 2: Open provider stream
         provider_context_ = std::make_unique<ClientContext>();
-        auto stream = stub_->OpenProviderStream(provider_context_.get());
-        if (!stream) {
-            LOG(ERROR) << "Failed to open provider stream";
-            provider_sm_->trigger_stream_failed(absl::UnavailableError("Failed to open stream"), true);
-            provider_sm_->trigger_stop();
-            return;
-        }
+        contexts_.insert(provider_context_.get());
+        provider_ready_ = false;
+        provider_writing_ = false;
+        provider_finish_pending_ = false;
+        provider_writes_.clear();
+
+        provider_stream_ = provider_stub_->PrepareAsyncOpenProviderStream(provider_context_.get(), runtime_->impl_->queue());
+        runtime_->impl_->stream_opened();
+        provider_stream_->StartCall(completion([this](bool ok) {
+            std::lock_guard<std::mutex> lock(stream_mutex_);
+            if (!ok || !running_) {
+                finish_provider_locked();
+                return;
+            }
 
-        // Step 3: Register actuators (if we have any)
-        if (!actuator_handlers_.empty()) {
+            // Step 3: Register actuators
             OpenProviderStreamRequest request;
             auto* provide_req = request.mutable_provide_actuation_request();
             for (const auto& handler : actuator_handlers_) {
@@ -685,53 +845,108 @@ private:
                 signal_id->set_id(handler.signal_id);
                 signal_id->set_path(handler.path);
             }
-            if (!stream->Write(request)) {
-                LOG(ERROR) << "Failed to register actuators";
-                provider_sm_->trigger_stream_failed(absl::UnavailableError("Write failed"), true);
-                provider_sm_->trigger_stop();
-                return;
-            }
+            write_provider_locked(std::move(request));
             LOG(INFO) << "Sent registration for " << actuator_handlers_.size() << " actuator(s)";
-        }
 
-        // Step 4: Wait for responses and handle actuation requests
-        bool ready = actuator_handlers_.empty();  // If no actuators, we're ready immediately
+            // Step 4: Wait for responses and handle actuation requests
+            read_provider_locked();
+        }));
+    }
 
-        // Mark as ready if no registration sent
-        if (ready) {
-            LOG(INFO) << "Provider stream ready (no actuators registered)";
-            provider_sm_->trigger_stream_ready();
-        }
+    void read_provider_locked() {
+        provider_stream_->Read(&provider_response_, completion([this](bool ok) {
+            std::unique_lock<std::mutex> lock(stream_mutex_);
+            if (!ok || !running_) {
+                finish_provider_locked();
+                return;
+            }
 
-        // Read responses
-        OpenProviderStreamResponse response;
-        while (running_ && stream->Read(&response)) {
-            if (response.has_provide_actuation_response()) {
-                if (!ready) {
+            if (provider_response_.has_provide_actuation_response()) {
+                if (!provider_ready_) {
                     LOG(INFO) << "Actuator registration confirmed";
-                    ready = true;
+                    provider_ready_ = true;
                     provider_sm_->trigger_stream_ready();
                 }
-            } else if (response.has_batch_actuate_stream_request()) {
-                handle_actuation_request(response.batch_actuate_stream_request(), stream.get());
+            } else if (provider_response_.has_batch_actuate_stream_request()) {
+                lock.unlock();
+                handle_actuation_request(provider_response_.batch_actuate_stream_request());
+                lock.lock();
+
+                // Send response
+                if (running_) {
+                    OpenProviderStreamRequest stream_req;
+                    stream_req.mutable_batch_actuate_stream_response();
+                    write_provider_locked(std::move(stream_req));
+                }
             }
-        }
 
-        auto grpc_finish_status = stream->Finish();
-        if (running_ && grpc_finish_status.error_code() != grpc::StatusCode::CANCELLED) {
-            LOG(ERROR) << "Provider stream ended: " << grpc_finish_status.error_message();
-            provider_sm_->trigger_stream_ended(absl::UnavailableError(grpc_finish_status.error_message()));
-        } else {
-            provider_sm_->trigger_stop();
+            if (!running_) {
+                finish_provider_locked();
+                return;
+            }
+            read_provider_locked();
+        }));
+    }
+
+    // gRPC allows one outstanding write per stream; later writes queue up
+    void write_provider_locked(OpenProviderStreamRequest request) {
+        provider_writes_.push_back(std::move(request));
+        if (!provider_writing_) {
+            next_provider_write_locked();
         }
+    }
 
-        LOG(INFO) << "Provider stream thread ended";
+    void next_provider_write_locked() {
+        provider_writing_ = true;
+        provider_write_ = std::move(provider_writes_.front());
+        provider_writes_.pop_front();
+
+        provider_stream_->Write(provider_write_, completion([this](bool ok) {
+            std::lock_guard<std::mutex> lock(stream_mutex_);
+            provider_writing_ = false;
+            if (!ok) {
+                // The read side sees the broken stream as well and finishes it
+                LOG(ERROR) << "Provider stream write failed";
+                provider_writes_.clear();
+            }
+            if (provider_finish_pending_) {
+                finish_provider_locked();
+            } else if (!provider_writes_.empty()) {
+                next_provider_write_locked();
+            }
+        }));
     }
 
-    void handle_actuation_request(
-        const BatchActuateStreamRequest& request,
-        grpc::ClientReaderWriter<OpenProviderStreamRequest, OpenProviderStreamResponse>* stream) {
+    void finish_provider_locked() {
+        // Finish() must not overlap a write
+        if (provider_writing_) {
+            provider_finish_pending_ = true;
+            return;
+        }
+        provider_finish_pending_ = false;
+
+        provider_stream_->Finish(&provider_status_, completion([this](bool) {
+            std::lock_guard<std::mutex> lock(stream_mutex_);
+            contexts_.erase(provider_context_.get());
+            runtime_->impl_->stream_closed();
+
+            if (running_ && provider_status_.error_code() != grpc::StatusCode::CANCELLED) {
+                LOG(ERROR) << "Provider stream ended: " << provider_status_.error_message();
+                auto error = absl::UnavailableError(provider_status_.error_message());
+                if (provider_ready_) {
+                    provider_sm_->trigger_stream_ended(error);
+                } else {
+                    provider_sm_->trigger_stream_failed(error, true);
+                }
+            } else {
+                provider_sm_->trigger_stop();
+            }
 
+            LOG(INFO) << "Provider stream ended";
+        }));
+    }
+
+    void handle_actuation_request(const BatchActuateStreamRequest& request) {
         LOG(INFO) << "Received " << request.actuate_requests_size() << " actuation request(s)";
 
         for (const auto& actuate_req : request.actuate_requests()) {
@@ -743,7 +958,11 @@ private:
             for (const auto& handler : actuator_handlers_) {
                 if (handler.signal_id == signal_id) {
                     // Call handler (handle already captured in closure)
-                    handler.handler(target_value);
+                    if (callbacks_) {
+                        callbacks_->push([handler = handler.handler, target_value]() { handler(target_value); });
+                    } else {
+                        handler.handler(target_value);
+                    }
                     found = true;
                     break;
                 }
@@ -753,121 +972,137 @@ private:
                 LOG(WARNING) << "No handler registered for signal ID: " << signal_id;
             }
         }
-
-        // Send response
-        if (running_) {
-            OpenProviderStreamRequest stream_req;
-            auto* response = stream_req.mutable_batch_actuate_stream_response();
-            stream->Write(stream_req);
-        }
     }
 
     // ========================================================================
-    // Subscriber Stream Thread
+    // Subscriptions
     // ========================================================================
 
-    void subscriber_loop() {
-        subscriber_sm_->trigger_start();
-        LOG(INFO) << "Subscriber stream thread started";
-
-        int retry_attempt = 0;
-        const int MAX_RETRY_DELAY_MS = 30000;
-
-        while (running_) {
-            if (retry_attempt > 0) {
-                subscriber_sm_->trigger_retry();
-
-                // Exponential backoff
-                int delay_ms = std::min(100 * (1 << (retry_attempt - 1)), MAX_RETRY_DELAY_MS);
-                LOG(INFO) << "Waiting " << delay_ms << "ms before reconnection";
-
-                auto sleep_until = std::chrono::steady_clock::now() + std::chrono::milliseconds(delay_ms);
-                while (running_ && std::chrono::steady_clock::now() < sleep_until) {
-                    std::this_thread::sleep_for(std::chrono::milliseconds(100));
-                }
-                if (!running_) break;
-            }
-
-            // Wait for channel
-            auto deadline = std::chrono::system_clock::now() + std::chrono::seconds(5);
-            if (!channel_->WaitForConnected(deadline)) {
-                LOG(WARNING) << "Subscriber connection timeout";
-                subscriber_sm_->trigger_connect_failed(absl::UnavailableError("Connection timeout"));
-                retry_attempt++;
-                continue;
+    void start_subscriptions() {
+        std::array<std::vector<int32_t>, PRIORITY_COUNT> signal_ids;
+        {
+            std::lock_guard<std::mutex> lock(subscriptions_mutex_);
+            for (const auto& [signal_id, _] : subscriptions_) {
+                signal_ids[lane_of(signal_id)].push_back(signal_id);
             }
-
-            subscriber_sm_->trigger_channel_ready();
-
-            // Create subscription
-            subscriber_context_ = std::make_unique<ClientContext>();
-            SubscribeByIdRequest request;
-
-            {
-                std::lock_guard<std::mutex> lock(subscriptions_mutex_);
-                for (const auto& [id, _] : subscriptions_) {
-                    request.add_signal_ids(id);
-                }
+        }
+        // Signals other clients already stream are not subscribed again. Standby
+        // databrokers are subscribed too, so failing over needs no new stream.
+        for (size_t i = 0; i < endpoints_.size(); ++i) {
+            for (size_t lane = 0; lane < PRIORITY_COUNT; ++lane) {
+                auto& l = endpoints_[i].lanes[lane];
+                l.membership.reset();  // left by stop()
+                if (signal_ids[lane].empty()) continue;
+                l.membership = l.subscriptions->join(
+                    signal_ids[lane],
+                    [this, i](int32_t signal_id, const vss::types::DynamicQualifiedValue& value) {
+                        if (is_active(i)) {
+                            handle_subscription_update(signal_id, value);
+                        }
+                    },
+                    [this, i]() { endpoint_down(i); });
             }
+        }
+        joined_ = true;
+    }
 
-            auto reader = stub_->SubscribeById(subscriber_context_.get(), request);
+    /**
+     * @brief Whether updates from endpoint i are delivered, failing over to it if needed
+     *
+     * The active endpoint's updates are delivered. Another endpoint that
+     * sends an update takes over if it is preferred (earlier in the list) or
+     * the active endpoint's subscription is down; duplicates from healthy
+     * standbys are dropped.
+     */
+    bool is_active(size_t i) {
+        size_t active = active_.load();
+        if (i == active) return true;
+        if (!joined_) return false;
+        if (i > active && endpoint_status(endpoints_[active]).ok()) {
+            return false;
+        }
+        if (!active_.compare_exchange_strong(active, i) && active != i) {
+            return false;
+        }
+        LOG(WARNING) << "Switching subscriptions from " << endpoints_[active].address
+                     << " to " << endpoints_[i].address;
+        return true;
+    }
 
-            // Fetch initial values
-            if (!fetch_initial_values()) {
-                subscriber_sm_->trigger_stream_failed(
-                    absl::FailedPreconditionError("Failed to fetch initial values"), false);
-                retry_attempt++;
+    /**
+     * @brief Switch to the first healthy standby when the active endpoint's stream fails
+     *
+     * The standby's latest values are delivered at once, so updates it sent
+     * while the failure went unnoticed are not lost.
+     */
+    void endpoint_down(size_t i) {
+        if (!joined_) return;
+        for (size_t j = 0; j < endpoints_.size(); ++j) {
+            if (j == i || !endpoint_status(endpoints_[j]).ok()) {
                 continue;
             }
-
-            subscriber_sm_->trigger_stream_ready();
-
-            // Read subscription updates
-            SubscribeByIdResponse response;
-            bool stream_ok = true;
-            while (running_ && stream_ok) {
-                stream_ok = reader->Read(&response);
-                if (stream_ok) {
-                    retry_attempt = 0;
-                    for (const auto& [signal_id, datapoint] : response.entries()) {
-                        handle_subscription_update(signal_id, datapoint);
+            size_t active = i;
+            if (active_.compare_exchange_strong(active, j)) {
+                LOG(WARNING) << "Switching subscriptions from " << endpoints_[i].address
+                             << " to " << endpoints_[j].address;
+                for (auto& lane : endpoints_[j].lanes) {
+                    if (lane.membership) {
+                        lane.subscriptions->replay(lane.membership);
                     }
                 }
             }
-
-            auto grpc_finish_status = reader->Finish();
-            if (!running_) break;
-
-            LOG(WARNING) << "Subscription stream ended: " << grpc_finish_status.error_message();
-            subscriber_sm_->trigger_stream_ended(absl::UnavailableError(grpc_finish_status.error_message()));
-            retry_attempt++;
+            return;
         }
-
-        subscriber_sm_->trigger_stop();
-        LOG(INFO) << "Subscriber stream thread ended";
     }
 
-    bool fetch_initial_values() {
-        std::vector<std::pair<int32_t, Datapoint>> initial_values;
+    /**
+     * @brief OK if the subscriptions are up on any endpoint
+     */
+    Status subscription_status() const {
+        Status first_error;
+        for (const auto& endpoint : endpoints_) {
+            auto status = endpoint_status(endpoint);
+            if (status.ok()) return status;
+            if (first_error.ok()) first_error = status;
+        }
+        return first_error;
+    }
 
-        {
-            std::lock_guard<std::mutex> lock(subscriptions_mutex_);
-            for (const auto& [signal_id, _] : subscriptions_) {
-                auto value = get_current_value(signal_id);
-                if (value && value->has_timestamp()) {
-                    initial_values.push_back({signal_id, *value});
-                }
+    /**
+     * @brief First non-OK status of endpoint's lanes
+     */
+    static Status endpoint_status(const Endpoint& endpoint) {
+        for (const auto& lane : endpoint.lanes) {
+            if (lane.membership) {
+                auto status = lane.subscriptions->status(*lane.membership);
+                if (!status.ok()) return status;
             }
         }
+        return absl::OkStatus();
+    }
 
-        for (const auto& [signal_id, datapoint] : initial_values) {
-            handle_subscription_update(signal_id, datapoint);
+    static Status wait_for_lanes(const Endpoint& endpoint, std::chrono::steady_clock::time_point deadline) {
+        for (const auto& lane : endpoint.lanes) {
+            if (!lane.membership) continue;
+            auto remaining = std::chrono::duration_cast<std::chrono::milliseconds>(
+                deadline - std::chrono::steady_clock::now());
+            auto status = lane.subscriptions->wait_until_active(*lane.membership, remaining);
+            if (!status.ok()) return status;
         }
+        return absl::OkStatus();
+    }
 
-        return true;
+    Status wait_for_any_subscription(std::chrono::steady_clock::time_point deadline) const {
+        while (true) {
+            if (subscription_status().ok()) return absl::OkStatus();
+            if (std::chrono::steady_clock::now() >= deadline) {
+                return absl::DeadlineExceededError("Timeout waiting for Subscriber to become active");
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        }
     }
 
-    void handle_subscription_update(int32_t signal_id, const Datapoint& datapoint) {
+    void handle_subscription_update(int32_t signal_id, const vss::types::DynamicQualifiedValue& value) {
         std::function<void(const vss::types::DynamicQualifiedValue&)> callback;
         std::shared_ptr<DynamicSignalHandle> handle;
 
@@ -883,38 +1118,34 @@ private:
             }
         }
 
-        if (callback) {
-            try {
-                auto qvalue = datapoint_to_qualified_value(datapoint);
+        if (!callback) {
+            return;
+        }
 
-                // Narrow value to signal's registered metadata type if needed
-                if (handle) {
-                    qvalue = vss::types::convert_qualified_value_type(qvalue, handle->type());
+        if (callbacks_) {
+            // Converted here, run on the application's loop
+            callbacks_->push([callback = std::move(callback), signal_id,
+                              value = handle ? vss::types::convert_qualified_value_type(value, handle->type())
+                                             : value]() {
+                try {
+                    callback(value);
+                } catch (const std::exception& e) {
+                    LOG(ERROR) << "Exception in subscription callback for ID " << signal_id << ": " << e.what();
                 }
-
-                callback(qvalue);
-            } catch (const std::exception& e) {
-                LOG(ERROR) << "Exception in subscription callback for ID " << signal_id << ": " << e.what();
-            }
+            });
+            return;
         }
-    }
-
-    std::optional<Datapoint> get_current_value(int32_t signal_id) {
-        ClientContext context;
-        // Set a deadline to prevent hanging forever on slow/stuck RPCs
-        context.set_deadline(std::chrono::system_clock::now() + std::chrono::seconds(5));
-
-        GetValueRequest request;
-        request.mutable_signal_id()->set_id(signal_id);
-
-        GetValueResponse response;
-        grpc::Status grpc_status = stub_->GetValue(&context, request, &response);
 
-        if (!grpc_status.ok()) {
-            return std::nullopt;
+        try {
+            // Narrow value to signal's registered metadata type if needed
+            if (handle) {
+                callback(vss::types::convert_qualified_value_type(value, handle->type()));
+            } else {
+                callback(value);
+            }
+        } catch (const std::exception& e) {
+            LOG(ERROR) << "Exception in subscription callback for ID " << signal_id << ": " << e.what();
         }
-
-        return response.data_point();
     }
 
     // ========================================================================
@@ -926,22 +1157,7 @@ private:
         vss::types::ValueType type = vss::types::ValueType::UNSPECIFIED;
     };
 
-    SignalMetadata query_signal_metadata(const std::string& path) {
-        ClientContext context;
-        // Set a deadline to prevent hanging forever on slow/stuck RPCs
-        context.set_deadline(std::chrono::system_clock::now() + std::chrono::seconds(5));
-
-        ListMetadataRequest request;
-        request.set_root(path);
-
-        ListMetadataResponse response;
-        grpc::Status grpc_status = stub_->ListMetadata(&context, request, &response);
-
-        if (!grpc_status.ok()) {
-            LOG(ERROR) << "Failed to query metadata for " << path;
-            return {-1, vss::types::ValueType::UNSPECIFIED};
-        }
-
+    static SignalMetadata find_signal_metadata(const std::string& path, const ListMetadataResponse& response) {
         for (const auto& metadata : response.metadata()) {
             if (metadata.path() == path && metadata.id() != 0) {
                 auto type = static_cast<vss::types::ValueType>(metadata.data_type());
@@ -956,33 +1172,57 @@ private:
     // Member Variables
     // ========================================================================
 
-    std::string address_;
+    // Declared first so it outlives every gRPC object below
+    std::shared_ptr<Runtime> runtime_;
+
+    FailoverOptions options_;
     std::atomic<bool> running_;
 
-    // gRPC (single channel, two streams)
-    std::shared_ptr<Channel> channel_;
-    std::unique_ptr<VAL::Stub> stub_;
+    // gRPC (pooled channels, two streams)
+    std::shared_ptr<Channel> channel_;  // first endpoint's NORMAL lane; set before the client is shared
+    std::shared_ptr<VAL::Stub> stub_;
+    std::shared_ptr<Channel> provider_channel_;  // lane of the most critical actuator; guarded by stream_mutex_
+    std::shared_ptr<VAL::Stub> provider_stub_;
 
-    // Provider stream
-    std::unique_ptr<ClientContext> provider_context_;
-    std::thread provider_thread_;
-    std::unique_ptr<DatabrokerConnectionStateMachine> provider_sm_;
+    // Databrokers in order of preference, each with its share of the subscriber stream
+    std::vector<Endpoint> endpoints_;
+    std::atomic<size_t> active_{0};
+    std::atomic<bool> joined_{false};  // every endpoint's membership is set
 
-    // Subscriber stream
-    std::unique_ptr<ClientContext> subscriber_context_;
-    std::thread subscriber_thread_;
-    std::unique_ptr<DatabrokerConnectionStateMachine> subscriber_sm_;
+    // Callbacks for the application's event loop; null to run them on runtime threads
+    std::shared_ptr<CallbackQueue> callbacks_;
 
-    // Actuators
-    struct ActuatorRegistration {
-        std::string path;
-        int32_t signal_id;       // Already resolved from handle
-        vss::types::ValueType type;
-        std::function<void(const vss::types::Value&)> handler;  // Handle already captured in closure
-    };
+    // Lane of each signal given a priority; the others use NORMAL_LANE
+    mutable std::mutex priorities_mutex_;
+    std::map<int32_t, size_t> priorities_;
+    std::atomic<bool> has_priorities_{false};
+
+    // Stream state shared by the completion handlers
+    std::mutex stream_mutex_;
+    std::set<ClientContext*> contexts_;  // cancelled by stop()
 
+    // Completions not yet run by the runtime
+    std::mutex operations_mutex_;
+    std::condition_variable operations_done_;
+    size_t pending_operations_ = 0;
+
+    // Actuators
     std::vector<ActuatorRegistration> actuator_handlers_;
 
+    // Provider stream
+    std::unique_ptr<DatabrokerConnectionStateMachine> provider_sm_;
+    std::unique_ptr<ClientContext> provider_context_;
+    std::unique_ptr<grpc::ClientAsyncReaderWriter<OpenProviderStreamRequest, OpenProviderStreamResponse>> provider_stream_;
+    OpenProviderStreamResponse provider_response_;
+    OpenProviderStreamRequest provider_write_;
+    std::deque<OpenProviderStreamRequest> provider_writes_;
+    grpc::Status provider_status_;
+    size_t pending_validations_ = 0;
+    std::vector<std::string> validation_errors_;
+    bool provider_ready_ = false;
+    bool provider_writing_ = false;
+    bool provider_finish_pending_ = false;
+
     // Subscriptions
     mutable std::mutex subscriptions_mutex_;
     std::map<int32_t, std::function<void(const vss::types::DynamicQualifiedValue&)>> subscriptions_;
@@ -990,14 +1230,38 @@ private:
 };
 
 // ============================================================================
-// Factory Method
+// Factory Methods
 // ============================================================================
 
 Result<std::unique_ptr<Client>> Client::create(const std::string& databroker_address) {
-    auto impl = std::make_unique<VSSClientImpl>(databroker_address);
+    return create(databroker_address, Runtime::create());
+}
+
+Result<std::unique_ptr<Client>> Client::create(const std::string& databroker_address,
+                                               std::shared_ptr<Runtime> runtime) {
+    if (!runtime) {
+        return absl::InvalidArgumentError("Client runtime must not be null");
+    }
+    auto impl = std::make_unique<VSSClientImpl>(std::vector<std::string>{databroker_address},
+                                                std::move(runtime), FailoverOptions{});
     impl->initialize_connection();
     LOG(INFO) << "Created unified Client for " << databroker_address;
     return std::unique_ptr<Client>(std::move(impl));
 }
 
+Result<std::unique_ptr<Client>> Client::create(const std::vector<std::string>& databroker_addresses,
+                                               std::shared_ptr<Runtime> runtime,
+                                               const FailoverOptions& options) {
+    if (databroker_addresses.empty()) {
+        return absl::InvalidArgumentError("At least one databroker address is required");
+    }
+    if (!runtime) {
+        return absl::InvalidArgumentError("Client runtime must not be null");
+    }
+    auto impl = std::make_unique<VSSClientImpl>(databroker_addresses, std::move(runtime), options);
+    impl->initialize_connection();
+    LOG(INFO) << "Created unified Client for " << absl::StrJoin(databroker_addresses, ", ");
+    return std::unique_ptr<Client>(std::move(impl));
+}
+
 } // namespace kuksa
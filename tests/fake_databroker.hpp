@@ -0,0 +1,292 @@
+/**
+ * @file fake_databroker.hpp
+ * @brief Minimal in-process KUKSA v2 databroker for client tests (no Docker)
+ *
+ * Implements just enough of kuksa.val.v2.VAL for the client's streams:
+ * ListMetadata, GetValue, PublishValue, SubscribeById and OpenProviderStream.
+ * Listens on 127.0.0.1 with an ephemeral port unless one is given, so a test
+ * can restart a broker on the same address.
+ */
+
+#pragma once
+
+#include <grpcpp/grpcpp.h>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <utility>
+
+#include "kuksa/val/v2/val.grpc.pb.h"
+
+class FakeDatabroker final : public kuksa::val::v2::VAL::Service {
+public:
+    explicit FakeDatabroker(int port = 0) {
+        grpc::ServerBuilder builder;
+        builder.AddListeningPort("127.0.0.1:" + std::to_string(port), grpc::InsecureServerCredentials(), &port_);
+        // Like the databroker, accept the clients' keepalive pings at any rate
+        builder.AddChannelArgument(GRPC_ARG_KEEPALIVE_PERMIT_WITHOUT_CALLS, 1);
+        builder.AddChannelArgument(GRPC_ARG_HTTP2_MAX_PING_STRIKES, 0);
+        builder.RegisterService(this);
+        server_ = builder.BuildAndStart();
+    }
+
+    ~FakeDatabroker() override {
+        shutdown();
+    }
+
+    void shutdown() {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            stopping_ = true;
+        }
+        changed_.notify_all();
+        if (server_) {
+            server_->Shutdown(std::chrono::system_clock::now() + std::chrono::milliseconds(200));
+            server_.reset();
+        }
+    }
+
+    int port() const { return port_; }
+    std::string address() const { return "127.0.0.1:" + std::to_string(port_); }
+
+    void add_signal(const std::string& path, int32_t id, kuksa::val::v2::DataType type,
+                    kuksa::val::v2::EntryType entry = kuksa::val::v2::ENTRY_TYPE_SENSOR) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto& metadata = metadata_[path];
+        metadata.set_path(path);
+        metadata.set_id(id);
+        metadata.set_data_type(type);
+        metadata.set_entry_type(entry);
+    }
+
+    void set_value(int32_t id, const kuksa::val::v2::Value& value) {
+        kuksa::val::v2::Datapoint datapoint;
+        auto now = std::chrono::system_clock::now().time_since_epoch();
+        datapoint.mutable_timestamp()->set_seconds(std::chrono::duration_cast<std::chrono::seconds>(now).count());
+        *datapoint.mutable_value() = value;
+        store(id, datapoint);
+    }
+
+    /**
+     * @brief Fail SubscribeById requests that include id with code, and
+     *        GetValue for id too unless only_streams
+     */
+    void refuse(int32_t id, grpc::StatusCode code, bool only_streams = false) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        refused_[id] = {code, only_streams};
+    }
+
+    /**
+     * @brief Fail PublishValue for id with code
+     */
+    void refuse_publish(int32_t id, grpc::StatusCode code) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        refused_publishes_[id] = code;
+    }
+
+    /**
+     * @brief Send an actuation request to the provider that registered id
+     */
+    bool actuate(int32_t id, const kuksa::val::v2::Value& value) {
+        std::shared_ptr<Provider> provider;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            auto it = owners_.find(id);
+            if (it == owners_.end()) {
+                return false;
+            }
+            provider = it->second;
+        }
+        kuksa::val::v2::OpenProviderStreamResponse response;
+        auto* request = response.mutable_batch_actuate_stream_request()->add_actuate_requests();
+        request->mutable_signal_id()->set_id(id);
+        *request->mutable_value() = value;
+        return provider->write(response);
+    }
+
+    size_t subscribers() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return subscribers_;
+    }
+
+    size_t subscribe_calls() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return subscribe_calls_;
+    }
+
+    size_t providers() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return providers_;
+    }
+
+    size_t actuation_acks() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return actuation_acks_;
+    }
+
+    // ========================================================================
+    // VAL service
+    // ========================================================================
+
+    grpc::Status ListMetadata(grpc::ServerContext*, const kuksa::val::v2::ListMetadataRequest* request,
+                              kuksa::val::v2::ListMetadataResponse* response) override {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = metadata_.find(request->root());
+        if (it == metadata_.end()) {
+            return grpc::Status(grpc::StatusCode::NOT_FOUND, "Unknown path " + request->root());
+        }
+        *response->add_metadata() = it->second;
+        return grpc::Status::OK;
+    }
+
+    grpc::Status GetValue(grpc::ServerContext*, const kuksa::val::v2::GetValueRequest* request,
+                          kuksa::val::v2::GetValueResponse* response) override {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto refused = refused_.find(request->signal_id().id());
+        if (refused != refused_.end() && !refused->second.second) {
+            return grpc::Status(refused->second.first, "Refused signal " + std::to_string(refused->first));
+        }
+        auto it = values_.find(request->signal_id().id());
+        if (it != values_.end()) {
+            *response->mutable_data_point() = it->second;
+        }
+        return grpc::Status::OK;
+    }
+
+    grpc::Status PublishValue(grpc::ServerContext*, const kuksa::val::v2::PublishValueRequest* request,
+                              kuksa::val::v2::PublishValueResponse*) override {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            auto refused = refused_publishes_.find(request->signal_id().id());
+            if (refused != refused_publishes_.end()) {
+                return grpc::Status(refused->second, "Refused publish " + std::to_string(refused->first));
+            }
+        }
+        store(request->signal_id().id(), request->data_point());
+        return grpc::Status::OK;
+    }
+
+    grpc::Status SubscribeById(grpc::ServerContext* context, const kuksa::val::v2::SubscribeByIdRequest* request,
+                               grpc::ServerWriter<kuksa::val::v2::SubscribeByIdResponse>* writer) override {
+        std::unique_lock<std::mutex> lock(mutex_);
+        ++subscribe_calls_;
+        for (int32_t id : request->signal_ids()) {
+            auto refused = refused_.find(id);
+            if (refused != refused_.end()) {
+                return grpc::Status(refused->second.first, "Refused signal " + std::to_string(id));
+            }
+        }
+        ++subscribers_;
+        uint64_t seen = version_;
+        while (!stopping_ && !context->IsCancelled()) {
+            changed_.wait_for(lock, std::chrono::milliseconds(20));
+            if (version_ == seen) {
+                continue;
+            }
+            kuksa::val::v2::SubscribeByIdResponse response;
+            for (int32_t id : request->signal_ids()) {
+                auto it = updated_.find(id);
+                if (it != updated_.end() && it->second > seen) {
+                    (*response.mutable_entries())[id] = values_[id];
+                }
+            }
+            seen = version_;
+            if (response.entries().empty()) {
+                continue;
+            }
+            lock.unlock();
+            bool ok = writer->Write(response);
+            lock.lock();
+            if (!ok) {
+                break;
+            }
+        }
+        --subscribers_;
+        return grpc::Status::OK;
+    }
+
+    grpc::Status OpenProviderStream(
+        grpc::ServerContext*,
+        grpc::ServerReaderWriter<kuksa::val::v2::OpenProviderStreamResponse,
+                                 kuksa::val::v2::OpenProviderStreamRequest>* stream) override {
+        auto provider = std::make_shared<Provider>();
+        provider->stream = stream;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            ++providers_;
+        }
+
+        kuksa::val::v2::OpenProviderStreamRequest request;
+        while (stream->Read(&request)) {
+            if (request.has_provide_actuation_request()) {
+                {
+                    std::lock_guard<std::mutex> lock(mutex_);
+                    for (const auto& id : request.provide_actuation_request().actuator_identifiers()) {
+                        auto it = id.has_path() ? metadata_.find(id.path()) : metadata_.end();
+                        owners_[it != metadata_.end() ? it->second.id() : id.id()] = provider;
+                    }
+                }
+                kuksa::val::v2::OpenProviderStreamResponse response;
+                response.mutable_provide_actuation_response();
+                provider->write(response);
+            } else if (request.has_batch_actuate_stream_response()) {
+                std::lock_guard<std::mutex> lock(mutex_);
+                ++actuation_acks_;
+            }
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(provider->mutex);
+            provider->stream = nullptr;
+        }
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (auto it = owners_.begin(); it != owners_.end();) {
+            it = it->second == provider ? owners_.erase(it) : std::next(it);
+        }
+        --providers_;
+        return grpc::Status::OK;
+    }
+
+private:
+    struct Provider {
+        std::mutex mutex;
+        grpc::ServerReaderWriter<kuksa::val::v2::OpenProviderStreamResponse,
+                                 kuksa::val::v2::OpenProviderStreamRequest>* stream = nullptr;
+
+        bool write(const kuksa::val::v2::OpenProviderStreamResponse& response) {
+            std::lock_guard<std::mutex> lock(mutex);
+            return stream && stream->Write(response);
+        }
+    };
+
+    void store(int32_t id, const kuksa::val::v2::Datapoint& datapoint) {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            values_[id] = datapoint;
+            updated_[id] = ++version_;
+        }
+        changed_.notify_all();
+    }
+
+    int port_ = 0;
+    std::unique_ptr<grpc::Server> server_;
+
+    mutable std::mutex mutex_;
+    std::condition_variable changed_;
+    bool stopping_ = false;
+    std::map<std::string, kuksa::val::v2::Metadata> metadata_;
+    std::map<int32_t, kuksa::val::v2::Datapoint> values_;
+    std::map<int32_t, uint64_t> updated_;
+    uint64_t version_ = 0;
+    std::map<int32_t, std::shared_ptr<Provider>> owners_;
+    std::map<int32_t, std::pair<grpc::StatusCode, bool>> refused_;  // code, only_streams
+    std::map<int32_t, grpc::StatusCode> refused_publishes_;
+    size_t subscribers_ = 0;
+    size_t subscribe_calls_ = 0;
+    size_t providers_ = 0;
+    size_t actuation_acks_ = 0;
+};
@@ -0,0 +1,150 @@
+/**
+ * @file tcp_proxy.hpp
+ * @brief TCP forwarder that can cut a client off from a broker without closing connections
+ *
+ * Stands in for a network partition or a hung databroker: after partition()
+ * the connections stay open but no byte moves in either direction, so only
+ * timeouts and keepalive pings can tell that the peer is gone.
+ */
+
+#pragma once
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+class TcpProxy {
+public:
+    explicit TcpProxy(int target_port) : target_port_(target_port) {
+        listener_ = ::socket(AF_INET, SOCK_STREAM, 0);
+        sockaddr_in address = loopback(0);
+        ::bind(listener_, reinterpret_cast<sockaddr*>(&address), sizeof(address));
+        ::listen(listener_, 16);
+        socklen_t length = sizeof(address);
+        ::getsockname(listener_, reinterpret_cast<sockaddr*>(&address), &length);
+        port_ = ntohs(address.sin_port);
+        thread_ = std::thread([this]() { run(); });
+    }
+
+    ~TcpProxy() {
+        stopping_ = true;
+        thread_.join();
+        for (auto& [client, broker] : pairs_) {
+            ::close(client);
+            ::close(broker);
+        }
+        ::close(listener_);
+    }
+
+    TcpProxy(const TcpProxy&) = delete;
+    TcpProxy& operator=(const TcpProxy&) = delete;
+
+    std::string address() const { return "127.0.0.1:" + std::to_string(port_); }
+
+    /// Stop forwarding; connections stay open and new ones are accepted
+    void partition() { partitioned_ = true; }
+
+    /// Forward again, including what was sent meanwhile
+    void heal() { partitioned_ = false; }
+
+private:
+    static sockaddr_in loopback(int port) {
+        sockaddr_in address{};
+        address.sin_family = AF_INET;
+        address.sin_port = htons(static_cast<uint16_t>(port));
+        address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        return address;
+    }
+
+    void run() {
+        while (!stopping_) {
+            std::vector<pollfd> fds{{listener_, POLLIN, 0}};
+            if (!partitioned_) {
+                for (const auto& [client, broker] : pairs_) {
+                    fds.push_back({client, POLLIN, 0});
+                    fds.push_back({broker, POLLIN, 0});
+                }
+            }
+            if (::poll(fds.data(), fds.size(), 10) <= 0) {
+                continue;
+            }
+            if (fds[0].revents & POLLIN) {
+                accept();
+            }
+            for (size_t i = 1; i < fds.size(); ++i) {
+                if (fds[i].revents == 0) {
+                    continue;
+                }
+                auto& pair = pairs_[(i - 1) / 2];
+                int from = fds[i].fd;
+                int to = from == pair.first ? pair.second : pair.first;
+                if (!forward(from, to)) {
+                    ::shutdown(pair.first, SHUT_RDWR);
+                    ::shutdown(pair.second, SHUT_RDWR);
+                }
+            }
+            drop_closed();
+        }
+    }
+
+    void accept() {
+        int client = ::accept(listener_, nullptr, nullptr);
+        if (client < 0) {
+            return;
+        }
+        int broker = ::socket(AF_INET, SOCK_STREAM, 0);
+        sockaddr_in address = loopback(target_port_);
+        if (::connect(broker, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0) {
+            ::close(client);
+            ::close(broker);
+            return;
+        }
+        pairs_.emplace_back(client, broker);
+    }
+
+    static bool forward(int from, int to) {
+        char buffer[16384];
+        auto received = ::recv(from, buffer, sizeof(buffer), 0);
+        if (received <= 0) {
+            return false;
+        }
+        for (ssize_t sent = 0; sent < received;) {
+            auto n = ::send(to, buffer + sent, static_cast<size_t>(received - sent), MSG_NOSIGNAL);
+            if (n <= 0) {
+                return false;
+            }
+            sent += n;
+        }
+        return true;
+    }
+
+    // Pairs shut down by forward() read as closed on both ends
+    void drop_closed() {
+        for (auto it = pairs_.begin(); it != pairs_.end();) {
+            char byte;
+            if (::recv(it->first, &byte, 1, MSG_PEEK | MSG_DONTWAIT) == 0) {
+                ::close(it->first);
+                ::close(it->second);
+                it = pairs_.erase(it);
+            } else {
+                ++it;
+            }
+        }
+    }
+
+    const int target_port_;
+    int listener_ = -1;
+    int port_ = 0;
+    std::vector<std::pair<int, int>> pairs_;  // client, broker; only touched by thread_
+    std::atomic<bool> partitioned_{false};
+    std::atomic<bool> stopping_{false};
+    std::thread thread_;
+};
@@ -213,4 +213,153 @@ TEST_F(HierarchicalTest, ParentChildStateRelationship) {
     
     // Should be in Driving state (even if actually in a substate)
     EXPECT_TRUE(vehicle.is_in_state(VehicleState::Driving));
-}
\ No newline at end of file
+}
+// Same-enum hierarchy used by the nested tests below:
+//
+//   Vehicle
+//   ├── Off
+//   └── On
+//       ├── Ready
+//       └── Moving
+//           ├── Forward
+//           │   ├── Eco
+//           │   └── Sport
+//           └── Reverse
+enum class NestedState {
+    Vehicle,
+    Off,
+    On,
+    Ready,
+    Moving,
+    Forward,
+    Eco,
+    Sport,
+    Reverse,
+    _Count
+};
+
+class NestedHierarchyTest : public HierarchicalTest {
+protected:
+    using Machine = sdv::HierarchicalStateMachine<NestedState>;
+
+    void build(Machine& sm) {
+        sm.set_state_name_function([](NestedState s) {
+            static const char* names[] = {"Vehicle", "Off", "On", "Ready", "Moving",
+                                          "Forward", "Eco", "Sport", "Reverse"};
+            return std::string(names[static_cast<int>(s)]);
+        });
+        sm.add_composite_state(NestedState::Vehicle, {NestedState::Off, NestedState::On}, NestedState::Off);
+        sm.add_composite_state(NestedState::On, {NestedState::Ready, NestedState::Moving}, NestedState::Ready);
+        sm.add_composite_state(NestedState::Moving, {NestedState::Forward, NestedState::Reverse}, NestedState::Forward);
+        sm.add_composite_state(NestedState::Forward, {NestedState::Eco, NestedState::Sport}, NestedState::Eco);
+
+        for (int i = 0; i < static_cast<int>(NestedState::_Count); ++i) {
+            auto state = static_cast<NestedState>(i);
+            sm.define_state(state)
+                .on_entry([this, state]() { log.push_back("+" + std::to_string(static_cast<int>(state))); })
+                .on_exit([this, state]() { log.push_back("-" + std::to_string(static_cast<int>(state))); });
+        }
+    }
+
+    static std::string in(NestedState s) { return "+" + std::to_string(static_cast<int>(s)); }
+    static std::string out(NestedState s) { return "-" + std::to_string(static_cast<int>(s)); }
+
+    std::vector<std::string> log;
+};
+
+TEST_F(NestedHierarchyTest, EnteringCompositeDescendsToInitialLeaf) {
+    Machine sm("Nested", NestedState::Off);
+    build(sm);
+    sm.add_transition(NestedState::Off, NestedState::On, "power");
+    sm.add_transition(NestedState::Ready, NestedState::Moving, "go");
+
+    EXPECT_TRUE(sm.trigger("power"));
+    EXPECT_EQ(sm.current_state(), NestedState::Ready);
+    EXPECT_EQ(log, (std::vector<std::string>{out(NestedState::Off), in(NestedState::On), in(NestedState::Ready)}));
+
+    log.clear();
+    EXPECT_TRUE(sm.trigger("go"));
+    EXPECT_EQ(sm.current_state(), NestedState::Eco);
+    EXPECT_EQ(log, (std::vector<std::string>{out(NestedState::Ready), in(NestedState::Moving),
+                                             in(NestedState::Forward), in(NestedState::Eco)}));
+    EXPECT_EQ(sm.get_state_depth(), 4);
+}
+
+TEST_F(NestedHierarchyTest, EventsBubbleToAncestors) {
+    Machine sm("Nested", NestedState::Sport);
+    build(sm);
+    // Defined on On, handled from any descendant
+    sm.add_transition(NestedState::On, NestedState::Off, "power");
+    sm.add_transition(NestedState::Forward, NestedState::Reverse, "shift");
+
+    auto triggers = sm.available_triggers();
+    EXPECT_EQ(triggers.size(), 2u);
+
+    EXPECT_TRUE(sm.trigger("shift"));
+    EXPECT_EQ(sm.current_state(), NestedState::Reverse);
+    EXPECT_EQ(log, (std::vector<std::string>{out(NestedState::Sport), out(NestedState::Forward),
+                                             in(NestedState::Reverse)}));
+
+    log.clear();
+    EXPECT_TRUE(sm.trigger("power"));
+    EXPECT_EQ(sm.current_state(), NestedState::Off);
+    EXPECT_EQ(log, (std::vector<std::string>{out(NestedState::Reverse), out(NestedState::Moving),
+                                             out(NestedState::On), in(NestedState::Off)}));
+    EXPECT_FALSE(sm.trigger("shift"));
+}
+
+TEST_F(NestedHierarchyTest, InnerTransitionTakesPrecedence) {
+    Machine sm("Nested", NestedState::Eco);
+    build(sm);
+    sm.add_transition(NestedState::On, NestedState::Off, "stop");
+    sm.add_transition(NestedState::Moving, NestedState::Ready, "stop");
+
+    EXPECT_TRUE(sm.trigger("stop"));
+    EXPECT_EQ(sm.current_state(), NestedState::Ready);
+    // On is the common ancestor and stays active
+    EXPECT_EQ(log, (std::vector<std::string>{out(NestedState::Eco), out(NestedState::Forward),
+                                             out(NestedState::Moving), in(NestedState::Ready)}));
+}
+
+TEST_F(NestedHierarchyTest, InheritedTransitionFallsBackWhenGuardFails) {
+    Machine sm("Nested", NestedState::Eco);
+    build(sm);
+    sm.add_transition(NestedState::Eco, NestedState::Sport, "boost", [](const auto&) { return false; });
+    sm.add_transition(NestedState::Moving, NestedState::Reverse, "boost");
+
+    EXPECT_TRUE(sm.trigger("boost"));
+    EXPECT_EQ(sm.current_state(), NestedState::Reverse);
+}
+
+TEST_F(NestedHierarchyTest, SelfTransitionOnCompositeReentersIt) {
+    Machine sm("Nested", NestedState::Sport);
+    build(sm);
+    sm.add_transition(NestedState::Forward, NestedState::Forward, "reset");
+
+    EXPECT_TRUE(sm.trigger("reset"));
+    EXPECT_EQ(sm.current_state(), NestedState::Eco);
+    EXPECT_EQ(log, (std::vector<std::string>{out(NestedState::Sport), out(NestedState::Forward),
+                                             in(NestedState::Forward), in(NestedState::Eco)}));
+}
+
+TEST_F(NestedHierarchyTest, HierarchyQueries) {
+    Machine sm("Nested", NestedState::Sport);
+    build(sm);
+
+    EXPECT_EQ(sm.get_state_depth(), 4);
+    EXPECT_TRUE(sm.is_in_state(NestedState::Sport));
+    EXPECT_TRUE(sm.is_in_state(NestedState::Forward));
+    EXPECT_TRUE(sm.is_in_state(NestedState::On));
+    EXPECT_TRUE(sm.is_in_state(NestedState::Vehicle));
+    EXPECT_FALSE(sm.is_in_state(NestedState::Reverse));
+    EXPECT_FALSE(sm.is_in_state(NestedState::Off));
+
+    auto active = sm.get_active_states();
+    EXPECT_EQ(active, (std::unordered_set<NestedState>{NestedState::Sport, NestedState::Forward,
+                                                       NestedState::Moving, NestedState::On,
+                                                       NestedState::Vehicle}));
+    EXPECT_EQ(sm.parent_state(NestedState::Eco), NestedState::Forward);
+    EXPECT_FALSE(sm.parent_state(NestedState::Vehicle).has_value());
+    EXPECT_TRUE(sm.is_composite(NestedState::Moving));
+    EXPECT_FALSE(sm.is_composite(NestedState::Eco));
+}
@@ -0,0 +1,914 @@
+/**
+ * @file test_runtime.cpp
+ * @brief Client streams on standalone and shared runtimes, against an in-process broker
+ */
+
+#include "fake_databroker.hpp"
+#include "tcp_proxy.hpp"
+#include <kuksa_cpp/client.hpp>
+#include <kuksa_cpp/runtime.hpp>
+#include <kuksa_cpp/struct_binding.hpp>
+#include <kuksa_cpp/testing/test_utils.hpp>
+#include <gtest/gtest.h>
+#include <glog/logging.h>
+#include <algorithm>
+#include <atomic>
+#include <mutex>
+#include <set>
+#include <poll.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#include <thread>
+#include <vector>
+
+using namespace kuksa;
+using namespace std::chrono_literals;
+
+namespace {
+
+template<typename Predicate>
+bool wait_until(Predicate predicate, std::chrono::milliseconds timeout = 5000ms) {
+    auto deadline = std::chrono::steady_clock::now() + timeout;
+    while (!predicate()) {
+        if (std::chrono::steady_clock::now() > deadline) {
+            return false;
+        }
+        std::this_thread::sleep_for(5ms);
+    }
+    return true;
+}
+
+kuksa::val::v2::Value float_value(float value) {
+    kuksa::val::v2::Value proto;
+    proto.set_float_(value);
+    return proto;
+}
+
+class RuntimeTest : public ::testing::Test {
+protected:
+    RuntimeTest() {
+        broker.add_signal("Vehicle.Speed", 1, kuksa::val::v2::DATA_TYPE_FLOAT);
+        broker.add_signal("Vehicle.Cabin.Temperature", 2, kuksa::val::v2::DATA_TYPE_FLOAT,
+                          kuksa::val::v2::ENTRY_TYPE_ACTUATOR);
+    }
+
+    FakeDatabroker broker;
+    SignalHandle<float> speed = TestResolver::signal<float>("Vehicle.Speed", 1);
+    SignalHandle<float> temperature =
+        TestResolver::signal<float>("Vehicle.Cabin.Temperature", 2, SignalClass::ACTUATOR);
+};
+
+} // namespace
+
+TEST_F(RuntimeTest, ClientsShareChannelAndThreads) {
+    auto runtime = Runtime::create();
+    std::atomic<int> updates{0};
+
+    std::vector<std::unique_ptr<Client>> clients;
+    for (int i = 0; i < 5; ++i) {
+        auto client = Client::create(broker.address(), runtime);
+        ASSERT_TRUE(client.ok());
+        (*client)->subscribe(speed, [&](const vss::types::QualifiedValue<float>& value) {
+            if (value.is_valid() && *value.value == 88.0f) {
+                ++updates;
+            }
+        });
+        ASSERT_TRUE((*client)->start().ok());
+        clients.push_back(std::move(*client));
+    }
+    for (auto& client : clients) {
+        ASSERT_TRUE(client->wait_until_ready(5000ms).ok());
+    }
+
+    auto stats = runtime->stats();
+    EXPECT_EQ(stats.channels, 1u);
+    EXPECT_EQ(stats.clients, 5u);
+    EXPECT_EQ(stats.threads, 1u);
+    EXPECT_EQ(stats.streams, 1u) << "one subscription stream carries all five clients";
+
+    broker.set_value(1, float_value(88.0f));
+    EXPECT_TRUE(wait_until([&]() { return updates == 5; }));
+
+    clients.clear();
+    stats = runtime->stats();
+    EXPECT_EQ(stats.channels, 0u);
+    EXPECT_EQ(stats.clients, 0u);
+    EXPECT_EQ(stats.streams, 0u);
+    EXPECT_TRUE(wait_until([&]() { return broker.subscribers() == 0; }))
+        << "streams are cancelled with their client";
+}
+
+TEST_F(RuntimeTest, SubscriptionsAreMultiplexed) {
+    auto runtime = Runtime::create();
+    std::atomic<int> speeds{0};
+    std::atomic<int> temperatures{0};
+
+    std::vector<std::unique_ptr<Client>> clients;
+    for (int i = 0; i < 5; ++i) {
+        auto client = *Client::create(broker.address(), runtime);
+        client->subscribe(speed, [&](const vss::types::QualifiedValue<float>&) { ++speeds; });
+        if (i == 0) {
+            client->subscribe(temperature, [&](const vss::types::QualifiedValue<float>&) { ++temperatures; });
+        }
+        ASSERT_TRUE(client->start().ok());
+        clients.push_back(std::move(client));
+    }
+    for (auto& client : clients) {
+        ASSERT_TRUE(client->wait_until_ready(5000ms).ok());
+    }
+    EXPECT_EQ(broker.subscribe_calls(), 1u);
+
+    for (int i = 1; i <= 10; ++i) {
+        broker.set_value(1, float_value(static_cast<float>(i)));
+        ASSERT_TRUE(wait_until([&]() { return speeds == 5 * i; }));
+    }
+    broker.set_value(2, float_value(20.0f));
+    EXPECT_TRUE(wait_until([&]() { return temperatures == 1; }));
+
+    auto stats = runtime->stats();
+    EXPECT_EQ(stats.subscriptions, 1u);
+    EXPECT_EQ(stats.signals, 2u);
+    EXPECT_EQ(stats.decoded, 11u) << "each update is decoded once";
+    EXPECT_EQ(stats.delivered, 51u) << "and delivered to every subscriber";
+
+    // A late subscriber joins the existing stream and gets the latest value from the cache
+    auto late = *Client::create(broker.address(), runtime);
+    std::atomic<float> latest{0.0f};
+    late->subscribe(speed, [&](const vss::types::QualifiedValue<float>& value) { latest = *value.value; });
+    ASSERT_TRUE(late->start().ok());
+    ASSERT_TRUE(late->wait_until_ready(5000ms).ok());
+    EXPECT_TRUE(wait_until([&]() { return latest == 10.0f; }));
+    EXPECT_EQ(broker.subscribe_calls(), 1u);
+
+    // The stream outlives the client that opened it
+    clients.front()->stop();
+    broker.set_value(1, float_value(11.0f));
+    EXPECT_TRUE(wait_until([&]() { return latest == 11.0f; }));
+    EXPECT_EQ(broker.subscribe_calls(), 1u);
+
+    late.reset();
+    clients.clear();
+    EXPECT_EQ(runtime->stats().subscriptions, 0u);
+    EXPECT_TRUE(wait_until([&]() { return broker.subscribers() == 0; }));
+}
+
+TEST_F(RuntimeTest, RefusedSignalFailsOnlyItsSubscriber) {
+    broker.add_signal("Vehicle.Private.Secret", 3, kuksa::val::v2::DATA_TYPE_FLOAT);
+    broker.refuse(3, grpc::StatusCode::PERMISSION_DENIED);
+    broker.refuse(2, grpc::StatusCode::NOT_FOUND, true);  // the stream fails, GetValue does not
+    auto secret = TestResolver::signal<float>("Vehicle.Private.Secret", 3);
+    auto runtime = Runtime::create();
+    std::atomic<int> good_speeds{0};
+    std::atomic<int> bad_speeds{0};
+
+    // Started together, so all three signals go to one merged stream at first
+    auto good = *Client::create(broker.address(), runtime);
+    good->subscribe(speed, [&](const vss::types::QualifiedValue<float>&) { ++good_speeds; });
+    auto bad = *Client::create(broker.address(), runtime);
+    bad->subscribe(speed, [&](const vss::types::QualifiedValue<float>&) { ++bad_speeds; });
+    bad->subscribe(secret, [](const vss::types::QualifiedValue<float>&) {});
+    auto unknown = *Client::create(broker.address(), runtime);
+    unknown->subscribe(temperature, [](const vss::types::QualifiedValue<float>&) {});
+    ASSERT_TRUE(good->start().ok());
+    ASSERT_TRUE(bad->start().ok());
+    ASSERT_TRUE(unknown->start().ok());
+
+    EXPECT_TRUE(wait_until([&]() { return good->status().ok(); }));
+    EXPECT_TRUE(wait_until([&]() { return bad->status().code() == absl::StatusCode::kPermissionDenied; }))
+        << bad->status();
+    EXPECT_TRUE(wait_until([&]() { return unknown->status().code() == absl::StatusCode::kNotFound; }))
+        << unknown->status();
+    EXPECT_TRUE(good->wait_until_ready(5000ms).ok());
+
+    // The refused signals are dropped; speed keeps streaming to both of its subscribers
+    EXPECT_EQ(runtime->stats().signals, 1u);
+    broker.set_value(1, float_value(42.0f));
+    EXPECT_TRUE(wait_until([&]() { return good_speeds >= 1 && bad_speeds >= 1; }));
+
+    // ...without retrying the refused signals
+    auto calls = broker.subscribe_calls();
+    std::this_thread::sleep_for(300ms);
+    EXPECT_EQ(broker.subscribe_calls(), calls);
+    EXPECT_TRUE(good->status().ok());
+}
+
+TEST_F(RuntimeTest, HealthySignalsShareOneStreamAfterARefusal) {
+    std::vector<SignalHandle<float>> healthy;
+    for (int32_t id = 100; id < 116; ++id) {
+        auto path = "Vehicle.Telemetry.S" + std::to_string(id);
+        broker.add_signal(path, id, kuksa::val::v2::DATA_TYPE_FLOAT);
+        healthy.push_back(TestResolver::signal<float>(path, id));
+    }
+    broker.refuse(2, grpc::StatusCode::NOT_FOUND, true);  // only the stream names the culprit
+    auto runtime = Runtime::create();
+    auto client = *Client::create(broker.address(), runtime);
+    std::mutex updated_mutex;
+    std::set<int32_t> updated;
+    for (const auto& signal : healthy) {
+        client->subscribe(signal, [&, id = signal.id()](const vss::types::QualifiedValue<float>& value) {
+            if (!value.value || *value.value != 7.0f) return;
+            std::lock_guard<std::mutex> lock(updated_mutex);
+            updated.insert(id);
+        });
+    }
+    client->subscribe(temperature, [](const vss::types::QualifiedValue<float>&) {});
+    ASSERT_TRUE(client->start().ok());
+
+    EXPECT_TRUE(wait_until([&]() { return client->status().code() == absl::StatusCode::kNotFound; }))
+        << client->status();
+    EXPECT_TRUE(wait_until([&]() {
+        auto stats = runtime->stats();
+        return stats.signals == healthy.size() && stats.subscriptions == 1;
+    })) << runtime->stats().subscriptions << " streams";
+    // Halving 17 signals takes four rounds of two calls; one stream per signal would take 18
+    EXPECT_LE(broker.subscribe_calls(), 10u);
+
+    // The merged stream may still be resubscribing, so set the values until each arrives
+    EXPECT_TRUE(wait_until([&]() {
+        for (const auto& signal : healthy) {
+            broker.set_value(signal.id(), float_value(7.0f));
+        }
+        std::this_thread::sleep_for(50ms);
+        std::lock_guard<std::mutex> lock(updated_mutex);
+        return updated.size() == healthy.size();
+    }));
+    client->stop();
+}
+
+TEST_F(RuntimeTest, LoopbackDeliversLocallyAndForwards) {
+    RuntimeOptions options;
+    options.loopback = true;
+    auto runtime = *Runtime::create(options);
+
+    auto consumer = *Client::create(broker.address(), runtime);
+    std::vector<float> speeds;
+    std::mutex speeds_mutex;
+    std::thread::id callback_thread;
+    consumer->subscribe(speed, [&](const vss::types::QualifiedValue<float>& value) {
+        std::lock_guard<std::mutex> lock(speeds_mutex);
+        speeds.push_back(*value.value);
+        callback_thread = std::this_thread::get_id();
+    });
+    ASSERT_TRUE(consumer->start().ok());
+    ASSERT_TRUE(consumer->wait_until_ready(5000ms).ok());
+
+    // Delivered before publish() returns, on the publishing thread
+    auto producer = *Client::create(broker.address(), runtime);
+    ASSERT_TRUE(producer->publish(speed, 42.0f).ok());
+    {
+        std::lock_guard<std::mutex> lock(speeds_mutex);
+        EXPECT_EQ(speeds, std::vector<float>{42.0f});
+        EXPECT_EQ(callback_thread, std::this_thread::get_id());
+    }
+
+    // Forwarded to the broker, whose copy is not delivered again
+    EXPECT_TRUE(wait_until([&]() {
+        auto value = producer->get(speed);
+        return value.ok() && value->is_valid() && *value->value == 42.0f;
+    }));
+    std::this_thread::sleep_for(200ms);
+    {
+        std::lock_guard<std::mutex> lock(speeds_mutex);
+        EXPECT_EQ(speeds, std::vector<float>{42.0f});
+    }
+
+    // Updates from elsewhere still arrive through the broker
+    broker.set_value(1, float_value(7.0f));
+    EXPECT_TRUE(wait_until([&]() {
+        std::lock_guard<std::mutex> lock(speeds_mutex);
+        return speeds.size() == 2 && speeds.back() == 7.0f;
+    }));
+
+    auto stats = runtime->stats();
+    EXPECT_EQ(stats.looped_back, 1u);
+    EXPECT_EQ(stats.decoded, 1u);
+
+    // Signals without local subscribers are published to the broker directly
+    auto temperature_sensor = TestResolver::signal<float>("Vehicle.Cabin.Temperature", 2);
+    ASSERT_TRUE(producer->publish(temperature_sensor, 19.0f).ok());
+    EXPECT_EQ(runtime->stats().looped_back, 1u);
+}
+
+TEST_F(RuntimeTest, SharedMemoryDeliversBetweenRuntimes) {
+    // Two runtimes on one segment stand in for two processes on one host
+    std::string segment = "/kuksa-runtime-test-" + std::to_string(::getpid());
+    ::shm_unlink(segment.c_str());
+    RuntimeOptions options;
+    options.shared_memory = segment;
+    auto producer_runtime = Runtime::create(options);
+    auto consumer_runtime = Runtime::create(options);
+    ASSERT_TRUE(producer_runtime.ok()) << producer_runtime.status();
+    ASSERT_TRUE(consumer_runtime.ok()) << consumer_runtime.status();
+
+    auto consumer = *Client::create(broker.address(), *consumer_runtime);
+    std::vector<float> speeds;
+    std::mutex speeds_mutex;
+    consumer->subscribe(speed, [&](const vss::types::QualifiedValue<float>& value) {
+        std::lock_guard<std::mutex> lock(speeds_mutex);
+        speeds.push_back(*value.value);
+    });
+    ASSERT_TRUE(consumer->start().ok());
+    ASSERT_TRUE(consumer->wait_until_ready(5000ms).ok());
+
+    auto producer = *Client::create(broker.address(), *producer_runtime);
+    ASSERT_TRUE(producer->publish(speed, 42.0f).ok());
+    EXPECT_TRUE(wait_until([&]() {
+        std::lock_guard<std::mutex> lock(speeds_mutex);
+        return !speeds.empty();
+    }));
+
+    // The broker has the value too; its copy is not delivered again
+    auto stored = producer->get(speed);
+    ASSERT_TRUE(stored.ok());
+    EXPECT_EQ(*stored->value, 42.0f);
+    std::this_thread::sleep_for(200ms);
+    {
+        std::lock_guard<std::mutex> lock(speeds_mutex);
+        EXPECT_EQ(speeds, std::vector<float>{42.0f});
+    }
+    EXPECT_EQ((*producer_runtime)->stats().shared_written, 1u);
+    EXPECT_EQ((*consumer_runtime)->stats().shared_received, 1u);
+    EXPECT_EQ((*consumer_runtime)->stats().decoded, 0u);
+
+    consumer.reset();
+    producer.reset();
+    ::shm_unlink(segment.c_str());
+}
+
+TEST_F(RuntimeTest, SharedMemoryMirrorsBeforeTheBrokerAccepts) {
+    std::string segment = "/kuksa-runtime-test-refused-" + std::to_string(::getpid());
+    ::shm_unlink(segment.c_str());
+    RuntimeOptions options;
+    options.shared_memory = segment;
+    auto producer_runtime = Runtime::create(options);
+    auto consumer_runtime = Runtime::create(options);
+    ASSERT_TRUE(producer_runtime.ok()) << producer_runtime.status();
+    ASSERT_TRUE(consumer_runtime.ok()) << consumer_runtime.status();
+
+    auto consumer = *Client::create(broker.address(), *consumer_runtime);
+    std::atomic<float> latest{0.0f};
+    consumer->subscribe(speed, [&](const vss::types::QualifiedValue<float>& value) { latest = *value.value; });
+    ASSERT_TRUE(consumer->start().ok());
+    ASSERT_TRUE(consumer->wait_until_ready(5000ms).ok());
+
+    // The value reaches shared memory before the databroker refuses it;
+    // only the publisher learns about the refusal
+    broker.refuse_publish(1, grpc::StatusCode::PERMISSION_DENIED);
+    auto producer = *Client::create(broker.address(), *producer_runtime);
+    auto status = producer->publish(speed, 42.0f);
+    EXPECT_EQ(status.code(), absl::StatusCode::kPermissionDenied) << status;
+    EXPECT_TRUE(wait_until([&]() { return latest == 42.0f; }));
+    EXPECT_EQ((*producer_runtime)->stats().shared_written, 1u);
+    EXPECT_EQ((*producer_runtime)->stats().shared_dropped, 0u);
+
+    auto stored = producer->get(speed);
+    EXPECT_FALSE(stored.ok() && stored->value) << "the databroker never stored it";
+
+    consumer.reset();
+    producer.reset();
+    ::shm_unlink(segment.c_str());
+}
+
+TEST(RuntimeFactoryTest, RejectsInvalidSharedMemoryName) {
+    RuntimeOptions options;
+    options.shared_memory = "/not/a/valid/segment";
+    EXPECT_FALSE(Runtime::create(options).ok());
+}
+
+TEST_F(RuntimeTest, StandaloneClientSubscribesAndServesActuator) {
+    broker.set_value(1, float_value(12.5f));
+
+    auto client = *Client::create(broker.address());
+    std::vector<float> speeds;
+    std::mutex speeds_mutex;
+    std::atomic<int> actuations{0};
+
+    client->subscribe(speed, [&](const vss::types::QualifiedValue<float>& value) {
+        std::lock_guard<std::mutex> lock(speeds_mutex);
+        speeds.push_back(*value.value);
+    });
+    client->serve_actuator(temperature, [&](float target, const SignalHandle<float>&) {
+        EXPECT_EQ(target, 21.0f);
+        ++actuations;
+    });
+    ASSERT_TRUE(client->start().ok());
+    ASSERT_TRUE(client->wait_until_ready(5000ms).ok());
+
+    // Initial value first, then updates
+    broker.set_value(1, float_value(30.0f));
+    EXPECT_TRUE(wait_until([&]() {
+        std::lock_guard<std::mutex> lock(speeds_mutex);
+        return speeds.size() == 2;
+    }));
+    {
+        std::lock_guard<std::mutex> lock(speeds_mutex);
+        EXPECT_EQ(speeds, (std::vector<float>{12.5f, 30.0f}));
+    }
+
+    ASSERT_TRUE(broker.actuate(2, float_value(21.0f)));
+    EXPECT_TRUE(wait_until([&]() { return actuations == 1 && broker.actuation_acks() == 1; }));
+
+    client->stop();
+    EXPECT_FALSE(client->is_running());
+    EXPECT_TRUE(wait_until([&]() { return broker.providers() == 0; }));
+}
+
+TEST_F(RuntimeTest, ActuatorValidationFailsForUnknownSignal) {
+    auto client = *Client::create(broker.address());
+    auto unknown = TestResolver::signal<float>("Vehicle.Unknown", 7, SignalClass::ACTUATOR);
+    client->serve_actuator(unknown, [](float, const SignalHandle<float>&) {});
+    ASSERT_TRUE(client->start().ok());
+
+    auto status = client->wait_until_ready(5000ms);
+    EXPECT_EQ(status.code(), absl::StatusCode::kInvalidArgument) << status;
+    EXPECT_EQ(broker.providers(), 0u);
+}
+
+TEST_F(RuntimeTest, SubscriberReconnectsAfterBrokerRestart) {
+    auto runtime = Runtime::create();
+    auto client = *Client::create(broker.address(), runtime);
+    std::atomic<int> updates{0};
+    client->subscribe(speed, [&](const vss::types::QualifiedValue<float>&) { ++updates; });
+    ASSERT_TRUE(client->start().ok());
+    ASSERT_TRUE(client->wait_until_ready(5000ms).ok());
+
+    int port = broker.port();
+    broker.shutdown();
+    EXPECT_TRUE(wait_until([&]() { return !client->status().ok(); }));
+
+    FakeDatabroker restarted(port);
+    ASSERT_EQ(restarted.port(), port);
+    EXPECT_TRUE(wait_until([&]() { return client->status().ok(); }, 10000ms));
+
+    restarted.set_value(1, float_value(50.0f));
+    EXPECT_TRUE(wait_until([&]() { return updates >= 1; }));
+    client->stop();
+}
+
+TEST_F(RuntimeTest, KeepaliveDetectsAnUnreachableBroker) {
+    TcpProxy proxy(broker.port());
+    RuntimeOptions options;
+    options.keepalive_interval = 200ms;
+    options.keepalive_timeout = 300ms;
+    auto runtime = *Runtime::create(options);
+    std::atomic<float> latest{0.0f};
+    auto client = *Client::create(proxy.address(), runtime);
+    client->subscribe(speed, [&](const vss::types::QualifiedValue<float>& value) { latest = *value.value; });
+    ASSERT_TRUE(client->start().ok());
+    ASSERT_TRUE(client->wait_until_ready(5000ms).ok());
+
+    // Connections stay open but nothing gets through: only the pings notice
+    proxy.partition();
+    EXPECT_TRUE(wait_until([&]() { return !client->status().ok(); }, 5000ms))
+        << "a silent broker must not look healthy";
+
+    proxy.heal();
+    EXPECT_TRUE(wait_until([&]() { return client->status().ok(); }, 10000ms)) << client->status();
+    broker.set_value(1, float_value(7.0f));
+    EXPECT_TRUE(wait_until([&]() { return latest == 7.0f; }));
+}
+
+TEST_F(RuntimeTest, FailsOverToStandbyWithoutResubscribing) {
+    FakeDatabroker standby;
+    standby.add_signal("Vehicle.Speed", 1, kuksa::val::v2::DATA_TYPE_FLOAT);
+
+    auto runtime = Runtime::create();
+    auto client = *Client::create(std::vector<std::string>{broker.address(), standby.address()}, runtime);
+    std::vector<float> speeds;
+    std::mutex speeds_mutex;
+    std::chrono::steady_clock::time_point delivered_at;
+    client->subscribe(speed, [&](const vss::types::QualifiedValue<float>& value) {
+        if (!value.value) return;
+        std::lock_guard<std::mutex> lock(speeds_mutex);
+        speeds.push_back(*value.value);
+        delivered_at = std::chrono::steady_clock::now();
+    });
+    ASSERT_TRUE(client->start().ok());
+    ASSERT_TRUE(client->wait_until_ready(5000ms).ok());
+    EXPECT_TRUE(wait_until([&]() { return broker.subscribers() == 1 && standby.subscribers() == 1; }));
+
+    // Both brokers stream; only the preferred one is delivered
+    broker.set_value(1, float_value(10.0f));
+    standby.set_value(1, float_value(10.0f));
+    EXPECT_TRUE(wait_until([&]() {
+        std::lock_guard<std::mutex> lock(speeds_mutex);
+        return !speeds.empty() && speeds.back() == 10.0f;
+    }));
+    std::this_thread::sleep_for(100ms);
+    {
+        std::lock_guard<std::mutex> lock(speeds_mutex);
+        EXPECT_EQ(speeds, std::vector<float>{10.0f});
+    }
+
+    // The standby's stream is already open: on failure its latest value is
+    // delivered at once, and its updates from then on
+    standby.set_value(1, float_value(20.0f));
+    std::this_thread::sleep_for(100ms);
+    auto failed_at = std::chrono::steady_clock::now();
+    broker.shutdown();
+    EXPECT_TRUE(wait_until([&]() {
+        std::lock_guard<std::mutex> lock(speeds_mutex);
+        return speeds.back() == 20.0f;
+    }));
+    {
+        std::lock_guard<std::mutex> lock(speeds_mutex);
+        auto failover = std::chrono::duration_cast<std::chrono::milliseconds>(delivered_at - failed_at);
+        LOG(INFO) << "Failover delivered the standby's value after " << failover.count() << " ms";
+        EXPECT_LT(failover, 1000ms);
+    }
+    standby.set_value(1, float_value(30.0f));
+    EXPECT_TRUE(wait_until([&]() {
+        std::lock_guard<std::mutex> lock(speeds_mutex);
+        return speeds.back() == 30.0f;
+    }));
+    EXPECT_EQ(standby.subscribe_calls(), 1u);
+    EXPECT_TRUE(client->status().ok());
+
+    // Reads go to the standby as well
+    auto value = client->get(speed);
+    ASSERT_TRUE(value.ok()) << value.status();
+    EXPECT_EQ(*value->value, 30.0f);
+    client->stop();
+}
+
+TEST_F(RuntimeTest, PublishToAllReachesEveryBroker) {
+    FakeDatabroker standby;
+    standby.add_signal("Vehicle.Speed", 1, kuksa::val::v2::DATA_TYPE_FLOAT);
+
+    auto runtime = Runtime::create();
+    FailoverOptions options;
+    options.publish_to_all = true;
+    auto producer = *Client::create(std::vector<std::string>{broker.address(), standby.address()},
+                                    runtime, options);
+    ASSERT_TRUE(producer->publish(speed, 33.0f).ok());
+
+    for (auto* server : {&broker, &standby}) {
+        auto reader = *Client::create(server->address(), runtime);
+        auto value = reader->get(speed);
+        ASSERT_TRUE(value.ok()) << value.status();
+        EXPECT_EQ(*value->value, 33.0f);
+    }
+
+    // One broker down is not an error
+    broker.shutdown();
+    EXPECT_TRUE(producer->publish(speed, 34.0f).ok());
+    auto value = (*Client::create(standby.address(), runtime))->get(speed);
+    ASSERT_TRUE(value.ok()) << value.status();
+    EXPECT_EQ(*value->value, 34.0f);
+}
+
+TEST_F(RuntimeTest, PriorityLanesUseSeparateChannelsAndStreams) {
+    auto runtime = Runtime::create();
+    auto client = *Client::create(broker.address(), runtime);
+    std::atomic<int> speed_updates{0};
+    std::atomic<int> temperature_updates{0};
+    client->subscribe(speed, [&](const vss::types::QualifiedValue<float>& value) {
+        if (value.value) ++speed_updates;
+    });
+    client->subscribe(temperature, [&](const vss::types::QualifiedValue<float>& value) {
+        if (value.value) ++temperature_updates;
+    });
+    client->set_priority(temperature, Priority::HIGH);
+    ASSERT_TRUE(client->start().ok());
+    ASSERT_TRUE(client->wait_until_ready(5000ms).ok());
+    EXPECT_THROW(client->set_priority(speed, Priority::BULK), std::logic_error);
+
+    auto stats = runtime->stats();
+    EXPECT_EQ(stats.channels, 2u);
+    EXPECT_EQ(stats.subscriptions, 2u);
+    EXPECT_TRUE(wait_until([&]() { return broker.subscribe_calls() == 2; }));
+
+    broker.set_value(1, float_value(80.0f));
+    broker.set_value(2, float_value(21.0f));
+    EXPECT_TRUE(wait_until([&]() { return speed_updates == 1 && temperature_updates == 1; }));
+
+    // Blocking calls take the signal's lane
+    ASSERT_TRUE(client->publish(speed, 81.0f).ok());
+    auto value = client->get(temperature);
+    ASSERT_TRUE(value.ok()) << value.status();
+    EXPECT_EQ(*value->value, 21.0f);
+    client->stop();
+}
+
+TEST_F(RuntimeTest, HighPriorityCallbacksOvertakeBulkFrames) {
+    // 48 bulk signals arrive in one burst; their callbacks are slow
+    std::vector<SignalHandle<float>> bulk;
+    for (int32_t id = 100; id < 148; ++id) {
+        auto path = "Vehicle.Telemetry.S" + std::to_string(id);
+        broker.add_signal(path, id, kuksa::val::v2::DATA_TYPE_FLOAT);
+        bulk.push_back(TestResolver::signal<float>(path, id));
+    }
+
+    auto runtime = Runtime::create(1);
+    auto client = *Client::create(broker.address(), runtime);
+    std::mutex order_mutex;
+    std::vector<int32_t> order;
+    for (const auto& signal : bulk) {
+        client->subscribe(signal, [&, id = signal.id()](const vss::types::QualifiedValue<float>& value) {
+            if (!value.value) return;
+            std::this_thread::sleep_for(2ms);
+            std::lock_guard<std::mutex> lock(order_mutex);
+            order.push_back(id);
+        });
+        client->set_priority(signal, Priority::BULK);
+    }
+    client->subscribe(temperature, [&](const vss::types::QualifiedValue<float>& value) {
+        if (!value.value) return;
+        std::lock_guard<std::mutex> lock(order_mutex);
+        order.push_back(temperature.id());
+    });
+    client->set_priority(temperature, Priority::HIGH);
+    ASSERT_TRUE(client->start().ok());
+    ASSERT_TRUE(client->wait_until_ready(5000ms).ok());
+
+    for (const auto& signal : bulk) {
+        broker.set_value(signal.id(), float_value(1.0f));
+    }
+    EXPECT_TRUE(wait_until([&]() {
+        std::lock_guard<std::mutex> lock(order_mutex);
+        return !order.empty();
+    }));
+    broker.set_value(temperature.id(), float_value(22.0f));
+
+    EXPECT_TRUE(wait_until([&]() {
+        std::lock_guard<std::mutex> lock(order_mutex);
+        return order.size() == bulk.size() + 1;
+    }));
+    {
+        // The safety update does not wait for the remaining bulk callbacks
+        std::lock_guard<std::mutex> lock(order_mutex);
+        auto position = std::find(order.begin(), order.end(), temperature.id()) - order.begin();
+        EXPECT_LT(position, static_cast<long>(bulk.size()) - 8);
+    }
+
+    auto stats = runtime->stats();
+    const auto& high = stats.dispatch[static_cast<size_t>(Priority::HIGH)];
+    const auto& low = stats.dispatch[static_cast<size_t>(Priority::BULK)];
+    EXPECT_EQ(high.callbacks, 1u);
+    EXPECT_EQ(low.callbacks, bulk.size());
+    EXPECT_LT(high.max_us, low.max_us);
+    client->stop();
+}
+
+TEST_F(RuntimeTest, PrioritiesDrainConcurrentlyOnSeveralThreads) {
+    auto runtime = Runtime::create(2);
+    auto client = *Client::create(broker.address(), runtime);
+    std::atomic<bool> bulk_entered{false};
+    std::atomic<bool> normal_ran{false};
+    std::atomic<bool> bulk_saw_normal{false};
+    client->subscribe(speed, [&](const vss::types::QualifiedValue<float>& value) {
+        if (!value.value) return;
+        // A slow bulk callback must not hold back the other classes
+        bulk_entered = true;
+        bulk_saw_normal = wait_until([&]() { return normal_ran.load(); }, 2000ms);
+    });
+    client->set_priority(speed, Priority::BULK);
+    client->subscribe(temperature, [&](const vss::types::QualifiedValue<float>& value) {
+        if (value.value) normal_ran = true;
+    });
+    ASSERT_TRUE(client->start().ok());
+    ASSERT_TRUE(client->wait_until_ready(5000ms).ok());
+
+    broker.set_value(speed.id(), float_value(1.0f));
+    ASSERT_TRUE(wait_until([&]() { return bulk_entered.load(); }));
+    broker.set_value(temperature.id(), float_value(22.0f));
+    EXPECT_TRUE(wait_until([&]() { return bulk_saw_normal.load(); }));
+    client->stop();
+}
+
+TEST_F(RuntimeTest, SlowBulkConsumerStopsReading) {
+    // Each frame carries 100 bulk signals, i.e. 7 slices of callbacks
+    std::vector<SignalHandle<float>> bulk;
+    for (int32_t id = 100; id < 200; ++id) {
+        auto path = "Vehicle.Telemetry.S" + std::to_string(id);
+        broker.add_signal(path, id, kuksa::val::v2::DATA_TYPE_FLOAT);
+        bulk.push_back(TestResolver::signal<float>(path, id));
+    }
+
+    auto runtime = Runtime::create(2);
+    auto client = *Client::create(broker.address(), runtime);
+    std::atomic<int> finished{0};
+    for (const auto& signal : bulk) {
+        client->subscribe(signal, [&](const vss::types::QualifiedValue<float>& value) {
+            if (!value.value) return;
+            std::this_thread::sleep_for(1ms);
+            if (*value.value == 20.0f) ++finished;
+        });
+        client->set_priority(signal, Priority::BULK);
+    }
+    ASSERT_TRUE(client->start().ok());
+    ASSERT_TRUE(client->wait_until_ready(5000ms).ok());
+
+    // 20 frames arrive far faster than their callbacks run
+    for (int round = 1; round <= 20; ++round) {
+        for (const auto& signal : bulk) {
+            broker.set_value(signal.id(), float_value(static_cast<float>(round)));
+        }
+        std::this_thread::sleep_for(30ms);
+    }
+
+    auto stats = runtime->stats();
+    EXPECT_GE(stats.paused_reads, 1u);
+    EXPECT_LT(stats.decoded, 2000u);  // the last frames wait for the queue to drain
+
+    EXPECT_TRUE(wait_until([&]() { return finished.load() == static_cast<int>(bulk.size()); }, 10000ms));
+    client->stop();
+}
+
+TEST_F(RuntimeTest, EventFdDeliversOnTheLoopThread) {
+    broker.set_value(1, float_value(12.5f));
+
+    auto client = *Client::create(broker.address());
+    auto fd = client->enable_event_fd();
+    ASSERT_TRUE(fd.ok()) << fd.status();
+    std::vector<float> speeds;
+    std::vector<std::thread::id> threads;
+    int actuations = 0;
+    client->subscribe(speed, [&](const vss::types::QualifiedValue<float>& value) {
+        speeds.push_back(*value.value);
+        threads.push_back(std::this_thread::get_id());
+    });
+    client->serve_actuator(temperature, [&](float target, const SignalHandle<float>&) {
+        EXPECT_EQ(target, 21.0f);
+        ++actuations;
+        threads.push_back(std::this_thread::get_id());
+    });
+    ASSERT_TRUE(client->start().ok());
+    ASSERT_TRUE(client->wait_until_ready(5000ms).ok());
+    EXPECT_EQ(client->set_executor([](std::function<void()>) {}).code(), absl::StatusCode::kFailedPrecondition);
+
+    // A minimal event loop: wait for the descriptor, then dispatch
+    auto run_loop = [&](auto done) {
+        auto deadline = std::chrono::steady_clock::now() + 5s;
+        while (!done() && std::chrono::steady_clock::now() < deadline) {
+            pollfd readable{*fd, POLLIN, 0};
+            if (::poll(&readable, 1, 100) > 0) {
+                client->dispatch_pending();
+            }
+        }
+        return done();
+    };
+
+    EXPECT_TRUE(run_loop([&]() { return speeds.size() == 1; }));
+    EXPECT_EQ(speeds, std::vector<float>{12.5f});
+
+    broker.set_value(1, float_value(30.0f));
+    ASSERT_TRUE(broker.actuate(2, float_value(21.0f)));
+    EXPECT_TRUE(run_loop([&]() { return speeds.size() == 2 && actuations == 1; }));
+    EXPECT_EQ(speeds.back(), 30.0f);
+    for (auto id : threads) {
+        EXPECT_EQ(id, std::this_thread::get_id());
+    }
+
+    // Nothing is pending, so the descriptor is not readable
+    pollfd readable{*fd, POLLIN, 0};
+    EXPECT_EQ(::poll(&readable, 1, 0), 0);
+    client->stop();
+}
+
+TEST_F(RuntimeTest, ExecutorGetsOneTaskPerBatch) {
+    auto runtime = Runtime::create(1);
+    auto client = *Client::create(broker.address(), runtime);
+    std::mutex tasks_mutex;
+    std::vector<std::function<void()>> tasks;
+    ASSERT_TRUE(client->set_executor([&](std::function<void()> task) {
+        std::lock_guard<std::mutex> lock(tasks_mutex);
+        tasks.push_back(std::move(task));
+    }).ok());
+
+    std::vector<float> speeds;
+    client->subscribe(speed, [&](const vss::types::QualifiedValue<float>& value) {
+        if (value.value) speeds.push_back(*value.value);
+    });
+    ASSERT_TRUE(client->start().ok());
+    ASSERT_TRUE(client->wait_until_ready(5000ms).ok());
+
+    // Updates queue up behind the first wakeup until the loop runs its task
+    auto delivered = runtime->stats().delivered;
+    for (float value : {1.0f, 2.0f, 3.0f}) {
+        broker.set_value(1, float_value(value));
+        ASSERT_TRUE(wait_until([&]() { return runtime->stats().delivered == delivered + 1; }));
+        ++delivered;
+    }
+    std::vector<std::function<void()>> batch;
+    {
+        std::lock_guard<std::mutex> lock(tasks_mutex);
+        batch.swap(tasks);
+    }
+    ASSERT_EQ(batch.size(), 1u);
+    batch.front()();
+    EXPECT_EQ(speeds, (std::vector<float>{1.0f, 2.0f, 3.0f}));
+    client->stop();
+}
+
+TEST_F(RuntimeTest, CallbacksMayDispatchAndDestroyTheClient) {
+    auto runtime = Runtime::create(1);
+    auto client = *Client::create(broker.address(), runtime);
+    auto fd = client->enable_event_fd();
+    ASSERT_TRUE(fd.ok()) << fd.status();
+    int calls = 0;
+    size_t nested = SIZE_MAX;
+    auto callback = [&](const vss::types::QualifiedValue<float>& value) {
+        if (!value.value) return;
+        ++calls;
+        nested = client->dispatch_pending();
+        client.reset();
+    };
+    client->subscribe(speed, callback);
+    client->subscribe(temperature, callback);
+    ASSERT_TRUE(client->start().ok());
+    ASSERT_TRUE(client->wait_until_ready(5000ms).ok());
+
+    // Both updates wait in one batch; the second is dropped with the client
+    auto delivered = runtime->stats().delivered;
+    broker.set_value(1, float_value(1.0f));
+    broker.set_value(2, float_value(2.0f));
+    ASSERT_TRUE(wait_until([&]() { return runtime->stats().delivered == delivered + 2; }));
+    pollfd readable{*fd, POLLIN, 0};
+    ASSERT_EQ(::poll(&readable, 1, 0), 1);
+    client->dispatch_pending();
+    EXPECT_EQ(client, nullptr);
+    EXPECT_EQ(calls, 1);
+    EXPECT_EQ(nested, 0u);
+}
+
+TEST_F(RuntimeTest, PollingQueuesReceiveUpdates) {
+    broker.set_value(1, float_value(10.0f));
+    broker.set_value(2, float_value(20.0f));
+
+    auto client = *Client::create(broker.address());
+    auto speeds = client->subscribe_queue(speed, 2);
+    auto temperatures = client->subscribe_latest(temperature);
+    ASSERT_TRUE(client->start().ok());
+    ASSERT_TRUE(client->wait_until_ready(5000ms).ok());
+
+    ASSERT_TRUE(wait_until([&]() { return speeds->size() == 1 && temperatures->fresh(); }));
+    broker.set_value(1, float_value(11.0f));
+    broker.set_value(2, float_value(21.0f));
+    ASSERT_TRUE(wait_until([&]() { return speeds->size() == 2 && temperatures->overflows() == 1; }));
+    broker.set_value(1, float_value(12.0f));
+    broker.set_value(2, float_value(22.0f));
+    ASSERT_TRUE(wait_until([&]() { return speeds->overflows() == 1 && temperatures->overflows() == 2; }));
+
+    // The queue keeps the oldest updates; the latest value wins
+    std::array<vss::types::QualifiedValue<float>, 4> batch;
+    ASSERT_EQ(speeds->poll(batch), 2u);
+    EXPECT_EQ(*batch[0].value, 10.0f);
+    EXPECT_EQ(*batch[1].value, 11.0f);
+
+    vss::types::QualifiedValue<float> temperature_value;
+    ASSERT_TRUE(temperatures->poll(temperature_value));
+    EXPECT_EQ(*temperature_value.value, 22.0f);
+    EXPECT_FALSE(temperatures->poll(temperature_value));
+    client->stop();
+}
+
+TEST_F(RuntimeTest, CellsAndStructBindingsFollowUpdates) {
+    struct Cabin {
+        float speed = 0.0f;
+        float temperature = 0.0f;
+    };
+    broker.set_value(1, float_value(10.0f));
+    broker.set_value(2, float_value(20.0f));
+
+    auto client = *Client::create(broker.address());
+    auto speed_cell = client->subscribe_cell(speed);
+    StructBinding<Cabin> cabin;
+    cabin.bind(&Cabin::temperature, temperature);
+    cabin.subscribe(*client);
+    ASSERT_TRUE(client->start().ok());
+    ASSERT_TRUE(client->wait_until_ready(5000ms).ok());
+
+    EXPECT_TRUE(wait_until([&]() { return speed_cell->version() == 1 && cabin.version() == 1; }));
+    EXPECT_EQ(*speed_cell->load().value, 10.0f);
+    EXPECT_EQ(cabin.read().temperature, 20.0f);
+
+    broker.set_value(1, float_value(11.0f));
+    broker.set_value(2, float_value(21.0f));
+    EXPECT_TRUE(wait_until([&]() {
+        return speed_cell->load().value == 11.0f && cabin.read().temperature == 21.0f;
+    }));
+    client->stop();
+}
+
+TEST_F(RuntimeTest, StopWhileConnectingIsPrompt) {
+    broker.shutdown();
+    auto client = *Client::create(broker.address());
+    client->subscribe(speed, [](const vss::types::QualifiedValue<float>&) {});
+    ASSERT_TRUE(client->start().ok());
+    std::this_thread::sleep_for(50ms);
+
+    auto start = std::chrono::steady_clock::now();
+    client->stop();
+    EXPECT_LT(std::chrono::steady_clock::now() - start, 1s);
+}
+
+TEST(RuntimeFactoryTest, RejectsNullRuntime) {
+    auto client = Client::create("localhost:55555", nullptr);
+    EXPECT_EQ(client.status().code(), absl::StatusCode::kInvalidArgument);
+}
+
+TEST(RuntimeFactoryTest, RejectsEmptyAddressList) {
+    auto client = Client::create(std::vector<std::string>{}, Runtime::create());
+    EXPECT_EQ(client.status().code(), absl::StatusCode::kInvalidArgument);
+}
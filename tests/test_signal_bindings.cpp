@@ -0,0 +1,128 @@
+/**
+ * @file test_signal_bindings.cpp
+ * @brief Unit tests for signal-to-event bindings (no databroker required)
+ */
+
+#include <kuksa_cpp/signal_bindings.hpp>
+#include <kuksa_cpp/state_machine/state_machine.hpp>
+#include <kuksa_cpp/testing/test_utils.hpp>
+#include <gtest/gtest.h>
+#include <glog/logging.h>
+
+using namespace kuksa;
+using vss::types::DynamicQualifiedValue;
+using vss::types::SignalQuality;
+
+namespace {
+
+enum class Battery { OK, CRITICAL, LOST };
+
+DynamicQualifiedValue valid(vss::types::Value value) {
+    return DynamicQualifiedValue{std::move(value), SignalQuality::VALID};
+}
+
+DynamicQualifiedValue unavailable() {
+    return DynamicQualifiedValue{vss::types::Value{}, SignalQuality::NOT_AVAILABLE};
+}
+
+class SignalBindingsTest : public ::testing::Test {
+protected:
+    SignalBindingsTest() : sm("Battery", Battery::OK) {
+        sm.set_text_logging(false);
+        sm.add_transition(Battery::OK, Battery::CRITICAL, "critical");
+        sm.add_transition(Battery::CRITICAL, Battery::OK, "recovered");
+        sm.add_transition(Battery::OK, Battery::LOST, "lost");
+        sm.add_transition(Battery::CRITICAL, Battery::LOST, "lost");
+        sm.add_transition(Battery::LOST, Battery::OK, "recovered");
+    }
+
+    sdv::StateMachine<Battery> sm;
+};
+
+} // namespace
+
+TEST_F(SignalBindingsTest, ThresholdWithHysteresisPostsOnlyEdges) {
+    auto voltage = TestResolver::signal<float>("Vehicle.LowVoltageBattery.CurrentVoltage", 7);
+    SignalBindings bindings;
+    bindings.on_threshold(voltage, sm, Hysteresis<float>{23.6f, 24.5f}, "recovered", "critical");
+    EXPECT_EQ(bindings.size(), 1u);
+
+    bindings.dispatch(7, valid(24.0f));   // inside the band: no side yet
+    EXPECT_EQ(sm.current_state(), Battery::OK);
+    bindings.dispatch(7, valid(23.0f));   // below
+    EXPECT_EQ(sm.current_state(), Battery::CRITICAL);
+    bindings.dispatch(7, valid(22.0f));   // still below: suppressed
+    bindings.dispatch(7, valid(24.0f));   // back in the band: no recovery yet
+    EXPECT_EQ(sm.current_state(), Battery::CRITICAL);
+    bindings.dispatch(7, valid(25.0f));   // above
+    EXPECT_EQ(sm.current_state(), Battery::OK);
+    bindings.dispatch(99, valid(1.0f));   // unbound signal
+
+    auto stats = bindings.stats();
+    EXPECT_EQ(stats.updates, 5u);
+    EXPECT_EQ(stats.events, 2u);
+    EXPECT_EQ(stats.suppressed, 3u);
+
+    auto metrics = sm.metrics();
+    EXPECT_EQ(metrics.transitions, 2u);
+    EXPECT_EQ(metrics.ignored, 0u);  // the machine never saw a redundant event
+}
+
+TEST_F(SignalBindingsTest, QualityLossResetsSideAndFiresOnce) {
+    auto voltage = TestResolver::signal<float>("Vehicle.LowVoltageBattery.CurrentVoltage", 7);
+    SignalBindings bindings;
+    bindings.on_threshold(voltage, sm, Hysteresis<float>{23.6f, 23.6f}, "recovered", "critical")
+            .on_unavailable(voltage, sm, "lost");
+
+    bindings.dispatch(7, valid(23.0f));
+    EXPECT_EQ(sm.current_state(), Battery::CRITICAL);
+    bindings.dispatch(7, unavailable());
+    EXPECT_EQ(sm.current_state(), Battery::LOST);
+    bindings.dispatch(7, unavailable());  // still lost: no second event
+    EXPECT_EQ(bindings.stats().events, 2u);
+
+    // The first valid value after a loss establishes the side again
+    bindings.dispatch(7, valid(24.0f));
+    EXPECT_EQ(sm.current_state(), Battery::OK);
+    EXPECT_EQ(bindings.stats().events, 3u);
+}
+
+TEST_F(SignalBindingsTest, BoolEdgesDriveSeveralMachines) {
+    sdv::StateMachine<Battery> other("Other", Battery::OK);
+    other.set_text_logging(false);
+    other.add_transition(Battery::OK, Battery::CRITICAL, "engine_on");
+
+    auto running = TestResolver::signal<bool>("Vehicle.Powertrain.CombustionEngine.IsRunning", 3);
+    SignalBindings bindings;
+    bindings.on_edge(running, sm, "critical", "recovered")
+            .on_edge(running, other, "engine_on", "");
+
+    bindings.dispatch(3, valid(true));
+    bindings.dispatch(3, valid(true));
+    EXPECT_EQ(sm.current_state(), Battery::CRITICAL);
+    EXPECT_EQ(other.current_state(), Battery::CRITICAL);
+    bindings.dispatch(3, valid(false));
+    EXPECT_EQ(sm.current_state(), Battery::OK);
+
+    auto stats = bindings.stats();
+    EXPECT_EQ(stats.updates, 6u);
+    EXPECT_EQ(stats.events, 3u);  // falling edge has no event on "other"
+}
+
+TEST_F(SignalBindingsTest, EdgesAreQueuedWhenEventQueueRuns) {
+    auto voltage = TestResolver::signal<double>("Vehicle.Test.Double", 5);
+    SignalBindings bindings;
+    bindings.on_threshold(voltage, sm, Hysteresis<double>{10.0, 20.0}, "recovered", "critical");
+
+    sm.start_event_queue();
+    bindings.dispatch(5, valid(5.0));
+    sm.stop_event_queue();  // drains the queue
+    EXPECT_EQ(sm.current_state(), Battery::CRITICAL);
+}
+
+TEST_F(SignalBindingsTest, RejectsInvalidBand) {
+    auto voltage = TestResolver::signal<float>("Vehicle.Test.Float", 1);
+    SignalBindings bindings;
+    EXPECT_THROW(bindings.on_threshold(voltage, sm, Hysteresis<float>{5.0f, 1.0f}, "a", "b"),
+                 std::invalid_argument);
+}
@@ -0,0 +1,179 @@
+/**
+ * @file test_signal_queue.cpp
+ * @brief Unit tests for the polling queues (no databroker required)
+ */
+
+#include <kuksa_cpp/signal_queue.hpp>
+#include <gtest/gtest.h>
+#include <array>
+#include <atomic>
+#include <memory>
+#include <string>
+#include <thread>
+
+using namespace kuksa;
+using vss::types::QualifiedValue;
+using vss::types::SignalQuality;
+
+namespace {
+
+template<typename T>
+QualifiedValue<T> valid(T value) {
+    return QualifiedValue<T>{std::move(value), SignalQuality::VALID};
+}
+
+} // namespace
+
+TEST(SignalQueueTest, PollsInOrderUpToMax) {
+    SignalQueue<int32_t> queue(4);
+    for (int32_t i = 1; i <= 3; ++i) {
+        EXPECT_TRUE(queue.push(valid(i)));
+    }
+    EXPECT_EQ(queue.size(), 3u);
+
+    std::array<QualifiedValue<int32_t>, 2> out;
+    ASSERT_EQ(queue.poll(out), 2u);
+    EXPECT_EQ(*out[0].value, 1);
+    EXPECT_EQ(*out[1].value, 2);
+    ASSERT_EQ(queue.poll(out), 1u);
+    EXPECT_EQ(*out[0].value, 3);
+    EXPECT_EQ(queue.poll(out), 0u);
+}
+
+TEST(SignalQueueTest, RoundsCapacityUpAndCountsOverflows) {
+    SignalQueue<int32_t> queue(3);
+    ASSERT_EQ(queue.capacity(), 4u);
+    for (int32_t i = 0; i < 6; ++i) {
+        queue.push(valid(i));
+    }
+    EXPECT_EQ(queue.overflows(), 2u);
+
+    // The oldest values survive; the newest were dropped
+    std::array<QualifiedValue<int32_t>, 8> out;
+    ASSERT_EQ(queue.poll(out), 4u);
+    EXPECT_EQ(*out[0].value, 0);
+    EXPECT_EQ(*out[3].value, 3);
+
+    // Room again after polling
+    EXPECT_TRUE(queue.push(valid(6)));
+    EXPECT_EQ(queue.overflows(), 2u);
+}
+
+TEST(SignalQueueTest, SwapsBuffersWithTheProducer) {
+    SignalQueue<std::string> queue(1);
+    std::string pushed(64, 'a');
+    const char* pushed_buffer = pushed.data();
+    queue.push(valid(std::move(pushed)));
+
+    // The consumer gets the producer's buffer, not a copy
+    QualifiedValue<std::string> out = valid(std::string(64, 'b'));
+    ASSERT_EQ(queue.poll(&out, 1), 1u);
+    EXPECT_EQ(*out.value, std::string(64, 'a'));
+    EXPECT_EQ(out.value->data(), pushed_buffer);
+    EXPECT_EQ(queue.size(), 0u);
+}
+
+TEST(SignalQueueTest, ProducerFreesWhatPollSwappedOut) {
+    SignalQueue<std::shared_ptr<int>> queue(1);
+    queue.push(valid(std::make_shared<int>(1)));
+
+    auto previous = std::make_shared<int>(0);
+    std::weak_ptr<int> previous_alive = previous;
+    QualifiedValue<std::shared_ptr<int>> out = valid(std::move(previous));
+    ASSERT_EQ(queue.poll(&out, 1), 1u);
+    EXPECT_EQ(**out.value, 1);
+    EXPECT_FALSE(previous_alive.expired()) << "poll() must not free the caller's value";
+
+    queue.push(valid(std::make_shared<int>(2)));
+    EXPECT_TRUE(previous_alive.expired()) << "the next push into the slot frees it";
+}
+
+TEST(SignalQueueTest, ConcurrentProducerAndConsumerKeepOrder) {
+    constexpr int32_t COUNT = 20000;
+    SignalQueue<int32_t> queue(256);
+    std::atomic<bool> stopping{false};
+
+    // No ASSERT while the producer runs: returning early would destroy it joinable
+    std::thread producer([&]() {
+        for (int32_t i = 0; i < COUNT && !stopping;) {
+            if (queue.push(valid(i))) {
+                ++i;
+            } else {
+                std::this_thread::yield();
+            }
+        }
+    });
+
+    std::array<QualifiedValue<int32_t>, 32> out;
+    int32_t expected = 0;
+    bool in_order = true;
+    while (in_order && expected < COUNT) {
+        size_t n = queue.poll(out);
+        if (n == 0) {
+            std::this_thread::yield();
+        }
+        for (size_t i = 0; i < n && in_order; ++i) {
+            EXPECT_EQ(*out[i].value, expected);
+            in_order = *out[i].value == expected;
+            ++expected;
+        }
+    }
+    stopping = true;
+    producer.join();
+    EXPECT_EQ(queue.size(), 0u);
+}
+
+TEST(LatestSignalTest, PollsEachUpdateOnce) {
+    LatestSignal<float> latest;
+    QualifiedValue<float> out;
+    EXPECT_FALSE(latest.poll(out));
+
+    EXPECT_TRUE(latest.push(valid(1.0f)));
+    EXPECT_TRUE(latest.fresh());
+    ASSERT_TRUE(latest.poll(out));
+    EXPECT_EQ(*out.value, 1.0f);
+    EXPECT_FALSE(latest.poll(out));
+    EXPECT_EQ(*out.value, 1.0f);
+}
+
+TEST(LatestSignalTest, KeepsNewestAndCountsReplaced) {
+    LatestSignal<float> latest;
+    latest.push(valid(1.0f));
+    latest.push(valid(2.0f));
+    EXPECT_FALSE(latest.push(valid(3.0f)));
+    EXPECT_EQ(latest.overflows(), 2u);
+
+    QualifiedValue<float> out;
+    ASSERT_EQ(latest.poll(&out, 1), 1u);
+    EXPECT_EQ(*out.value, 3.0f);
+    EXPECT_EQ(latest.poll(&out, 1), 0u);
+}
+
+TEST(LatestSignalTest, ConcurrentReaderSeesIncreasingValues) {
+    constexpr int32_t COUNT = 20000;
+    LatestSignal<int32_t> latest;
+
+    std::thread producer([&]() {
+        for (int32_t i = 1; i <= COUNT; ++i) {
+            latest.push(valid(i));
+        }
+    });
+
+    QualifiedValue<int32_t> out;
+    int32_t last = 0;
+    uint64_t polled = 0;
+    while (last < COUNT) {
+        if (latest.poll(out)) {
+            EXPECT_GT(*out.value, last);
+            if (*out.value <= last) {
+                break;  // the producer finishes on its own; join it below
+            }
+            last = *out.value;
+            ++polled;
+        } else {
+            std::this_thread::yield();
+        }
+    }
+    producer.join();
+    EXPECT_EQ(polled + latest.overflows(), static_cast<uint64_t>(COUNT));
+}
@@ -0,0 +1,199 @@
+/**
+ * @file test_snapshot.cpp
+ * @brief Unit tests for state machine snapshots, restore and the snapshot file
+ */
+
+#include <gtest/gtest.h>
+#include <glog/logging.h>
+#include <kuksa_cpp/state_machine/snapshot.hpp>
+#include <kuksa_cpp/state_machine/state_machine.hpp>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <string>
+#include <thread>
+
+using namespace std::chrono_literals;
+
+enum class ProtectionState {
+    Idle,
+    Monitoring,
+    Protecting,
+    _Count
+};
+
+class SnapshotTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        if (!google::IsGoogleLoggingInitialized()) {
+            google::InitGoogleLogging("test");
+            FLAGS_logtostderr = 1;
+        }
+        path_ = ::testing::TempDir() + "snapshot_test_" +
+                ::testing::UnitTest::GetInstance()->current_test_info()->name() + ".bin";
+        std::remove(path_.c_str());
+    }
+
+    void TearDown() override {
+        std::remove(path_.c_str());
+    }
+
+    static void define(sdv::StateMachine<ProtectionState>& sm, int* protecting_entries = nullptr) {
+        sm.add_transition(ProtectionState::Idle, ProtectionState::Monitoring, "start");
+        sm.add_transition(ProtectionState::Monitoring, ProtectionState::Protecting, "battery_low");
+        sm.add_transition(ProtectionState::Protecting, ProtectionState::Monitoring, "recovered");
+        sm.define_state(ProtectionState::Protecting)
+            .on_entry([protecting_entries]() {
+                if (protecting_entries) {
+                    ++*protecting_entries;
+                }
+            })
+            .timeout(10min, "recovered");
+    }
+
+    std::string path_;
+};
+
+TEST_F(SnapshotTest, EncodeDecodeRoundTrip) {
+    sdv::StateSnapshot snapshot;
+    snapshot.machine = "Protection";
+    snapshot.state = 2;
+    snapshot.entered = std::chrono::system_clock::now() - 5s;
+    snapshot.taken = std::chrono::system_clock::now();
+    snapshot.timers.push_back({"recovered", snapshot.taken + 1min, true, 2});
+    snapshot.context = std::string("\0ctx", 4);
+
+    auto record = sdv::encode_snapshot(snapshot);
+    auto decoded = sdv::decode_snapshot(record);
+    ASSERT_TRUE(decoded);
+    EXPECT_EQ(decoded->machine, "Protection");
+    EXPECT_EQ(decoded->state, 2);
+    EXPECT_EQ(decoded->entered, snapshot.entered);
+    ASSERT_EQ(decoded->timers.size(), 1u);
+    EXPECT_EQ(decoded->timers[0].trigger, "recovered");
+    EXPECT_TRUE(decoded->timers[0].state_timeout);
+    EXPECT_EQ(decoded->context, snapshot.context);
+
+    EXPECT_FALSE(sdv::decode_snapshot(record.substr(0, record.size() - 1)));
+    EXPECT_FALSE(sdv::decode_snapshot("garbage"));
+}
+
+TEST_F(SnapshotTest, FileKeepsLatestIntactSlot) {
+    sdv::StateSnapshot first;
+    first.machine = "Protection";
+    first.state = 1;
+    sdv::StateSnapshot second = first;
+    second.state = 2;
+
+    {
+        sdv::SnapshotFile file(path_);
+        EXPECT_FALSE(file.read());
+        EXPECT_TRUE(file.write(first));
+        EXPECT_TRUE(file.write(second));
+        EXPECT_EQ(file.read()->state, 2);
+
+        sdv::StateSnapshot huge = first;
+        huge.context.assign(file.capacity() + 1, 'x');
+        EXPECT_FALSE(file.write(huge));
+    }
+
+    // Reopened: still the newest one
+    {
+        sdv::SnapshotFile file(path_);
+        ASSERT_TRUE(file.read());
+        EXPECT_EQ(file.read()->state, 2);
+    }
+
+    // A torn write of the newest slot falls back to the previous snapshot
+    {
+        std::fstream raw(path_, std::ios::in | std::ios::out | std::ios::binary);
+        raw.seekp(30);  // inside slot 0's payload (second snapshot, sequence 2)
+        raw.put('!');
+    }
+    sdv::SnapshotFile file(path_);
+    ASSERT_TRUE(file.read());
+    EXPECT_EQ(file.read()->state, 1);
+}
+
+TEST_F(SnapshotTest, RestoreResumesStateAndTimers) {
+    sdv::SnapshotFile file(path_);
+    std::string saved_context = "threshold=23.6";
+    {
+        sdv::StateMachine<ProtectionState> sm("Protection", ProtectionState::Idle);
+        define(sm);
+        sm.set_context_snapshot([&]() { return saved_context; }, {});
+        sdv::persist_snapshots(sm, file);
+        sm.trigger("start");
+        sm.trigger("battery_low");
+        sm.after(1h, "start");
+    }
+
+    auto snapshot = file.read();
+    ASSERT_TRUE(snapshot);
+    EXPECT_EQ(snapshot->timers.size(), 1u);  // after() came after the last transition
+    EXPECT_EQ(snapshot->context, saved_context);
+
+    int entries = 0;
+    std::string loaded_context;
+    sdv::StateMachine<ProtectionState> restored("Protection", ProtectionState::Idle);
+    define(restored, &entries);
+    restored.set_context_snapshot({}, [&](const std::string& context) { loaded_context = context; });
+    ASSERT_TRUE(restored.restore(*snapshot));
+
+    EXPECT_EQ(restored.current_state(), ProtectionState::Protecting);
+    EXPECT_EQ(entries, 0);  // entry actions are not replayed
+    EXPECT_EQ(loaded_context, saved_context);
+    EXPECT_LE(restored.snapshot().entered, snapshot->entered + 1ms);
+
+    // The state timeout is re-armed with its remaining time...
+    auto timers = restored.snapshot().timers;
+    ASSERT_EQ(timers.size(), 1u);
+    EXPECT_TRUE(timers[0].state_timeout);
+    EXPECT_GT(timers[0].deadline, std::chrono::system_clock::now() + 9min);
+
+    // ...and cancelled on exit like one armed by entry
+    restored.trigger("recovered");
+    EXPECT_EQ(restored.current_state(), ProtectionState::Monitoring);
+    EXPECT_TRUE(restored.snapshot().timers.empty());
+
+    sdv::StateMachine<ProtectionState> other("Other", ProtectionState::Idle);
+    EXPECT_FALSE(other.restore(*snapshot));
+}
+
+TEST_F(SnapshotTest, OverdueTimersFireAfterRestore) {
+    sdv::StateMachine<ProtectionState> sm("Protection", ProtectionState::Idle);
+    define(sm);
+
+    sdv::StateSnapshot snapshot;
+    snapshot.machine = "Protection";
+    snapshot.state = static_cast<std::int64_t>(ProtectionState::Protecting);
+    snapshot.entered = std::chrono::system_clock::now() - 11min;
+    snapshot.taken = std::chrono::system_clock::now() - 1min;
+    snapshot.timers.push_back({"recovered", snapshot.entered + 10min, true,
+                               static_cast<std::int64_t>(ProtectionState::Protecting)});
+    ASSERT_TRUE(sm.restore(snapshot));
+
+    auto deadline = std::chrono::steady_clock::now() + 2s;
+    while (sm.current_state() != ProtectionState::Monitoring && std::chrono::steady_clock::now() < deadline) {
+        std::this_thread::sleep_for(1ms);
+    }
+    EXPECT_EQ(sm.current_state(), ProtectionState::Monitoring);
+}
+
+TEST_F(SnapshotTest, RestoreRejectsUnknownStates) {
+    sdv::StateMachine<ProtectionState> sm("Protection", ProtectionState::Idle);
+    define(sm);
+    sm.trigger("start");
+    sm.after(1h, "battery_low");
+
+    sdv::StateSnapshot snapshot;
+    snapshot.machine = "Protection";
+    snapshot.entered = std::chrono::system_clock::now();
+    snapshot.timers.push_back({"recovered", snapshot.entered + 1min, false, 0});
+    for (std::int64_t state : {std::int64_t{42}, std::int64_t{1} << 40}) {
+        snapshot.state = state;
+        EXPECT_FALSE(sm.restore(snapshot)) << state;
+        EXPECT_EQ(sm.current_state(), ProtectionState::Monitoring);
+        EXPECT_EQ(sm.snapshot().timers.size(), 1u);  // left untouched
+    }
+}
@@ -9,6 +9,9 @@
 #include <thread>
 #include <atomic>
 #include <algorithm>
+#include <map>
+#include <sstream>
+#include <stdexcept>
 
 // Test state enum
 enum class TestState {
@@ -251,4 +254,289 @@ TEST_F(StateMachineTest, ThreadSafety) {
     EXPECT_TRUE(state == TestState::Initial || 
                 state == TestState::Middle || 
                 state == TestState::Final);
-}
\ No newline at end of file
+}
+
+TEST_F(StateMachineTest, TriggerRunsOnCallerThread) {
+    sdv::StateMachine<TestState> sm("TestMachine", TestState::Initial);
+    
+    std::thread::id action_thread;
+    sm.add_transition(
+        TestState::Initial,
+        TestState::Middle,
+        "next",
+        {},
+        [&action_thread](const sdv::Context& ctx) {
+            action_thread = std::this_thread::get_id();
+        }
+    );
+    
+    EXPECT_TRUE(sm.trigger("next"));
+    EXPECT_EQ(action_thread, std::this_thread::get_id());
+}
+
+TEST_F(StateMachineTest, InternedTriggerIds) {
+    sdv::StateMachine<TestState> sm("TestMachine", TestState::Initial);
+    
+    auto next = sm.register_trigger("next");
+    auto reset = sm.register_trigger("reset");
+    EXPECT_NE(next, reset);
+    EXPECT_EQ(sm.register_trigger("next"), next);
+    EXPECT_EQ(sm.trigger_id("reset"), reset);
+    EXPECT_EQ(sm.trigger_id("unknown"), sdv::kInvalidTriggerId);
+    EXPECT_EQ(sm.trigger_name(next), "next");
+    
+    sm.add_transition(TestState::Initial, TestState::Middle, next);
+    sm.add_transition(TestState::Middle, TestState::Initial, reset);
+    
+    EXPECT_FALSE(sm.trigger(reset));
+    EXPECT_TRUE(sm.trigger(next));
+    EXPECT_EQ(sm.current_state(), TestState::Middle);
+    
+    // String API resolves to the same interned trigger
+    EXPECT_TRUE(sm.trigger("reset"));
+    EXPECT_EQ(sm.current_state(), TestState::Initial);
+    
+    // Unknown IDs are ignored
+    EXPECT_FALSE(sm.trigger(sdv::kInvalidTriggerId));
+    EXPECT_EQ(sm.current_state(), TestState::Initial);
+}
+
+TEST_F(StateMachineTest, UnregisteredTriggerIdsAreRejected) {
+    sdv::StateMachine<TestState> sm("TestMachine", TestState::Initial);
+    auto next = sm.register_trigger("next");
+    
+    sm.add_transition(TestState::Initial, TestState::Final, sdv::kInvalidTriggerId);
+    sm.add_transition(TestState::Initial, TestState::Final, next + 1);
+    sm.add_transition(TestState::Initial, TestState::Middle, next);
+    
+    EXPECT_TRUE(sm.trigger(next));
+    EXPECT_EQ(sm.current_state(), TestState::Middle);
+    EXPECT_FALSE(sm.trigger(sdv::kInvalidTriggerId));
+    EXPECT_EQ(sm.current_state(), TestState::Middle);
+}
+
+TEST_F(StateMachineTest, TransitionsAddedAfterDispatch) {
+    sdv::StateMachine<TestState> sm("TestMachine", TestState::Initial);
+    
+    sm.add_transition(TestState::Initial, TestState::Middle, "next");
+    EXPECT_TRUE(sm.trigger("next"));
+    
+    // Table is recompiled when new states and triggers are added
+    EXPECT_FALSE(sm.trigger("fail"));
+    sm.add_transition(TestState::Middle, TestState::Error, "fail");
+    EXPECT_TRUE(sm.trigger("fail"));
+    EXPECT_EQ(sm.current_state(), TestState::Error);
+    EXPECT_EQ(sm.current_state_name(), "State_3");
+}
+
+TEST_F(StateMachineTest, MetricsPerTransition) {
+    sdv::StateMachine<TestState> sm("TestMachine", TestState::Initial);
+    sm.set_state_name_function([](TestState s) {
+        static const char* names[] = {"Initial", "Middle", "Final", "Error"};
+        return std::string(names[static_cast<int>(s)]);
+    });
+    
+    bool allow = false;
+    sm.add_transition(TestState::Initial, TestState::Middle, "next");
+    sm.add_transition(TestState::Middle, TestState::Final, "next",
+                      [&allow](const sdv::Context&) { return allow; });
+    sm.add_transition(TestState::Middle, TestState::Initial, "back");
+    
+    EXPECT_TRUE(sm.trigger("next"));    // Initial -> Middle
+    EXPECT_FALSE(sm.trigger("next"));   // blocked
+    EXPECT_TRUE(sm.trigger("back"));    // Middle -> Initial
+    EXPECT_TRUE(sm.trigger("next"));    // Initial -> Middle
+    allow = true;
+    EXPECT_TRUE(sm.trigger("next"));    // Middle -> Final
+    EXPECT_FALSE(sm.trigger("back"));   // no transition from Final
+    EXPECT_FALSE(sm.trigger("bogus"));  // unknown trigger
+    
+    auto snapshot = sm.metrics();
+    EXPECT_EQ(snapshot.machine, "TestMachine");
+    EXPECT_EQ(snapshot.current_state, "Final");
+    EXPECT_EQ(snapshot.transitions, 4u);
+    EXPECT_EQ(snapshot.ignored, 3u);
+    
+    ASSERT_EQ(snapshot.transition_metrics.size(), 3u);
+    const auto& initial_middle = snapshot.transition_metrics[0];
+    EXPECT_EQ(initial_middle.from, "Initial");
+    EXPECT_EQ(initial_middle.to, "Middle");
+    EXPECT_EQ(initial_middle.trigger, "next");
+    EXPECT_EQ(initial_middle.latency.count, 2u);
+    
+    const auto& middle_final = snapshot.transition_metrics[1];
+    EXPECT_EQ(middle_final.latency.count, 1u);
+    EXPECT_EQ(middle_final.blocked, 1u);
+    
+    std::uint64_t bucketed = 0;
+    for (auto n : initial_middle.latency.buckets) {
+        bucketed += n;
+    }
+    EXPECT_EQ(bucketed, initial_middle.latency.count);
+    EXPECT_LE(initial_middle.latency.quantile(0.5), initial_middle.latency.max);
+    
+    std::map<std::string, std::uint64_t> entries;
+    for (const auto& state : snapshot.state_metrics) {
+        entries[state.state] = state.entries;
+    }
+    EXPECT_EQ(entries["Middle"], 2u);
+    EXPECT_EQ(entries["Initial"], 1u);
+    EXPECT_EQ(entries["Final"], 1u);
+    
+    auto text = sdv::to_prometheus_text(snapshot);
+    EXPECT_NE(text.find("sdv_state_machine_transitions_total{machine=\"TestMachine\","
+                        "from=\"Initial\",to=\"Middle\",trigger=\"next\"} 2"), std::string::npos);
+    EXPECT_NE(text.find("sdv_state_machine_current_state{machine=\"TestMachine\",state=\"Final\"} 1"),
+              std::string::npos);
+    EXPECT_NE(text.find("le=\"+Inf\"} 2"), std::string::npos);
+    EXPECT_NE(sdv::to_text(snapshot).find("Initial -> Middle [next]"), std::string::npos);
+    
+    sm.reset_metrics();
+    snapshot = sm.metrics();
+    EXPECT_EQ(snapshot.transitions, 0u);
+    EXPECT_EQ(snapshot.transition_metrics[0].latency.count, 0u);
+}
+
+TEST_F(StateMachineTest, LatencyBuckets) {
+    EXPECT_EQ(sdv::latency_bucket(0), 0u);
+    EXPECT_EQ(sdv::latency_bucket(1), 0u);
+    EXPECT_EQ(sdv::latency_bucket(2), 1u);
+    EXPECT_EQ(sdv::latency_bucket(1023), 9u);
+    EXPECT_EQ(sdv::latency_bucket(1024), 10u);
+    EXPECT_EQ(sdv::latency_bucket(~std::uint64_t{0}), sdv::kLatencyBuckets - 1);
+    EXPECT_EQ(sdv::latency_bucket_bound(9).count(), 1024);
+}
+
+TEST_F(StateMachineTest, TraceRecordsTransitions) {
+    sdv::StateMachine<TestState> sm("TestMachine", TestState::Initial);
+    EXPECT_EQ(sm.trace(), nullptr);
+    
+    sm.enable_trace(4);
+    sm.set_text_logging(false);
+    sm.add_transition(TestState::Initial, TestState::Middle, "next");
+    sm.add_transition(TestState::Middle, TestState::Initial, "back");
+    auto next = sm.trigger_id("next");
+    auto back = sm.trigger_id("back");
+    
+    for (int i = 0; i < 3; ++i) {
+        EXPECT_TRUE(sm.trigger(next));
+        EXPECT_TRUE(sm.trigger(back));
+    }
+    EXPECT_FALSE(sm.trigger(back));  // ignored events are not traced
+    
+    auto trace = sm.trace();
+    ASSERT_NE(trace, nullptr);
+    EXPECT_EQ(trace->capacity(), 4u);
+    EXPECT_EQ(trace->written(), 6u);
+    
+    std::uint64_t cursor = 0;
+    std::vector<sdv::TransitionRecord<TestState>> records;
+    EXPECT_EQ(trace->read(cursor, records), 2u);  // oldest two overwritten
+    EXPECT_EQ(cursor, 6u);
+    ASSERT_EQ(records.size(), 4u);
+    for (std::size_t i = 0; i < records.size(); ++i) {
+        EXPECT_EQ(records[i].sequence, i + 2);
+        bool forward = (records[i].sequence % 2) == 0;
+        EXPECT_EQ(records[i].from, forward ? TestState::Initial : TestState::Middle);
+        EXPECT_EQ(records[i].to, forward ? TestState::Middle : TestState::Initial);
+        EXPECT_EQ(records[i].trigger, forward ? next : back);
+        EXPECT_GE(records[i].duration.count(), 0);
+    }
+    
+    // Nothing new since the cursor
+    records.clear();
+    EXPECT_EQ(trace->read(cursor, records), 0u);
+    EXPECT_TRUE(records.empty());
+    
+    std::ostringstream dump;
+    sm.dump_trace(dump, 1);
+    EXPECT_NE(dump.str().find("#5"), std::string::npos);
+    EXPECT_NE(dump.str().find("State_1 -> State_0 | trigger=back"), std::string::npos);
+}
+
+TEST_F(StateMachineTest, TraceReadWhileWriting) {
+    sdv::StateMachine<TestState> sm("TestMachine", TestState::Initial);
+    sm.enable_trace(64);
+    sm.set_text_logging(false);
+    sm.add_transition(TestState::Initial, TestState::Middle, "toggle");
+    sm.add_transition(TestState::Middle, TestState::Initial, "toggle");
+    auto toggle = sm.trigger_id("toggle");
+    auto trace = sm.trace();
+    
+    constexpr std::uint64_t kTransitions = 50000;
+    std::thread writer([&]() {
+        for (std::uint64_t i = 0; i < kTransitions; ++i) {
+            sm.trigger(toggle);
+        }
+    });
+    
+    std::uint64_t cursor = 0;
+    std::uint64_t seen = 0;
+    std::uint64_t lost = 0;
+    std::vector<sdv::TransitionRecord<TestState>> records;
+    while (cursor < kTransitions) {
+        records.clear();
+        lost += trace->read(cursor, records);
+        for (const auto& record : records) {
+            // Torn records would mix fields of different transitions
+            bool forward = (record.sequence % 2) == 0;
+            ASSERT_EQ(record.from, forward ? TestState::Initial : TestState::Middle);
+            ASSERT_EQ(record.to, forward ? TestState::Middle : TestState::Initial);
+            ++seen;
+        }
+    }
+    writer.join();
+    EXPECT_EQ(seen + lost, kTransitions);
+}
+
+TEST_F(StateMachineTest, ObserversSeeTransitionsInOrder) {
+    sdv::StateMachine<TestState> sm("TestMachine", TestState::Initial);
+    sm.set_text_logging(false);
+    sm.add_transition(TestState::Initial, TestState::Middle, "next");
+    sm.add_transition(TestState::Middle, TestState::Final, "next");
+    
+    std::vector<std::string> seen;
+    auto id = sm.add_observer([&](const sdv::TransitionEvent<TestState>& event) {
+        EXPECT_EQ(event.machine, "TestMachine");
+        EXPECT_EQ(event.trigger_name, "next");
+        EXPECT_GE(event.duration.count(), 0);
+        seen.push_back(std::string(event.from_name) + "->" + std::string(event.to_name));
+    });
+    EXPECT_NE(id, sdv::kInvalidObserverId);
+    
+    EXPECT_TRUE(sm.trigger("next"));
+    EXPECT_FALSE(sm.trigger("missing"));  // ignored events are not reported
+    EXPECT_TRUE(sm.trigger("next"));
+    EXPECT_EQ(seen, (std::vector<std::string>{"State_0->State_1", "State_1->State_2"}));
+    
+    EXPECT_TRUE(sm.remove_observer(id));
+    EXPECT_FALSE(sm.remove_observer(id));
+    sm.add_transition(TestState::Final, TestState::Initial, "reset");
+    EXPECT_TRUE(sm.trigger("reset"));
+    EXPECT_EQ(seen.size(), 2u);
+}
+
+TEST_F(StateMachineTest, ObserverCanRemoveItself) {
+    sdv::StateMachine<TestState> sm("TestMachine", TestState::Initial);
+    sm.set_text_logging(false);
+    sm.add_transition(TestState::Initial, TestState::Middle, "toggle");
+    sm.add_transition(TestState::Middle, TestState::Initial, "toggle");
+    
+    int once = 0;
+    int always = 0;
+    sdv::ObserverId self = sdv::kInvalidObserverId;
+    self = sm.add_observer([&](const sdv::TransitionEvent<TestState>&) {
+        ++once;
+        sm.remove_observer(self);
+    });
+    sm.add_observer([&](const sdv::TransitionEvent<TestState>&) {
+        ++always;
+        throw std::runtime_error("observer failure");  // logged, transition unaffected
+    });
+    
+    EXPECT_TRUE(sm.trigger("toggle"));
+    EXPECT_TRUE(sm.trigger("toggle"));
+    EXPECT_EQ(once, 1);
+    EXPECT_EQ(always, 2);
+    EXPECT_EQ(sm.current_state(), TestState::Initial);
+}
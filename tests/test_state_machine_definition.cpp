@@ -0,0 +1,145 @@
+/**
+ * @file test_state_machine_definition.cpp
+ * @brief Unit tests for shared state machine definitions and their instances
+ */
+
+#include <gtest/gtest.h>
+#include <glog/logging.h>
+#include <kuksa_cpp/state_machine/state_machine_definition.hpp>
+#include <chrono>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+enum class WindowState {
+    Closed,
+    Open,
+    Blocked,
+    _Count
+};
+
+struct WindowContext {
+    std::size_t window = 0;
+    bool obstacle = false;
+};
+
+// Definitions have no state timeouts, so the builder must not offer one
+template<typename Hooks, typename = void>
+struct HasTimeout : std::false_type {};
+template<typename Hooks>
+struct HasTimeout<Hooks, std::void_t<decltype(std::declval<Hooks&>().timeout(
+    std::chrono::nanoseconds{}, std::string{}))>> : std::true_type {};
+
+static_assert(!HasTimeout<sdv::StateMachineDefinition<WindowState>::StateHooks>::value,
+              "StateMachineDefinition::Builder must not accept state timeouts");
+static_assert(HasTimeout<sdv::StateDefinition<WindowState>>::value,
+              "StateMachine states keep their timeout()");
+
+class StateMachineDefinitionTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        if (!google::IsGoogleLoggingInitialized()) {
+            google::InitGoogleLogging("test");
+            FLAGS_logtostderr = 1;
+        }
+    }
+};
+
+TEST_F(StateMachineDefinitionTest, InstancesShareOneDefinition) {
+    sdv::StateMachineDefinition<WindowState>::Builder builder("Window", WindowState::Closed);
+    auto open = builder.add_transition(WindowState::Closed, WindowState::Open, "open");
+    auto close = builder.add_transition(WindowState::Open, WindowState::Closed, "close");
+    auto definition = builder.build();
+    
+    std::vector<sdv::MachineInstance<WindowState>> windows(3, definition->make_instance());
+    EXPECT_TRUE(definition->dispatch(windows[1], open));
+    EXPECT_FALSE(definition->dispatch(windows[1], open));
+    
+    EXPECT_EQ(windows[0].state, WindowState::Closed);
+    EXPECT_EQ(windows[1].state, WindowState::Open);
+    EXPECT_EQ(definition->trigger_id("close"), close);
+    EXPECT_EQ(definition->trigger_id("unknown"), sdv::kInvalidTriggerId);
+    
+    // Only the two closed windows open
+    EXPECT_EQ(definition->broadcast(windows, open), 2u);
+    EXPECT_EQ(definition->broadcast(windows, close), 3u);
+    for (const auto& window : windows) {
+        EXPECT_EQ(window.state, WindowState::Closed);
+    }
+}
+
+TEST_F(StateMachineDefinitionTest, BatchDispatchUsesPerEventContext) {
+    using Definition = sdv::StateMachineDefinition<WindowState, WindowContext>;
+    std::vector<std::size_t> opened;
+    
+    Definition::Builder builder("Window", WindowState::Closed);
+    auto open = builder.add_transition(WindowState::Closed, WindowState::Blocked, "open",
+        [](const WindowContext& ctx) { return ctx.obstacle; });
+    builder.add_transition(WindowState::Closed, WindowState::Open, "open", {},
+        [&opened](const WindowContext& ctx) { opened.push_back(ctx.window); });
+    auto definition = builder.build();
+    
+    std::vector<sdv::MachineInstance<WindowState>> windows(4, definition->make_instance());
+    WindowContext blocked{2, true};
+    std::vector<Definition::Event> events{
+        {0, open, nullptr},
+        {2, open, &blocked},
+        {3, open, nullptr},
+        {7, open, nullptr},   // out of range: ignored
+    };
+    
+    EXPECT_EQ(definition->dispatch_batch(windows, events, WindowContext{99, false}), 3u);
+    EXPECT_EQ(windows[0].state, WindowState::Open);
+    EXPECT_EQ(windows[1].state, WindowState::Closed);
+    EXPECT_EQ(windows[2].state, WindowState::Blocked);
+    EXPECT_EQ(windows[3].state, WindowState::Open);
+    EXPECT_EQ(opened, (std::vector<std::size_t>{99, 99}));
+    EXPECT_EQ(windows[0].entered, windows[3].entered);
+}
+
+TEST_F(StateMachineDefinitionTest, HooksKnowTheirInstance) {
+    using Definition = sdv::StateMachineDefinition<WindowState, WindowContext>;
+    std::vector<std::pair<std::size_t, std::size_t>> entered;  // instance index, context window
+
+    Definition::Builder builder("Window", WindowState::Closed);
+    auto open = builder.add_transition(WindowState::Closed, WindowState::Open, "open");
+    std::vector<sdv::MachineInstance<WindowState>> windows;
+    builder.define_state(WindowState::Open).on_entry(
+        [&](const sdv::MachineInstance<WindowState>& window, const WindowContext& ctx) {
+            EXPECT_EQ(window.state, WindowState::Closed);  // before the transition
+            entered.emplace_back(static_cast<std::size_t>(&window - windows.data()), ctx.window);
+        });
+    auto definition = builder.build();
+
+    windows.assign(3, definition->make_instance());
+    WindowContext second{1, false};
+    EXPECT_EQ(definition->dispatch_batch(windows, {{2, open, nullptr}, {1, open, &second}},
+                                         WindowContext{2, false}), 2u);
+    EXPECT_EQ(entered, (std::vector<std::pair<std::size_t, std::size_t>>{{2, 2}, {1, 1}}));
+}
+
+TEST_F(StateMachineDefinitionTest, HooksRunAndFailuresKeepState) {
+    sdv::StateMachineDefinition<WindowState>::Builder builder("Window", WindowState::Closed);
+    builder.set_state_name_function([](WindowState state) {
+        return state == WindowState::Open ? std::string("Open") : std::string("Other");
+    });
+    int entries = 0;
+    int exits = 0;
+    builder.define_state(WindowState::Open).on_entry([&]() { ++entries; });
+    builder.define_state(WindowState::Closed).on_exit([&]() { ++exits; });
+    auto open = builder.add_transition(WindowState::Closed, WindowState::Open, "open");
+    auto jam = builder.add_transition(WindowState::Open, WindowState::Blocked, "jam", {},
+        [](const sdv::Context&) { throw std::runtime_error("motor"); });
+    auto definition = builder.build();
+    
+    auto window = definition->make_instance();
+    EXPECT_TRUE(definition->dispatch(window, open));
+    EXPECT_EQ(entries, 1);
+    EXPECT_EQ(exits, 1);
+    EXPECT_EQ(definition->state_name(window.state), "Open");
+    
+    EXPECT_THROW(definition->dispatch(window, jam), std::runtime_error);
+    EXPECT_EQ(window.state, WindowState::Open);
+    EXPECT_EQ(definition->available_triggers(WindowState::Open), std::vector<sdv::TriggerId>{jam});
+}
@@ -0,0 +1,210 @@
+/**
+ * @file test_state_publisher.cpp
+ * @brief Unit tests for batched state publishing (no databroker required)
+ */
+
+#include <kuksa_cpp/state_publisher.hpp>
+#include <kuksa_cpp/state_machine/state_machine.hpp>
+#include <kuksa_cpp/testing/test_utils.hpp>
+#include <gtest/gtest.h>
+#include <glog/logging.h>
+#include <set>
+#include <thread>
+#include <vector>
+
+using namespace kuksa;
+
+namespace {
+
+enum class Protection { IDLE = 0, MONITORING = 1, PROTECTING = 2 };
+
+/**
+ * @brief Client that records publish_batch() calls
+ */
+class RecordingClient : public Client {
+public:
+    std::mutex mutex;
+    std::vector<std::map<int32_t, vss::types::DynamicQualifiedValue>> batches;
+    bool fail = false;
+    std::set<int32_t> refuse;  // signals the broker rejects, reported per signal
+
+    size_t batch_count() {
+        std::lock_guard<std::mutex> lock(mutex);
+        return batches.size();
+    }
+
+    void clear_subscriptions() override {}
+    size_t subscription_count() const override { return 0; }
+    Status start() override { return absl::OkStatus(); }
+    void stop() override {}
+    bool is_running() const override { return true; }
+    Status status() const override { return absl::OkStatus(); }
+    Status wait_until_ready(std::chrono::milliseconds) override { return absl::OkStatus(); }
+
+protected:
+    void serve_actuator_impl(const std::string&, int32_t, vss::types::ValueType,
+                             std::function<void(const vss::types::Value&)>) override {}
+    Result<vss::types::DynamicQualifiedValue> get_impl(int32_t) override {
+        return absl::UnimplementedError("get");
+    }
+    Status set_impl(int32_t, const vss::types::DynamicQualifiedValue&, SignalClass) override {
+        return absl::UnimplementedError("set");
+    }
+    Status publish_impl(int32_t, const vss::types::DynamicQualifiedValue&) override {
+        return absl::UnimplementedError("publish");
+    }
+    Status publish_batch_impl(const std::map<int32_t, vss::types::DynamicQualifiedValue>& values,
+                              std::function<void(const std::map<int32_t, Status>&)> callback) override {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (fail) {
+            return absl::UnavailableError("provider stream down");
+        }
+        batches.push_back(values);
+        std::map<int32_t, Status> errors;
+        for (const auto& [id, value] : values) {
+            if (refuse.count(id)) {
+                errors[id] = absl::PermissionDeniedError("refused");
+            }
+        }
+        if (callback) {
+            callback(errors);
+        }
+        return errors.empty() ? absl::OkStatus() : absl::UnknownError("Some publishes failed");
+    }
+    void subscribe_impl(std::shared_ptr<DynamicSignalHandle>,
+                        std::function<void(const vss::types::DynamicQualifiedValue&)>) override {}
+    bool unsubscribe_impl(int32_t) override { return false; }
+};
+
+class StatePublisherTest : public ::testing::Test {
+protected:
+    StatePublisherTest() : sm("Protection", Protection::IDLE) {
+        sm.set_text_logging(false);
+        sm.set_state_name_function([](Protection state) {
+            switch (state) {
+                case Protection::IDLE: return std::string("IDLE");
+                case Protection::MONITORING: return std::string("MONITORING");
+                case Protection::PROTECTING: return std::string("PROTECTING");
+            }
+            return std::string("UNKNOWN");
+        });
+        sm.add_transition(Protection::IDLE, Protection::MONITORING, "start");
+        sm.add_transition(Protection::MONITORING, Protection::PROTECTING, "critical");
+        sm.add_transition(Protection::PROTECTING, Protection::MONITORING, "recovered");
+    }
+
+    RecordingClient client;
+    sdv::StateMachine<Protection> sm;
+};
+
+} // namespace
+
+TEST_F(StatePublisherTest, CoalescesChangesIntoOneBatch) {
+    auto name_signal = TestResolver::signal<std::string>("Vehicle.Private.Protection.State", 1);
+    auto code_signal = TestResolver::signal<int32_t>("Vehicle.Private.Protection.StateCode", 2);
+    StatePublisher publisher(client);
+    publisher.add(sm, name_signal);
+    publisher.add(sm, code_signal);
+
+    sm.trigger("start");
+    sm.trigger("critical");
+    EXPECT_EQ(publisher.flush(), 2u);
+    EXPECT_EQ(publisher.flush(), 0u);  // nothing changed since
+
+    ASSERT_EQ(client.batches.size(), 1u);
+    const auto& batch = client.batches[0];
+    EXPECT_EQ(std::get<std::string>(batch.at(1).value), "PROTECTING");
+    EXPECT_EQ(std::get<int32_t>(batch.at(2).value), 2);
+
+    auto stats = publisher.stats();
+    EXPECT_EQ(stats.changes, 6u);    // two initial states + two transitions per signal
+    EXPECT_EQ(stats.coalesced, 4u);
+    EXPECT_EQ(stats.published, 2u);
+    EXPECT_EQ(stats.batches, 1u);
+}
+
+TEST_F(StatePublisherTest, FailedBatchIsRetried) {
+    auto name_signal = TestResolver::signal<std::string>("Vehicle.Private.Protection.State", 1);
+    StatePublisher publisher(client);
+    publisher.add(sm, name_signal);
+
+    client.fail = true;
+    EXPECT_EQ(publisher.flush(), 0u);
+    EXPECT_EQ(publisher.stats().errors, 1u);
+
+    client.fail = false;
+    EXPECT_EQ(publisher.flush(), 1u);
+    ASSERT_EQ(client.batches.size(), 1u);
+    EXPECT_EQ(std::get<std::string>(client.batches[0].at(1).value), "IDLE");
+}
+
+TEST_F(StatePublisherTest, OnlyRejectedSignalsAreRetried) {
+    auto name_signal = TestResolver::signal<std::string>("Vehicle.Private.Protection.State", 1);
+    auto code_signal = TestResolver::signal<int32_t>("Vehicle.Private.Protection.StateCode", 2);
+    StatePublisher publisher(client);
+    publisher.add(sm, name_signal);
+    publisher.add(sm, code_signal);
+
+    client.refuse = {2};
+    EXPECT_EQ(publisher.flush(), 1u);
+    EXPECT_EQ(publisher.stats().errors, 1u);
+
+    client.refuse.clear();
+    EXPECT_EQ(publisher.flush(), 1u);
+    ASSERT_EQ(client.batches.size(), 2u);
+    ASSERT_EQ(client.batches[1].size(), 1u);  // the accepted name is not sent again
+    EXPECT_EQ(std::get<int32_t>(client.batches[1].at(2).value), 0);
+
+    auto stats = publisher.stats();
+    EXPECT_EQ(stats.published, 2u);
+    EXPECT_EQ(stats.batches, 2u);
+}
+
+TEST_F(StatePublisherTest, FlushThreadPublishesPeriodically) {
+    auto name_signal = TestResolver::signal<std::string>("Vehicle.Private.Protection.State", 1);
+    {
+        StatePublisher publisher(client, std::chrono::milliseconds(5));
+        publisher.add(sm, name_signal);
+        publisher.start();
+
+        auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(2);
+        while (client.batch_count() == 0 && std::chrono::steady_clock::now() < deadline) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        EXPECT_EQ(client.batch_count(), 1u);
+        sm.trigger("start");
+    }
+    // The destructor flushed the last change; the machine outlives the publisher
+    EXPECT_EQ(client.batch_count(), 2u);
+    sm.trigger("critical");
+}
+
+TEST_F(StatePublisherTest, DestructorFlushesWithoutStartAndRemovesObservers) {
+    auto name_signal = TestResolver::signal<std::string>("Vehicle.Private.Protection.State", 1);
+    auto code_signal = TestResolver::signal<int32_t>("Vehicle.Private.Protection.StateCode", 2);
+    {
+        StatePublisher publisher(client);
+        publisher.add(sm, name_signal);
+        publisher.add(sm, code_signal);
+        sm.trigger("start");
+    }
+    ASSERT_EQ(client.batch_count(), 1u);
+    EXPECT_EQ(std::get<std::string>(client.batches[0].at(1).value), "MONITORING");
+    EXPECT_EQ(std::get<int32_t>(client.batches[0].at(2).value), 1);
+
+    // The publisher's observers were the machine's first two
+    EXPECT_FALSE(sm.remove_observer(1));
+    EXPECT_FALSE(sm.remove_observer(2));
+
+    // A machine destroyed first simply drops its observer
+    {
+        sdv::StateMachine<Protection> other("Other", Protection::IDLE);
+        StatePublisher publisher(client);
+        {
+            sdv::StateMachine<Protection> gone("Gone", Protection::IDLE);
+            publisher.add(gone, name_signal);
+        }
+        publisher.add(other, code_signal);
+    }
+    EXPECT_EQ(client.batch_count(), 2u);
+}
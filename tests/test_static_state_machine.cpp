@@ -0,0 +1,172 @@
+/**
+ * @file test_static_state_machine.cpp
+ * @brief Unit tests for the compile-time state machine
+ */
+
+#include <gtest/gtest.h>
+#include <glog/logging.h>
+#include <kuksa_cpp/state_machine/static_state_machine.hpp>
+#include <string>
+#include <vector>
+
+namespace {
+
+// Shared context for guards, actions and state hooks
+struct HeaterContext {
+    float temperature = 20.0f;
+    float threshold = 5.0f;
+    int heater_commands = 0;
+    std::vector<std::string> log;
+};
+
+// States
+struct Idle {
+    static constexpr const char* name = "IDLE";
+    static void on_exit(HeaterContext& ctx) { ctx.log.push_back("exit:IDLE"); }
+};
+struct Heating {
+    static constexpr const char* name = "HEATING";
+    static void on_entry(HeaterContext& ctx) { ctx.log.push_back("entry:HEATING"); }
+};
+struct Fault {};  // no name, no hooks
+
+// Events
+struct TemperatureUpdate {
+    static constexpr const char* name = "temperature";
+    float value;
+};
+struct SensorLost {};
+struct Recover {};
+
+// Guards
+struct IsCold {
+    bool operator()(HeaterContext& ctx, const TemperatureUpdate& e) const {
+        return e.value < ctx.threshold;
+    }
+};
+struct IsWarm {
+    bool operator()(HeaterContext& ctx, const TemperatureUpdate& e) const {
+        return e.value >= ctx.threshold;
+    }
+};
+
+// Actions
+struct StartHeater {
+    void operator()(HeaterContext& ctx, const TemperatureUpdate& e) const {
+        ctx.temperature = e.value;
+        ctx.heater_commands++;
+        ctx.log.push_back("action:start");
+    }
+};
+
+using HeaterTable = sdv::StaticTransitionTable<
+    sdv::Row<Idle,    TemperatureUpdate, Heating, IsCold, StartHeater>,
+    sdv::Row<Heating, TemperatureUpdate, Idle,    IsWarm>,
+    sdv::Row<Idle,    SensorLost,        Fault>,
+    sdv::Row<Heating, SensorLost,        Fault>,
+    sdv::Row<Fault,   Recover,           Idle>
+>;
+
+using HeaterMachine = sdv::StaticStateMachine<HeaterTable, HeaterContext>;
+
+// Context-free machine
+struct Off { static constexpr const char* name = "OFF"; };
+struct On { static constexpr const char* name = "ON"; };
+struct Toggle { static constexpr const char* name = "toggle"; };
+
+using SwitchMachine = sdv::StaticStateMachine<sdv::StaticTransitionTable<
+    sdv::Row<Off, Toggle, On>,
+    sdv::Row<On, Toggle, Off>
+>>;
+
+} // namespace
+
+class StaticStateMachineTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        if (!google::IsGoogleLoggingInitialized()) {
+            google::InitGoogleLogging("test");
+            FLAGS_logtostderr = 1;
+        }
+    }
+};
+
+TEST_F(StaticStateMachineTest, StatesIndexedInTableOrder) {
+    static_assert(HeaterMachine::num_states == 3);
+    static_assert(HeaterMachine::state_index<Idle>() == 0);
+    static_assert(HeaterMachine::state_index<Heating>() == 1);
+    static_assert(HeaterMachine::state_index<Fault>() == 2);
+
+    HeaterContext ctx;
+    HeaterMachine sm("Heater", ctx);
+    EXPECT_TRUE(sm.is_in<Idle>());
+    EXPECT_EQ(sm.current_state_name(), "IDLE");
+    EXPECT_EQ(sm.state_name(2), "State_2");
+}
+
+TEST_F(StaticStateMachineTest, GuardsActionsAndHooks) {
+    HeaterContext ctx;
+    HeaterMachine sm("Heater", ctx);
+
+    // Guard fails: no transition
+    EXPECT_FALSE(sm.process(TemperatureUpdate{10.0f}));
+    EXPECT_TRUE(sm.is_in<Idle>());
+    EXPECT_EQ(ctx.heater_commands, 0);
+
+    // Guard passes: exit, action, entry in order
+    EXPECT_TRUE(sm.process(TemperatureUpdate{2.0f}));
+    EXPECT_TRUE(sm.is_in<Heating>());
+    EXPECT_EQ(ctx.heater_commands, 1);
+    EXPECT_FLOAT_EQ(ctx.temperature, 2.0f);
+    ASSERT_EQ(ctx.log.size(), 3u);
+    EXPECT_EQ(ctx.log[0], "exit:IDLE");
+    EXPECT_EQ(ctx.log[1], "action:start");
+    EXPECT_EQ(ctx.log[2], "entry:HEATING");
+
+    EXPECT_TRUE(sm.process(TemperatureUpdate{6.0f}));
+    EXPECT_TRUE(sm.is_in<Idle>());
+}
+
+TEST_F(StaticStateMachineTest, UnhandledEventsAreIgnored) {
+    HeaterContext ctx;
+    HeaterMachine sm("Heater", ctx);
+
+    // Recover has no row from Idle
+    EXPECT_FALSE(sm.process(Recover{}));
+    EXPECT_TRUE(sm.is_in<Idle>());
+
+    EXPECT_TRUE(sm.process(SensorLost{}));
+    EXPECT_TRUE(sm.is_in<Fault>());
+    EXPECT_FALSE(sm.process(TemperatureUpdate{0.0f}));
+    EXPECT_TRUE(sm.process(Recover{}));
+    EXPECT_TRUE(sm.is_in<Idle>());
+}
+
+TEST_F(StaticStateMachineTest, ResetAndNameHook) {
+    SwitchMachine sm("Switch");
+    EXPECT_TRUE(sm.is_in<Off>());
+    EXPECT_TRUE(sm.process(Toggle{}));
+    EXPECT_TRUE(sm.is_in<On>());
+
+    sm.reset<Off>();
+    EXPECT_EQ(sm.current_state_name(), "OFF");
+
+    sm.set_state_name_function([](std::size_t index) {
+        return index == SwitchMachine::state_index<On>() ? std::string("SWITCH_ON")
+                                                         : std::string("SWITCH_OFF");
+    });
+    EXPECT_TRUE(sm.process(Toggle{}));
+    EXPECT_EQ(sm.current_state_name(), "SWITCH_ON");
+}
+
+TEST_F(StaticStateMachineTest, TransitionsWithoutTextLogging) {
+    HeaterContext context;
+    HeaterMachine sm("Heater", context);
+    sm.set_text_logging(false);
+
+    EXPECT_TRUE(sm.process(TemperatureUpdate{0.0f}));
+    EXPECT_TRUE(sm.is_in<Heating>());
+    EXPECT_EQ(context.heater_commands, 1);
+    EXPECT_TRUE(sm.process(SensorLost{}));
+    EXPECT_TRUE(sm.is_in<Fault>());
+}
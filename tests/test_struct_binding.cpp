@@ -0,0 +1,125 @@
+/**
+ * @file test_struct_binding.cpp
+ * @brief Unit tests for seqlock cells and struct bindings (no databroker required)
+ */
+
+#include <kuksa_cpp/struct_binding.hpp>
+#include <kuksa_cpp/testing/test_utils.hpp>
+#include <gtest/gtest.h>
+#include <glog/logging.h>
+#include <array>
+#include <atomic>
+#include <thread>
+
+using namespace kuksa;
+using vss::types::DynamicQualifiedValue;
+using vss::types::SignalQuality;
+
+namespace {
+
+DynamicQualifiedValue valid(vss::types::Value value) {
+    return DynamicQualifiedValue{std::move(value), SignalQuality::VALID};
+}
+
+DynamicQualifiedValue unavailable() {
+    return DynamicQualifiedValue{vss::types::Value{}, SignalQuality::NOT_AVAILABLE};
+}
+
+struct Dynamics {
+    float speed = -1.0f;
+    std::optional<float> yaw_rate;
+    vss::types::QualifiedValue<bool> brake;
+    float speed_copy = -1.0f;
+};
+
+} // namespace
+
+TEST(StructBindingTest, FieldKindsFollowQuality) {
+    auto speed = TestResolver::signal<float>("Vehicle.Speed", 1);
+    auto yaw_rate = TestResolver::signal<float>("Vehicle.AngularVelocityYaw", 2);
+    auto brake = TestResolver::signal<bool>("Vehicle.Chassis.Brake.IsActive", 3);
+
+    StructBinding<Dynamics> dynamics;
+    dynamics.bind(&Dynamics::speed, speed)
+            .bind(&Dynamics::yaw_rate, yaw_rate)
+            .bind(&Dynamics::brake, brake)
+            .bind(&Dynamics::speed_copy, speed);
+    EXPECT_EQ(dynamics.size(), 4u);
+
+    auto initial = dynamics.read();
+    EXPECT_EQ(initial.speed, -1.0f);
+    EXPECT_FALSE(initial.yaw_rate);
+    EXPECT_EQ(dynamics.version(), 0u);
+
+    dynamics.dispatch(1, valid(42.0f));
+    dynamics.dispatch(2, valid(0.5f));
+    dynamics.dispatch(3, valid(true));
+    auto now = dynamics.read();
+    EXPECT_EQ(now.speed, 42.0f);
+    EXPECT_EQ(now.speed_copy, 42.0f);
+    EXPECT_EQ(now.yaw_rate, 0.5f);
+    EXPECT_TRUE(now.brake.is_valid());
+    EXPECT_TRUE(*now.brake.value);
+    EXPECT_EQ(dynamics.version(), 3u);
+
+    // T keeps the last valid value, optional<T> empties, QualifiedValue<T> reports
+    dynamics.dispatch(1, unavailable());
+    dynamics.dispatch(2, unavailable());
+    dynamics.dispatch(3, unavailable());
+    dynamics.dispatch(99, valid(1.0f));  // unbound signal
+    now = dynamics.read();
+    EXPECT_EQ(now.speed, 42.0f);
+    EXPECT_FALSE(now.yaw_rate);
+    EXPECT_EQ(now.brake.quality, SignalQuality::NOT_AVAILABLE);
+    EXPECT_FALSE(now.brake.value);
+    EXPECT_EQ(dynamics.version(), 6u);
+}
+
+TEST(StructBindingTest, ReadIfChangedSkipsUnchangedSnapshots) {
+    auto speed = TestResolver::signal<float>("Vehicle.Speed", 1);
+    StructBinding<Dynamics> dynamics;
+    dynamics.bind(&Dynamics::speed, speed);
+
+    Dynamics out;
+    uint64_t version = 0;
+    EXPECT_FALSE(dynamics.read_if_changed(out, version));
+
+    dynamics.dispatch(1, valid(10.0f));
+    ASSERT_TRUE(dynamics.read_if_changed(out, version));
+    EXPECT_EQ(out.speed, 10.0f);
+    EXPECT_EQ(version, 1u);
+    EXPECT_FALSE(dynamics.read_if_changed(out, version));
+}
+
+TEST(StructBindingTest, RejectsInvalidHandles) {
+    StructBinding<Dynamics> dynamics;
+    EXPECT_THROW(dynamics.bind(&Dynamics::speed, SignalHandle<float>{}), std::invalid_argument);
+}
+
+TEST(SeqlockTest, ReadersNeverSeeTornWrites) {
+    // Every write sets all words to the same value; a torn copy would mix two
+    struct Words {
+        std::array<uint64_t, 16> words{};
+    };
+    Seqlock<Words> cell;
+    std::atomic<bool> stopping{false};
+
+    std::thread writer([&]() {
+        for (uint64_t i = 1; !stopping; ++i) {
+            cell.write([i](Words& value) { value.words.fill(i); });
+        }
+    });
+
+    uint64_t last = 0;
+    for (int i = 0; i < 100000; ++i) {
+        auto copy = cell.load();
+        for (auto word : copy.words) {
+            ASSERT_EQ(word, copy.words[0]) << "torn read";
+        }
+        ASSERT_GE(copy.words[0], last);
+        last = copy.words[0];
+    }
+    stopping = true;
+    writer.join();
+    EXPECT_GT(cell.version(), 0u);
+}
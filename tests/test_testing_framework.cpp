@@ -7,10 +7,12 @@
 #include <kuksa_cpp/testing/yaml_parser.hpp>
 #include <kuksa_cpp/testing/test_runner.hpp>
 #include <kuksa_cpp/testing/kuksa_client_wrapper.hpp>
+#include <kuksa_cpp/testing/state_tracker.hpp>
 #include <gtest/gtest.h>
 #include <glog/logging.h>
 #include <fstream>
 #include <filesystem>
+#include <thread>
 
 using namespace sdv::testing;
 
@@ -376,6 +378,84 @@ TEST(KuksaClientWrapperTest, DisconnectBeforeConnect) {
     EXPECT_NO_THROW(client.disconnect());
 }
 
+// ============================================================================
+// State Machine Expectation Tests (in-process, no databroker)
+// ============================================================================
+
+enum class DoorState { Closed, Open, Locked };
+
+TEST(StateTrackerTest, FollowsWatchedMachine) {
+    sdv::StateMachine<DoorState> door("Door", DoorState::Closed);
+    door.set_state_name_function([](DoorState s) {
+        switch (s) {
+            case DoorState::Closed: return std::string("Closed");
+            case DoorState::Open: return std::string("Open");
+            case DoorState::Locked: return std::string("Locked");
+        }
+        return std::string("?");
+    });
+    door.add_transition(DoorState::Closed, DoorState::Open, "open");
+    door.add_transition(DoorState::Open, DoorState::Closed, "close");
+    door.add_transition(DoorState::Closed, DoorState::Locked, "lock");
+
+    auto tracker = std::make_shared<StateTracker>();
+    EXPECT_FALSE(tracker->is_watched("Door"));
+    tracker->watch(door);
+    EXPECT_EQ(tracker->current_state("Door"), "Closed");
+
+    // Transition completed before the wait is still matched, once
+    door.trigger("open");
+    EXPECT_TRUE(tracker->wait_for_transition("Door", "Closed", "Open", std::chrono::milliseconds(0)));
+    EXPECT_FALSE(tracker->wait_for_transition("Door", "Closed", "Open", std::chrono::milliseconds(0)));
+
+    // Waiters wake when the transition happens on another thread
+    std::thread worker([&door]() {
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        door.trigger("close");
+        door.trigger("lock");
+    });
+    EXPECT_TRUE(tracker->wait_for_state("Door", "Locked", std::chrono::seconds(5)));
+    worker.join();
+    EXPECT_TRUE(tracker->wait_for_transition("Door", "", "Locked", std::chrono::milliseconds(0)));
+    EXPECT_FALSE(tracker->wait_for_state("Door", "Open", std::chrono::milliseconds(10)));
+}
+
+TEST(StateTrackerTest, RunnerExpectSteps) {
+    sdv::StateMachine<DoorState> door("Door", DoorState::Closed);
+    door.add_transition(DoorState::Closed, DoorState::Open, "open");
+    door.trigger("open");  // before watching: only the current state is known
+
+    TestRunner runner(nullptr);
+    runner.watch_state_machine(door);
+
+    auto make_step = [](auto data, double timeout) {
+        TestStep step;
+        step.type = std::is_same_v<decltype(data), ExpectStateData> ? StepType::EXPECT_STATE
+                                                                     : StepType::EXPECT_TRANSITION;
+        step.data = data;
+        step.timeout = timeout;
+        return step;
+    };
+
+    TestCase passing;
+    passing.name = "door opened";
+    passing.steps.push_back(make_step(ExpectStateData{"Door", "State_1"}, 1.0));
+    EXPECT_EQ(runner.run_test_case(passing).status, TestStatus::PASSED);
+
+    TestCase failing;
+    failing.name = "transition missed";
+    failing.steps.push_back(make_step(ExpectTransitionData{"Door", "State_0", "State_1"}, 0.05));
+    auto result = runner.run_test_case(failing);
+    EXPECT_EQ(result.status, TestStatus::FAILED);
+
+    TestCase unknown;
+    unknown.name = "unwatched machine";
+    unknown.steps.push_back(make_step(ExpectStateData{"Window", "Open"}, 0.05));
+    result = runner.run_test_case(unknown);
+    ASSERT_EQ(result.step_results.size(), 1u);
+    EXPECT_EQ(result.step_results[0].status, TestStatus::SKIPPED);
+}
+
 // Note: Actual connection tests require KUKSA databroker running
 // Those are tested separately with Docker integration tests
 
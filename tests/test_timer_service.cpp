@@ -0,0 +1,287 @@
+/**
+ * @file test_timer_service.cpp
+ * @brief Unit tests for the timing wheel and state machine timeouts
+ */
+
+#include <gtest/gtest.h>
+#include <glog/logging.h>
+#include <kuksa_cpp/state_machine/state_machine.hpp>
+#include <kuksa_cpp/state_machine/timer_service.hpp>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <future>
+#include <mutex>
+#include <random>
+#include <thread>
+#include <vector>
+
+using namespace std::chrono_literals;
+
+enum class EngineState {
+    Stopped,
+    Running,
+    Cooldown,
+    _Count
+};
+
+class TimerServiceTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        if (!google::IsGoogleLoggingInitialized()) {
+            google::InitGoogleLogging("test");
+            FLAGS_logtostderr = 1;
+        }
+    }
+
+    template<typename Pred>
+    static bool wait_for(Pred pred, std::chrono::milliseconds timeout = 2000ms) {
+        auto deadline = std::chrono::steady_clock::now() + timeout;
+        while (!pred()) {
+            if (std::chrono::steady_clock::now() > deadline) {
+                return false;
+            }
+            std::this_thread::sleep_for(1ms);
+        }
+        return true;
+    }
+};
+
+TEST_F(TimerServiceTest, FiresInDeadlineOrder) {
+    sdv::TimerService timers;
+    std::mutex mutex;
+    std::vector<int> fired;
+
+    auto record = [&](int value) {
+        return [&, value]() {
+            std::lock_guard<std::mutex> lock(mutex);
+            fired.push_back(value);
+        };
+    };
+    timers.after(30ms, record(3));
+    timers.after(10ms, record(1));
+    timers.after(20ms, record(2));
+
+    ASSERT_TRUE(wait_for([&]() { return timers.pending() == 0; }));
+    std::lock_guard<std::mutex> lock(mutex);
+    EXPECT_EQ(fired, (std::vector<int>{1, 2, 3}));
+}
+
+TEST_F(TimerServiceTest, CancelPreventsCallback) {
+    sdv::TimerService timers;
+    std::atomic<int> fired{0};
+
+    auto cancelled = timers.after(20ms, [&]() { fired += 100; });
+    auto kept = timers.after(20ms, [&]() { fired += 1; });
+    EXPECT_EQ(timers.pending(), 2u);
+
+    EXPECT_TRUE(timers.cancel(cancelled));
+    EXPECT_FALSE(timers.cancel(cancelled));
+    EXPECT_FALSE(timers.cancel(sdv::kInvalidTimerId));
+
+    ASSERT_TRUE(wait_for([&]() { return fired.load() != 0; }));
+    EXPECT_EQ(fired.load(), 1);
+    EXPECT_FALSE(timers.cancel(kept));  // already fired
+}
+
+TEST_F(TimerServiceTest, CascadesFromOuterWheels) {
+    // 10us ticks: 5ms lands in the second wheel, 700ms in the third
+    sdv::TimerService timers(10us);
+    std::atomic<int> fired{0};
+    auto start = std::chrono::steady_clock::now();
+    std::chrono::steady_clock::duration short_elapsed{}, long_elapsed{};
+
+    timers.after(5ms, [&]() {
+        short_elapsed = std::chrono::steady_clock::now() - start;
+        ++fired;
+    });
+    timers.after(700ms, [&]() {
+        long_elapsed = std::chrono::steady_clock::now() - start;
+        ++fired;
+    });
+
+    ASSERT_TRUE(wait_for([&]() { return fired.load() == 2; }, 3000ms));
+    EXPECT_GE(short_elapsed, 5ms);
+    EXPECT_GE(long_elapsed, 700ms);
+    EXPECT_LT(long_elapsed, 1500ms);
+}
+
+TEST_F(TimerServiceTest, ManyConcurrentTimers) {
+    constexpr int kTimers = 20000;
+    sdv::TimerService timers;
+    std::atomic<int> fired{0};
+    std::atomic<int> early{0};
+    std::vector<sdv::TimerId> ids;
+    ids.reserve(kTimers);
+
+    std::mt19937 rng(42);
+    std::uniform_int_distribution<int> delay_ms(0, 300);
+    for (int i = 0; i < kTimers; ++i) {
+        auto delay = std::chrono::milliseconds(delay_ms(rng));
+        auto deadline = std::chrono::steady_clock::now() + delay;
+        ids.push_back(timers.after(delay, [&, deadline]() {
+            if (std::chrono::steady_clock::now() < deadline) {
+                ++early;
+            }
+            ++fired;
+        }));
+    }
+
+    // Cancel every fourth timer
+    int cancelled = 0;
+    for (int i = 0; i < kTimers; i += 4) {
+        if (timers.cancel(ids[i])) {
+            ++cancelled;
+        }
+    }
+
+    ASSERT_TRUE(wait_for([&]() { return timers.pending() == 0; }, 5000ms));
+    EXPECT_EQ(fired.load() + cancelled, kTimers);
+    EXPECT_EQ(early.load(), 0);
+}
+
+TEST_F(TimerServiceTest, CancelAndWaitBlocksForRunningCallback) {
+    sdv::TimerService timers;
+    std::atomic<bool> started{false};
+    std::atomic<bool> finished{false};
+
+    auto id = timers.after(0ms, [&]() {
+        started = true;
+        std::this_thread::sleep_for(50ms);
+        finished = true;
+    });
+    ASSERT_TRUE(wait_for([&]() { return started.load(); }));
+
+    EXPECT_FALSE(timers.cancel_and_wait(id));
+    EXPECT_TRUE(finished.load());
+}
+
+TEST_F(TimerServiceTest, StateMachineAfterFiresTrigger) {
+    sdv::TimerService timers;
+    sdv::StateMachine<EngineState> engine("Engine", EngineState::Stopped);
+    engine.set_timer_service(timers);
+    engine.add_transition(EngineState::Stopped, EngineState::Running, "start");
+
+    engine.after(10ms, "start");
+    ASSERT_TRUE(wait_for([&]() { return engine.current_state() == EngineState::Running; }));
+
+    auto handle = engine.after(10ms, "start");
+    EXPECT_TRUE(engine.cancel_timer(handle));
+    EXPECT_FALSE(engine.cancel_timer(handle));
+}
+
+TEST_F(TimerServiceTest, StateTimeoutFiresWhileInState) {
+    sdv::TimerService timers;
+    sdv::StateMachine<EngineState> engine("Engine", EngineState::Stopped);
+    engine.set_timer_service(timers);
+
+    engine.define_state(EngineState::Running).timeout(20ms, "min_runtime_elapsed");
+    engine.add_transition(EngineState::Stopped, EngineState::Running, "start");
+    engine.add_transition(EngineState::Running, EngineState::Cooldown, "min_runtime_elapsed");
+
+    auto start = std::chrono::steady_clock::now();
+    EXPECT_TRUE(engine.trigger("start"));
+    ASSERT_TRUE(wait_for([&]() { return engine.current_state() == EngineState::Cooldown; }));
+    EXPECT_GE(std::chrono::steady_clock::now() - start, 20ms);
+}
+
+TEST_F(TimerServiceTest, StateTimeoutCancelledOnExit) {
+    sdv::TimerService timers;
+    sdv::StateMachine<EngineState> engine("Engine", EngineState::Stopped);
+    engine.set_timer_service(timers);
+
+    engine.define_state(EngineState::Running).timeout(30ms, "min_runtime_elapsed");
+    engine.add_transition(EngineState::Stopped, EngineState::Running, "start");
+    engine.add_transition(EngineState::Running, EngineState::Stopped, "stop");
+    engine.add_transition(EngineState::Running, EngineState::Cooldown, "min_runtime_elapsed");
+    engine.add_transition(EngineState::Stopped, EngineState::Cooldown, "min_runtime_elapsed");
+
+    EXPECT_TRUE(engine.trigger("start"));
+    EXPECT_TRUE(engine.trigger("stop"));
+    EXPECT_EQ(timers.pending(), 0u);
+
+    std::this_thread::sleep_for(60ms);
+    EXPECT_EQ(engine.current_state(), EngineState::Stopped);
+
+    // Re-entering re-arms the timeout
+    EXPECT_TRUE(engine.trigger("start"));
+    ASSERT_TRUE(wait_for([&]() { return engine.current_state() == EngineState::Cooldown; }));
+}
+
+TEST_F(TimerServiceTest, DestroyingMachineCancelsItsTimers) {
+    sdv::TimerService timers;
+    {
+        sdv::StateMachine<EngineState> engine("Engine", EngineState::Stopped);
+        engine.set_timer_service(timers);
+        engine.add_transition(EngineState::Stopped, EngineState::Running, "start");
+        engine.after(20ms, "start");
+        EXPECT_EQ(timers.pending(), 1u);
+    }
+    EXPECT_EQ(timers.pending(), 0u);
+}
+
+TEST_F(TimerServiceTest, DestroyingMachineArmsNoTimerForQueuedEvents) {
+    sdv::TimerService timers;
+    std::promise<void> entered;
+    std::promise<void> release;
+    auto released = release.get_future().share();
+    std::thread releaser;
+    {
+        sdv::StateMachine<EngineState> engine("Engine", EngineState::Stopped);
+        engine.set_timer_service(timers);
+        engine.define_state(EngineState::Running).timeout(1h, "min_runtime_elapsed");
+        engine.add_transition(EngineState::Stopped, EngineState::Cooldown, "warm_up", {},
+                              [&entered, released](const sdv::Context&) {
+                                  entered.set_value();
+                                  released.wait();
+                              });
+        engine.add_transition(EngineState::Cooldown, EngineState::Running, "start");
+        engine.add_transition(EngineState::Running, EngineState::Cooldown, "min_runtime_elapsed");
+        engine.start_event_queue();
+        engine.post("warm_up");
+        engine.post("start");
+        engine.trigger_async("start", sdv::Context{});
+        entered.get_future().wait();
+
+        // Destruction drains the queues into Running after the timers were cancelled
+        releaser = std::thread([&release]() {
+            std::this_thread::sleep_for(20ms);
+            release.set_value();
+        });
+    }
+    releaser.join();
+    EXPECT_EQ(timers.pending(), 0u);
+}
+
+TEST_F(TimerServiceTest, DestroyingMachineWaitsForFiringTimer) {
+    sdv::TimerService timers;
+    std::promise<void> entered;
+    std::promise<void> release;
+    auto released = release.get_future().share();
+    std::atomic<bool> finished{false};
+
+    auto engine = std::make_unique<sdv::StateMachine<EngineState>>("Engine", EngineState::Stopped);
+    engine->set_timer_service(timers);
+    engine->add_transition(EngineState::Stopped, EngineState::Running, "start", {},
+                           [&entered, released, &finished](const sdv::Context&) {
+                               entered.set_value();
+                               released.wait();
+                               finished = true;
+                           });
+    engine->after(1ms, "start");
+    entered.get_future().wait();
+
+    // The timer's action is blocked: destruction must wait for it
+    std::atomic<bool> destroyed{false};
+    std::thread destroyer([&]() {
+        engine.reset();
+        destroyed = true;
+    });
+    std::this_thread::sleep_for(30ms);
+    EXPECT_FALSE(destroyed);
+
+    release.set_value();
+    destroyer.join();
+    EXPECT_TRUE(finished);
+    EXPECT_TRUE(destroyed);
+}
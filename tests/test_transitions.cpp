@@ -8,6 +8,8 @@
 #include <kuksa_cpp/state_machine/state_machine.hpp>
 #include <chrono>
 #include <thread>
+#include <future>
+#include <atomic>
 
 enum class DoorState {
     Closed,
@@ -208,6 +210,30 @@ TEST_F(TransitionTest, AsyncTransitions) {
     EXPECT_EQ(door.current_state(), DoorState::Open);
 }
 
+TEST_F(TransitionTest, AsyncTransitionsUseExecutor) {
+    sdv::Executor executor(4);
+    sdv::StateMachine<DoorState> door("Door", DoorState::Closed, executor);
+    
+    door.add_transition(DoorState::Closed, DoorState::Opening, "open");
+    door.add_transition(DoorState::Opening, DoorState::Open, "opened");
+    door.add_transition(DoorState::Open, DoorState::Closing, "close");
+    door.add_transition(DoorState::Closing, DoorState::Closed, "closed");
+    
+    // Async triggers of one machine keep submission order on a multi-worker pool
+    std::vector<std::future<bool>> results;
+    for (int i = 0; i < 50; ++i) {
+        results.push_back(door.trigger_async("open"));
+        results.push_back(door.trigger_async("opened"));
+        results.push_back(door.trigger_async("close"));
+        results.push_back(door.trigger_async("closed"));
+    }
+    
+    for (auto& result : results) {
+        EXPECT_TRUE(result.get());
+    }
+    EXPECT_EQ(door.current_state(), DoorState::Closed);
+}
+
 TEST_F(TransitionTest, TransitionRollback) {
     sdv::StateMachine<DoorState> door("Door", DoorState::Closed);
     
@@ -271,4 +297,394 @@ TEST_F(TransitionTest, ComplexStateMachine) {
     
     EXPECT_TRUE(door.trigger("unlock"));
     EXPECT_EQ(door.current_state(), DoorState::Closed);
-}
\ No newline at end of file
+}
+
+// Typed context used instead of the dynamic sdv::Context map
+struct DoorContext {
+    bool locked = false;
+    float speed = 0.0f;
+};
+
+TEST_F(TransitionTest, TypedContext) {
+    sdv::StateMachine<DoorState, DoorContext> door("Door", DoorState::Closed);
+    
+    int actions = 0;
+    door.add_transition(
+        DoorState::Closed,
+        DoorState::Opening,
+        "open",
+        [](const DoorContext& ctx) { return !ctx.locked && ctx.speed < 5.0f; },
+        [&actions](const DoorContext& ctx) { actions++; }
+    );
+    door.add_transition(DoorState::Opening, DoorState::Closed, "close");
+    
+    DoorContext ctx;
+    ctx.locked = true;
+    EXPECT_FALSE(door.trigger("open", ctx));
+    
+    ctx.locked = false;
+    ctx.speed = 10.0f;
+    EXPECT_FALSE(door.trigger("open", ctx));
+    
+    ctx.speed = 0.0f;
+    EXPECT_TRUE(door.trigger("open", ctx));
+    EXPECT_EQ(actions, 1);
+    
+    // Async triggers copy the typed context
+    EXPECT_TRUE(door.trigger_async("close", ctx).get());
+    EXPECT_EQ(door.current_state(), DoorState::Closed);
+}
+
+TEST_F(TransitionTest, BoundContext) {
+    sdv::StateMachine<DoorState, DoorContext> door("Door", DoorState::Closed);
+    
+    auto open = door.register_trigger("open");
+    door.add_transition(
+        DoorState::Closed,
+        DoorState::Opening,
+        open,
+        [](const DoorContext& ctx) { return !ctx.locked; }
+    );
+    
+    // Guards read the bound object on every trigger
+    DoorContext vehicle;
+    vehicle.locked = true;
+    door.bind_context(&vehicle);
+    EXPECT_FALSE(door.trigger(open));
+    
+    // Guards see updates to the bound object without passing it again
+    vehicle.locked = false;
+    EXPECT_TRUE(door.trigger(open));
+    EXPECT_EQ(door.current_state(), DoorState::Opening);
+    
+    // Async triggers copy the bound object when queued
+    door.add_transition(
+        DoorState::Opening,
+        DoorState::Closed,
+        "close",
+        [](const DoorContext& ctx) { return !ctx.locked; }
+    );
+    vehicle.locked = true;
+    auto closing = door.trigger_async("close");
+    vehicle.locked = false;
+    EXPECT_FALSE(closing.get());
+    EXPECT_EQ(door.current_state(), DoorState::Opening);
+    
+    door.bind_context(nullptr);
+}
+
+TEST_F(TransitionTest, EventQueueRunToCompletion) {
+    sdv::StateMachine<DoorState> door("Door", DoorState::Closed);
+    
+    std::vector<std::string> trace;
+    door.add_transition(
+        DoorState::Closed,
+        DoorState::Opening,
+        "open",
+        {},
+        [&door, &trace](const sdv::Context& ctx) {
+            trace.push_back("open:begin");
+            // Raised mid-transition: deferred until this transition completes
+            EXPECT_TRUE(door.trigger("opened"));
+            trace.push_back("open:end");
+        }
+    );
+    door.add_transition(
+        DoorState::Opening,
+        DoorState::Open,
+        "opened",
+        {},
+        [&trace](const sdv::Context& ctx) { trace.push_back("opened"); }
+    );
+    door.add_transition(DoorState::Open, DoorState::Closing, "close");
+    
+    door.start_event_queue();
+    EXPECT_TRUE(door.event_queue_running());
+    
+    EXPECT_TRUE(door.trigger("open"));
+    // Blocking trigger is processed after the deferred "opened" event
+    EXPECT_TRUE(door.trigger("close"));
+    EXPECT_EQ(door.current_state(), DoorState::Closing);
+    
+    ASSERT_EQ(trace.size(), 3u);
+    EXPECT_EQ(trace[0], "open:begin");
+    EXPECT_EQ(trace[1], "open:end");
+    EXPECT_EQ(trace[2], "opened");
+    
+    door.stop_event_queue();
+    EXPECT_FALSE(door.event_queue_running());
+}
+
+TEST_F(TransitionTest, EventQueuePostFromManyThreads) {
+    sdv::StateMachine<DoorState> door("Door", DoorState::Closed);
+    
+    auto toggle = door.register_trigger("toggle");
+    auto sync = door.register_trigger("sync");
+    door.add_transition(DoorState::Closed, DoorState::Open, toggle);
+    door.add_transition(DoorState::Open, DoorState::Closed, toggle);
+    door.add_transition(DoorState::Closed, DoorState::Closed, sync);
+    door.add_transition(DoorState::Open, DoorState::Open, sync);
+    
+    door.start_event_queue({4096, false});
+    
+    std::vector<std::thread> producers;
+    for (int t = 0; t < 4; ++t) {
+        producers.emplace_back([&door, toggle]() {
+            for (int i = 0; i < 250; ++i) {
+                while (!door.post(toggle)) {
+                    std::this_thread::yield();
+                }
+            }
+        });
+    }
+    for (auto& p : producers) {
+        p.join();
+    }
+    
+    // FIFO: once the blocking trigger returns, all earlier posts are processed
+    EXPECT_TRUE(door.trigger(sync));
+    EXPECT_EQ(door.current_state(), DoorState::Closed);  // even number of toggles
+    
+    auto stats = door.event_queue_stats();
+    EXPECT_EQ(stats.posted, 1001u);
+    EXPECT_EQ(stats.processed, 1001u);
+    EXPECT_EQ(stats.depth, 0u);
+    EXPECT_GE(stats.max_latency, stats.mean_latency);
+}
+
+TEST_F(TransitionTest, EventQueueCoalescesDuplicates) {
+    sdv::StateMachine<DoorState> door("Door", DoorState::Closed);
+    
+    std::promise<void> release;
+    auto released = release.get_future().share();
+    std::atomic<int> refreshes{0};
+    
+    door.add_transition(
+        DoorState::Closed,
+        DoorState::Open,
+        "open",
+        {},
+        [released](const sdv::Context& ctx) { released.wait(); }
+    );
+    door.add_transition(
+        DoorState::Open,
+        DoorState::Open,
+        "refresh",
+        {},
+        [&refreshes](const sdv::Context& ctx) { refreshes++; }
+    );
+    
+    door.start_event_queue({64, true});
+    
+    // Worker is busy in the "open" action while duplicates pile up
+    EXPECT_TRUE(door.post("open"));
+    for (int i = 0; i < 10; ++i) {
+        EXPECT_TRUE(door.post("refresh"));
+    }
+    release.set_value();
+    
+    door.stop_event_queue();  // drains
+    EXPECT_EQ(door.current_state(), DoorState::Open);
+    EXPECT_EQ(refreshes, 1);
+}
+
+TEST_F(TransitionTest, EventQueueBlocksTriggersWhenFull) {
+    sdv::StateMachine<DoorState> door("Door", DoorState::Closed);
+    
+    std::promise<void> release;
+    auto released = release.get_future().share();
+    std::atomic<int> refreshes{0};
+    
+    door.add_transition(
+        DoorState::Closed,
+        DoorState::Open,
+        "open",
+        {},
+        [released](const sdv::Context& ctx) { released.wait(); }
+    );
+    door.add_transition(
+        DoorState::Open,
+        DoorState::Open,
+        "refresh",
+        {},
+        [&refreshes](const sdv::Context& ctx) { refreshes++; }
+    );
+    
+    door.start_event_queue({2, false});
+    EXPECT_TRUE(door.post("open"));
+    while (door.event_queue_stats().processed == 0 && door.event_queue_stats().depth > 0) {
+        std::this_thread::yield();
+    }
+    
+    // The worker is stuck in "open": blocking triggers fill the queue and wait
+    std::vector<std::thread> callers;
+    std::atomic<int> completed{0};
+    for (int t = 0; t < 6; ++t) {
+        callers.emplace_back([&door, &completed]() {
+            if (door.trigger("refresh")) {
+                completed++;
+            }
+        });
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    EXPECT_EQ(completed, 0);
+    EXPECT_EQ(door.event_queue_stats().dropped, 0u);
+    
+    release.set_value();
+    for (auto& caller : callers) {
+        caller.join();
+    }
+    EXPECT_EQ(completed, 6);
+    EXPECT_EQ(refreshes, 6);
+    door.stop_event_queue();
+}
+
+TEST_F(TransitionTest, EventQueuePropagatesExceptions) {
+    sdv::StateMachine<DoorState> door("Door", DoorState::Closed);
+    door.add_transition(
+        DoorState::Closed,
+        DoorState::Opening,
+        "open",
+        {},
+        [](const sdv::Context& ctx) { throw std::runtime_error("Motor failure"); }
+    );
+    
+    door.start_event_queue();
+    EXPECT_THROW(door.trigger("open"), std::runtime_error);
+    EXPECT_EQ(door.current_state(), DoorState::Closed);
+}
+
+namespace {
+
+template<typename Predicate>
+bool wait_until(Predicate predicate, std::chrono::milliseconds timeout = std::chrono::milliseconds(2000)) {
+    auto deadline = std::chrono::steady_clock::now() + timeout;
+    while (!predicate()) {
+        if (std::chrono::steady_clock::now() > deadline) {
+            return false;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    return true;
+}
+
+} // namespace
+
+TEST_F(TransitionTest, AsyncActionDefersEvents) {
+    sdv::StateMachine<DoorState> door("Door", DoorState::Closed);
+    std::promise<void> motor;
+    
+    door.add_async_transition(DoorState::Closed, DoorState::Open, "open",
+        [&motor](const sdv::Context&) { return motor.get_future(); });
+    door.add_transition(DoorState::Open, DoorState::Closing, "close");
+    
+    EXPECT_TRUE(door.trigger("open"));
+    EXPECT_TRUE(door.in_transition());
+    EXPECT_EQ(door.current_state(), DoorState::Closed);
+    
+    // Returns without waiting for the motor
+    EXPECT_TRUE(door.trigger("close"));
+    EXPECT_EQ(door.deferred_events(), 1u);
+    
+    motor.set_value();
+    EXPECT_TRUE(wait_until([&] { return door.current_state() == DoorState::Closing; }));
+    EXPECT_FALSE(door.in_transition());
+    EXPECT_EQ(door.deferred_events(), 0u);
+    EXPECT_EQ(door.metrics().transitions, 2u);
+}
+
+TEST_F(TransitionTest, AsyncCallbackCompletesFromAnotherThread) {
+    sdv::StateMachine<DoorState> door("Door", DoorState::Closed);
+    sdv::CompletionFunc done;
+    std::atomic<int> open_entries{0};
+    
+    door.define_state(DoorState::Open).on_entry([&]() { ++open_entries; });
+    door.add_async_transition(DoorState::Closed, DoorState::Open, "open",
+        [&done](const sdv::Context&, sdv::CompletionFunc completion) { done = std::move(completion); });
+    
+    EXPECT_TRUE(door.trigger("open"));
+    ASSERT_TRUE(done);
+    EXPECT_EQ(open_entries, 0);
+    
+    std::thread([&] { done(nullptr); }).join();
+    EXPECT_EQ(door.current_state(), DoorState::Open);
+    EXPECT_EQ(open_entries, 1);
+    
+    // A second completion is ignored
+    done(nullptr);
+    EXPECT_EQ(open_entries, 1);
+}
+
+TEST_F(TransitionTest, AsyncGuardFallsBackToNextCandidate) {
+    sdv::StateMachine<DoorState> door("Door", DoorState::Closed);
+    std::promise<bool> unlocked;
+    
+    door.add_async_transition(DoorState::Closed, DoorState::Open, "open",
+        [&unlocked](const sdv::Context&) { return unlocked.get_future(); });
+    door.add_transition(DoorState::Closed, DoorState::Locked, "open");
+    
+    EXPECT_TRUE(door.trigger("open"));
+    EXPECT_TRUE(door.in_transition());
+    
+    unlocked.set_value(false);
+    EXPECT_TRUE(wait_until([&] { return door.current_state() == DoorState::Locked; }));
+    EXPECT_FALSE(door.in_transition());
+}
+
+TEST_F(TransitionTest, AsyncActionFailureKeepsSourceState) {
+    sdv::StateMachine<DoorState> door("Door", DoorState::Closed);
+    std::promise<void> motor;
+    
+    door.add_async_transition(DoorState::Closed, DoorState::Open, "open",
+        [&motor](const sdv::Context&) { return motor.get_future(); });
+    door.add_transition(DoorState::Closed, DoorState::Locked, "lock");
+    
+    door.trigger("open");
+    door.trigger("lock");
+    motor.set_exception(std::make_exception_ptr(std::runtime_error("motor stalled")));
+    
+    // The failed transition leaves the door closed; the deferred event still runs
+    EXPECT_TRUE(wait_until([&] { return door.current_state() == DoorState::Locked; }));
+    EXPECT_FALSE(door.in_transition());
+}
+
+TEST_F(TransitionTest, DestroyWithPendingAsyncActions) {
+    sdv::CompletionFunc done;
+    std::promise<void> never;
+    {
+        sdv::StateMachine<DoorState> door("Door", DoorState::Closed);
+        door.add_async_transition(DoorState::Closed, DoorState::Open, "open",
+            [&done](const sdv::Context&, sdv::CompletionFunc completion) { done = std::move(completion); });
+        door.add_async_transition(DoorState::Closed, DoorState::Locked, "lock",
+            [&never](const sdv::Context&) { return never.get_future(); });
+        door.trigger("open");
+        EXPECT_TRUE(door.in_transition());
+    }
+    // Completing after the machine is gone is harmless
+    done(nullptr);
+}
+
+enum class Health {
+    Ok = 0,
+    Degraded = 7,
+    Fault = 100000
+};
+
+TEST_F(TransitionTest, SparseStateValues) {
+    // Rows follow the states in use, not the range of their values
+    sdv::StateMachine<Health> health("Health", Health::Ok);
+    health.define_state(Health::Fault).on_entry([] {});
+    health.add_transition(Health::Ok, Health::Degraded, "warn");
+    health.add_transition(Health::Degraded, Health::Fault, "fail");
+    health.add_transition(Health::Fault, Health::Ok, "reset");
+
+    EXPECT_FALSE(health.trigger("fail"));
+    EXPECT_TRUE(health.trigger("warn"));
+    EXPECT_TRUE(health.trigger("fail"));
+    EXPECT_EQ(health.current_state(), Health::Fault);
+    EXPECT_TRUE(health.trigger("reset"));
+    EXPECT_EQ(health.current_state(), Health::Ok);
+
+    auto metrics = health.metrics();
+    EXPECT_EQ(metrics.state_metrics.size(), 3u);
+}